@@ -23,6 +23,7 @@
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
 #include "ns3/aodv-module.h"
+#include "ns3/cpda-module.h"
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
 #include "ns3/internet-module.h"
@@ -32,25 +33,49 @@
 #include "ns3/v4ping-helper.h"
 #include "ns3/netanim-module.h"
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
 #include <cmath>
 
 
 // Simulation Parameters
 #define NODE_NUM 6 // number of sensor nodes in the network
 #define NODE_STEP 50 // step distance between nodes
+#define NODE_RANGE 150 // radio range, m
 #define TOTAL_TIME 5 // total simulation time
 
 
 using namespace ns3;
 
 /**
- * \brief Test script.
- * 
- * This script creates 1-dimensional grid topology and then ping last node from the first one:
- * 
- * [10.0.0.1] <-- step --> [10.0.0.2] <-- step --> [10.0.0.3] <-- step --> [10.0.0.4]
- * 
- * ping 10.0.0.4
+ * \brief CPDA scenario runner.
+ *
+ * Builds a deployment of sensor nodes plus one root and runs one CPDA round
+ * over it. The nodes are laid out as
+ *
+ * - grid: a square grid, step meters apart
+ * - random: uniformly over the square the grid would cover
+ * - clustered: in discs of one radio range around random hotspots of that square
+ *
+ * The root always sits in the middle of the deployment. leaderProb and
+ * ringSize take comma separated lists; every combination is run "runs"
+ * times with consecutive RngRun numbers and each run appends one line to
+ * the metrics CSV file:
+ *
+ * layout,nodes,leaderProb,ringSize,run,setupMs,runMs,events,txFrames,txBytes,keyNeighbors,keyMean,keyMax,readers,contributors,coverage,accuracy,messages,latency
+ *
+ * txBytes counts every frame handed to a PHY, i.e. the bytes on air without
+ * preambles. keyNeighbors is the mean number of neighbors whose key rings a
+ * node heard, keyMean and keyMax the mean and maximum time until a node heard
+ * the last of them. accuracy is the aggregate reported at the root divided by the
+ * sum of all readings taken in the round, coverage the share of all nodes,
+ * root included, that made it into the aggregate.
+ *
+ * With replicate, each sweep point is built once, with the first RngRun,
+ * and its runs are forked from it by a ReplicationRunner, jobs at a time.
+ * The runs then share the layout and the key rings, and setupMs is the
+ * setup paid once for all of them.
  */
 //=============================================================================
 // CPDA PROTOTYPE
@@ -60,23 +85,60 @@ public:
 	Cpda();
 	/// Configure script parameters, \return true on successful configuration
 	bool Configure(int argc, char **argv);
+	/// Run all runs of the sweep
+	void RunSweep();
 	/// Run simulation
 	void Run();
+	/// Build the scenario of the current sweep point
+	void Build();
+	/// Run the built scenario
+	void Simulate();
+	/// Destroy the scenario
+	void Teardown();
+	/// Run a replication of the built scenario, forked by a ReplicationRunner
+	void Replicate(uint64_t replicationRun, std::ostream & os);
 	/// Report results
 	void Report(std::ostream & os);
 
 private:
 	// parameters
-	/// Number of nodes
+	/// Number of sensor nodes
 	uint32_t size;
 	/// Distance between nodes, meters
 	double step;
+	/// Radio range, meters
+	double range;
 	/// Simulation time, seconds
 	double totalTime;
+	/// Node placement: grid, random or clustered
+	std::string layout;
+	/// Number of hotspots of the clustered layout, 0 for one per 50 nodes
+	uint32_t hotspots;
+	/// Cluster leader probabilities to sweep
+	std::string leaderProbs;
+	/// Key ring sizes to sweep
+	std::string ringSizes;
+	/// Runs per sweep point
+	uint32_t runs;
+	/// Install AODV, CPDA itself only needs one hop broadcasts
+	bool aodv;
+	/// Write a NetAnim trace if true
+	bool anim;
 	/// Write per-device PCAP traces if true
 	bool pcap;
 	/// Print routes if true
 	bool printRoutes;
+	/// File the per-run metrics are appended to
+	std::string metricsFile;
+	/// Build each sweep point once and fork its runs
+	bool replicate;
+	/// Runs forked at once, 0 for one per processor
+	uint32_t jobs;
+
+	// current run
+	double leaderProb;
+	uint32_t ringSize;
+	uint32_t run;
 
 	// network
 	NodeContainer nodes;
@@ -84,19 +146,66 @@ private:
 	NodeContainer senNodes;
 	NetDeviceContainer devices;
 	Ipv4InterfaceContainer interfaces;
+	AnimationInterface * animation;
+
+	// metrics
+	int64_t setupMs;
+	int64_t runMs;
+	uint64_t events;
+	uint64_t txFrames;
+	uint64_t txBytes;
+	uint32_t keyNodes;
+	uint64_t keyNeighbors;
+	double keySum;
+	double keyMax;
+	uint32_t readers;
+	std::vector<uint64_t> truth;
+	bool haveResult;
+	std::vector<uint32_t> sums;
+	uint16_t contributors;
+	uint32_t messages;
+	Time latency;
 
 private:
 	void CreateNodes();
 	void CreateDevices();
 	void InstallInternetStack();
+	void InstallCpda();
 	void InstallApplications();
+	void Reset();
+	void PhyTxBegin(Ptr<const Packet> packet);
+	void KeyDiscovery(uint32_t neighbors, Time completion);
+	void Reading(uint32_t round, const std::vector<uint32_t> & readings);
+	void Result(uint32_t round, const std::vector<uint32_t> & roundSums, uint16_t roundContributors,
+			uint32_t roundMessages, Time roundLatency);
 };
 
+/// Split a comma separated list
+template<typename T>
+static std::vector<T> ParseList(const std::string & list) {
+	std::vector<T> values;
+	std::istringstream is(list);
+	std::string item;
+	while (std::getline(is, item, ',')) {
+		std::istringstream iis(item);
+		T value;
+		if (!(iis >> value)) {
+			NS_FATAL_ERROR("Bad list element \"" << item << "\" in \"" << list << "\"");
+		}
+		values.push_back(value);
+	}
+	return values;
+}
+
 //=============================================================================
 // CPDA CODE
 //=============================================================================
 Cpda::Cpda() :
-		size(NODE_NUM), step(NODE_STEP), totalTime(TOTAL_TIME), pcap(false), printRoutes(false) {
+		size(NODE_NUM), step(NODE_STEP), range(NODE_RANGE), totalTime(TOTAL_TIME), layout("grid"),
+		hotspots(0), leaderProbs("0.25"), ringSizes("200"), runs(1), aodv(true), anim(false),
+		pcap(false), printRoutes(false), metricsFile("cpda-metrics.csv"), replicate(false),
+		jobs(0), leaderProb(0.25), ringSize(200), run(1), animation(0) {
+	Reset();
 }
 
 bool Cpda::Configure(int argc, char **argv) {
@@ -108,48 +217,214 @@ bool Cpda::Configure(int argc, char **argv) {
 
 	cmd.AddValue("pcap", "Write PCAP traces.", pcap);
 	cmd.AddValue("printRoutes", "Print routing table dumps.", printRoutes);
-	cmd.AddValue("size", "Number of nodes.", size);
+	cmd.AddValue("size", "Number of sensor nodes.", size);
 	cmd.AddValue("time", "Simulation time, s.", totalTime);
 	cmd.AddValue("step", "Grid step, m", step);
+	cmd.AddValue("range", "Radio range, m", range);
+	cmd.AddValue("layout", "Node placement: grid, random or clustered.", layout);
+	cmd.AddValue("hotspots", "Hotspots of the clustered layout, 0 for one per 50 nodes.", hotspots);
+	cmd.AddValue("leaderProb", "Comma separated cluster leader probabilities to sweep.", leaderProbs);
+	cmd.AddValue("ringSize", "Comma separated key ring sizes to sweep.", ringSizes);
+	cmd.AddValue("runs", "Runs per sweep point.", runs);
+	cmd.AddValue("aodv", "Install AODV routing.", aodv);
+	cmd.AddValue("anim", "Write the NetAnim trace cpda-anim.xml.", anim);
+	cmd.AddValue("metrics", "CSV file the per-run metrics are appended to.", metricsFile);
+	cmd.AddValue("replicate", "Build each sweep point once and fork its runs.", replicate);
+	cmd.AddValue("jobs", "Runs forked at once with replicate, 0 for one per processor.", jobs);
 
 	cmd.Parse(argc, argv);
-	return true;
+	if (layout != "grid" && layout != "random" && layout != "clustered") {
+		std::cerr << "Unknown layout " << layout << "\n";
+		return false;
+	}
+	return size > 0 && runs > 0;
+}
+
+void Cpda::RunSweep() {
+	std::vector<double> probs = ParseList<double>(leaderProbs);
+	std::vector<uint32_t> rings = ParseList<uint32_t>(ringSizes);
+
+	std::ofstream os(metricsFile.c_str(), std::ios::out | std::ios::app);
+	if (!os) {
+		NS_FATAL_ERROR("Can not open " << metricsFile);
+	}
+	if (os.tellp() == 0) {
+		os << "layout,nodes,leaderProb,ringSize,run,setupMs,runMs,events,txFrames,txBytes,"
+				"keyNeighbors,keyMean,keyMax,readers,contributors,coverage,accuracy,messages,latency\n";
+	}
+	uint32_t baseRun = RngSeedManager::GetRun();
+	for (std::vector<double>::const_iterator p = probs.begin(); p != probs.end(); ++p) {
+		for (std::vector<uint32_t>::const_iterator r = rings.begin(); r != rings.end(); ++r) {
+			if (replicate) {
+				leaderProb = *p;
+				ringSize = *r;
+				run = baseRun;
+				RngSeedManager::SetRun(run);
+				Build();
+				ReplicationRunner runner(jobs);
+				std::ostringstream reports;
+				uint32_t failed = runner.Run(baseRun, runs, MakeCallback(&Cpda::Replicate, this), reports);
+				os << reports.str();
+				std::cout << reports.str();
+				if (failed > 0) {
+					std::cerr << failed << " of " << runs << " runs failed\n";
+				}
+				Teardown();
+				continue;
+			}
+			for (uint32_t i = 0; i < runs; ++i) {
+				leaderProb = *p;
+				ringSize = *r;
+				run = baseRun + i;
+				RngSeedManager::SetRun(run);
+				Run();
+				Report(os);
+				Report(std::cout);
+			}
+		}
+	}
 }
 
 void Cpda::Run() {
+	Build();
+	Simulate();
+	Teardown();
+}
+
+void Cpda::Replicate(uint64_t replicationRun, std::ostream & os) {
+	run = replicationRun;
+	Simulate();
+	Report(os);
+}
+
+void Cpda::Build() {
 //  Config::SetDefault ("ns3::WifiRemoteStationManager::RtsCtsThreshold", UintegerValue (1)); // enable rts cts all the time.
+	Reset();
+	Config::SetDefault("ns3::CpdaApplication::LeaderProbability", DoubleValue(leaderProb));
+	Config::SetDefault("ns3::CpdaApplication::KeyRingSize", UintegerValue(ringSize));
+
+	SystemWallClockMs clock;
+	clock.Start();
 	CreateNodes();
 	CreateDevices();
 	InstallInternetStack();
+	InstallCpda();
 	//InstallApplications();
+	Config::ConnectWithoutContext("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/PhyTxBegin",
+			MakeCallback(&Cpda::PhyTxBegin, this));
+
+	if (anim) {
+		// Configure NetAnim
+		animation = new AnimationInterface("cpda-anim.xml");
+
+		// Configure root node
+		animation->UpdateNodeDescription(rootNode.Get(0), "ROOT"); // animation line
+		animation->UpdateNodeColor(rootNode.Get(0), 0, 255, 0); // Optional
+		animation->UpdateNodeSize(rootNode.Get(0)->GetId(), 10, 10);
+
+		// Configure sensor nodes
+		for (uint32_t i = 0; i < senNodes.GetN(); ++i) {
+			animation->UpdateNodeDescription(senNodes.Get(i), "STA"); // animation line
+			animation->UpdateNodeColor(senNodes.Get(i), 255, 0, 0); // Optional
+			animation->UpdateNodeSize(senNodes.Get(i)->GetId(), 10, 10);
+		}
+	}
+	setupMs = clock.End();
+}
 
+void Cpda::Simulate() {
 	std::cout << "Starting simulation for " << totalTime << " s ...\n";
+	SystemWallClockMs clock;
+	clock.Start();
+	Simulator::Stop(Seconds(totalTime));
+	Simulator::Run();
+	runMs = clock.End();
+	events = Simulator::GetEventCount();
+}
 
-	// Configure NetAnim
-	AnimationInterface anim("cpda-anim.xml");
-
-	// Configure root node
-	anim.UpdateNodeDescription(rootNode.Get(0), "ROOT"); // animation line
-	anim.UpdateNodeColor(rootNode.Get(0), 0, 255, 0); // Optional
-	anim.UpdateNodeSize(rootNode.Get(0)->GetId(), 10, 10);
+void Cpda::Teardown() {
+	delete animation;
+	animation = 0;
+	Simulator::Destroy();
+	Names::Clear();
+	nodes = NodeContainer();
+	rootNode = NodeContainer();
+	senNodes = NodeContainer();
+	devices = NetDeviceContainer();
+	interfaces = Ipv4InterfaceContainer();
+}
 
-	// Configure sensor nodes
-	for (uint32_t i = 0; i < senNodes.GetN(); ++i) {
-		anim.UpdateNodeDescription(senNodes.Get(i), "STA"); // animation line
-		anim.UpdateNodeColor(senNodes.Get(i), 255, 0, 0); // Optional
-		anim.UpdateNodeSize(senNodes.Get(i)->GetId(), 10, 10);
+void Cpda::Report(std::ostream & os) {
+	uint64_t sum = 0;
+	uint64_t expected = 0;
+	for (uint32_t i = 0; i < truth.size(); ++i) {
+		expected += truth[i];
+		sum += haveResult && i < sums.size() ? sums[i] : 0;
 	}
+	double accuracy = expected == 0 ? 0 : double(sum) / expected;
+	double coverage = double(contributors) / (size + 1);
+	double meanNeighbors = keyNodes == 0 ? 0 : double(keyNeighbors) / keyNodes;
+	double meanKey = keyNodes == 0 ? 0 : keySum / keyNodes;
+
+	os << layout << ',' << size << ',' << leaderProb << ',' << ringSize << ',' << run << ','
+			<< setupMs << ',' << runMs << ',' << events << ',' << txFrames << ',' << txBytes << ','
+			<< meanNeighbors << ',' << meanKey << ',' << keyMax << ',' << readers << ',' << contributors << ',' << coverage << ',' << accuracy << ','
+			<< messages << ',' << latency.GetSeconds() << std::endl;
+}
 
-	Simulator::Stop(Seconds(totalTime));
-	Simulator::Run();
-	Simulator::Destroy();
+void Cpda::Reset() {
+	setupMs = 0;
+	runMs = 0;
+	events = 0;
+	txFrames = 0;
+	txBytes = 0;
+	keyNodes = 0;
+	keyNeighbors = 0;
+	keySum = 0;
+	keyMax = 0;
+	readers = 0;
+	truth.clear();
+	haveResult = false;
+	sums.clear();
+	contributors = 0;
+	messages = 0;
+	latency = Seconds(0);
+}
+
+void Cpda::PhyTxBegin(Ptr<const Packet> packet) {
+	txFrames++;
+	txBytes += packet->GetSize();
 }
 
-void Cpda::Report(std::ostream &) {
+void Cpda::KeyDiscovery(uint32_t neighbors, Time completion) {
+	keyNodes++;
+	keyNeighbors += neighbors;
+	keySum += completion.GetSeconds();
+	keyMax = std::max(keyMax, completion.GetSeconds());
+}
+
+void Cpda::Reading(uint32_t round, const std::vector<uint32_t> & readings) {
+	readers++;
+	truth.resize(std::max(truth.size(), readings.size()), 0);
+	for (uint32_t i = 0; i < readings.size(); ++i) {
+		truth[i] += readings[i];
+	}
+}
+
+void Cpda::Result(uint32_t round, const std::vector<uint32_t> & roundSums, uint16_t roundContributors,
+		uint32_t roundMessages, Time roundLatency) {
+	haveResult = true;
+	sums = roundSums;
+	contributors = roundContributors;
+	messages = roundMessages;
+	latency = roundLatency;
 }
 
 void Cpda::CreateNodes() {
-	std::cout << "Creating " << (unsigned) size << " nodes " << step << " m apart.\n";
+	uint32_t width = std::ceil(std::sqrt(double(size)));
+	double side = width * step;
+	std::cout << "Creating " << (unsigned) size << " nodes, " << layout << " layout over "
+			<< side << " m x " << side << " m.\n";
 
 	// Create root and sensor
 	rootNode.Create(1);
@@ -165,24 +440,45 @@ void Cpda::CreateNodes() {
 		Names::Add(os.str(), nodes.Get(i));
 	}
 
-	// Place root in top middle of grid 3x3 grid
 	MobilityHelper mobility;
 	mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
 
-	// Place the root node at (100,0)
-	mobility.SetPositionAllocator("ns3::GridPositionAllocator",
-			"MinX", DoubleValue(50.0),
-			"MinY", DoubleValue(0.0));
+	// Place the root in the middle of the deployment, between grid points
+	Ptr<ListPositionAllocator> rootPosition = CreateObject<ListPositionAllocator>();
+	rootPosition->Add(Vector((width - 1) * step / 2 + step / 2, (width - 1) * step / 2 + step / 2, 0));
+	mobility.SetPositionAllocator(rootPosition);
 	mobility.Install(rootNode);
 
-	// Make grid of sensor nodes starting at (0,100)
-	mobility.SetPositionAllocator("ns3::GridPositionAllocator",
-			"MinX", DoubleValue(0.0),
-			"MinY", DoubleValue(100.0),
-			"DeltaX", DoubleValue(50),
-			"DeltaY", DoubleValue(100),
-			"GridWidth", UintegerValue(3),
-			"LayoutType", StringValue("RowFirst"));
+	if (layout == "grid") {
+		mobility.SetPositionAllocator("ns3::GridPositionAllocator",
+				"MinX", DoubleValue(0.0),
+				"MinY", DoubleValue(0.0),
+				"DeltaX", DoubleValue(step),
+				"DeltaY", DoubleValue(step),
+				"GridWidth", UintegerValue(width),
+				"LayoutType", StringValue("RowFirst"));
+	} else if (layout == "random") {
+		std::ostringstream bound;
+		bound << "ns3::UniformRandomVariable[Min=0.0|Max=" << side << "]";
+		mobility.SetPositionAllocator("ns3::RandomRectanglePositionAllocator",
+				"X", StringValue(bound.str()),
+				"Y", StringValue(bound.str()));
+	} else {
+		uint32_t n = hotspots > 0 ? hotspots : std::max<uint32_t>(1, size / 50);
+		Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable>();
+		std::vector<Vector> centers;
+		for (uint32_t i = 0; i < n; ++i) {
+			centers.push_back(Vector(uniform->GetValue(0, side), uniform->GetValue(0, side), 0));
+		}
+		Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator>();
+		for (uint32_t i = 0; i < size; ++i) {
+			Vector const & center = centers[i % n];
+			double rho = range * std::sqrt(uniform->GetValue());
+			double theta = uniform->GetValue(0, 2 * M_PI);
+			positions->Add(Vector(center.x + rho * std::cos(theta), center.y + rho * std::sin(theta), 0));
+		}
+		mobility.SetPositionAllocator(positions);
+	}
 	mobility.Install(senNodes);
 }
 
@@ -191,12 +487,12 @@ void Cpda::CreateDevices() {
 	wifiMac.SetType("ns3::AdhocWifiMac");
 	YansWifiPhyHelper wifiPhy = YansWifiPhyHelper::Default();
 
-	// Set wifi propgation Disk model with 100m
+	// Set wifi propgation Disk model with the radio range
 	YansWifiChannelHelper wifiChannel;
 	//YansWifiChannelHelper wifiChannel = YansWifiChannelHelper::Default();
 
 	wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
-	wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue(150));
+	wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue(range));
 	wifiPhy.SetChannel(wifiChannel.Create());
 
 	WifiHelper wifi;
@@ -210,25 +506,37 @@ void Cpda::CreateDevices() {
 }
 
 void Cpda::InstallInternetStack() {
-	AodvHelper aodv;
-	// you can configure AODV attributes here using aodv.Set(name, value)
+	AodvHelper aodvRouting;
+	// you can configure AODV attributes here using aodvRouting.Set(name, value)
 	InternetStackHelper stack;
-	stack.SetRoutingHelper(aodv); // has effect on the next Install ()
-	stack.Install(senNodes);
-
-	// Set root node attribute
-	aodv.Set("EnableQueryNode", BooleanValue(true));
-	stack.SetRoutingHelper(aodv); // has effect on the next Install ()
-	stack.Install(rootNode);
+	if (aodv) {
+		stack.SetRoutingHelper(aodvRouting); // has effect on the next Install ()
+	}
+	stack.Install(nodes);
 
 	Ipv4AddressHelper address;
 	address.SetBase("10.0.0.0", "255.0.0.0");
 	interfaces = address.Assign(devices);
 
-	if (printRoutes) {
+	if (printRoutes && aodv) {
 		Ptr<OutputStreamWrapper> routingStream = Create<OutputStreamWrapper>(
 				"aodv.routes", std::ios::out);
-		aodv.PrintRoutingTableAllAt(Seconds(8), routingStream);
+		aodvRouting.PrintRoutingTableAllAt(Seconds(8), routingStream);
+	}
+}
+
+void Cpda::InstallCpda() {
+	CpdaHelper cpda;
+	ApplicationContainer apps = cpda.Install(senNodes);
+
+	// Set root node attribute
+	cpda.SetAttribute("Root", BooleanValue(true));
+	apps.Add(cpda.Install(rootNode));
+
+	for (uint32_t i = 0; i < apps.GetN(); ++i) {
+		apps.Get(i)->TraceConnectWithoutContext("KeyDiscovery", MakeCallback(&Cpda::KeyDiscovery, this));
+		apps.Get(i)->TraceConnectWithoutContext("Reading", MakeCallback(&Cpda::Reading, this));
+		apps.Get(i)->TraceConnectWithoutContext("Result", MakeCallback(&Cpda::Result, this));
 	}
 }
 
@@ -302,8 +610,7 @@ int main(int argc, char **argv) {
 	if (!test.Configure(argc, argv))
 		NS_FATAL_ERROR("Configuration failed. Aborted.");
 
-	test.Run();
-	test.Report(std::cout);
+	test.RunSweep();
 	return 0;
 }
 
@@ -0,0 +1,232 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/aodv-id-cache.h"
+
+/**
+ * \file
+ * Benchmark of duplicate detection during floods.
+ *
+ * Places nodes at random in a square and connects those within range.
+ * Floods start from random nodes at a fixed interval; every node checks each
+ * copy it hears against its aodv::IdCache and rebroadcasts the first one
+ * after a random jitter, as AODV does for RREQs and broadcast data. The
+ * same floods run once with a linear scan cache (the former IdCache) and
+ * once with aodv::IdCache, whose lifetime defaults to the AODV
+ * PathDiscoveryTime. Both must see the same duplicates.
+ *
+ * \verbatim
+   ./waf --run="aodv-flood-bench --nodes=1000 --floods=200"
+   \endverbatim
+ */
+
+using namespace ns3;
+using namespace ns3::aodv;
+
+namespace {
+
+/// Linear scan cache, purged on every lookup: the former IdCache
+class NaiveIdCache
+{
+public:
+  NaiveIdCache (Time lifetime) : m_lifetime (lifetime) {}
+  bool IsDuplicate (Ipv4Address addr, uint32_t id)
+  {
+    m_ids.erase (std::remove_if (m_ids.begin (), m_ids.end (), IsExpired ()), m_ids.end ());
+    for (std::vector<UniqueId>::const_iterator i = m_ids.begin (); i != m_ids.end (); ++i)
+      {
+        if (i->m_context == addr && i->m_id == id)
+          {
+            return true;
+          }
+      }
+    UniqueId u = { addr, id, m_lifetime + Simulator::Now () };
+    m_ids.push_back (u);
+    return false;
+  }
+
+private:
+  struct UniqueId
+  {
+    Ipv4Address m_context;
+    uint32_t m_id;
+    Time m_expire;
+  };
+  struct IsExpired
+  {
+    bool operator() (UniqueId const & u) const
+    {
+      return (u.m_expire < Simulator::Now ());
+    }
+  };
+  std::vector<UniqueId> m_ids;
+  Time m_lifetime;
+};
+
+/// Random geometric graph
+struct Topology
+{
+  std::vector<std::vector<uint32_t> > neighbors;   ///< Adjacency lists
+  uint64_t links;                                  ///< Number of directed links
+};
+
+Topology
+MakeTopology (uint32_t nodes, double side, double range)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+  std::vector<double> x (nodes), y (nodes);
+  for (uint32_t i = 0; i < nodes; ++i)
+    {
+      x[i] = rng->GetValue (0, side);
+      y[i] = rng->GetValue (0, side);
+    }
+  Topology t;
+  t.neighbors.resize (nodes);
+  t.links = 0;
+  for (uint32_t i = 0; i < nodes; ++i)
+    {
+      for (uint32_t j = 0; j < nodes; ++j)
+        {
+          double dx = x[i] - x[j];
+          double dy = y[i] - y[j];
+          if (i != j && dx * dx + dy * dy <= range * range)
+            {
+              t.neighbors[i].push_back (j);
+              ++t.links;
+            }
+        }
+    }
+  return t;
+}
+
+/// Floods over the topology with one Cache per node
+template <typename Cache>
+class Flood
+{
+public:
+  Flood (Topology const & t, Time lifetime)
+    : m_topology (t),
+      m_caches (t.neighbors.size (), Cache (lifetime)),
+      m_received (0),
+      m_duplicates (0)
+  {
+    m_rng = CreateObject<UniformRandomVariable> ();
+    m_rng->SetStream (2);
+  }
+  /// Run the floods, return the CPU time in seconds
+  double Run (uint32_t floods, Time interval)
+  {
+    for (uint32_t f = 0; f < floods; ++f)
+      {
+        uint32_t origin = m_rng->GetInteger (0, m_caches.size () - 1);
+        Simulator::Schedule (interval * f, &Flood::Start, this, origin, f);
+      }
+    clock_t start = clock ();
+    Simulator::Run ();
+    double cpu = double (clock () - start) / CLOCKS_PER_SEC;
+    Simulator::Destroy ();
+    return cpu;
+  }
+  uint64_t GetReceived () const { return m_received; }
+  uint64_t GetDuplicates () const { return m_duplicates; }
+
+private:
+  static Ipv4Address GetAddress (uint32_t node) { return Ipv4Address (0x0a000001 + node); }
+  void Start (uint32_t origin, uint32_t id)
+  {
+    m_caches[origin].IsDuplicate (GetAddress (origin), id);
+    Broadcast (origin, origin, id);
+  }
+  void Broadcast (uint32_t node, uint32_t origin, uint32_t id)
+  {
+    std::vector<uint32_t> const & n = m_topology.neighbors[node];
+    for (std::vector<uint32_t>::const_iterator i = n.begin (); i != n.end (); ++i)
+      {
+        ++m_received;
+        if (m_caches[*i].IsDuplicate (GetAddress (origin), id))
+          {
+            ++m_duplicates;
+            continue;
+          }
+        Time jitter = MicroSeconds (m_rng->GetInteger (0, 10000));
+        Simulator::Schedule (jitter, &Flood::Broadcast, this, *i, origin, id);
+      }
+  }
+
+  Topology const & m_topology;
+  std::vector<Cache> m_caches;
+  Ptr<UniformRandomVariable> m_rng;
+  uint64_t m_received;
+  uint64_t m_duplicates;
+};
+
+} // namespace
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nodes = 1000;
+  double side = 1000;
+  double range = 100;
+  uint32_t floods = 200;
+  Time interval = MilliSeconds (20);
+  // AODV PathDiscoveryTime = 2 * NetTraversalTime = 4 * NetDiameter * NodeTraversalTime
+  Time lifetime = MilliSeconds (5600);
+
+  CommandLine cmd;
+  cmd.AddValue ("nodes", "Number of nodes", nodes);
+  cmd.AddValue ("side", "Side of the square the nodes are placed in (m)", side);
+  cmd.AddValue ("range", "Radio range (m)", range);
+  cmd.AddValue ("floods", "Number of floods", floods);
+  cmd.AddValue ("interval", "Time between flood starts", interval);
+  cmd.AddValue ("lifetime", "Lifetime of the cached IDs", lifetime);
+  cmd.Parse (argc, argv);
+
+  if (nodes == 0 || floods == 0)
+    {
+      std::cerr << "nodes and floods must be positive" << std::endl;
+      return 1;
+    }
+
+  Topology t = MakeTopology (nodes, side, range);
+  Flood<NaiveIdCache> reference (t, lifetime);
+  double naive = reference.Run (floods, interval);
+  Flood<IdCache> hashed (t, lifetime);
+  double fast = hashed.Run (floods, interval);
+
+  bool match = reference.GetReceived () == hashed.GetReceived ()
+    && reference.GetDuplicates () == hashed.GetDuplicates ();
+  std::cout << "nodes " << nodes << " mean degree " << double (t.links) / nodes
+            << " floods " << floods << " receptions " << hashed.GetReceived () << std::endl;
+  std::cout << std::fixed << std::setprecision (3)
+            << "linear scan   " << std::setw (8) << naive << " s" << std::endl
+            << "IdCache       " << std::setw (8) << fast << " s" << std::endl;
+  if (fast > 0)
+    {
+      std::cout << "speedup       " << std::setw (8) << naive / fast << std::endl;
+    }
+  std::cout << "duplicates " << (match ? "match" : "DIFFER")
+            << " (" << hashed.GetDuplicates () << ")" << std::endl;
+  return match ? 0 : 1;
+}
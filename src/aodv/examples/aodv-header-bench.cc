@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+#include "ns3/core-module.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/udp-header.h"
+#include "ns3/aodv-packet.h"
+
+/**
+ * \file
+ * Microbenchmark of the header serialization of AODV control packets.
+ *
+ * Times Packet::AddHeader and Packet::RemoveHeader for the headers of a
+ * RREQ and of a RREP as sent by the routing protocol: the AODV message
+ * and type headers under UDP and IPv4, which are all FixedSizeHeader.
+ * Each header is also timed alone.  \c --checksum enables the IPv4 and
+ * UDP checksums, whose computation then dominates.  \c --printing
+ * records the packet metadata of the given fraction of the packets, as
+ * Packet::EnableSampledPrinting does; 1 is Packet::EnablePrinting.
+ *
+ * \verbatim
+   ./waf --run="aodv-header-bench --iterations=1000000"
+   ./waf --run="aodv-header-bench --printing=0.01"
+   \endverbatim
+ */
+
+using namespace ns3;
+using namespace ns3::aodv;
+
+namespace {
+
+/// Print one measurement
+void
+Report (std::string name, clock_t start, uint64_t iterations, uint64_t sum)
+{
+  double ns = double (clock () - start) / CLOCKS_PER_SEC * 1e9 / iterations;
+  std::cout << std::left << std::setw (16) << name << std::right
+            << std::fixed << std::setprecision (1) << std::setw (10) << ns << " ns/op"
+            << "  (" << sum << ")" << std::endl;
+}
+
+/// Time adding then removing one header to a packet
+template <typename H>
+void
+TimeHeader (std::string name, H const &header, uint64_t iterations)
+{
+  Ptr<Packet> p = Create<Packet> ();
+  uint64_t sum = 0;
+  clock_t start = clock ();
+  for (uint64_t i = 0; i < iterations; i++)
+    {
+      p->AddHeader (header);
+      H h;
+      sum += p->RemoveHeader (h);
+    }
+  Report (name, start, iterations, sum);
+}
+
+} // namespace
+
+int main (int argc, char *argv[])
+{
+  uint64_t iterations = 1000000;
+  bool checksum = false;
+  double printing = 0;
+
+  CommandLine cmd;
+  cmd.AddValue ("iterations", "Number of operations timed", iterations);
+  cmd.AddValue ("checksum", "Compute the IPv4 and UDP checksums", checksum);
+  cmd.AddValue ("printing", "Fraction of the packets whose metadata is recorded", printing);
+  cmd.Parse (argc, argv);
+
+  if (printing >= 1)
+    {
+      Packet::EnablePrinting ();
+    }
+  else if (printing > 0)
+    {
+      Packet::EnableSampledPrinting (printing);
+    }
+
+  Ipv4Address origin ("10.0.0.1");
+  Ipv4Address dst ("10.0.0.42");
+  RreqHeader rreq (0, 0, 3, 7, dst, 11, origin, 13);
+  RrepHeader rrep (0, 2, dst, 17, origin, MilliSeconds (3000));
+  UdpHeader udp;
+  udp.SetSourcePort (654);
+  udp.SetDestinationPort (654);
+  Ipv4Header ipv4;
+  ipv4.SetSource (origin);
+  ipv4.SetDestination (Ipv4Address ("10.255.255.255"));
+  ipv4.SetProtocol (17);
+  ipv4.SetTtl (1);
+  ipv4.SetPayloadSize (udp.GetSerializedSize () + TypeHeader::SERIALIZED_SIZE
+                       + RreqHeader::SERIALIZED_SIZE);
+  if (checksum)
+    {
+      udp.InitializeChecksum (origin, Ipv4Address ("10.255.255.255"), 17);
+      udp.EnableChecksums ();
+      ipv4.EnableChecksum ();
+    }
+
+  TimeHeader ("ipv4", ipv4, iterations);
+  TimeHeader ("udp", udp, iterations);
+  TimeHeader ("aodv type", TypeHeader (AODVTYPE_RREQ), iterations);
+  TimeHeader ("aodv rreq", rreq, iterations);
+  TimeHeader ("aodv rrep", rrep, iterations);
+
+  // the whole stack of a RREQ, then of a RREP, as the protocol builds it
+  uint64_t sum = 0;
+  clock_t start = clock ();
+  for (uint64_t i = 0; i < iterations; i++)
+    {
+      Ptr<Packet> p = Create<Packet> ();
+      if (i & 1)
+        {
+          p->AddHeader (rrep);
+          p->AddHeader (TypeHeader (AODVTYPE_RREP));
+        }
+      else
+        {
+          p->AddHeader (rreq);
+          p->AddHeader (TypeHeader (AODVTYPE_RREQ));
+        }
+      p->AddHeader (udp);
+      p->AddHeader (ipv4);
+
+      Ipv4Header ipv4Rx;
+      UdpHeader udpRx;
+      TypeHeader typeRx;
+      p->RemoveHeader (ipv4Rx);
+      p->RemoveHeader (udpRx);
+      p->RemoveHeader (typeRx);
+      if (typeRx.Get () == AODVTYPE_RREQ)
+        {
+          RreqHeader rreqRx;
+          p->RemoveHeader (rreqRx);
+          sum += rreqRx.GetOriginSeqno ();
+        }
+      else
+        {
+          RrepHeader rrepRx;
+          p->RemoveHeader (rrepRx);
+          sum += rrepRx.GetDstSeqno ();
+        }
+    }
+  Report ("control packet", start, iterations, sum);
+
+  return 0;
+}
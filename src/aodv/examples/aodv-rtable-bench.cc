@@ -0,0 +1,183 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+
+#include "ns3/core-module.h"
+#include "ns3/aodv-rtable.h"
+#include "ns3/aodv-indexed-rtable.h"
+
+/**
+ * \file
+ * Microbenchmark of the AODV routing table.
+ *
+ * Replays the same stream of operations on aodv::RoutingTable, which purges
+ * the whole table before every lookup, and on aodv::IndexedRoutingTable.
+ * Every step of simulated time performs a batch of operations the way the
+ * routing protocol does while forwarding: lookups, lifetime refreshes of
+ * active routes, new routes and link breaks. Both tables must give the same
+ * answers.
+ *
+ * \verbatim
+   ./waf --run="aodv-rtable-bench --routes=1000 --steps=2000 --ops=50"
+   \endverbatim
+ */
+
+using namespace ns3;
+using namespace ns3::aodv;
+
+namespace {
+
+/// Operation stream parameters
+struct Workload
+{
+  uint32_t routes;    ///< Number of destinations
+  uint32_t steps;     ///< Number of time steps
+  uint32_t ops;       ///< Operations per step
+  Time step;          ///< Simulated time between steps
+};
+
+/// Operation stream driver for one table type
+template <typename Table>
+class Replay
+{
+public:
+  Replay (Workload const & w)
+    : m_w (w),
+      m_table (Seconds (3)),
+      m_found (0),
+      m_valid (0)
+  {
+    m_rng = CreateObject<UniformRandomVariable> ();
+    m_rng->SetStream (1);
+  }
+  /// Run the stream, return the CPU time in seconds
+  double Run ()
+  {
+    for (uint32_t s = 0; s < m_w.steps; ++s)
+      {
+        Simulator::Schedule (m_w.step * s, &Replay::Step, this);
+      }
+    clock_t start = clock ();
+    Simulator::Run ();
+    double cpu = double (clock () - start) / CLOCKS_PER_SEC;
+    Simulator::Destroy ();
+    return cpu;
+  }
+  uint64_t GetFound () const { return m_found; }
+  uint64_t GetValid () const { return m_valid; }
+
+private:
+  void Step ()
+  {
+    for (uint32_t i = 0; i < m_w.ops; ++i)
+      {
+        Ipv4Address dst (0x0a000000 + 1 + m_rng->GetInteger (0, m_w.routes - 1));
+        uint32_t op = m_rng->GetInteger (0, 99);
+        Time lifetime = MilliSeconds (m_rng->GetInteger (500, 3000));
+        RoutingTableEntry rt;
+        if (op < 70)
+          {
+            // forwarding: lookup, refresh the lifetime of an active route
+            if (m_table.LookupRoute (dst, rt))
+              {
+                ++m_found;
+                if (rt.GetFlag () == VALID)
+                  {
+                    ++m_valid;
+                    rt.SetLifeTime (std::max (lifetime, rt.GetLifeTime ()));
+                    m_table.Update (rt);
+                  }
+              }
+          }
+        else if (op < 95)
+          {
+            // route reply or hello: add or revalidate
+            if (m_table.LookupRoute (dst, rt))
+              {
+                rt.SetFlag (VALID);
+                rt.SetLifeTime (lifetime);
+                m_table.Update (rt);
+              }
+            else
+              {
+                RoutingTableEntry added (/*output device*/ 0, dst, /*validSeqNo*/ true, /*seqNo*/ 0,
+                                         Ipv4InterfaceAddress (), /*hop*/ 1, dst, lifetime);
+                m_table.AddRoute (added);
+              }
+          }
+        else
+          {
+            // link break
+            std::map<Ipv4Address, uint32_t> unreachable;
+            m_table.GetListOfDestinationWithNextHop (dst, unreachable);
+            m_table.InvalidateRoutesWithDst (unreachable);
+          }
+      }
+  }
+
+  Workload m_w;
+  Table m_table;
+  Ptr<UniformRandomVariable> m_rng;
+  uint64_t m_found;
+  uint64_t m_valid;
+};
+
+} // namespace
+
+int
+main (int argc, char *argv[])
+{
+  Workload w;
+  w.routes = 1000;
+  w.steps = 2000;
+  w.ops = 50;
+  w.step = MilliSeconds (10);
+
+  CommandLine cmd;
+  cmd.AddValue ("routes", "Number of destinations", w.routes);
+  cmd.AddValue ("steps", "Number of time steps", w.steps);
+  cmd.AddValue ("ops", "Table operations per time step", w.ops);
+  cmd.AddValue ("step", "Simulated time between steps", w.step);
+  cmd.Parse (argc, argv);
+
+  if (w.routes == 0 || w.steps == 0 || w.ops == 0)
+    {
+      std::cerr << "routes, steps and ops must be positive" << std::endl;
+      return 1;
+    }
+
+  Replay<RoutingTable> reference (w);
+  double naive = reference.Run ();
+  Replay<IndexedRoutingTable> indexed (w);
+  double fast = indexed.Run ();
+
+  bool match = reference.GetFound () == indexed.GetFound ()
+    && reference.GetValid () == indexed.GetValid ();
+  std::cout << "routes " << w.routes << " steps " << w.steps << " ops " << w.ops << std::endl;
+  std::cout << std::fixed << std::setprecision (3)
+            << "RoutingTable        " << std::setw (8) << naive << " s" << std::endl
+            << "IndexedRoutingTable " << std::setw (8) << fast << " s" << std::endl;
+  if (fast > 0)
+    {
+      std::cout << "speedup             " << std::setw (8) << naive / fast << std::endl;
+    }
+  std::cout << "lookups " << (match ? "match" : "DIFFER")
+            << " (" << indexed.GetFound () << " found, " << indexed.GetValid () << " valid)" << std::endl;
+  return match ? 0 : 1;
+}
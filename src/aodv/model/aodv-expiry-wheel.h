@@ -0,0 +1,181 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef AODV_EXPIRY_WHEEL_H
+#define AODV_EXPIRY_WHEEL_H
+
+#include "ns3/nstime.h"
+#include "ns3/assert.h"
+#include <algorithm>
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+namespace ns3
+{
+namespace aodv
+{
+/**
+ * \ingroup aodv
+ *
+ * \brief Timing wheel of (key, expiration time) records.
+ *
+ * Records are hashed into slots by expiration time rounded down to the
+ * resolution, so collecting the expired ones only visits the slots that
+ * elapsed since the previous call, instead of every key in a table.
+ * Records cannot be cancelled: the owner keeps the current expiration
+ * time of each key and ignores the records that no longer match it.
+ */
+template <typename Key>
+class ExpiryWheel
+{
+public:
+  /// Expired record: key and the expiration time it was scheduled with
+  typedef std::pair<Key, Time> Record;
+
+  /**
+   * c-tor
+   * \param resolution width of a slot
+   * \param slots number of slots
+   */
+  ExpiryWheel (Time resolution = MilliSeconds (50), uint32_t slots = 128);
+  /// Add a record for key expiring at the absolute time expire
+  void Schedule (Key key, Time expire);
+  /**
+   * Remove the records whose expiration time is strictly before now and
+   * append them to due.
+   */
+  void Expire (Time now, std::vector<Record> & due);
+  /// Remove all records
+  void Clear ();
+  /// Return number of records, expired or not
+  uint32_t GetSize () const { return m_size; }
+
+private:
+  /// Scheduled record
+  struct Entry
+  {
+    Key m_key;        ///< Key
+    Time m_expire;    ///< Absolute expiration time
+    int64_t m_tick;   ///< Tick of the slot the record is in
+  };
+  /// Tick containing time t
+  int64_t GetTick (Time t) const { return t.GetTimeStep () / m_resolution; }
+
+  /// Slots, the record with tick t is in slot t % size
+  std::vector<std::vector<Entry> > m_slots;
+  /// Slot width in time steps
+  int64_t m_resolution;
+  /// Tick of the last Expire call, records are never scheduled before it
+  int64_t m_tick;
+  /// Number of records
+  uint32_t m_size;
+};
+
+template <typename Key>
+ExpiryWheel<Key>::ExpiryWheel (Time resolution, uint32_t slots)
+  : m_slots (slots),
+    m_resolution (resolution.GetTimeStep ()),
+    m_tick (0),
+    m_size (0)
+{
+  NS_ASSERT (m_resolution > 0 && slots > 0);
+}
+
+template <typename Key>
+void
+ExpiryWheel<Key>::Schedule (Key key, Time expire)
+{
+  Entry e;
+  e.m_key = key;
+  e.m_expire = expire;
+  // records in the past go to the current slot, which the next call visits
+  e.m_tick = std::max (GetTick (expire), m_tick);
+  m_slots[e.m_tick % m_slots.size ()].push_back (e);
+  ++m_size;
+}
+
+template <typename Key>
+void
+ExpiryWheel<Key>::Expire (Time now, std::vector<Record> & due)
+{
+  int64_t tick = GetTick (now);
+  if (tick < m_tick)
+    {
+      // time went back, e.g. a new simulation after Simulator::Destroy:
+      // refile every record relative to the new current tick
+      std::vector<Entry> all;
+      for (uint32_t i = 0; i < m_slots.size (); ++i)
+        {
+          all.insert (all.end (), m_slots[i].begin (), m_slots[i].end ());
+          m_slots[i].clear ();
+        }
+      m_size = 0;
+      m_tick = tick;
+      for (typename std::vector<Entry>::const_iterator i = all.begin (); i != all.end (); ++i)
+        {
+          if (i->m_expire < now)
+            {
+              due.push_back (std::make_pair (i->m_key, i->m_expire));
+            }
+          else
+            {
+              Schedule (i->m_key, i->m_expire);
+            }
+        }
+      return;
+    }
+  if (m_size != 0)
+    {
+      // the current slot is visited again by the next call, since
+      // records later in this tick are not due yet
+      int64_t count = std::min<int64_t> (tick - m_tick + 1, m_slots.size ());
+      for (int64_t t = m_tick; t < m_tick + count; ++t)
+        {
+          std::vector<Entry> & slot = m_slots[t % m_slots.size ()];
+          for (uint32_t i = 0; i < slot.size ();)
+            {
+              Entry const & e = slot[i];
+              if (e.m_tick < tick || (e.m_tick == tick && e.m_expire < now))
+                {
+                  due.push_back (std::make_pair (e.m_key, e.m_expire));
+                  slot[i] = slot.back ();
+                  slot.pop_back ();
+                  --m_size;
+                }
+              else
+                {
+                  ++i;
+                }
+            }
+        }
+    }
+  m_tick = tick;
+}
+
+template <typename Key>
+void
+ExpiryWheel<Key>::Clear ()
+{
+  for (uint32_t i = 0; i < m_slots.size (); ++i)
+    {
+      m_slots[i].clear ();
+    }
+  m_size = 0;
+}
+
+}
+}
+#endif /* AODV_EXPIRY_WHEEL_H */
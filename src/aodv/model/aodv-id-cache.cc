@@ -26,7 +26,6 @@
  *          Pavel Boyko <boyko@iitp.ru>
  */
 #include "aodv-id-cache.h"
-#include <algorithm>
 
 namespace ns3
 {
@@ -36,27 +35,31 @@ bool
 IdCache::IsDuplicate (Ipv4Address addr, uint32_t id)
 {
   Purge ();
-  for (std::vector<UniqueId>::const_iterator i = m_idCache.begin ();
-       i != m_idCache.end (); ++i)
-    if (i->m_context == addr && i->m_id == id)
-      return true;
-  struct UniqueId uniqueId =
-  { addr, id, m_lifetime + Simulator::Now () };
-  m_idCache.push_back (uniqueId);
+  uint64_t key = GetKey (addr, id);
+  Time expire = m_lifetime + Simulator::Now ();
+  if (!m_idCache.Insert (key, expire).second)
+    return true;
+  m_expiry.Schedule (key, expire);
   return false;
 }
 void
 IdCache::Purge ()
 {
-  m_idCache.erase (remove_if (m_idCache.begin (), m_idCache.end (),
-                              IsExpired ()), m_idCache.end ());
+  m_expiry.Expire (Simulator::Now (), m_due);
+  for (std::vector<ExpiryWheel<uint64_t>::Record>::const_iterator i = m_due.begin ();
+       i != m_due.end (); ++i)
+    {
+      // an ID is never refreshed, so its only record cannot be stale
+      m_idCache.Erase (i->first);
+    }
+  m_due.clear ();
 }
 
 uint32_t
 IdCache::GetSize ()
 {
   Purge ();
-  return m_idCache.size ();
+  return m_idCache.GetSize ();
 }
 
 }
@@ -31,6 +31,8 @@
 
 #include "ns3/ipv4-address.h"
 #include "ns3/simulator.h"
+#include "ns3/flat-map.h"
+#include "aodv-expiry-wheel.h"
 #include <vector>
 
 namespace ns3
@@ -41,6 +43,9 @@ namespace aodv
  * \ingroup aodv
  * 
  * \brief Unique packets identification cache used for simple duplicate detection.
+ *
+ * IDs are hashed, and their expiration times are kept in an ExpiryWheel, so
+ * both the lookup and the purge that precedes it take constant time per ID.
  */
 class IdCache
 {
@@ -58,25 +63,17 @@ public:
   /// Return lifetime for existing entries in cache
   Time GetLifeTime () const { return m_lifetime; }
 private:
-  /// Unique packet ID
-  struct UniqueId
-  {
-    /// ID is supposed to be unique in single address context (e.g. sender address)
-    Ipv4Address m_context;
-    /// The id
-    uint32_t m_id;
-    /// When record will expire
-    Time m_expire;
-  };
-  struct IsExpired
+  /// Pack (addr, id) into a cache key
+  static uint64_t GetKey (Ipv4Address addr, uint32_t id)
   {
-    bool operator() (const struct UniqueId & u) const
-    {
-      return (u.m_expire < Simulator::Now ());
-    }
-  };
-  /// Already seen IDs
-  std::vector<UniqueId> m_idCache;
+    return (uint64_t (addr.Get ()) << 32) | id;
+  }
+  /// Already seen IDs, and when they expire. ID is supposed to be unique in single address context (e.g. sender address)
+  FlatMap<uint64_t, Time> m_idCache;
+  /// Expiration times of the IDs
+  ExpiryWheel<uint64_t> m_expiry;
+  /// Scratch list of expired IDs, kept to avoid reallocations
+  std::vector<ExpiryWheel<uint64_t>::Record> m_due;
   /// Default lifetime for ID records
   Time m_lifetime;
 };
@@ -0,0 +1,288 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "aodv-indexed-rtable.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE ("AodvIndexedRoutingTable");
+
+namespace aodv
+{
+
+IndexedRoutingTable::IndexedRoutingTable (Time t)
+  : m_badLinkLifetime (t)
+{
+}
+
+void
+IndexedRoutingTable::Reschedule (uint32_t dst, Slot & slot)
+{
+  Time now = Simulator::Now ();
+  Time expire = slot.m_entry.GetLifeTime () + now;
+  // an entry that is already due needs a new record even if its expiration
+  // time did not change: the record it had may have been dropped while the
+  // entry was IN_SEARCH
+  if (expire != slot.m_expire || expire < now)
+    {
+      slot.m_expire = expire;
+      m_wheel.Schedule (dst, expire);
+    }
+}
+
+bool
+IndexedRoutingTable::LookupRoute (Ipv4Address id, RoutingTableEntry & rt)
+{
+  NS_LOG_FUNCTION (this << id);
+  Purge ();
+  Slot const * slot = m_entries.Find (id.Get ());
+  if (slot == 0)
+    {
+      NS_LOG_LOGIC ("Route to " << id << " not found");
+      return false;
+    }
+  rt = slot->m_entry;
+  NS_LOG_LOGIC ("Route to " << id << " found");
+  return true;
+}
+
+bool
+IndexedRoutingTable::LookupValidRoute (Ipv4Address id, RoutingTableEntry & rt)
+{
+  NS_LOG_FUNCTION (this << id);
+  if (!LookupRoute (id, rt))
+    {
+      NS_LOG_LOGIC ("Route to " << id << " not found");
+      return false;
+    }
+  NS_LOG_LOGIC ("Route to " << id << " flag is " << ((rt.GetFlag () == VALID) ? "valid" : "not valid"));
+  return (rt.GetFlag () == VALID);
+}
+
+bool
+IndexedRoutingTable::DeleteRoute (Ipv4Address dst)
+{
+  NS_LOG_FUNCTION (this << dst);
+  Purge ();
+  if (m_entries.Erase (dst.Get ()))
+    {
+      NS_LOG_LOGIC ("Route deletion to " << dst << " successful");
+      return true;
+    }
+  NS_LOG_LOGIC ("Route deletion to " << dst << " not successful");
+  return false;
+}
+
+bool
+IndexedRoutingTable::AddRoute (RoutingTableEntry & rt)
+{
+  NS_LOG_FUNCTION (this);
+  Purge ();
+  if (rt.GetFlag () != IN_SEARCH)
+    {
+      rt.SetRreqCnt (0);
+    }
+  uint32_t dst = rt.GetDestination ().Get ();
+  Slot slot;
+  slot.m_entry = rt;
+  std::pair<Slot *, bool> result = m_entries.Insert (dst, slot);
+  if (result.second)
+    {
+      result.first->m_expire = rt.GetLifeTime () + Simulator::Now ();
+      m_wheel.Schedule (dst, result.first->m_expire);
+    }
+  return result.second;
+}
+
+bool
+IndexedRoutingTable::Update (RoutingTableEntry & rt)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t dst = rt.GetDestination ().Get ();
+  Slot * slot = m_entries.Find (dst);
+  if (slot == 0)
+    {
+      NS_LOG_LOGIC ("Route update to " << rt.GetDestination () << " fails; not found");
+      return false;
+    }
+  slot->m_entry = rt;
+  if (slot->m_entry.GetFlag () != IN_SEARCH)
+    {
+      NS_LOG_LOGIC ("Route update to " << rt.GetDestination () << " set RreqCnt to 0");
+      slot->m_entry.SetRreqCnt (0);
+    }
+  Reschedule (dst, *slot);
+  return true;
+}
+
+bool
+IndexedRoutingTable::SetEntryState (Ipv4Address id, RouteFlags state)
+{
+  NS_LOG_FUNCTION (this);
+  Slot * slot = m_entries.Find (id.Get ());
+  if (slot == 0)
+    {
+      NS_LOG_LOGIC ("Route set entry state to " << id << " fails; not found");
+      return false;
+    }
+  slot->m_entry.SetFlag (state);
+  slot->m_entry.SetRreqCnt (0);
+  Reschedule (id.Get (), *slot);
+  NS_LOG_LOGIC ("Route set entry state to " << id << ": new state is " << state);
+  return true;
+}
+
+void
+IndexedRoutingTable::GetListOfDestinationWithNextHop (Ipv4Address nextHop, std::map<Ipv4Address, uint32_t> & unreachable)
+{
+  NS_LOG_FUNCTION (this);
+  Purge ();
+  unreachable.clear ();
+  for (FlatMap<uint32_t, Slot>::const_iterator i = m_entries.Begin (); i != m_entries.End (); ++i)
+    {
+      RoutingTableEntry const & rt = i->second.m_entry;
+      if (rt.GetNextHop () == nextHop)
+        {
+          NS_LOG_LOGIC ("Unreachable insert " << rt.GetDestination () << " " << rt.GetSeqNo ());
+          unreachable.insert (std::make_pair (rt.GetDestination (), rt.GetSeqNo ()));
+        }
+    }
+}
+
+void
+IndexedRoutingTable::InvalidateRoutesWithDst (const std::map<Ipv4Address, uint32_t> & unreachable)
+{
+  NS_LOG_FUNCTION (this);
+  Purge ();
+  for (std::map<Ipv4Address, uint32_t>::const_iterator j = unreachable.begin ();
+       j != unreachable.end (); ++j)
+    {
+      Slot * slot = m_entries.Find (j->first.Get ());
+      if (slot != 0 && slot->m_entry.GetFlag () == VALID)
+        {
+          NS_LOG_LOGIC ("Invalidate route with destination address " << j->first);
+          slot->m_entry.Invalidate (m_badLinkLifetime);
+          Reschedule (j->first.Get (), *slot);
+        }
+    }
+}
+
+void
+IndexedRoutingTable::DeleteAllRoutesFromInterface (Ipv4InterfaceAddress iface)
+{
+  NS_LOG_FUNCTION (this);
+  for (FlatMap<uint32_t, Slot>::iterator i = m_entries.Begin (); i != m_entries.End ();)
+    {
+      if (i->second.m_entry.GetInterface () == iface)
+        {
+          i = m_entries.Erase (i);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
+void
+IndexedRoutingTable::Clear ()
+{
+  m_entries.Clear ();
+  m_wheel.Clear ();
+}
+
+void
+IndexedRoutingTable::Purge ()
+{
+  NS_LOG_FUNCTION (this);
+  m_wheel.Expire (Simulator::Now (), m_due);
+  for (std::vector<ExpiryWheel<uint32_t>::Record>::const_iterator i = m_due.begin ();
+       i != m_due.end (); ++i)
+    {
+      Slot * slot = m_entries.Find (i->first);
+      if (slot == 0 || slot->m_expire != i->second)
+        {
+          // the entry was deleted or its lifetime changed since
+          continue;
+        }
+      if (slot->m_entry.GetFlag () == INVALID)
+        {
+          m_entries.Erase (i->first);
+        }
+      else if (slot->m_entry.GetFlag () == VALID)
+        {
+          NS_LOG_LOGIC ("Invalidate route with destination address " << Ipv4Address (i->first));
+          slot->m_entry.Invalidate (m_badLinkLifetime);
+          Reschedule (i->first, *slot);
+        }
+      // IN_SEARCH entries stay; SetEntryState and Update reschedule them
+    }
+  m_due.clear ();
+}
+
+bool
+IndexedRoutingTable::MarkLinkAsUnidirectional (Ipv4Address neighbor, Time blacklistTimeout)
+{
+  NS_LOG_FUNCTION (this << neighbor << blacklistTimeout.GetSeconds ());
+  Slot * slot = m_entries.Find (neighbor.Get ());
+  if (slot == 0)
+    {
+      NS_LOG_LOGIC ("Mark link unidirectional to  " << neighbor << " fails; not found");
+      return false;
+    }
+  slot->m_entry.SetUnidirectional (true);
+  slot->m_entry.SetBalcklistTimeout (blacklistTimeout);
+  slot->m_entry.SetRreqCnt (0);
+  NS_LOG_LOGIC ("Set link to " << neighbor << " to unidirectional");
+  return true;
+}
+
+void
+IndexedRoutingTable::Print (Ptr<OutputStreamWrapper> stream) const
+{
+  // print in address order with the outdated entries purged, like RoutingTable
+  std::map<Ipv4Address, RoutingTableEntry> table;
+  for (FlatMap<uint32_t, Slot>::const_iterator i = m_entries.Begin (); i != m_entries.End (); ++i)
+    {
+      RoutingTableEntry rt = i->second.m_entry;
+      if (rt.GetLifeTime () < Seconds (0))
+        {
+          if (rt.GetFlag () == INVALID)
+            {
+              continue;
+            }
+          if (rt.GetFlag () == VALID)
+            {
+              rt.Invalidate (m_badLinkLifetime);
+            }
+        }
+      table.insert (std::make_pair (Ipv4Address (i->first), rt));
+    }
+  *stream->GetStream () << "\nAODV Routing table\n"
+                        << "Destination\tGateway\t\tInterface\tFlag\tExpire\t\tHops\n";
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i =
+         table.begin (); i != table.end (); ++i)
+    {
+      i->second.Print (stream);
+    }
+  *stream->GetStream () << "\n";
+}
+
+}
+}
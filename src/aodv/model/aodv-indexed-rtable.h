@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef AODV_INDEXED_RTABLE_H
+#define AODV_INDEXED_RTABLE_H
+
+#include "aodv-rtable.h"
+#include "ns3/flat-map.h"
+#include "aodv-expiry-wheel.h"
+#include <map>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+namespace aodv {
+
+/**
+ * \ingroup aodv
+ * \brief The routing table used by AODV protocol, indexed by destination
+ *
+ * Behaves like RoutingTable, but keeps the entries in a hash table and
+ * their expiration times in an ExpiryWheel. The purge that precedes
+ * lookups, additions and deletions then only touches the entries that
+ * expired since the previous one, instead of scanning the whole table.
+ */
+class IndexedRoutingTable
+{
+public:
+  /// c-tor
+  IndexedRoutingTable (Time t);
+  ///\name Handle life time of invalid route
+  //\{
+  Time GetBadLinkLifetime () const { return m_badLinkLifetime; }
+  void SetBadLinkLifetime (Time t) { m_badLinkLifetime = t; }
+  //\}
+  /**
+   * Add routing table entry if it doesn't yet exist in routing table
+   * \param r routing table entry
+   * \return true in success
+   */
+  bool AddRoute (RoutingTableEntry & r);
+  /**
+   * Delete routing table entry with destination address dst, if it exists.
+   * \param dst destination address
+   * \return true on success
+   */
+  bool DeleteRoute (Ipv4Address dst);
+  /**
+   * Lookup routing table entry with destination address dst
+   * \param dst destination address
+   * \param rt entry with destination address dst, if exists
+   * \return true on success
+   */
+  bool LookupRoute (Ipv4Address dst, RoutingTableEntry & rt);
+  /// Lookup route in VALID state
+  bool LookupValidRoute (Ipv4Address dst, RoutingTableEntry & rt);
+  /// Update routing table
+  bool Update (RoutingTableEntry & rt);
+  /// Set routing table entry flags
+  bool SetEntryState (Ipv4Address dst, RouteFlags state);
+  /// Lookup routing entries with next hop Address dst and not empty list of precursors.
+  void GetListOfDestinationWithNextHop (Ipv4Address nextHop, std::map<Ipv4Address, uint32_t> & unreachable);
+  /// \copydoc RoutingTable::InvalidateRoutesWithDst
+  void InvalidateRoutesWithDst (std::map<Ipv4Address, uint32_t> const & unreachable);
+  /// Delete all route from interface with address iface
+  void DeleteAllRoutesFromInterface (Ipv4InterfaceAddress iface);
+  /// Delete all entries from routing table
+  void Clear ();
+  /// Delete all outdated entries and invalidate valid entry if Lifetime is expired
+  void Purge ();
+  /// \copydoc RoutingTable::MarkLinkAsUnidirectional
+  bool MarkLinkAsUnidirectional (Ipv4Address neighbor, Time blacklistTimeout);
+  /// Print routing table
+  void Print (Ptr<OutputStreamWrapper> stream) const;
+  /// Return number of entries
+  uint32_t GetSize () const { return m_entries.GetSize (); }
+
+private:
+  /// Routing table entry and the expiration time it was last scheduled with
+  struct Slot
+  {
+    RoutingTableEntry m_entry;  ///< Entry
+    Time m_expire;              ///< Absolute expiration time in the wheel
+  };
+  /// Schedule the expiration of slot if it changed or the entry already expired
+  void Reschedule (uint32_t dst, Slot & slot);
+
+  /// Entries by destination address
+  FlatMap<uint32_t, Slot> m_entries;
+  /// Expiration times of the entries
+  ExpiryWheel<uint32_t> m_wheel;
+  /// Scratch list of expired wheel records, kept to avoid reallocations
+  std::vector<ExpiryWheel<uint32_t>::Record> m_due;
+  /// Deletion time for invalid routes
+  Time m_badLinkLifetime;
+};
+
+}
+}
+
+#endif /* AODV_INDEXED_RTABLE_H */
@@ -39,7 +39,8 @@ NS_LOG_COMPONENT_DEFINE ("AodvNeighbors");
 namespace aodv
 {
 Neighbors::Neighbors (Time delay) : 
-  m_ntimer (Timer::CANCEL_ON_DESTROY)
+  m_ntimer (Timer::CANCEL_ON_DESTROY),
+  m_nextOrder (0)
 {
   m_ntimer.SetDelay (delay);
   m_ntimer.SetFunction (&Neighbors::Purge, this);
@@ -50,74 +51,98 @@ bool
 Neighbors::IsNeighbor (Ipv4Address addr)
 {
   Purge ();
-  for (std::vector<Neighbor>::const_iterator i = m_nb.begin ();
-       i != m_nb.end (); ++i)
-    {
-      if (i->m_neighborAddress == addr)
-        return true;
-    }
-  return false;
+  return m_nb.Find (addr.Get ()) != 0;
 }
 
 Time
 Neighbors::GetExpireTime (Ipv4Address addr)
 {
   Purge ();
-  for (std::vector<Neighbor>::const_iterator i = m_nb.begin (); i
-       != m_nb.end (); ++i)
-    {
-      if (i->m_neighborAddress == addr)
-        return (i->m_expireTime - Simulator::Now ());
-    }
+  Slot const * slot = m_nb.Find (addr.Get ());
+  if (slot != 0)
+    return (slot->m_neighbor.m_expireTime - Simulator::Now ());
   return Seconds (0);
 }
 
 void
 Neighbors::Update (Ipv4Address addr, Time expire)
 {
-  for (std::vector<Neighbor>::iterator i = m_nb.begin (); i != m_nb.end (); ++i)
-    if (i->m_neighborAddress == addr)
-      {
-        i->m_expireTime
-          = std::max (expire + Simulator::Now (), i->m_expireTime);
-        if (i->m_hardwareAddress == Mac48Address ())
-          i->m_hardwareAddress = LookupMacAddress (i->m_neighborAddress);
-        return;
-      }
+  Slot * slot = m_nb.Find (addr.Get ());
+  if (slot != 0)
+    {
+      Neighbor & i = slot->m_neighbor;
+      Time old = i.m_expireTime;
+      i.m_expireTime
+        = std::max (expire + Simulator::Now (), i.m_expireTime);
+      if (i.m_expireTime != old)
+        m_expiry.Schedule (addr.Get (), i.m_expireTime);
+      if (i.m_hardwareAddress == Mac48Address ())
+        i.m_hardwareAddress = LookupMacAddress (i.m_neighborAddress);
+      return;
+    }
 
   NS_LOG_LOGIC ("Open link to " << addr);
-  Neighbor neighbor (addr, LookupMacAddress (addr), expire + Simulator::Now ());
-  m_nb.push_back (neighbor);
+  Slot added = { Neighbor (addr, LookupMacAddress (addr), expire + Simulator::Now ()), m_nextOrder++ };
+  m_nb.Insert (addr.Get (), added);
+  m_expiry.Schedule (addr.Get (), added.m_neighbor.m_expireTime);
   Purge ();
 }
 
-struct CloseNeighbor
+void
+Neighbors::Clear ()
+{
+  m_nb.Clear ();
+  m_expiry.Clear ();
+  m_closed.clear ();
+}
+
+/// Order closed links by the time their neighbors were added
+struct CloseOrder
 {
-  bool operator() (const Neighbors::Neighbor & nb) const
+  bool operator() (std::pair<uint64_t, Ipv4Address> const & a,
+                   std::pair<uint64_t, Ipv4Address> const & b) const
   {
-    return ((nb.m_expireTime < Simulator::Now ()) || nb.close);
+    return a.first < b.first;
   }
 };
 
 void
 Neighbors::Purge ()
 {
-  if (m_nb.empty ())
+  if (m_nb.IsEmpty ())
     return;
 
-  CloseNeighbor pred;
+  Time now = Simulator::Now ();
+  std::vector<ExpiryWheel<uint32_t>::Record> due;
+  m_expiry.Expire (now, due);
+  std::vector<std::pair<uint64_t, Ipv4Address> > closed;
+  for (std::vector<ExpiryWheel<uint32_t>::Record>::const_iterator j = due.begin (); j != due.end (); ++j)
+    {
+      Slot const * slot = m_nb.Find (j->first);
+      // records of expiration times that were extended since are stale
+      if (slot != 0 && slot->m_neighbor.m_expireTime == j->second && !slot->m_neighbor.close)
+        closed.push_back (std::make_pair (slot->m_order, slot->m_neighbor.m_neighborAddress));
+    }
+  for (std::vector<uint32_t>::const_iterator j = m_closed.begin (); j != m_closed.end (); ++j)
+    {
+      Slot const * slot = m_nb.Find (*j);
+      if (slot != 0)
+        closed.push_back (std::make_pair (slot->m_order, slot->m_neighbor.m_neighborAddress));
+    }
+  m_closed.clear ();
+  std::sort (closed.begin (), closed.end (), CloseOrder ());
   if (!m_handleLinkFailure.IsNull ())
     {
-      for (std::vector<Neighbor>::iterator j = m_nb.begin (); j != m_nb.end (); ++j)
+      for (std::vector<std::pair<uint64_t, Ipv4Address> >::const_iterator j = closed.begin (); j != closed.end (); ++j)
         {
-          if (pred (*j))
-            {
-              NS_LOG_LOGIC ("Close link to " << j->m_neighborAddress);
-              m_handleLinkFailure (j->m_neighborAddress);
-            }
+          NS_LOG_LOGIC ("Close link to " << j->second);
+          m_handleLinkFailure (j->second);
         }
     }
-  m_nb.erase (std::remove_if (m_nb.begin (), m_nb.end (), pred), m_nb.end ());
+  for (std::vector<std::pair<uint64_t, Ipv4Address> >::const_iterator j = closed.begin (); j != closed.end (); ++j)
+    {
+      m_nb.Erase (j->second.Get ());
+    }
   m_ntimer.Cancel ();
   m_ntimer.Schedule ();
 }
@@ -163,13 +188,15 @@ Neighbors::ProcessTxError (WifiMacHeader const & hdr)
 {
   Mac48Address addr = hdr.GetAddr1 ();
 
-  for (std::vector<Neighbor>::iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+  for (FlatMap<uint32_t, Slot>::iterator i = m_nb.Begin (); i != m_nb.End (); ++i)
     {
-      if (i->m_hardwareAddress == addr)
-        i->close = true;
+      if (i->second.m_neighbor.m_hardwareAddress == addr)
+        {
+          i->second.m_neighbor.close = true;
+          m_closed.push_back (i->first);
+        }
     }
   Purge ();
 }
 }
 }
-
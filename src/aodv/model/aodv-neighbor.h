@@ -35,6 +35,8 @@
 #include "ns3/callback.h"
 #include "ns3/wifi-mac-header.h"
 #include "ns3/arp-cache.h"
+#include "ns3/flat-map.h"
+#include "aodv-expiry-wheel.h"
 #include <vector>
 
 namespace ns3
@@ -45,6 +47,10 @@ class RoutingProtocol;
 /**
  * \ingroup aodv
  * \brief maintain list of active neighbors
+ *
+ * Neighbors are hashed by address and their expiration times are kept in
+ * an ExpiryWheel, so lookups do not scan the list. Closed links are still
+ * reported in the order the neighbors were added.
  */
 class Neighbors
 {
@@ -76,7 +82,7 @@ public:
   /// Schedule m_ntimer.
   void ScheduleTimer ();
   /// Remove all entries
-  void Clear () { m_nb.clear (); }
+  void Clear ();
 
   /// Add ARP cache to be used to allow layer 2 notifications processing
   void AddArpCache (Ptr<ArpCache>);
@@ -97,8 +103,20 @@ private:
   Callback<void, WifiMacHeader const &> m_txErrorCallback;
   /// Timer for neighbor's list. Schedule Purge().
   Timer m_ntimer;
-  /// vector of entries
-  std::vector<Neighbor> m_nb;
+  /// Neighbor and its position in the order the neighbors were added
+  struct Slot
+  {
+    Neighbor m_neighbor;  ///< Neighbor
+    uint64_t m_order;     ///< Sequence number of the Update that added it
+  };
+  /// Entries by neighbor address
+  FlatMap<uint32_t, Slot> m_nb;
+  /// Expiration times of the entries
+  ExpiryWheel<uint32_t> m_expiry;
+  /// Sequence number of the next entry
+  uint64_t m_nextOrder;
+  /// Addresses of the entries closed by TX errors since the last Purge ()
+  std::vector<uint32_t> m_closed;
   /// list of ARP cached to be used for layer 2 notifications processing
   std::vector<Ptr<ArpCache> > m_arp;
 
@@ -55,35 +55,35 @@ TypeId TypeHeader::GetInstanceTypeId() const {
 	return GetTypeId();
 }
 
-uint32_t TypeHeader::GetSerializedSize() const {
-	return 1;
+void TypeHeader::Serialize(Buffer::Iterator start) const {
+	SerializeFixed(start);
 }
 
-void TypeHeader::Serialize(Buffer::Iterator i) const {
+template<typename W>
+void TypeHeader::SerializeFields(W &i, Buffer::Iterator start) const {
 	i.WriteU8((uint8_t) m_type);
 }
 
 uint32_t TypeHeader::Deserialize(Buffer::Iterator start) {
-	Buffer::Iterator i = start;
+	return DeserializeFixed(start);
+}
+
+template<typename R>
+uint32_t TypeHeader::DeserializeFields(R &i, Buffer::Iterator start) {
 	uint8_t type = i.ReadU8();
 	m_valid = true;
 	switch (type) {
 	case AODVTYPE_RREQ:
 	case AODVTYPE_RREP:
 	case AODVTYPE_RERR:
-	case AODVTYPE_RREP_ACK:
-	case CPDATYPE_KEY:
-	case CPDATYPE_QUERY:
-	case CPDATYPE_JOIN:{
+	case AODVTYPE_RREP_ACK: {
 		m_type = (MessageType) type;
 		break;
 	}
 	default:
 		m_valid = false;
 	}
-	uint32_t dist = i.GetDistanceFrom(start);
-	NS_ASSERT(dist == GetSerializedSize());
-	return dist;
+	return SERIALIZED_SIZE;
 }
 
 void TypeHeader::Print(std::ostream &os) const {
@@ -104,18 +104,6 @@ void TypeHeader::Print(std::ostream &os) const {
 		os << "RREP_ACK";
 		break;
 	}
-	case CPDATYPE_KEY: {
-		os << "CPDA_KEY";
-		break;
-	}
-	case CPDATYPE_QUERY: {
-		os << "CPDA_QUERY";
-		break;
-	}
-	case CPDATYPE_JOIN: {
-		os << "CPDA_JOIN";
-		break;
-	}
 	default:
 		os << "UNKNOWN_TYPE";
 	}
@@ -131,427 +119,6 @@ operator<<(std::ostream & os, TypeHeader const & h) {
 	return os;
 }
 
-
-
-
-//==============================================================
-//==============================================================
-//
-// CPDA - KEY EXCHANGE
-//
-//==============================================================
-//==============================================================
-//TODO: fix constructor
-CpdaKeyHeader::CpdaKeyHeader(uint8_t prefixSize, uint8_t hopCount, Ipv4Address dst,
-		uint32_t dstSeqNo, Ipv4Address origin, Time lifeTime) :
-
-		m_flags(0),
-		m_prefixSize(prefixSize),
-		m_hopCount(hopCount),
-		m_dst(dst),
-		m_dstSeqNo(dstSeqNo),
-		m_origin(origin),
-		m_key(200)
-{
-	m_lifeTime = uint32_t(lifeTime.GetMilliSeconds());
-
-}
-
-NS_OBJECT_ENSURE_REGISTERED(CpdaKeyHeader);
-TypeId CpdaKeyHeader::GetTypeId() {
-	static TypeId tid =
-			TypeId("ns3::aodv::CpdaKeyHeader").SetParent<Header>().SetGroupName(
-					"Aodv").AddConstructor<CpdaKeyHeader>();
-	return tid;
-}
-
-TypeId CpdaKeyHeader::GetInstanceTypeId() const {
-	return GetTypeId();
-}
-
-uint32_t CpdaKeyHeader::GetSerializedSize() const {
-	return 419;
-}
-
-void CpdaKeyHeader::Serialize(Buffer::Iterator i) const {
-	i.WriteU8(m_flags);
-	i.WriteU8(m_prefixSize);
-	i.WriteU8(m_hopCount);
-	WriteTo(i, m_dst);
-	i.WriteHtonU32(m_dstSeqNo);
-	WriteTo(i, m_origin);
-	i.WriteHtonU32(m_lifeTime);
-
-	//std::cout<<"ser: " << m_key[0] << std::endl;
-	// write keys
-	for(int x=0; x<200; x++){
-		i.WriteHtonU16(m_key[x]);
-	}
-}
-
-uint32_t CpdaKeyHeader::Deserialize(Buffer::Iterator start) {
-	Buffer::Iterator i = start;
-
-	m_flags = i.ReadU8();
-	m_prefixSize = i.ReadU8();
-	m_hopCount = i.ReadU8();
-	ReadFrom(i, m_dst);
-	m_dstSeqNo = i.ReadNtohU32();
-	ReadFrom(i, m_origin);
-	m_lifeTime = i.ReadNtohU32();
-	// read keys
-	for(int x=0; x<200; x++){
-		m_key[x] = i.ReadNtohU16();
-	}
-	//std::cout<<"des: " << m_key[0] << std::endl;
-	uint32_t dist = i.GetDistanceFrom(start);
-	NS_ASSERT(dist == GetSerializedSize());
-	return dist;
-}
-
-//TODO: add print of keys
-void CpdaKeyHeader::Print(std::ostream &os) const {
-	os << "destination: ipv4 " << m_dst << " sequence number " << m_dstSeqNo;
-	if (m_prefixSize != 0) {
-		os << " prefix size " << m_prefixSize;
-	}
-	os << " source ipv4 " << m_origin << " lifetime " << m_lifeTime
-			<< " acknowledgment required flag " << (*this).GetAckRequired();
-}
-
-void CpdaKeyHeader::SetLifeTime(Time t) {
-	m_lifeTime = t.GetMilliSeconds();
-}
-
-Time CpdaKeyHeader::GetLifeTime() const {
-	Time t(MilliSeconds(m_lifeTime));
-	return t;
-}
-
-void CpdaKeyHeader::SetAckRequired(bool f) {
-	if (f)
-		m_flags |= (1 << 6);
-	else
-		m_flags &= ~(1 << 6);
-}
-
-bool CpdaKeyHeader::GetAckRequired() const {
-	return (m_flags & (1 << 6));
-}
-
-void CpdaKeyHeader::SetPrefixSize(uint8_t sz) {
-	m_prefixSize = sz;
-}
-
-uint8_t CpdaKeyHeader::GetPrefixSize() const {
-	return m_prefixSize;
-}
-
-void CpdaKeyHeader::SetHello(Ipv4Address origin, uint32_t srcSeqNo,
-		Time lifetime) {
-	m_flags = 0;
-	m_prefixSize = 0;
-	m_hopCount = 0;
-	m_dst = origin;
-	m_dstSeqNo = srcSeqNo;
-	m_origin = origin;
-	m_lifeTime = lifetime.GetMilliSeconds();
-}
-
-//TODO: ADD FUNCTION TO CHECK FOR KEYS
-bool CpdaKeyHeader::operator==(CpdaKeyHeader const & o) const {
-	return (m_flags == o.m_flags && m_prefixSize == o.m_prefixSize
-			&& m_hopCount == o.m_hopCount && m_dst == o.m_dst
-			&& m_dstSeqNo == o.m_dstSeqNo && m_origin == o.m_origin
-			&& m_lifeTime == o.m_lifeTime);
-}
-
-std::ostream &
-operator<<(std::ostream & os, CpdaKeyHeader const & h) {
-	h.Print(os);
-	return os;
-}
-
-
-//==============================================================
-//==============================================================
-//
-// END CPDA - KEY EXCHANGE
-//
-//==============================================================
-//==============================================================
-
-//==============================================================
-//==============================================================
-//
-// CPDA - QUERY
-//
-//==============================================================
-//==============================================================
-//TODO: fix constructor
-CpdaQueryHeader::CpdaQueryHeader(uint8_t prefixSize, uint8_t hopCount, Ipv4Address dst,
-		uint32_t dstSeqNo, Ipv4Address origin, Time lifeTime) :
-		m_flags(0),
-		m_prefixSize(prefixSize),
-		m_hopCount(hopCount),
-		m_dst(dst),
-		m_dstSeqNo(dstSeqNo),
-		m_origin(origin)
-{
-	m_lifeTime = uint32_t(lifeTime.GetMilliSeconds());
-
-}
-
-NS_OBJECT_ENSURE_REGISTERED(CpdaQueryHeader);
-TypeId CpdaQueryHeader::GetTypeId() {
-	static TypeId tid =
-			TypeId("ns3::aodv::CpdaQueryHeader").SetParent<Header>().SetGroupName(
-					"Aodv").AddConstructor<CpdaQueryHeader>();
-	return tid;
-}
-
-TypeId CpdaQueryHeader::GetInstanceTypeId() const {
-	return GetTypeId();
-}
-
-//TODO: FIX BYTE SIZE
-uint32_t CpdaQueryHeader::GetSerializedSize() const {
-	return 19;
-}
-
-void CpdaQueryHeader::Serialize(Buffer::Iterator i) const {
-	i.WriteU8(m_flags);
-	i.WriteU8(m_prefixSize);
-	i.WriteU8(m_hopCount);
-	WriteTo(i, m_dst);
-	i.WriteHtonU32(m_dstSeqNo);
-	WriteTo(i, m_origin);
-	i.WriteHtonU32(m_lifeTime);
-}
-
-uint32_t CpdaQueryHeader::Deserialize(Buffer::Iterator start) {
-	Buffer::Iterator i = start;
-
-	m_flags = i.ReadU8();
-	m_prefixSize = i.ReadU8();
-	m_hopCount = i.ReadU8();
-	ReadFrom(i, m_dst);
-	m_dstSeqNo = i.ReadNtohU32();
-	ReadFrom(i, m_origin);
-	m_lifeTime = i.ReadNtohU32();
-
-	uint32_t dist = i.GetDistanceFrom(start);
-	NS_ASSERT(dist == GetSerializedSize());
-	return dist;
-}
-
-void CpdaQueryHeader::Print(std::ostream &os) const {
-	os << "destination: ipv4 " << m_dst << " sequence number " << m_dstSeqNo;
-	if (m_prefixSize != 0) {
-		os << " prefix size " << m_prefixSize;
-	}
-	os << " source ipv4 " << m_origin << " lifetime " << m_lifeTime
-			<< " acknowledgment required flag " << (*this).GetAckRequired();
-}
-
-void CpdaQueryHeader::SetLifeTime(Time t) {
-	m_lifeTime = t.GetMilliSeconds();
-}
-
-Time CpdaQueryHeader::GetLifeTime() const {
-	Time t(MilliSeconds(m_lifeTime));
-	return t;
-}
-
-void CpdaQueryHeader::SetAckRequired(bool f) {
-	if (f)
-		m_flags |= (1 << 6);
-	else
-		m_flags &= ~(1 << 6);
-}
-
-bool CpdaQueryHeader::GetAckRequired() const {
-	return (m_flags & (1 << 6));
-}
-
-void CpdaQueryHeader::SetPrefixSize(uint8_t sz) {
-	m_prefixSize = sz;
-}
-
-uint8_t CpdaQueryHeader::GetPrefixSize() const {
-	return m_prefixSize;
-}
-
-void CpdaQueryHeader::SetHello(Ipv4Address origin, uint32_t srcSeqNo,
-		Time lifetime) {
-	m_flags = 0;
-	m_prefixSize = 0;
-	m_hopCount = 0;
-	m_dst = origin;
-	m_dstSeqNo = srcSeqNo;
-	m_origin = origin;
-	m_lifeTime = lifetime.GetMilliSeconds();
-}
-
-//TODO: ADD FUNCTION TO CHECK FOR KEYS
-bool CpdaQueryHeader::operator==(CpdaQueryHeader const & o) const {
-	return (m_flags == o.m_flags && m_prefixSize == o.m_prefixSize
-			&& m_hopCount == o.m_hopCount && m_dst == o.m_dst
-			&& m_dstSeqNo == o.m_dstSeqNo && m_origin == o.m_origin
-			&& m_lifeTime == o.m_lifeTime);
-}
-
-std::ostream &
-operator<<(std::ostream & os, CpdaQueryHeader const & h) {
-	h.Print(os);
-	return os;
-}
-
-
-//==============================================================
-//==============================================================
-//
-// END CPDA - QUERY
-//
-//==============================================================
-//==============================================================
-
-//==============================================================
-//==============================================================
-//
-// CPDA - JOIN
-//
-//==============================================================
-//==============================================================
-//TODO: fix constructor
-CpdaJoinHeader::CpdaJoinHeader(uint8_t prefixSize, uint8_t hopCount, Ipv4Address dst,
-		uint32_t dstSeqNo, Ipv4Address origin, Time lifeTime) :
-		m_flags(0),
-		m_prefixSize(prefixSize),
-		m_hopCount(hopCount),
-		m_dst(dst),
-		m_dstSeqNo(dstSeqNo),
-		m_origin(origin)
-{
-	m_lifeTime = uint32_t(lifeTime.GetMilliSeconds());
-
-}
-
-NS_OBJECT_ENSURE_REGISTERED(CpdaJoinHeader);
-TypeId CpdaJoinHeader::GetTypeId() {
-	static TypeId tid =
-			TypeId("ns3::aodv::CpdaJoinHeader").SetParent<Header>().SetGroupName(
-					"Aodv").AddConstructor<CpdaJoinHeader>();
-	return tid;
-}
-
-TypeId CpdaJoinHeader::GetInstanceTypeId() const {
-	return GetTypeId();
-}
-
-//TODO: FIX BYTE SIZE
-uint32_t CpdaJoinHeader::GetSerializedSize() const {
-	return 19;
-}
-
-void CpdaJoinHeader::Serialize(Buffer::Iterator i) const {
-	i.WriteU8(m_flags);
-	i.WriteU8(m_prefixSize);
-	i.WriteU8(m_hopCount);
-	WriteTo(i, m_dst);
-	i.WriteHtonU32(m_dstSeqNo);
-	WriteTo(i, m_origin);
-	i.WriteHtonU32(m_lifeTime);
-}
-
-uint32_t CpdaJoinHeader::Deserialize(Buffer::Iterator start) {
-	Buffer::Iterator i = start;
-
-	m_flags = i.ReadU8();
-	m_prefixSize = i.ReadU8();
-	m_hopCount = i.ReadU8();
-	ReadFrom(i, m_dst);
-	m_dstSeqNo = i.ReadNtohU32();
-	ReadFrom(i, m_origin);
-	m_lifeTime = i.ReadNtohU32();
-
-	uint32_t dist = i.GetDistanceFrom(start);
-	NS_ASSERT(dist == GetSerializedSize());
-	return dist;
-}
-
-void CpdaJoinHeader::Print(std::ostream &os) const {
-	os << "destination: ipv4 " << m_dst << " sequence number " << m_dstSeqNo;
-	if (m_prefixSize != 0) {
-		os << " prefix size " << m_prefixSize;
-	}
-	os << " source ipv4 " << m_origin << " lifetime " << m_lifeTime
-			<< " acknowledgment required flag " << (*this).GetAckRequired();
-}
-
-void CpdaJoinHeader::SetLifeTime(Time t) {
-	m_lifeTime = t.GetMilliSeconds();
-}
-
-Time CpdaJoinHeader::GetLifeTime() const {
-	Time t(MilliSeconds(m_lifeTime));
-	return t;
-}
-
-void CpdaJoinHeader::SetAckRequired(bool f) {
-	if (f)
-		m_flags |= (1 << 6);
-	else
-		m_flags &= ~(1 << 6);
-}
-
-bool CpdaJoinHeader::GetAckRequired() const {
-	return (m_flags & (1 << 6));
-}
-
-void CpdaJoinHeader::SetPrefixSize(uint8_t sz) {
-	m_prefixSize = sz;
-}
-
-uint8_t CpdaJoinHeader::GetPrefixSize() const {
-	return m_prefixSize;
-}
-
-void CpdaJoinHeader::SetHello(Ipv4Address origin, uint32_t srcSeqNo,
-		Time lifetime) {
-	m_flags = 0;
-	m_prefixSize = 0;
-	m_hopCount = 0;
-	m_dst = origin;
-	m_dstSeqNo = srcSeqNo;
-	m_origin = origin;
-	m_lifeTime = lifetime.GetMilliSeconds();
-}
-
-//TODO: ADD FUNCTION TO CHECK FOR KEYS
-bool CpdaJoinHeader::operator==(CpdaJoinHeader const & o) const {
-	return (m_flags == o.m_flags && m_prefixSize == o.m_prefixSize
-			&& m_hopCount == o.m_hopCount && m_dst == o.m_dst
-			&& m_dstSeqNo == o.m_dstSeqNo && m_origin == o.m_origin
-			&& m_lifeTime == o.m_lifeTime);
-}
-
-std::ostream &
-operator<<(std::ostream & os, CpdaJoinHeader const & h) {
-	h.Print(os);
-	return os;
-}
-
-
-//==============================================================
-//==============================================================
-//
-// END CPDA - JOIN
-//
-//==============================================================
-//==============================================================
-
-
 //-----------------------------------------------------------------------------
 // RREQ
 //-----------------------------------------------------------------------------
@@ -576,35 +143,37 @@ TypeId RreqHeader::GetInstanceTypeId() const {
 	return GetTypeId();
 }
 
-uint32_t RreqHeader::GetSerializedSize() const {
-	return 23;
+void RreqHeader::Serialize(Buffer::Iterator start) const {
+	SerializeFixed(start);
 }
 
-void RreqHeader::Serialize(Buffer::Iterator i) const {
+template<typename W>
+void RreqHeader::SerializeFields(W &i, Buffer::Iterator start) const {
 	i.WriteU8(m_flags);
 	i.WriteU8(m_reserved);
 	i.WriteU8(m_hopCount);
 	i.WriteHtonU32(m_requestID);
-	WriteTo(i, m_dst);
+	i.WriteHtonU32(m_dst.Get());
 	i.WriteHtonU32(m_dstSeqNo);
-	WriteTo(i, m_origin);
+	i.WriteHtonU32(m_origin.Get());
 	i.WriteHtonU32(m_originSeqNo);
 }
 
 uint32_t RreqHeader::Deserialize(Buffer::Iterator start) {
-	Buffer::Iterator i = start;
+	return DeserializeFixed(start);
+}
+
+template<typename R>
+uint32_t RreqHeader::DeserializeFields(R &i, Buffer::Iterator start) {
 	m_flags = i.ReadU8();
 	m_reserved = i.ReadU8();
 	m_hopCount = i.ReadU8();
 	m_requestID = i.ReadNtohU32();
-	ReadFrom(i, m_dst);
+	m_dst.Set(i.ReadNtohU32());
 	m_dstSeqNo = i.ReadNtohU32();
-	ReadFrom(i, m_origin);
+	m_origin.Set(i.ReadNtohU32());
 	m_originSeqNo = i.ReadNtohU32();
-
-	uint32_t dist = i.GetDistanceFrom(start);
-	NS_ASSERT(dist == GetSerializedSize());
-	return dist;
+	return SERIALIZED_SIZE;
 }
 
 void RreqHeader::Print(std::ostream &os) const {
@@ -687,34 +256,35 @@ TypeId RrepHeader::GetInstanceTypeId() const {
 	return GetTypeId();
 }
 
-uint32_t RrepHeader::GetSerializedSize() const {
-	return 19;
+void RrepHeader::Serialize(Buffer::Iterator start) const {
+	SerializeFixed(start);
 }
 
-void RrepHeader::Serialize(Buffer::Iterator i) const {
+template<typename W>
+void RrepHeader::SerializeFields(W &i, Buffer::Iterator start) const {
 	i.WriteU8(m_flags);
 	i.WriteU8(m_prefixSize);
 	i.WriteU8(m_hopCount);
-	WriteTo(i, m_dst);
+	i.WriteHtonU32(m_dst.Get());
 	i.WriteHtonU32(m_dstSeqNo);
-	WriteTo(i, m_origin);
+	i.WriteHtonU32(m_origin.Get());
 	i.WriteHtonU32(m_lifeTime);
 }
 
 uint32_t RrepHeader::Deserialize(Buffer::Iterator start) {
-	Buffer::Iterator i = start;
+	return DeserializeFixed(start);
+}
 
+template<typename R>
+uint32_t RrepHeader::DeserializeFields(R &i, Buffer::Iterator start) {
 	m_flags = i.ReadU8();
 	m_prefixSize = i.ReadU8();
 	m_hopCount = i.ReadU8();
-	ReadFrom(i, m_dst);
+	m_dst.Set(i.ReadNtohU32());
 	m_dstSeqNo = i.ReadNtohU32();
-	ReadFrom(i, m_origin);
+	m_origin.Set(i.ReadNtohU32());
 	m_lifeTime = i.ReadNtohU32();
-
-	uint32_t dist = i.GetDistanceFrom(start);
-	NS_ASSERT(dist == GetSerializedSize());
-	return dist;
+	return SERIALIZED_SIZE;
 }
 
 void RrepHeader::Print(std::ostream &os) const {
@@ -799,20 +369,23 @@ TypeId RrepAckHeader::GetInstanceTypeId() const {
 	return GetTypeId();
 }
 
-uint32_t RrepAckHeader::GetSerializedSize() const {
-	return 1;
+void RrepAckHeader::Serialize(Buffer::Iterator start) const {
+	SerializeFixed(start);
 }
 
-void RrepAckHeader::Serialize(Buffer::Iterator i) const {
+template<typename W>
+void RrepAckHeader::SerializeFields(W &i, Buffer::Iterator start) const {
 	i.WriteU8(m_reserved);
 }
 
 uint32_t RrepAckHeader::Deserialize(Buffer::Iterator start) {
-	Buffer::Iterator i = start;
+	return DeserializeFixed(start);
+}
+
+template<typename R>
+uint32_t RrepAckHeader::DeserializeFields(R &i, Buffer::Iterator start) {
 	m_reserved = i.ReadU8();
-	uint32_t dist = i.GetDistanceFrom(start);
-	NS_ASSERT(dist == GetSerializedSize());
-	return dist;
+	return SERIALIZED_SIZE;
 }
 
 void RrepAckHeader::Print(std::ostream &os) const {
@@ -29,7 +29,7 @@
 #define AODVPACKET_H
 
 #include <iostream>
-#include "ns3/header.h"
+#include "ns3/fixed-size-header.h"
 #include "ns3/enum.h"
 #include "ns3/ipv4-address.h"
 #include <map>
@@ -44,16 +44,13 @@ enum MessageType
   AODVTYPE_RREP  = 2,   //!< AODVTYPE_RREP
   AODVTYPE_RERR  = 3,   //!< AODVTYPE_RERR
   AODVTYPE_RREP_ACK = 4, //!< AODVTYPE_RREP_ACK
-  CPDATYPE_KEY = 5,
-  CPDATYPE_QUERY = 6,
-  CPDATYPE_JOIN = 7,
 };
 
 /**
 * \ingroup aodv
 * \brief AODV types
 */
-class TypeHeader : public Header
+class TypeHeader : public FixedSizeHeader<TypeHeader, 1>
 {
 public:
   /// c-tor
@@ -62,7 +59,6 @@ public:
   // Header serialization/deserialization
   static TypeId GetTypeId ();
   TypeId GetInstanceTypeId () const;
-  uint32_t GetSerializedSize () const;
   void Serialize (Buffer::Iterator start) const;
   uint32_t Deserialize (Buffer::Iterator start);
   void Print (std::ostream &os) const;
@@ -73,6 +69,14 @@ public:
   bool IsValid () const { return m_valid; }
   bool operator== (TypeHeader const & o) const;
 private:
+  friend class FixedSizeHeader<TypeHeader, 1>;
+  /// Write the fields with \p i, see FixedSizeHeader
+  template <typename W>
+  void SerializeFields (W &i, Buffer::Iterator start) const;
+  /// Read the fields with \p i, see FixedSizeHeader
+  template <typename R>
+  uint32_t DeserializeFields (R &i, Buffer::Iterator start);
+
   MessageType m_type;
   bool m_valid;
 };
@@ -81,212 +85,6 @@ std::ostream & operator<< (std::ostream & os, TypeHeader const & h);
 
 
 
-
-
-// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-//
-// CPDA - KEY EXCHANGE - CPDATYPE_KEY
-//
-// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-/*
- * Description: Used RREP class as baseline
- *
- */
-class CpdaKeyHeader: public Header
-{
-public:
-  typedef std::vector<uint16_t> uint16_vec;
-
-
-  /// c-tor
-  CpdaKeyHeader (uint8_t prefixSize = 0, uint8_t hopCount = 0, Ipv4Address dst = Ipv4Address (), uint32_t dstSeqNo = 0, Ipv4Address origin =
-                Ipv4Address (), Time lifetime = MilliSeconds (0));
-
-  // Header serialization/deserialization
-  static TypeId GetTypeId ();
-  TypeId GetInstanceTypeId () const;
-  uint32_t GetSerializedSize () const;
-  void Serialize (Buffer::Iterator start) const;
-  uint32_t Deserialize (Buffer::Iterator start);
-  void Print (std::ostream &os) const;
-
-  // Fields
-  void SetHopCount (uint8_t count) { m_hopCount = count; }
-  uint8_t GetHopCount () const { return m_hopCount; }
-  void SetDst (Ipv4Address a) { m_dst = a; }
-  Ipv4Address GetDst () const { return m_dst; }
-  void SetDstSeqno (uint32_t s) { m_dstSeqNo = s; }
-  uint32_t GetDstSeqno () const { return m_dstSeqNo; }
-  void SetOrigin (Ipv4Address a) { m_origin = a; }
-  Ipv4Address GetOrigin () const { return m_origin; }
-  void SetLifeTime (Time t);
-  Time GetLifeTime () const;
-
-  // Flags
-  void SetAckRequired (bool f);
-  bool GetAckRequired () const;
-  void SetPrefixSize (uint8_t sz);
-  uint8_t GetPrefixSize () const;
-
-  /// Configure RREP to be a Hello message
-  void SetHello (Ipv4Address src, uint32_t srcSeqNo, Time lifetime);
-
-  // CPDA Fields
-  void SetKey(uint16_vec key) { m_key = key; }
-  uint16_vec GetKey() const { return m_key; }
-
-
-  bool operator== (CpdaKeyHeader const & o) const;
-private:
-  uint8_t       m_flags;                  ///< A - acknowledgment required flag
-  uint8_t       m_prefixSize;         ///< Prefix Size
-  uint8_t       m_hopCount;         ///< Hop Count
-  Ipv4Address   m_dst;              ///< Destination IP Address
-  uint32_t      m_dstSeqNo;         ///< Destination Sequence Number
-  Ipv4Address   m_origin;           ///< Source IP Address
-  uint32_t      m_lifeTime;         ///< Lifetime (in milliseconds)
-
-  // CPDA MEMBER VARIABLES
-  uint16_vec m_key; // CPDA keys for exchange
-};
-
-std::ostream & operator<< (std::ostream & os, CpdaKeyHeader const &);
-// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-//
-// END CPDA - KEY EXCHANGE
-//
-// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-
-
-// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-//
-// CPDA - QUERY
-//
-// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-/*
- * Description: Used RREP class as baseline
- *
- */
-class CpdaQueryHeader: public Header
-{
-public:
-  /// c-tor
-  CpdaQueryHeader (uint8_t prefixSize = 0, uint8_t hopCount = 0, Ipv4Address dst = Ipv4Address (), uint32_t dstSeqNo = 0, Ipv4Address origin =
-                Ipv4Address (), Time lifetime = MilliSeconds (0));
-
-  // Header serialization/deserialization
-  static TypeId GetTypeId ();
-  TypeId GetInstanceTypeId () const;
-  uint32_t GetSerializedSize () const;
-  void Serialize (Buffer::Iterator start) const;
-  uint32_t Deserialize (Buffer::Iterator start);
-  void Print (std::ostream &os) const;
-
-  // Fields
-  void SetHopCount (uint8_t count) { m_hopCount = count; }
-  uint8_t GetHopCount () const { return m_hopCount; }
-  void SetDst (Ipv4Address a) { m_dst = a; }
-  Ipv4Address GetDst () const { return m_dst; }
-  void SetDstSeqno (uint32_t s) { m_dstSeqNo = s; }
-  uint32_t GetDstSeqno () const { return m_dstSeqNo; }
-  void SetOrigin (Ipv4Address a) { m_origin = a; }
-  Ipv4Address GetOrigin () const { return m_origin; }
-  void SetLifeTime (Time t);
-  Time GetLifeTime () const;
-
-  // Flags
-  void SetAckRequired (bool f);
-  bool GetAckRequired () const;
-  void SetPrefixSize (uint8_t sz);
-  uint8_t GetPrefixSize () const;
-
-  /// Configure RREP to be a Hello message
-  void SetHello (Ipv4Address src, uint32_t srcSeqNo, Time lifetime);
-
-  bool operator== (CpdaQueryHeader const & o) const;
-private:
-  uint8_t       m_flags;                  ///< A - acknowledgment required flag
-  uint8_t       m_prefixSize;         ///< Prefix Size
-  uint8_t       m_hopCount;         ///< Hop Count
-  Ipv4Address   m_dst;              ///< Destination IP Address
-  uint32_t      m_dstSeqNo;         ///< Destination Sequence Number
-  Ipv4Address   m_origin;           ///< Source IP Address
-  uint32_t      m_lifeTime;         ///< Lifetime (in milliseconds)
-};
-
-std::ostream & operator<< (std::ostream & os, CpdaQueryHeader const &);
-
-// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-//
-// END CPDA - QUERY
-//
-// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-
-// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-//
-// CPDA - JOIN
-//
-// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-/*
- * Description: Used RREP class as baseline
- *
- */
-class CpdaJoinHeader: public Header
-{
-public:
-  /// c-tor
-	CpdaJoinHeader (uint8_t prefixSize = 0, uint8_t hopCount = 0, Ipv4Address dst = Ipv4Address (), uint32_t dstSeqNo = 0, Ipv4Address origin =
-                Ipv4Address (), Time lifetime = MilliSeconds (0));
-
-  // Header serialization/deserialization
-  static TypeId GetTypeId ();
-  TypeId GetInstanceTypeId () const;
-  uint32_t GetSerializedSize () const;
-  void Serialize (Buffer::Iterator start) const;
-  uint32_t Deserialize (Buffer::Iterator start);
-  void Print (std::ostream &os) const;
-
-  // Fields
-  void SetHopCount (uint8_t count) { m_hopCount = count; }
-  uint8_t GetHopCount () const { return m_hopCount; }
-  void SetDst (Ipv4Address a) { m_dst = a; }
-  Ipv4Address GetDst () const { return m_dst; }
-  void SetDstSeqno (uint32_t s) { m_dstSeqNo = s; }
-  uint32_t GetDstSeqno () const { return m_dstSeqNo; }
-  void SetOrigin (Ipv4Address a) { m_origin = a; }
-  Ipv4Address GetOrigin () const { return m_origin; }
-  void SetLifeTime (Time t);
-  Time GetLifeTime () const;
-
-  // Flags
-  void SetAckRequired (bool f);
-  bool GetAckRequired () const;
-  void SetPrefixSize (uint8_t sz);
-  uint8_t GetPrefixSize () const;
-
-  /// Configure RREP to be a Hello message
-  void SetHello (Ipv4Address src, uint32_t srcSeqNo, Time lifetime);
-
-  bool operator== (CpdaJoinHeader const & o) const;
-private:
-  uint8_t       m_flags;                  ///< A - acknowledgment required flag
-  uint8_t       m_prefixSize;         ///< Prefix Size
-  uint8_t       m_hopCount;         ///< Hop Count
-  Ipv4Address   m_dst;              ///< Destination IP Address
-  uint32_t      m_dstSeqNo;         ///< Destination Sequence Number
-  Ipv4Address   m_origin;           ///< Source IP Address
-  uint32_t      m_lifeTime;         ///< Lifetime (in milliseconds)
-};
-
-std::ostream & operator<< (std::ostream & os, CpdaJoinHeader const &);
-
-// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-//
-// END CPDA - JOIN
-//
-// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-
-
 //==============================================================
 // RREQ FUNCTIONS - AODVTYPE_RREQ
 //==============================================================
@@ -312,7 +110,7 @@ std::ostream & operator<< (std::ostream & os, CpdaJoinHeader const &);
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   \endverbatim
 */
-class RreqHeader : public Header 
+class RreqHeader : public FixedSizeHeader<RreqHeader, 23>
 {
 public:
   /// c-tor
@@ -324,7 +122,6 @@ public:
   // Header serialization/deserialization
   static TypeId GetTypeId ();
   TypeId GetInstanceTypeId () const;
-  uint32_t GetSerializedSize () const;
   void Serialize (Buffer::Iterator start) const;
   uint32_t Deserialize (Buffer::Iterator start);
   void Print (std::ostream &os) const;
@@ -354,6 +151,14 @@ public:
   bool operator== (RreqHeader const & o) const;
 
 private:
+  friend class FixedSizeHeader<RreqHeader, 23>;
+  /// Write the fields with \p i, see FixedSizeHeader
+  template <typename W>
+  void SerializeFields (W &i, Buffer::Iterator start) const;
+  /// Read the fields with \p i, see FixedSizeHeader
+  template <typename R>
+  uint32_t DeserializeFields (R &i, Buffer::Iterator start);
+
   uint8_t        m_flags;          ///< |J|R|G|D|U| bit flags, see RFC
   uint8_t        m_reserved;       ///< Not used
   uint8_t        m_hopCount;       ///< Hop Count
@@ -393,7 +198,7 @@ std::ostream & operator<< (std::ostream & os, RreqHeader const &);
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   \endverbatim
 */
-class RrepHeader : public Header
+class RrepHeader : public FixedSizeHeader<RrepHeader, 19>
 {
 public:
   /// c-tor
@@ -403,7 +208,6 @@ public:
   // Header serialization/deserialization
   static TypeId GetTypeId ();
   TypeId GetInstanceTypeId () const;
-  uint32_t GetSerializedSize () const;
   void Serialize (Buffer::Iterator start) const;
   uint32_t Deserialize (Buffer::Iterator start);
   void Print (std::ostream &os) const;
@@ -431,6 +235,14 @@ public:
 
   bool operator== (RrepHeader const & o) const;
 private:
+  friend class FixedSizeHeader<RrepHeader, 19>;
+  /// Write the fields with \p i, see FixedSizeHeader
+  template <typename W>
+  void SerializeFields (W &i, Buffer::Iterator start) const;
+  /// Read the fields with \p i, see FixedSizeHeader
+  template <typename R>
+  uint32_t DeserializeFields (R &i, Buffer::Iterator start);
+
   uint8_t       m_flags;                  ///< A - acknowledgment required flag
   uint8_t       m_prefixSize;         ///< Prefix Size
   uint8_t             m_hopCount;         ///< Hop Count
@@ -457,7 +269,7 @@ std::ostream & operator<< (std::ostream & os, RrepHeader const &);
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   \endverbatim
 */
-class RrepAckHeader : public Header
+class RrepAckHeader : public FixedSizeHeader<RrepAckHeader, 1>
 {
 public:
   /// c-tor
@@ -466,13 +278,20 @@ public:
   // Header serialization/deserialization
   static TypeId GetTypeId ();
   TypeId GetInstanceTypeId () const;
-  uint32_t GetSerializedSize () const;
   void Serialize (Buffer::Iterator start) const;
   uint32_t Deserialize (Buffer::Iterator start);
   void Print (std::ostream &os) const;
 
   bool operator== (RrepAckHeader const & o) const;
 private:
+  friend class FixedSizeHeader<RrepAckHeader, 1>;
+  /// Write the fields with \p i, see FixedSizeHeader
+  template <typename W>
+  void SerializeFields (W &i, Buffer::Iterator start) const;
+  /// Read the fields with \p i, see FixedSizeHeader
+  template <typename R>
+  uint32_t DeserializeFields (R &i, Buffer::Iterator start);
+
   uint8_t       m_reserved;
 };
 std::ostream & operator<< (std::ostream & os, RrepAckHeader const &);
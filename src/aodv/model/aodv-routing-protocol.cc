@@ -45,12 +45,6 @@
 #include <limits>
 
 
-// =========================== CPDA PARAMETERS ===========================
-#define CLUSTER_LEADER_PROBABILITY 25 // percentage
-#define CLUSTER_MEMBERS_NUM 20 // initilization number for cluster members vector
-// =======================================================================
-
-
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE("AodvRoutingProtocol");
@@ -130,15 +124,7 @@ RoutingProtocol::RoutingProtocol() :
 				0), m_seqNo(0), m_rreqIdCache(m_pathDiscoveryTime), m_dpd(m_pathDiscoveryTime), m_nb(
 				m_helloInterval), m_rreqCount(0), m_rerrCount(0), m_htimer(
 				Timer::CANCEL_ON_DESTROY), m_rreqRateLimitTimer(Timer::CANCEL_ON_DESTROY), m_rerrRateLimitTimer(
-				Timer::CANCEL_ON_DESTROY), m_lastBcastTime(Seconds(0)),
-
-				// ========= CPDA CHANGES =========
-				// Key parameters
-				m_keyTotal(10000), m_keySelection(200), m_key(m_keySelection),
-				// Cluster formation parameters
-				m_isClusterLeader(false), m_isPartOfCluster(false)
-
-
+				Timer::CANCEL_ON_DESTROY), m_lastBcastTime(Seconds(0))
 {
 	m_nb.SetCallback(MakeCallback(&RoutingProtocol::SendRerrWhenBreaksLinkToNextHop, this));
 }
@@ -236,19 +222,7 @@ TypeId RoutingProtocol::GetTypeId(void) {
 					"UniformRv", "Access to the underlying UniformRandomVariable",
 					StringValue("ns3::UniformRandomVariable"),
 					MakePointerAccessor(&RoutingProtocol::m_uniformRandomVariable),
-					MakePointerChecker<UniformRandomVariable>())
-
-
-					//==============================================================
-					  //==============================================================
-					  //
-					  // CPDA PROTOCOL ATTRIBUTE
-					  //
-					  //==============================================================
-					  //==============================================================					//TODO: ADD CLUSTER FORMATION ATTRIBUTE FOR ROOT NODE
-					.AddAttribute("EnableQueryNode", "Indicates that this is the root query node.",
-									BooleanValue(false), MakeBooleanAccessor(&RoutingProtocol::SetQueryNode,
-									&RoutingProtocol::GetQueryNode), MakeBooleanChecker());
+					MakePointerChecker<UniformRandomVariable>());
 	return tid;
 }
 
@@ -300,29 +274,6 @@ int64_t RoutingProtocol::AssignStreams(int64_t stream) {
  */
 void RoutingProtocol::Start() {
 	NS_LOG_FUNCTION(this);
-
-	// CPDA TESTING OF QUERY NODE
-	//std::cout << "QUERY NODE: " << m_enableQueryNode << std::endl;
-
-	// Key selection pre-distribution
-	for (int i = 0; i < m_keySelection; i++) {
-		m_key[i] = m_uniformRandomVariable->GetInteger(1, m_keyTotal);
-	};
-
-	//std::cout << "IP: " << m_socketAddresses.begin()->second.GetLocal() << std::endl;
-	if(m_enableQueryNode){
-		//save local IP address as cluster leader IP
-		m_clusterLeaderIp = m_socketAddresses.begin()->second.GetLocal();
-		SendQuery();
-	}
-	// CPDA Start ShareKey Distribution
-	SendKey();
-}
-
-// CPDA - Test function
-void RoutingProtocol::check() {
-	static int i = 0;
-	std::cout << "Key" << i++ << ": " << m_key[0] << std::endl;
 }
 
 /*
@@ -506,303 +457,6 @@ bool RoutingProtocol::RouteInput(Ptr<const Packet> p, const Ipv4Header &header,
 	return Forwarding(p, header, ucb, ecb);
 }
 
-//==============================================================
-//==============================================================
-//
-// CPDA - KEY FUNCTION
-//
-//==============================================================
-//==============================================================
-/*
- * This function creates a CPDA_KEY packet which is a modified version of
- * the HELLO packet (which is a special form of a RREP pkt), but also with
- * a key vector
- */
-void RoutingProtocol::SendKey() {
-	NS_LOG_FUNCTION(this);
-	/* Broadcast a RREP with TTL = 1 with the RREP message fields set as follows:
-	 *   Destination IP Address         The node's IP address.
-	 *   Destination Sequence Number    The node's latest sequence number.
-	 *   Hop Count                      0
-	 *   Lifetime                       AllowedHelloLoss * HelloInterval
-	 */
-	// for all interfaces
-	for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin();
-			j != m_socketAddresses.end(); ++j) {
-
-		// Variables for IP interface
-		Ptr<Socket> socket = j->first;
-		Ipv4InterfaceAddress iface = j->second;
-
-		// Key header/packet constructor
-		Ptr<Packet> packet = Create<Packet>();
-		CpdaKeyHeader keyHeader(/*prefix size=*/0, /*hops=*/0, /*dst=*/iface.GetLocal(),
-		/*dst seqno=*/m_seqNo, /*origin=*/iface.GetLocal(),
-		/*lifetime=*/Time(m_allowedHelloLoss * m_helloInterval));
-
-		keyHeader.SetKey(m_key); //copy keys into header
-
-		//CPDA SEND KEY TESTING
-		//std::cout << "SendKey: " << m_key[0] << std::endl;
-
-		// Add tag for IP 1-hop broadcast
-		SocketIpTtlTag tag;
-		tag.SetTtl(1);
-		packet->AddPacketTag(tag);
-
-		// Add header for Key packets
-		packet->AddHeader(keyHeader);
-		TypeHeader tHeader(CPDATYPE_KEY);
-		packet->AddHeader(tHeader);
-
-		// Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
-		Ipv4Address destination;
-		if (iface.GetMask() == Ipv4Mask::GetOnes()) {
-			destination = Ipv4Address("255.255.255.255");
-		} else {
-			destination = iface.GetBroadcast();
-		}
-		Time jitter = Time(MilliSeconds(m_uniformRandomVariable->GetInteger(0, 20)));
-		//Simulator::Schedule(jitter, &RoutingProtocol::SendTo, this, socket, packet, destination);
-		Simulator::ScheduleNow(&RoutingProtocol::SendTo, this, socket, packet, destination);
-	}
-}
-
-void RoutingProtocol::RecvKey(Ptr<Packet> p, Ipv4Address receiver, Ipv4Address sender) {
-	NS_LOG_FUNCTION(this << " src " << sender);
-	CpdaKeyHeader keyHeader;
-	p->RemoveHeader(keyHeader);
-	Ipv4Address dst = keyHeader.GetDst();
-	NS_LOG_LOGIC("RREP destination " << dst << " RREP origin " << keyHeader.GetOrigin ());
-
-	//TODO: Add key handling functionality here
-	std::vector<uint16_t> recvKeys = keyHeader.GetKey();
-
-	// CPDA TESTING OF RECV KEYS
-	//std::cout << "S:" << keyHeader.GetOrigin() << "\tD:" << dst << "\tKEY:" << recvKeys[0] << "\n";
-
-	// Find matching neighbor key and add it to the Key Map
-	uint16_t neighborKey = m_keyMap.FindMatchingKey(m_key, recvKeys);
-
-	// CPDA TESTING OF MATCHING KEYS
-	std::cout << "S:" << sender << " R:" << receiver << " Key:" << neighborKey << std::endl;
-
-	if (neighborKey != 0) { //matching neighbor key found
-		m_keyMap.AddKey(sender, neighborKey); //insert into key map
-	}
-
-	//m_keyMap.Print(); //check recv'd keys
-	//std::cout << std::endl;
-
-	//TODO: Add path key functionality or....??
-	//else path key stuff
-
-	return;
-
-}
-//
-////TODO: Decompose this function in order to do actual key handling
-//void RoutingProtocol::ProcessKey(RrepHeader const & rrepHeader, Ipv4Address receiver) {
-//	NS_LOG_FUNCTION(this << "from " << rrepHeader.GetDst ());
-//	/*
-//	 *  Whenever a node receives a Hello message from a neighbor, the node
-//	 * SHOULD make sure that it has an active route to the neighbor, and
-//	 * create one if necessary.
-//	 */
-//	RoutingTableEntry toNeighbor;
-//	if (!m_routingTable.LookupRoute(rrepHeader.GetDst(), toNeighbor)) {
-//		Ptr<NetDevice> dev = m_ipv4->GetNetDevice(m_ipv4->GetInterfaceForAddress(receiver));
-//		RoutingTableEntry newEntry(/*device=*/dev, /*dst=*/rrepHeader.GetDst(), /*validSeqNo=*/
-//		true, /*seqno=*/rrepHeader.GetDstSeqno(),
-//		/*iface=*/m_ipv4->GetAddress(m_ipv4->GetInterfaceForAddress(receiver), 0),
-//		/*hop=*/1, /*nextHop=*/rrepHeader.GetDst(), /*lifeTime=*/
-//		rrepHeader.GetLifeTime());
-//		m_routingTable.AddRoute(newEntry);
-//	} else {
-//		toNeighbor.SetLifeTime(
-//				std::max(Time(m_allowedHelloLoss * m_helloInterval), toNeighbor.GetLifeTime()));
-//		toNeighbor.SetSeqNo(rrepHeader.GetDstSeqno());
-//		toNeighbor.SetValidSeqNo(true);
-//		toNeighbor.SetFlag(VALID);
-//		toNeighbor.SetOutputDevice(m_ipv4->GetNetDevice(m_ipv4->GetInterfaceForAddress(receiver)));
-//		toNeighbor.SetInterface(m_ipv4->GetAddress(m_ipv4->GetInterfaceForAddress(receiver), 0));
-//		toNeighbor.SetHop(1);
-//		toNeighbor.SetNextHop(rrepHeader.GetDst());
-//		m_routingTable.Update(toNeighbor);
-//	}
-//	if (m_enableHello) {
-//		m_nb.Update(rrepHeader.GetDst(), Time(m_allowedHelloLoss * m_helloInterval));
-//	}
-//}
-//==============================================================
-//==============================================================
-//
-// END CPDA - KEY EXCHANGE
-//
-//==============================================================
-//==============================================================
-
-//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-//
-// CPDA - QUERY/JOIN CLUSTERING FUNCTION
-//
-//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-/*
- * Root node will broadcast a query that will propagate through the network
- * to establish the TAG tree
- *
- */
-void RoutingProtocol::SendQuery() {
-	NS_LOG_FUNCTION(this);
-	// for all interfaces
-	for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin();
-			j != m_socketAddresses.end(); ++j) {
-
-		// Variables for IP interface
-		Ptr<Socket> socket = j->first;
-		Ipv4InterfaceAddress iface = j->second;
-
-		// Key header/packet constructor
-		Ptr<Packet> packet = Create<Packet>();
-		CpdaQueryHeader queryHeader(/*prefix size=*/0, /*hops=*/0, /*dst=*/iface.GetLocal(),
-		/*dst seqno=*/m_seqNo, /*origin=*/iface.GetLocal(),
-		/*lifetime=*/Time(m_allowedHelloLoss * m_helloInterval));
-
-		// Add tag for IP 1-hop broadcast
-		SocketIpTtlTag tag;
-		tag.SetTtl(1);
-		packet->AddPacketTag(tag);
-
-		// Add header for Key packets
-		packet->AddHeader(queryHeader);
-		TypeHeader tHeader(CPDATYPE_QUERY);
-		packet->AddHeader(tHeader);
-
-		// Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
-		Ipv4Address destination;
-		if (iface.GetMask() == Ipv4Mask::GetOnes()) {
-			destination = Ipv4Address("255.255.255.255");
-		} else {
-			destination = iface.GetBroadcast();
-		}
-		Time jitter = Time(MilliSeconds(m_uniformRandomVariable->GetInteger(0, 20)));
-		Simulator::Schedule(jitter, &RoutingProtocol::SendTo, this, socket, packet, destination);
-		//Simulator::ScheduleNow(&RoutingProtocol::SendTo, this, socket, packet, destination);
-	}
-}
-/*
- * Upon receiving a Query a node either selects itself as a cluster leader to propagate a query message
- * or sends a Join message to join the sender of the Query message
- */
-void RoutingProtocol::RecvQuery(Ptr<Packet> p, Ipv4Address receiver, Ipv4Address sender) {
-	NS_LOG_FUNCTION(this << " src " << sender);
-
-	// probabilistic selection of cluster leader
-
-	// Check if this node is already part of cluster or root query node
-	if(!m_isPartOfCluster && !m_enableQueryNode){// if part of cluster or is a root node then ignore message
-
-		// Handle flags and clusters members
-		m_isPartOfCluster = true; // node is now part of a cluster
-		m_clusterLeaderIp = sender; // sender of the query is now our cluster leader
-		m_clusterMembers.push_back(sender);// add cluster leader to our cluster list
-
-		//std::cout << m_socketAddresses.begin()->second.GetLocal() << " added " << sender << std::endl;
-
-		// probability of self selecting as cluster leader to propagate queries
-		if(m_uniformRandomVariable->GetInteger(1, 100) <= CLUSTER_LEADER_PROBABILITY){
-			m_isClusterLeader = true; // set node flag to cluster leader
-
-			std::cout << "Cluster Leader: " << receiver << std::endl;
-			SendQuery(); // forward query
-		}
-		// else not a cluster leader
-		//std::cout << "Joining: " << receiver << " to " << sender << std::endl;
-		SendJoin(sender); // Send a Join msg back to the sender of the query
-	}
-	return;
-}
-
-/*
- * Reply to Query messages with a Join msg. This is broadcasted so other cluster members
- * can snoop on the message and add to their list of cluster member IPs
- */
-void RoutingProtocol::SendJoin(Ipv4Address clusterLeaderIp){
-	NS_LOG_FUNCTION(this);
-	// for all interfaces
-	for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin();
-			j != m_socketAddresses.end(); ++j) {
-
-		// Variables for IP interface
-		Ptr<Socket> socket = j->first;
-		Ipv4InterfaceAddress iface = j->second;
-
-		// Key header/packet constructor
-		Ptr<Packet> packet = Create<Packet>();
-		CpdaJoinHeader CpdaJoinHeader(/*prefix size=*/0, /*hops=*/0, /*dst=*/clusterLeaderIp,
-		/*dst seqno=*/m_seqNo, /*origin=*/iface.GetLocal(),
-		/*lifetime=*/Time(m_allowedHelloLoss * m_helloInterval));
-
-		// Add tag for IP 1-hop broadcast
-		SocketIpTtlTag tag;
-		tag.SetTtl(1);
-		packet->AddPacketTag(tag);
-
-		// Add header for Key packets
-		packet->AddHeader(CpdaJoinHeader);
-		TypeHeader tHeader(CPDATYPE_JOIN);
-		packet->AddHeader(tHeader);
-
-		// Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
-		Ipv4Address destination;
-		if (iface.GetMask() == Ipv4Mask::GetOnes()) {
-			destination = Ipv4Address("255.255.255.255");
-		} else {
-			destination = iface.GetBroadcast();
-		}
-		Time jitter = Time(MilliSeconds(m_uniformRandomVariable->GetInteger(0, 20)));
-		Simulator::Schedule(jitter, &RoutingProtocol::SendTo, this, socket, packet, destination);
-
-
-		// queue the packet to send immediately - doesn't work if we use jitter...
-		//std::cout << m_socketAddresses.begin()->second.GetLocal() << " sending JOIN to " << clusterLeaderIp << std::endl;
-		Simulator::ScheduleNow(&RoutingProtocol::SendTo, this, socket, packet, destination);
-	}
-}
-/*
- * Upon receiving a Join message, we add it to our vector of other cluster members if destination matches
- * our cluster leader IP
- *
- */
-void RoutingProtocol::RecvJoin(Ptr<Packet> p, Ipv4Address receiver, Ipv4Address sender){
-	CpdaJoinHeader joinHeader;
-	p->RemoveHeader(joinHeader);
-
-	// snoop other nodes joins by checking if the dst matches our cluster leader
-	if(joinHeader.GetDst() == m_clusterLeaderIp){
-
-		//std::cout << m_socketAddresses.begin()->second.GetLocal() << " added " << sender << std::endl;
-		m_clusterMembers.push_back(sender); //add the sender's ip to our cluster list
-
-		// testing to see what the sensor nodes snoop
-		if(!m_enableQueryNode){
-			std::cout << m_socketAddresses.begin()->second.GetLocal() << " snooped " << sender << " joining our leader " << joinHeader.GetDst() << std::endl;
-
-			if(m_clusterMembers.size() == 3){
-				for(std::vector<Ipv4Address>::const_iterator i = m_clusterMembers.begin(); i!=m_clusterMembers.end(); i++){
-					std::cout<< "\tPrinting cluster members: " << *i << std::endl;
-				}
-			}
-		}
-	}
-	return;
-}
-
-//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-//
-// END CPDA - QUERY/JOIN CLUSTERING FUNCTION
-//
-//@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 
 
 
@@ -1306,21 +960,6 @@ void RoutingProtocol::RecvAodv(Ptr<Socket> socket) {
 		RecvReplyAck(sender);
 		break;
 	}
-	case CPDATYPE_KEY: {
-//		std::cout << "CPDATYPE_KEY\n";
-		RecvKey(packet, receiver, sender);
-		break;
-	}
-	case CPDATYPE_QUERY: {
-//		std::cout << "CPDATYPE_QUERY\n";
-		RecvQuery(packet, receiver, sender);
-		break;
-	}
-	case CPDATYPE_JOIN: {
-//		std::cout << "CPDATYPE_JOIN\n";
-		RecvJoin(packet, receiver, sender);
-		break;
-	}
 	}
 }
 
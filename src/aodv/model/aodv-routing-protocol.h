@@ -28,7 +28,7 @@
 #ifndef AODVROUTINGPROTOCOL_H
 #define AODVROUTINGPROTOCOL_H
 
-#include "aodv-rtable.h"
+#include "aodv-indexed-rtable.h"
 #include "aodv-rqueue.h"
 #include "aodv-packet.h"
 #include "aodv-neighbor.h"
@@ -45,48 +45,6 @@ namespace ns3
 {
 namespace aodv
 {
-/*
- * Hash Map of (IP,Key)
- */
-class KeyMap{
-	std::map<Ipv4Address, uint16_t> m_ipKeyMap; //(ip,key) mapping
-public:
-	void AddKey(Ipv4Address ip, uint16_t key){
-		m_ipKeyMap.insert(std::make_pair(ip,key));
-	}
-	void DeleteKey(Ipv4Address ip){
-		m_ipKeyMap.erase(ip);
-	}
-
-	// Find a matching pair of keys from x and y
-	// Returns 0 otherwise
-	uint16_t FindMatchingKey(std::vector<uint16_t> x, std::vector<uint16_t> y){
-		typedef std::vector<uint16_t>::const_iterator VectorIterator;
-
-		// iterate through vector x
-		for(VectorIterator xiter = x.begin(); xiter != x.end(); xiter++){
-
-			// find if xkey inside of vector y
-			VectorIterator yiter = find(y.begin(), y.end(), *xiter);
-
-			if(yiter != y.end()){//no key found, go onto the next key
-				return *yiter;
-			}
-		}
-		return 0;
-	}
-	void Print(void)const{
-		for (std::map<Ipv4Address, uint16_t>::const_iterator i = m_ipKeyMap.begin ();
-				i != m_ipKeyMap.end (); ++i){
-			std::cout << "IP: " << i->first << " Key: " << i->second << std::endl;
-		}
-	}
-};
-
-
-
-
-
 /**
  * \ingroup aodv
  *
@@ -130,16 +88,6 @@ public:
   void SetBroadcastEnable (bool f) { m_enableBroadcast = f; }
   bool GetBroadcastEnable () const { return m_enableBroadcast; }
 
-  //==============================================================
-  //==============================================================
-  //
-  // CPDA PROTOCOL CHANGES
-  //
-  //==============================================================
-  //==============================================================
-  void SetQueryNode(bool f) { m_enableQueryNode = f;}
-  bool GetQueryNode() const { return m_enableQueryNode; }
-
   /**
   * Assign a fixed random variable stream number to the random variables
   * used by this model.  Return the number of streams (possibly zero) that
@@ -192,15 +140,6 @@ private:
   bool m_enableHello;                  ///< Indicates whether a hello messages enable
   bool m_enableBroadcast;              ///< Indicates whether a a broadcast data packets forwarding enable
   //\}
-  //==============================================================
-  //==============================================================
-  //
-  // CPDA PROTOCOL VARIABLE
-  //
-  //==============================================================
-  //==============================================================
-  bool m_enableQueryNode; // Indicates that this node is the root query node
-
   /// IP protocol
   Ptr<Ipv4> m_ipv4;
   /// Raw unicast socket per each IP interface, map socket -> iface address (IP + mask)
@@ -211,7 +150,7 @@ private:
   Ptr<NetDevice> m_lo; 
 
   /// Routing table
-  RoutingTable m_routingTable;
+  IndexedRoutingTable m_routingTable;
   /// A "drop-front" queue used by the routing layer to buffer packets to which it does not have a route.
   RequestQueue m_queue;
   /// Broadcast ID
@@ -337,40 +276,6 @@ private:
   Ptr<UniformRandomVariable> m_uniformRandomVariable;  
   /// Keep track of the last bcast time
   Time m_lastBcastTime;
-
-  //==============================================================
-  //==============================================================
-  //
-  // CPDA CHANGES
-  //
-  //==============================================================
-  //==============================================================
-  void check();
-  // Key Functions
-  void SendKey(); //Broadcast keys to all neighbors
-  void RecvKey(Ptr<Packet> p, Ipv4Address my, Ipv4Address src);
-
-  // Query Functions
-  void SendQuery(); // Broadcast query
-  void RecvQuery(Ptr<Packet> p, Ipv4Address my, Ipv4Address src);
-
-  // Join Functions - Unicast Query Pkts
-  void SendJoin(Ipv4Address dst);
-  void RecvJoin(Ptr<Packet> p, Ipv4Address my, Ipv4Address src);
-
-  // CPDA Key Management
-  uint16_t m_keyTotal; //total number of possible keys
-  uint16_t m_keySelection; // total number of keys to be selected per node
-  std::vector<uint16_t> m_key; // CPDA keys for exchange
-  KeyMap m_keyMap; //(IP,Key) Mapping for neighbor nodes
-
-  // Cluster Formation Changes
-  bool m_isClusterLeader; // flag to check if this node is a cluster leader
-  bool m_isPartOfCluster; // flag to check if this node is part of a cluster
-  Ipv4Address m_clusterLeaderIp; // IP of the cluster leader
-  std::vector<Ipv4Address> m_clusterMembers; // IP of all cluster members
-
-
 };
 
 }
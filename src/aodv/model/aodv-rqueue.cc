@@ -27,7 +27,6 @@
  */
 #include "aodv-rqueue.h"
 #include <algorithm>
-#include <functional>
 #include "ns3/ipv4-route.h"
 #include "ns3/socket.h"
 #include "ns3/log.h"
@@ -43,74 +42,120 @@ uint32_t
 RequestQueue::GetSize ()
 {
   Purge ();
-  return m_queue.size ();
+  return m_size;
+}
+
+void
+RequestQueue::SetQueueTimeout (Time t)
+{
+  if (t < m_queueTimeout && m_size != 0)
+    {
+      m_unordered = true;
+    }
+  m_queueTimeout = t;
 }
 
 bool
 RequestQueue::Enqueue (QueueEntry & entry)
 {
   Purge ();
-  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  uint32_t dst = entry.GetIpv4Header ().GetDestination ().Get ();
+  Bucket const * bucket = m_byDst.Find (dst);
+  if (bucket != 0)
     {
-      if ((i->GetPacket ()->GetUid () == entry.GetPacket ()->GetUid ())
-          && (i->GetIpv4Header ().GetDestination ()
-              == entry.GetIpv4Header ().GetDestination ()))
-        return false;
+      for (Bucket::const_iterator i = bucket->begin (); i != bucket->end (); ++i)
+        {
+          if ((*i)->GetPacket ()->GetUid () == entry.GetPacket ()->GetUid ())
+            return false;
+        }
     }
   entry.SetExpireTime (m_queueTimeout);
-  if (m_queue.size () == m_maxLen)
+  if (m_size >= m_maxLen)
     {
-      Drop (m_queue.front (), "Drop the most aged packet"); // Drop the most aged packet
-      m_queue.erase (m_queue.begin ());
+      if (m_size == 0)
+        {
+          // a queue of length 0 holds nothing
+          Drop (entry, "Drop the packet, the queue has no room ");
+          return false;
+        }
+      QueueEntry aged = m_queue.front ();
+      Remove (m_queue.begin ());
+      Drop (aged, "Drop the most aged packet"); // Drop the most aged packet
     }
   m_queue.push_back (entry);
+  ++m_size;
+  m_byDst.Insert (dst, Bucket ()).first->push_back (--m_queue.end ());
   return true;
 }
 
+void
+RequestQueue::Remove (Entries::iterator i)
+{
+  uint32_t dst = i->GetIpv4Header ().GetDestination ().Get ();
+  Bucket * bucket = m_byDst.Find (dst);
+  NS_ASSERT (bucket != 0);
+  if (bucket->front () == i)
+    {
+      bucket->pop_front ();
+    }
+  else
+    {
+      bucket->erase (std::find (bucket->begin (), bucket->end (), i));
+    }
+  if (bucket->empty ())
+    {
+      m_byDst.Erase (dst);
+    }
+  m_queue.erase (i);
+  if (--m_size == 0)
+    {
+      m_unordered = false;
+    }
+}
+
 void
 RequestQueue::DropPacketWithDst (Ipv4Address dst)
 {
   NS_LOG_FUNCTION (this << dst);
   Purge ();
-  for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  Bucket const * bucket = m_byDst.Find (dst.Get ());
+  if (bucket == 0)
+    return;
+  std::vector<QueueEntry> dropped;
+  for (Bucket::const_iterator i = bucket->begin (); i != bucket->end (); ++i)
     {
-      if (IsEqual (*i, dst))
-        {
-          Drop (*i, "DropPacketWithDst ");
-        }
+      dropped.push_back (**i);
+      m_queue.erase (*i);
+    }
+  m_size -= dropped.size ();
+  m_byDst.Erase (dst.Get ());
+  if (m_size == 0)
+    {
+      m_unordered = false;
+    }
+  for (std::vector<QueueEntry>::const_iterator i = dropped.begin (); i != dropped.end (); ++i)
+    {
+      Drop (*i, "DropPacketWithDst ");
     }
-  m_queue.erase (std::remove_if (m_queue.begin (), m_queue.end (),
-                                 std::bind2nd (std::ptr_fun (RequestQueue::IsEqual), dst)), m_queue.end ());
 }
 
 bool
 RequestQueue::Dequeue (Ipv4Address dst, QueueEntry & entry)
 {
   Purge ();
-  for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i != m_queue.end (); ++i)
-    {
-      if (i->GetIpv4Header ().GetDestination () == dst)
-        {
-          entry = *i;
-          m_queue.erase (i);
-          return true;
-        }
-    }
-  return false;
+  Bucket const * bucket = m_byDst.Find (dst.Get ());
+  if (bucket == 0)
+    return false;
+  Entries::iterator i = bucket->front ();
+  entry = *i;
+  Remove (i);
+  return true;
 }
 
 bool
 RequestQueue::Find (Ipv4Address dst)
 {
-  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
-    {
-      if (i->GetIpv4Header ().GetDestination () == dst)
-        return true;
-    }
-  return false;
+  return m_byDst.Find (dst.Get ()) != 0;
 }
 
 struct IsExpired
@@ -126,16 +171,34 @@ void
 RequestQueue::Purge ()
 {
   IsExpired pred;
-  for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i
-       != m_queue.end (); ++i)
+  std::vector<QueueEntry> expired;
+  if (m_unordered)
+    {
+      for (Entries::iterator i = m_queue.begin (); i != m_queue.end ();)
+        {
+          Entries::iterator next = i;
+          ++next;
+          if (pred (*i))
+            {
+              expired.push_back (*i);
+              Remove (i);
+            }
+          i = next;
+        }
+    }
+  else
     {
-      if (pred (*i))
+      // with a constant timeout entries expire in arrival order
+      while (!m_queue.empty () && pred (m_queue.front ()))
         {
-          Drop (*i, "Drop outdated packet ");
+          expired.push_back (m_queue.front ());
+          Remove (m_queue.begin ());
         }
     }
-  m_queue.erase (std::remove_if (m_queue.begin (), m_queue.end (), pred),
-                 m_queue.end ());
+  for (std::vector<QueueEntry>::const_iterator i = expired.begin (); i != expired.end (); ++i)
+    {
+      Drop (*i, "Drop outdated packet ");
+    }
 }
 
 void
@@ -29,8 +29,11 @@
 #define AODV_RQUEUE_H
 
 #include <vector>
+#include <list>
+#include <deque>
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/simulator.h"
+#include "ns3/flat-map.h"
 
 
 namespace ns3 {
@@ -92,13 +95,16 @@ private:
  * \brief AODV route request queue
  * 
  * Since AODV is an on demand routing we queue requests while looking for route.
+ *
+ * Entries are kept in arrival order and indexed per destination, so that
+ * the operations on one destination cost O(packets for that destination).
  */
 class RequestQueue
 {
 public:
   /// Default c-tor
   RequestQueue (uint32_t maxLen, Time routeToQueueTimeout) :
-    m_maxLen (maxLen), m_queueTimeout (routeToQueueTimeout)
+    m_size (0), m_unordered (false), m_maxLen (maxLen), m_queueTimeout (routeToQueueTimeout)
   {
   }
   /// Push entry in queue, if there is no entry with the same packet and destination address in queue.
@@ -116,20 +122,32 @@ public:
   uint32_t GetMaxQueueLen () const { return m_maxLen; }
   void SetMaxQueueLen (uint32_t len) { m_maxLen = len; }
   Time GetQueueTimeout () const { return m_queueTimeout; }
-  void SetQueueTimeout (Time t) { m_queueTimeout = t; }
+  void SetQueueTimeout (Time t);
 
 private:
-  
-  std::vector<QueueEntry> m_queue;
+  /// Entries in arrival order
+  typedef std::list<QueueEntry> Entries;
+  /// Entries of one destination in arrival order
+  typedef std::deque<Entries::iterator> Bucket;
+
+  /// Entries in arrival order
+  Entries m_queue;
+  /// Entries by destination address
+  FlatMap<uint32_t, Bucket> m_byDst;
+  /// Number of entries
+  uint32_t m_size;
+  /// Set when the timeout was reduced while entries were queued, so that they may not expire in arrival order
+  bool m_unordered;
   /// Remove all expired entries
   void Purge ();
+  /// Remove entry i from the queue and its destination bucket
+  void Remove (Entries::iterator i);
   /// Notify that packet is dropped from queue by timeout
   void Drop (QueueEntry en, std::string reason);
   /// The maximum number of packets that we allow a routing protocol to buffer.
   uint32_t m_maxLen;
   /// The maximum period of time that a routing protocol is allowed to buffer a packet for, seconds.
   Time m_queueTimeout;
-  static bool IsEqual (QueueEntry en, const Ipv4Address dst) { return (en.GetIpv4Header ().GetDestination () == dst); }
 };
 
 
@@ -183,6 +183,9 @@ private:
 /**
  * \ingroup aodv
  * \brief The Routing table used by AODV protocol
+ *
+ * Purges the whole table before most operations; RoutingProtocol uses
+ * IndexedRoutingTable, which keeps the same behaviour without the scans.
  */
 class RoutingTable
 {
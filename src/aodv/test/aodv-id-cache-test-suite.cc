@@ -93,12 +93,58 @@ IdCacheTest::CheckTimeout3 ()
   NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), 0, "All records expire");
 }
 //-----------------------------------------------------------------------------
+/// Unit test for id cache expiration when the lifetime changes
+class IdCacheLifetimeTest : public TestCase
+{
+public:
+  IdCacheLifetimeTest () : TestCase ("Id Cache lifetime change"), cache (Seconds (10))
+  {}
+  virtual void DoRun ();
+
+private:
+  void CheckTimeout1 ();
+  void CheckTimeout2 ();
+
+  IdCache cache;
+};
+
+void
+IdCacheLifetimeTest::DoRun ()
+{
+  cache.IsDuplicate (Ipv4Address ("1.1.1.1"), 1);
+  // IDs added later with a shorter lifetime expire first
+  cache.SetLifetime (Seconds (2));
+  cache.IsDuplicate (Ipv4Address ("1.1.1.1"), 2);
+  cache.IsDuplicate (Ipv4Address ("2.2.2.2"), 1);
+  NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), 3, "trivial");
+
+  Simulator::Schedule (Seconds (2), &IdCacheLifetimeTest::CheckTimeout1, this);
+  Simulator::Schedule (Seconds (2) + NanoSeconds (1), &IdCacheLifetimeTest::CheckTimeout2, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+IdCacheLifetimeTest::CheckTimeout1 ()
+{
+  NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), 3, "Records expire strictly after their lifetime");
+}
+
+void
+IdCacheLifetimeTest::CheckTimeout2 ()
+{
+  NS_TEST_EXPECT_MSG_EQ (cache.GetSize (), 1, "2 records expire");
+  NS_TEST_EXPECT_MSG_EQ (cache.IsDuplicate (Ipv4Address ("1.1.1.1"), 2), false, "Expired ID");
+  NS_TEST_EXPECT_MSG_EQ (cache.IsDuplicate (Ipv4Address ("1.1.1.1"), 1), true, "Known ID");
+}
+//-----------------------------------------------------------------------------
 class IdCacheTestSuite : public TestSuite
 {
 public:
   IdCacheTestSuite () : TestSuite ("aodv-routing-id-cache", UNIT)
   {
     AddTestCase (new IdCacheTest, TestCase::QUICK);
+    AddTestCase (new IdCacheLifetimeTest, TestCase::QUICK);
   }
 } g_idCacheTestSuite;
 
@@ -22,6 +22,9 @@
 #include "ns3/aodv-packet.h"
 #include "ns3/aodv-rqueue.h"
 #include "ns3/aodv-rtable.h"
+#include "ns3/aodv-indexed-rtable.h"
+#include "ns3/aodv-expiry-wheel.h"
+#include "ns3/random-variable-stream.h"
 #include "ns3/ipv4-route.h"
 
 namespace ns3
@@ -95,6 +98,64 @@ NeighborTest::DoRun ()
   Simulator::Destroy ();
 }
 //-----------------------------------------------------------------------------
+/// Unit test for the order in which neighbors report closed links
+struct NeighborCloseTest : public TestCase
+{
+  NeighborCloseTest () : TestCase ("Neighbor close order"), neighbor (0) { }
+  virtual void DoRun ();
+  void Handler (Ipv4Address addr) { closed.push_back (addr); }
+  void CheckTimeout1 ();
+  void CheckTimeout2 ();
+  Neighbors * neighbor;
+  std::vector<Ipv4Address> closed;
+};
+
+void
+NeighborCloseTest::CheckTimeout1 ()
+{
+  NS_TEST_EXPECT_MSG_EQ (neighbor->IsNeighbor (Ipv4Address ("2.2.2.2")), true, "Extended neighbor exists");
+  NS_TEST_EXPECT_MSG_EQ (closed.size (), 2, "Two links closed");
+  NS_TEST_EXPECT_MSG_EQ (closed[0], Ipv4Address ("3.3.3.3"), "Links close in the order they were opened");
+  NS_TEST_EXPECT_MSG_EQ (closed[1], Ipv4Address ("1.1.1.1"), "Links close in the order they were opened");
+}
+
+void
+NeighborCloseTest::CheckTimeout2 ()
+{
+  NS_TEST_EXPECT_MSG_EQ (neighbor->IsNeighbor (Ipv4Address ("2.2.2.2")), false, "Neighbor doesn't exist");
+  NS_TEST_EXPECT_MSG_EQ (closed.size (), 3, "All links closed");
+  NS_TEST_EXPECT_MSG_EQ (closed[2], Ipv4Address ("2.2.2.2"), "trivial");
+
+  // TX errors close the links to the neighbors with the failed MAC address
+  neighbor->Update (Ipv4Address ("5.5.5.5"), Seconds (10));
+  neighbor->Update (Ipv4Address ("4.4.4.4"), Seconds (10));
+  WifiMacHeader hdr;
+  hdr.SetAddr1 (Mac48Address ());
+  neighbor->GetTxErrorCallback () (hdr);
+  NS_TEST_EXPECT_MSG_EQ (closed.size (), 5, "TX error closes links");
+  NS_TEST_EXPECT_MSG_EQ (closed[3], Ipv4Address ("5.5.5.5"), "trivial");
+  NS_TEST_EXPECT_MSG_EQ (closed[4], Ipv4Address ("4.4.4.4"), "trivial");
+  NS_TEST_EXPECT_MSG_EQ (neighbor->IsNeighbor (Ipv4Address ("4.4.4.4")), false, "Neighbor doesn't exist");
+}
+
+void
+NeighborCloseTest::DoRun ()
+{
+  // purge timer later than the checks
+  Neighbors nb (Seconds (20));
+  neighbor = &nb;
+  neighbor->SetCallback (MakeCallback (&NeighborCloseTest::Handler, this));
+  neighbor->Update (Ipv4Address ("3.3.3.3"), Seconds (5));
+  neighbor->Update (Ipv4Address ("2.2.2.2"), Seconds (1));
+  neighbor->Update (Ipv4Address ("1.1.1.1"), Seconds (2));
+  neighbor->Update (Ipv4Address ("2.2.2.2"), Seconds (8));
+
+  Simulator::Schedule (Seconds (6), &NeighborCloseTest::CheckTimeout1, this);
+  Simulator::Schedule (Seconds (9), &NeighborCloseTest::CheckTimeout2, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+//-----------------------------------------------------------------------------
 struct TypeHeaderTest : public TestCase
 {
   TypeHeaderTest () : TestCase ("AODV TypeHeader") 
@@ -160,6 +221,23 @@ struct RreqHeaderTest : public TestCase
     NS_TEST_EXPECT_MSG_EQ (bytes, 23, "RREP is 23 bytes long");
     NS_TEST_EXPECT_MSG_EQ (h, h2, "Round trip serialization works");
 
+    // a header whose last bytes are in the zero area is read byte by byte
+    h.SetOrigin (Ipv4Address ("0.0.0.0"));
+    h.SetOriginSeqno (0);
+    Buffer contiguous;
+    contiguous.AddAtStart (23);
+    h.Serialize (contiguous.Begin ());
+    uint8_t data[23];
+    contiguous.CopyData (data, 23);
+    Buffer fragmented (8);
+    fragmented.AddAtStart (15);
+    fragmented.Begin ().Write (data, 15);
+    bool contiguous23 = fragmented.Begin ().PeekContiguous (23) != 0;
+    NS_TEST_EXPECT_MSG_EQ (contiguous23, false, "Header is not contiguous");
+    RreqHeader h3;
+    bytes = h3.Deserialize (fragmented.Begin ());
+    NS_TEST_EXPECT_MSG_EQ (bytes, 23, "RREQ is 23 bytes long");
+    NS_TEST_EXPECT_MSG_EQ (h, h3, "Deserialization from a fragmented buffer works");
   }
 };
 //-----------------------------------------------------------------------------
@@ -388,6 +466,83 @@ AodvRqueueTest::CheckTimeout ()
   NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 0, "Must be empty now");
 }
 //-----------------------------------------------------------------------------
+/// Unit test for the per destination order and expiration of RequestQueue
+struct AodvRqueueOrderTest : public TestCase
+{
+  AodvRqueueOrderTest () : TestCase ("Rqueue order"), q (3, Seconds (10)), drops (0) {}
+  virtual void DoRun ();
+  void Unicast (Ptr<Ipv4Route> route, Ptr<const Packet> packet, const Ipv4Header & header) {}
+  void Error (Ptr<const Packet>, const Ipv4Header &, Socket::SocketErrno) { ++drops; }
+  QueueEntry Make (Ptr<const Packet> p, char const * dst);
+  void CheckTimeout ();
+
+  RequestQueue q;
+  uint32_t drops;
+};
+
+QueueEntry
+AodvRqueueOrderTest::Make (Ptr<const Packet> p, char const * dst)
+{
+  Ipv4Header h;
+  h.SetDestination (Ipv4Address (dst));
+  return QueueEntry (p, h, MakeCallback (&AodvRqueueOrderTest::Unicast, this),
+                     MakeCallback (&AodvRqueueOrderTest::Error, this));
+}
+
+void
+AodvRqueueOrderTest::DoRun ()
+{
+  Ptr<const Packet> p1 = Create<Packet> ();
+  Ptr<const Packet> p2 = Create<Packet> ();
+  Ptr<const Packet> p3 = Create<Packet> ();
+  Ptr<const Packet> p4 = Create<Packet> ();
+  QueueEntry e1 = Make (p1, "1.1.1.1");
+  QueueEntry e2 = Make (p2, "2.2.2.2");
+  QueueEntry e3 = Make (p3, "1.1.1.1");
+  QueueEntry e4 = Make (p4, "1.1.1.1");
+  NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e1), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e2), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e3), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e3), false, "Same packet and destination");
+  // full: the oldest packet of any destination goes
+  NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e4), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (drops, 1, "Most aged packet dropped");
+  NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 3, "trivial");
+  QueueEntry e;
+  NS_TEST_EXPECT_MSG_EQ (q.Dequeue (Ipv4Address ("1.1.1.1"), e), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (e.GetPacket (), p3, "Earliest packet for the destination");
+  NS_TEST_EXPECT_MSG_EQ (q.Dequeue (Ipv4Address ("1.1.1.1"), e), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (e.GetPacket (), p4, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (q.Find (Ipv4Address ("1.1.1.1")), false, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (q.Find (Ipv4Address ("2.2.2.2")), true, "trivial");
+
+  // packets queued after the timeout was reduced expire first
+  q.SetQueueTimeout (Seconds (1));
+  NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e3), true, "trivial");
+  Simulator::Schedule (Seconds (2), &AodvRqueueOrderTest::CheckTimeout, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+AodvRqueueOrderTest::CheckTimeout ()
+{
+  NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 1, "Newer packet expired");
+  NS_TEST_EXPECT_MSG_EQ (drops, 2, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (q.Find (Ipv4Address ("1.1.1.1")), false, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (q.Find (Ipv4Address ("2.2.2.2")), true, "trivial");
+  q.DropPacketWithDst (Ipv4Address ("2.2.2.2"));
+  NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 0, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (drops, 3, "trivial");
+
+  // a queue of length 0 drops every packet
+  q.SetMaxQueueLen (0);
+  QueueEntry e5 = Make (Create<Packet> (), "1.1.1.1");
+  NS_TEST_EXPECT_MSG_EQ (q.Enqueue (e5), false, "No room in the queue");
+  NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 0, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (drops, 4, "New packet dropped");
+}
+//-----------------------------------------------------------------------------
 /// Unit test for AODV routing table entry
 struct AodvRtableEntryTest : public TestCase
 {
@@ -467,13 +622,14 @@ struct AodvRtableEntryTest : public TestCase
   }
 };
 //-----------------------------------------------------------------------------
-/// Unit test for AODV routing table
+/// Unit test for AODV routing table, run on both table implementations
+template <typename Table>
 struct AodvRtableTest : public TestCase
 {
-  AodvRtableTest () : TestCase ("Rtable") {}
+  AodvRtableTest (std::string name) : TestCase (name) {}
   virtual void DoRun ()
   {
-    RoutingTable rtable (Seconds (2));
+    Table rtable (Seconds (2));
     NS_TEST_EXPECT_MSG_EQ (rtable.GetBadLinkLifetime (), Seconds (2), "trivial");
     rtable.SetBadLinkLifetime (Seconds (1));
     NS_TEST_EXPECT_MSG_EQ (rtable.GetBadLinkLifetime (), Seconds (1), "trivial");
@@ -520,12 +676,196 @@ struct AodvRtableTest : public TestCase
   }
 };
 //-----------------------------------------------------------------------------
+/// Unit test for ExpiryWheel
+struct ExpiryWheelTest : public TestCase
+{
+  ExpiryWheelTest () : TestCase ("ExpiryWheel") {}
+  virtual void DoRun ()
+  {
+    // 8 slots of 10 ms, so the wheel turns every 80 ms
+    ExpiryWheel<uint32_t> w (MilliSeconds (10), 8);
+    std::vector<ExpiryWheel<uint32_t>::Record> due;
+    w.Schedule (1, MilliSeconds (5));
+    w.Schedule (2, MilliSeconds (15));
+    w.Schedule (3, MilliSeconds (95));
+    w.Schedule (4, MilliSeconds (1000));
+    NS_TEST_EXPECT_MSG_EQ (w.GetSize (), 4, "trivial");
+    w.Expire (MilliSeconds (5), due);
+    NS_TEST_EXPECT_MSG_EQ (due.size (), 0, "expiration time is not before now");
+    w.Expire (MilliSeconds (6), due);
+    NS_TEST_EXPECT_MSG_EQ (due.size (), 1, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (due[0].first, 1, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (due[0].second, MilliSeconds (5), "trivial");
+    due.clear ();
+    // slot 1 holds both 15 ms and 95 ms
+    w.Expire (MilliSeconds (20), due);
+    NS_TEST_EXPECT_MSG_EQ (due.size (), 1, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (due[0].first, 2, "trivial");
+    due.clear ();
+    // a record in the past goes to the current slot
+    w.Schedule (5, MilliSeconds (1));
+    w.Expire (MilliSeconds (21), due);
+    NS_TEST_EXPECT_MSG_EQ (due.size (), 1, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (due[0].first, 5, "trivial");
+    due.clear ();
+    // jump over more than a full turn
+    w.Expire (MilliSeconds (500), due);
+    NS_TEST_EXPECT_MSG_EQ (due.size (), 1, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (due[0].first, 3, "trivial");
+    due.clear ();
+    w.Expire (MilliSeconds (1001), due);
+    NS_TEST_EXPECT_MSG_EQ (due.size (), 1, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (due[0].first, 4, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (w.GetSize (), 0, "trivial");
+    due.clear ();
+    // time going back, as in a new simulation, refiles the records
+    w.Schedule (6, MilliSeconds (2000));
+    w.Schedule (7, MilliSeconds (1500));
+    w.Expire (MilliSeconds (1600), due);
+    NS_TEST_EXPECT_MSG_EQ (due.size (), 1, "trivial");
+    due.clear ();
+    w.Expire (MilliSeconds (100), due);
+    NS_TEST_EXPECT_MSG_EQ (due.size (), 0, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (w.GetSize (), 1, "trivial");
+    w.Expire (MilliSeconds (2001), due);
+    NS_TEST_EXPECT_MSG_EQ (due.size (), 1, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (due[0].first, 6, "trivial");
+  }
+};
+//-----------------------------------------------------------------------------
+/**
+ * Random operations applied to both RoutingTable and IndexedRoutingTable,
+ * which must give the same answers at every step.
+ */
+struct AodvIndexedRtableCompareTest : public TestCase
+{
+  AodvIndexedRtableCompareTest ()
+    : TestCase ("IndexedRtable matches Rtable"),
+      reference (Seconds (3)),
+      indexed (Seconds (3)),
+      mismatches (0)
+  {
+  }
+  virtual void DoRun ();
+  /// Apply one random operation to both tables
+  void Step ();
+  /// Check that both tables have the same entry for dst
+  void Compare (Ipv4Address dst);
+
+  RoutingTable reference;
+  IndexedRoutingTable indexed;
+  Ptr<UniformRandomVariable> rng;
+  uint32_t mismatches;
+};
+
+void
+AodvIndexedRtableCompareTest::DoRun ()
+{
+  rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+  Time t = Seconds (0);
+  for (uint32_t i = 0; i < 3000; ++i)
+    {
+      t += MilliSeconds (rng->GetInteger (0, 300));
+      Simulator::Schedule (t, &AodvIndexedRtableCompareTest::Step, this);
+    }
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (mismatches, 0, "tables disagree");
+  Simulator::Destroy ();
+}
+
+void
+AodvIndexedRtableCompareTest::Step ()
+{
+  Ipv4Address dst (0x0a000001 + rng->GetInteger (0, 40));
+  Ipv4Address nextHop (0x0a000001 + rng->GetInteger (0, 4));
+  Time lifetime = MilliSeconds (rng->GetInteger (0, 6000)) - Seconds (1);
+  RouteFlags flags[] = { VALID, INVALID, IN_SEARCH };
+  RouteFlags flag = flags[rng->GetInteger (0, 2)];
+  RoutingTableEntry rt (/*output device*/ 0, dst, /*validSeqNo*/ true, /*seqNo*/ rng->GetInteger (0, 100),
+                                          Ipv4InterfaceAddress (), /*hop*/ 1, nextHop, lifetime);
+  rt.SetFlag (flag);
+  RoutingTableEntry copy = rt;
+  switch (rng->GetInteger (0, 6))
+    {
+    case 0:
+    case 1:
+      if (reference.AddRoute (rt) != indexed.AddRoute (copy))
+        {
+          ++mismatches;
+        }
+      break;
+    case 2:
+      {
+        // refresh an existing entry, like the routing protocol does
+        RoutingTableEntry a, b;
+        if (reference.LookupRoute (dst, a) && indexed.LookupRoute (dst, b))
+          {
+            a.SetLifeTime (lifetime);
+            b.SetLifeTime (lifetime);
+            a.SetFlag (flag);
+            b.SetFlag (flag);
+            reference.Update (a);
+            indexed.Update (b);
+          }
+        break;
+      }
+    case 3:
+      if (reference.SetEntryState (dst, flag) != indexed.SetEntryState (dst, flag))
+        {
+          ++mismatches;
+        }
+      break;
+    case 4:
+      {
+        std::map<Ipv4Address, uint32_t> a, b;
+        reference.GetListOfDestinationWithNextHop (nextHop, a);
+        indexed.GetListOfDestinationWithNextHop (nextHop, b);
+        if (a != b)
+          {
+            ++mismatches;
+          }
+        reference.InvalidateRoutesWithDst (a);
+        indexed.InvalidateRoutesWithDst (b);
+        break;
+      }
+    case 5:
+      if (reference.DeleteRoute (dst) != indexed.DeleteRoute (dst))
+        {
+          ++mismatches;
+        }
+      break;
+    default:
+      break;
+    }
+  Compare (dst);
+  Compare (nextHop);
+}
+
+void
+AodvIndexedRtableCompareTest::Compare (Ipv4Address dst)
+{
+  RoutingTableEntry a, b;
+  bool foundA = reference.LookupRoute (dst, a);
+  bool foundB = indexed.LookupRoute (dst, b);
+  if (foundA != foundB)
+    {
+      ++mismatches;
+    }
+  else if (foundA && (a.GetFlag () != b.GetFlag () || a.GetLifeTime () != b.GetLifeTime ()
+                      || a.GetSeqNo () != b.GetSeqNo ()))
+    {
+      ++mismatches;
+    }
+}
+//-----------------------------------------------------------------------------
 class AodvTestSuite : public TestSuite
 {
 public:
   AodvTestSuite () : TestSuite ("routing-aodv", UNIT)
   {
     AddTestCase (new NeighborTest, TestCase::QUICK);
+    AddTestCase (new NeighborCloseTest, TestCase::QUICK);
     AddTestCase (new TypeHeaderTest, TestCase::QUICK);
     AddTestCase (new RreqHeaderTest, TestCase::QUICK);
     AddTestCase (new RrepHeaderTest, TestCase::QUICK);
@@ -533,8 +873,12 @@ public:
     AddTestCase (new RerrHeaderTest, TestCase::QUICK);
     AddTestCase (new QueueEntryTest, TestCase::QUICK);
     AddTestCase (new AodvRqueueTest, TestCase::QUICK);
+    AddTestCase (new AodvRqueueOrderTest, TestCase::QUICK);
     AddTestCase (new AodvRtableEntryTest, TestCase::QUICK);
-    AddTestCase (new AodvRtableTest, TestCase::QUICK);
+    AddTestCase (new AodvRtableTest<RoutingTable> ("Rtable"), TestCase::QUICK);
+    AddTestCase (new AodvRtableTest<IndexedRoutingTable> ("IndexedRtable"), TestCase::QUICK);
+    AddTestCase (new ExpiryWheelTest, TestCase::QUICK);
+    AddTestCase (new AodvIndexedRtableCompareTest, TestCase::QUICK);
   }
 } g_aodvTestSuite;
 
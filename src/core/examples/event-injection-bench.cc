@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <sys/time.h>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+/**
+ * \file
+ * \ingroup thread
+ * Benchmark of the events injected into the simulator by other threads.
+ *
+ * Reader threads, such as those of ns3::FdNetDevice, hand the packets they
+ * receive to the simulator with Simulator::ScheduleWithContext. This
+ * program starts a number of such injector threads, each scheduling a
+ * number of events as fast as it can, while the main thread runs the
+ * simulation. It reports the wall clock time until all the events ran,
+ * and checks that the events of each thread ran in order. Each injector
+ * can pause between its events, as a reader thread waits for packets.
+ *
+ * \verbatim
+   ./waf --run="event-injection-bench --threads=4 --events=1000000"
+   \endverbatim
+ */
+
+using namespace ns3;
+
+namespace {
+
+/// Injector threads and the events they schedule
+class Injection
+{
+public:
+  Injection (uint32_t threads, uint32_t events, uint32_t pause)
+    : m_events (events),
+      m_pause (pause),
+      m_next (threads, 0),
+      m_received (0),
+      m_ordered (true)
+  {
+  }
+  /// Body of the injector threads
+  static void Inject (std::pair<Injection *, uint32_t> context)
+  {
+    context.first->Run (context.second);
+  }
+  /// Keep the simulation running until all the events are received
+  void Poll (void)
+  {
+    if (m_received < m_next.size () * uint64_t (m_events))
+      {
+        Simulator::Schedule (NanoSeconds (1), &Injection::Poll, this);
+      }
+  }
+  bool IsOrdered (void) const
+  {
+    return m_ordered;
+  }
+
+private:
+  void Run (uint32_t thread)
+  {
+    for (uint32_t i = 0; i < m_events; i++)
+      {
+        Simulator::ScheduleWithContext (thread, Seconds (0), &Injection::Receive, this, thread, i);
+        for (volatile uint32_t j = 0; j < m_pause; j++)
+          {
+          }
+      }
+  }
+  void Receive (uint32_t thread, uint32_t i)
+  {
+    m_ordered = m_ordered && m_next[thread] == i;
+    m_next[thread] = i + 1;
+    m_received++;
+  }
+
+  uint32_t m_events;
+  uint32_t m_pause;
+  std::vector<uint32_t> m_next;
+  uint64_t m_received;
+  bool m_ordered;
+};
+
+double
+GetWallClock (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+} // namespace
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t threads = 4;
+  uint32_t events = 1000000;
+  uint32_t pause = 0;
+
+  CommandLine cmd;
+  cmd.AddValue ("threads", "Number of injector threads", threads);
+  cmd.AddValue ("events", "Number of events scheduled by each thread", events);
+  cmd.AddValue ("pause", "Iterations of an empty loop between two events of a thread", pause);
+  cmd.Parse (argc, argv);
+
+  if (threads == 0 || events == 0)
+    {
+      std::cerr << "threads and events must be positive" << std::endl;
+      return 1;
+    }
+
+  Injection injection (threads, events, pause);
+  Simulator::Schedule (NanoSeconds (1), &Injection::Poll, &injection);
+  std::vector<Ptr<SystemThread> > injectors;
+  for (uint32_t i = 0; i < threads; i++)
+    {
+      injectors.push_back (Create<SystemThread> (MakeBoundCallback (&Injection::Inject,
+                                                                    std::make_pair (&injection, i))));
+    }
+  double start = GetWallClock ();
+  for (uint32_t i = 0; i < threads; i++)
+    {
+      injectors[i]->Start ();
+    }
+  Simulator::Run ();
+  double wall = GetWallClock () - start;
+  for (uint32_t i = 0; i < threads; i++)
+    {
+      injectors[i]->Join ();
+    }
+  uint64_t total = Simulator::GetEventCount ();
+  Simulator::Destroy ();
+
+  uint64_t injected = uint64_t (threads) * events;
+  std::cout << "threads " << threads << " events " << injected << " (" << total << " run)" << std::endl
+            << std::fixed << std::setprecision (3) << wall << " s "
+            << std::setprecision (0) << injected / wall << " injected events/s" << std::endl
+            << "events " << (injection.IsOrdered () ? "in order" : "OUT OF ORDER") << std::endl;
+  return injection.IsOrdered () ? 0 : 1;
+}
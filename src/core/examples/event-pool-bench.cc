@@ -0,0 +1,244 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <new>
+
+#include "ns3/core-module.h"
+
+/**
+ * \file
+ * \ingroup events
+ * Benchmark of the event free lists.
+ *
+ * Keeps a number of event chains running: every event schedules the next
+ * one of its chain, through member and function MakeEvent templates with
+ * zero to five bound arguments. The same chains run with the EventPool
+ * disabled, then enabled. The program replaces the global operator new
+ * and delete to count every heap allocation of the process, next to the
+ * counters of EventImpl::GetPoolStats.
+ *
+ * The scheduler is the one of the SchedulerType global value. Node based
+ * schedulers such as ns3::MapScheduler allocate for every event too.
+ *
+ * \verbatim
+   ./waf --run="event-pool-bench --chains=1000 --events=2000000 --SchedulerType=ns3::LadderScheduler"
+   \endverbatim
+ */
+
+namespace {
+
+/// Number of calls to the global operator new
+uint64_t g_news = 0;
+/// Number of calls to the global operator delete
+uint64_t g_deletes = 0;
+
+} // namespace
+
+void *
+operator new (std::size_t size)
+{
+  g_news++;
+  void *p = std::malloc (size == 0 ? 1 : size);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+void
+operator delete (void *p) throw ()
+{
+  if (p != 0)
+    {
+      g_deletes++;
+      std::free (p);
+    }
+}
+
+using namespace ns3;
+
+namespace {
+
+/// Event chains
+class Chains
+{
+public:
+  Chains (uint64_t events)
+    : m_left (events),
+      m_sum (0)
+  {
+  }
+  void Start (uint32_t chains)
+  {
+    for (uint32_t i = 0; i < chains; i++)
+      {
+        Next (i);
+      }
+  }
+  uint64_t GetSum (void) const
+  {
+    return m_sum;
+  }
+
+private:
+  /// Schedule the next event of chain i, with i % 7 bound arguments
+  void Next (uint32_t i)
+  {
+    if (m_left == 0)
+      {
+        return;
+      }
+    m_left--;
+    Time delay = NanoSeconds (1 + (m_left * 7919) % 10000);
+    switch (i % 7)
+      {
+      case 0:
+        Simulator::Schedule (delay, &Chains::Run1, this, i);
+        break;
+      case 1:
+        Simulator::Schedule (delay, &Chains::Run2, this, i, m_left);
+        break;
+      case 2:
+        Simulator::Schedule (delay, &Chains::Run3, this, i, m_left, 0.5);
+        break;
+      case 3:
+        Simulator::Schedule (delay, &Chains::Run4, this, i, m_left, 0.5, true);
+        break;
+      case 4:
+        Simulator::Schedule (delay, &Chains::Run5, this, i, m_left, 0.5, true, 'x');
+        break;
+      case 5:
+        Simulator::ScheduleWithContext (i, delay, &Chains::Run3, this, i, m_left, 0.25);
+        break;
+      default:
+        Simulator::Schedule (delay, &Chains::Static2, this, i);
+        break;
+      }
+  }
+  void Run1 (uint32_t i)
+  {
+    m_sum += i;
+    Next (i);
+  }
+  void Run2 (uint32_t i, uint64_t a)
+  {
+    m_sum += a;
+    Next (i);
+  }
+  void Run3 (uint32_t i, uint64_t a, double b)
+  {
+    m_sum += a + uint64_t (b * 4);
+    Next (i);
+  }
+  void Run4 (uint32_t i, uint64_t a, double b, bool c)
+  {
+    m_sum += a + c;
+    Next (i);
+  }
+  void Run5 (uint32_t i, uint64_t a, double b, bool c, char d)
+  {
+    m_sum += a + d;
+    Next (i);
+  }
+  static void Static2 (Chains *chains, uint32_t i)
+  {
+    chains->Run1 (i);
+  }
+
+  uint64_t m_left;
+  uint64_t m_sum;
+};
+
+/// Measurements of one run
+struct Result
+{
+  double cpu;                    ///< CPU time in seconds
+  uint64_t sum;                  ///< Checksum of the event arguments
+  uint64_t news;                 ///< Calls to operator new
+  uint64_t deletes;              ///< Calls to operator delete
+  EventImpl::PoolStats stats;    ///< Event allocation counters
+};
+
+Result
+Run (bool pool, uint32_t chains, uint64_t events)
+{
+  Chains c (events);
+  Simulator::Schedule (Seconds (0), &Chains::Start, &c, chains);
+  EventImpl::SetPoolEnabled (pool);
+  EventImpl::ResetPoolStats ();
+  Result r;
+  r.news = g_news;
+  r.deletes = g_deletes;
+  clock_t start = clock ();
+  Simulator::Run ();
+  r.cpu = double (clock () - start) / CLOCKS_PER_SEC;
+  r.news = g_news - r.news;
+  r.deletes = g_deletes - r.deletes;
+  r.stats = EventImpl::GetPoolStats ();
+  r.sum = c.GetSum ();
+  Simulator::Destroy ();
+  return r;
+}
+
+void
+Print (std::string name, Result const &r, uint64_t events)
+{
+  std::cout << std::left << std::setw (10) << name << std::right << std::fixed
+            << std::setprecision (3) << std::setw (8) << r.cpu << " s"
+            << std::setw (12) << r.stats.m_allocations << " events"
+            << std::setw (12) << r.stats.m_heapAllocations << " from heap"
+            << std::setprecision (2) << std::setw (8) << double (r.news) / events << " new/event"
+            << std::setw (8) << double (r.deletes) / events << " delete/event" << std::endl;
+}
+
+} // namespace
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t chains = 1000;
+  uint64_t events = 2000000;
+
+  CommandLine cmd;
+  cmd.AddValue ("chains", "Number of concurrent event chains", chains);
+  cmd.AddValue ("events", "Number of events to run", events);
+  cmd.Parse (argc, argv);
+
+  if (chains == 0 || events == 0)
+    {
+      std::cerr << "chains and events must be positive" << std::endl;
+      return 1;
+    }
+
+  Result heap = Run (false, chains, events);
+  Result pool = Run (true, chains, events);
+
+  bool match = heap.sum == pool.sum;
+  std::cout << "chains " << chains << " events " << events << std::endl;
+  Print ("heap", heap, events);
+  Print ("EventPool", pool, events);
+  if (pool.cpu > 0)
+    {
+      std::cout << "speedup   " << std::setw (8) << std::setprecision (2) << heap.cpu / pool.cpu << std::endl;
+    }
+  std::cout << "events " << (match ? "match" : "DIFFER") << std::endl;
+  return match ? 0 : 1;
+}
@@ -0,0 +1,346 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Benchmark of the event schedulers on recorded event-time traces.
+ *
+ * Records the scheduler operations of a simulation: event insertions with
+ * their time stamps, removals of the next event and removals of cancelled
+ * events. The trace then is replayed against ns3::MapScheduler,
+ * ns3::HeapScheduler, ns3::CalendarScheduler, ns3::LadderScheduler and,
+ * with \c --list, ns3::ListScheduler. They must all dequeue the events in
+ * the same order.
+ *
+ * The recorded simulation is a synthetic wireless network: every node
+ * broadcasts hellos that all its neighbors receive within a few
+ * microseconds of each other, refreshes a neighbor timer on each reception,
+ * and sends data packets that are forwarded hop by hop after a random
+ * backoff. The source of each packet arms a far retransmission timeout
+ * that the delivery removes. Instead, a trace can be read from a file
+ * written by a previous run with \c --save, one operation per line:
+ * "i <ts> <uid>" to insert, "n" to remove the next event, and
+ * "r <ts> <uid>" to remove an event.
+ *
+ * \verbatim
+   ./waf --run="scheduler-trace-bench --nodes=500 --duration=20"
+   ./waf --run="scheduler-trace-bench --trace=events.txt"
+   \endverbatim
+ */
+
+using namespace ns3;
+
+namespace {
+
+/// Scheduler operation
+struct Operation
+{
+  char type;      ///< 'i' insert, 'n' remove next, 'r' remove
+  uint64_t ts;    ///< Event time stamp
+  uint32_t uid;   ///< Event unique id
+};
+
+/// Trace being recorded
+std::vector<Operation> *g_trace = 0;
+
+/// MapScheduler that appends its operations to g_trace
+class TraceRecordingScheduler : public MapScheduler
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::TraceRecordingScheduler")
+      .SetParent<MapScheduler> ()
+      .SetGroupName ("Core")
+      .AddConstructor<TraceRecordingScheduler> ()
+    ;
+    return tid;
+  }
+  virtual void Insert (const Scheduler::Event &ev)
+  {
+    Record ('i', ev);
+    MapScheduler::Insert (ev);
+  }
+  virtual Scheduler::Event RemoveNext (void)
+  {
+    Scheduler::Event ev = MapScheduler::RemoveNext ();
+    Record ('n', ev);
+    return ev;
+  }
+  virtual void Remove (const Scheduler::Event &ev)
+  {
+    Record ('r', ev);
+    MapScheduler::Remove (ev);
+  }
+
+private:
+  void Record (char type, const Scheduler::Event &ev)
+  {
+    Operation op = { type, ev.key.m_ts, ev.key.m_uid };
+    g_trace->push_back (op);
+  }
+};
+
+NS_OBJECT_ENSURE_REGISTERED (TraceRecordingScheduler);
+
+/// Synthetic wireless network driving the recorded simulation
+class Network
+{
+public:
+  Network (uint32_t nodes, uint32_t degree, Time packetInterval)
+    : m_nodes (nodes),
+      m_degree (std::min (degree, nodes - 1)),
+      m_packetInterval (packetInterval),
+      m_neighborTimers (nodes)
+  {
+    m_rng = CreateObject<UniformRandomVariable> ();
+    m_rng->SetStream (1);
+  }
+  void Start (void)
+  {
+    for (uint32_t n = 0; n < m_nodes; n++)
+      {
+        Simulator::Schedule (MicroSeconds (m_rng->GetInteger (0, 1000000)), &Network::Hello, this, n);
+        Simulator::Schedule (MicroSeconds (m_rng->GetInteger (0, 1000000)), &Network::Generate, this, n);
+      }
+  }
+
+private:
+  uint32_t GetNeighbor (uint32_t node, uint32_t k) const
+  {
+    return (node + 1 + k * 7) % m_nodes;
+  }
+  /// Broadcast a frame: every neighbor receives it after the propagation delay
+  void Broadcast (uint32_t node)
+  {
+    Time txTime = MicroSeconds (400);
+    for (uint32_t k = 0; k < m_degree; k++)
+      {
+        Simulator::Schedule (txTime + NanoSeconds (100 * (k + 1)), &Network::Receive, this,
+                             GetNeighbor (node, k), node);
+      }
+  }
+  void Hello (uint32_t node)
+  {
+    Broadcast (node);
+    Simulator::Schedule (Seconds (1) + MicroSeconds (m_rng->GetInteger (0, 100000)), &Network::Hello, this, node);
+  }
+  void Receive (uint32_t node, uint32_t from)
+  {
+    // neighbor timers are refreshed by cancelling them, as ns3::Timer does
+    m_neighborTimers[node].Cancel ();
+    m_neighborTimers[node] = Simulator::Schedule (Seconds (3), &Network::NeighborLost, this, node);
+  }
+  void NeighborLost (uint32_t node)
+  {
+  }
+  void Generate (uint32_t node)
+  {
+    uint32_t hops = m_rng->GetInteger (1, 8);
+    EventId timeout = Simulator::Schedule (Seconds (2), &Network::Timeout, this, node);
+    Forward (node, hops, timeout);
+    Simulator::Schedule (m_packetInterval * m_rng->GetValue (0.5, 1.5), &Network::Generate, this, node);
+  }
+  void Forward (uint32_t node, uint32_t hops, EventId timeout)
+  {
+    if (hops == 0)
+      {
+        Simulator::Remove (timeout);
+        return;
+      }
+    Broadcast (node);
+    uint32_t next = GetNeighbor (node, m_rng->GetInteger (0, m_degree - 1));
+    Time backoff = MicroSeconds (m_rng->GetInteger (0, 31) * 20);
+    Simulator::Schedule (MicroSeconds (500) + backoff, &Network::Forward, this, next, hops - 1, timeout);
+  }
+  void Timeout (uint32_t node)
+  {
+  }
+
+  uint32_t m_nodes;
+  uint32_t m_degree;
+  Time m_packetInterval;
+  std::vector<EventId> m_neighborTimers;
+  Ptr<UniformRandomVariable> m_rng;
+};
+
+/// Replay result
+struct Result
+{
+  double cpu;           ///< CPU time in seconds
+  uint64_t checksum;    ///< Hash of the order of the dequeued events
+};
+
+Result
+Replay (std::string type, std::vector<Operation> const &trace)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (type);
+  Ptr<Scheduler> scheduler = factory.Create<Scheduler> ();
+  Result result;
+  result.checksum = 14695981039346656037ULL;
+  clock_t start = clock ();
+  for (std::vector<Operation>::const_iterator i = trace.begin (); i != trace.end (); ++i)
+    {
+      Scheduler::Event ev;
+      ev.impl = 0;
+      ev.key.m_ts = i->ts;
+      ev.key.m_uid = i->uid;
+      ev.key.m_context = 0;
+      if (i->type == 'i')
+        {
+          scheduler->Insert (ev);
+        }
+      else if (i->type == 'r')
+        {
+          scheduler->Remove (ev);
+        }
+      else
+        {
+          result.checksum = (result.checksum ^ scheduler->RemoveNext ().key.m_uid) * 1099511628211ULL;
+        }
+    }
+  result.cpu = double (clock () - start) / CLOCKS_PER_SEC;
+  return result;
+}
+
+bool
+Load (std::string file, std::vector<Operation> &trace)
+{
+  std::ifstream in (file.c_str ());
+  Operation op;
+  while (in >> op.type)
+    {
+      op.ts = 0;
+      op.uid = 0;
+      if (op.type != 'n' && !(in >> op.ts >> op.uid))
+        {
+          return false;
+        }
+      trace.push_back (op);
+    }
+  return in.eof () && !trace.empty ();
+}
+
+void
+Save (std::string file, std::vector<Operation> const &trace)
+{
+  std::ofstream out (file.c_str ());
+  for (std::vector<Operation>::const_iterator i = trace.begin (); i != trace.end (); ++i)
+    {
+      out << i->type;
+      if (i->type != 'n')
+        {
+          out << " " << i->ts << " " << i->uid;
+        }
+      out << "\n";
+    }
+}
+
+} // namespace
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nodes = 100;
+  uint32_t degree = 10;
+  Time duration = Seconds (10);
+  Time packetInterval = Seconds (1);
+  std::string traceFile;
+  std::string saveFile;
+  bool list = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("nodes", "Number of nodes of the recorded network", nodes);
+  cmd.AddValue ("degree", "Number of neighbors of each node", degree);
+  cmd.AddValue ("duration", "Simulated time to record", duration);
+  cmd.AddValue ("packetInterval", "Mean time between packets sent by a node", packetInterval);
+  cmd.AddValue ("trace", "Replay the trace in this file instead of recording one", traceFile);
+  cmd.AddValue ("save", "Write the trace to this file", saveFile);
+  cmd.AddValue ("list", "Include ns3::ListScheduler, which is slow on long event lists", list);
+  cmd.Parse (argc, argv);
+
+  std::vector<Operation> trace;
+  if (!traceFile.empty ())
+    {
+      if (!Load (traceFile, trace))
+        {
+          std::cerr << "cannot read a trace from " << traceFile << std::endl;
+          return 1;
+        }
+    }
+  else
+    {
+      if (nodes < 2 || degree == 0)
+        {
+          std::cerr << "nodes must be at least 2 and degree positive" << std::endl;
+          return 1;
+        }
+      g_trace = &trace;
+      Simulator::SetScheduler (ObjectFactory ("ns3::TraceRecordingScheduler"));
+      Network network (nodes, degree, packetInterval);
+      network.Start ();
+      Simulator::Stop (duration);
+      Simulator::Run ();
+      Simulator::Destroy ();
+      g_trace = 0;
+    }
+  if (!saveFile.empty ())
+    {
+      Save (saveFile, trace);
+    }
+
+  uint64_t removeNext = 0;
+  for (std::vector<Operation>::const_iterator i = trace.begin (); i != trace.end (); ++i)
+    {
+      removeNext += (i->type == 'n');
+    }
+  std::cout << "operations " << trace.size () << " events run " << removeNext << std::endl;
+
+  std::vector<std::string> types;
+  if (list)
+    {
+      types.push_back ("ns3::ListScheduler");
+    }
+  types.push_back ("ns3::MapScheduler");
+  types.push_back ("ns3::HeapScheduler");
+  types.push_back ("ns3::CalendarScheduler");
+  types.push_back ("ns3::LadderScheduler");
+
+  Result reference = Replay ("ns3::MapScheduler", trace);
+  bool match = true;
+  for (std::vector<std::string>::const_iterator i = types.begin (); i != types.end (); ++i)
+    {
+      Result r = Replay (*i, trace);
+      bool same = r.checksum == reference.checksum;
+      match = match && same;
+      std::cout << std::left << std::setw (24) << *i << std::right << std::fixed
+                << std::setprecision (3) << std::setw (8) << r.cpu << " s "
+                << std::setprecision (1) << std::setw (8) << r.cpu * 1e9 / trace.size () << " ns/op "
+                << (same ? "match" : "DIFFER") << std::endl;
+    }
+  return match ? 0 : 1;
+}
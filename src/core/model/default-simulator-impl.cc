@@ -22,13 +22,16 @@
 #include "default-simulator-impl.h"
 #include "scheduler.h"
 #include "event-impl.h"
+#include "event-profiler.h"
 
 #include "ptr.h"
 #include "pointer.h"
+#include "string.h"
 #include "assert.h"
 #include "log.h"
 
 #include <cmath>
+#include <sched.h>
 
 
 /**
@@ -53,11 +56,25 @@ DefaultSimulatorImpl::GetTypeId (void)
     .SetParent<SimulatorImpl> ()
     .SetGroupName ("Core")
     .AddConstructor<DefaultSimulatorImpl> ()
+    .AddAttribute ("ProfileFile",
+                   "If not empty, account for the events run per context "
+                   "and per target, and write this account to the file at "
+                   "Simulator::Destroy. See ns3::EventProfiler.",
+                   StringValue (""),
+                   MakeStringAccessor (&DefaultSimulatorImpl::m_profileFile),
+                   MakeStringChecker ())
+    .AddAttribute ("ProfileInterval",
+                   "The simulated time between two samples of the number "
+                   "of pending events in the profile.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&DefaultSimulatorImpl::m_profileInterval),
+                   MakeTimeChecker (Seconds (0)))
   ;
   return tid;
 }
 
 DefaultSimulatorImpl::DefaultSimulatorImpl ()
+  : m_eventsWithContext (EVENTS_WITH_CONTEXT_CAPACITY)
 {
   NS_LOG_FUNCTION (this);
   m_stop = false;
@@ -69,15 +86,18 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   // before ::Run is entered, the m_currentUid will be zero
   m_currentUid = 0;
   m_currentTs = 0;
+  m_eventCount = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
-  m_eventsWithContextEmpty = true;
+  m_eventsWithContextOverflowing = 0;
   m_main = SystemThread::Self();
+  m_profiler = 0;
 }
 
 DefaultSimulatorImpl::~DefaultSimulatorImpl ()
 {
   NS_LOG_FUNCTION (this);
+  delete m_profiler;
 }
 
 void
@@ -92,6 +112,8 @@ DefaultSimulatorImpl::DoDispose (void)
       next.impl->Unref ();
     }
   m_events = 0;
+  delete m_profiler;
+  m_profiler = 0;
   SimulatorImpl::DoDispose ();
 }
 void
@@ -108,6 +130,10 @@ DefaultSimulatorImpl::Destroy ()
           ev->Invoke ();
         }
     }
+  if (m_profiler != 0)
+    {
+      m_profiler->Write (m_profileFile);
+    }
 }
 
 void
@@ -146,7 +172,15 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
   m_currentTs = next.key.m_ts;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
-  next.impl->Invoke ();
+  m_eventCount++;
+  if (m_profiler == 0)
+    {
+      next.impl->Invoke ();
+    }
+  else
+    {
+      m_profiler->Invoke (m_currentContext, next.impl, m_currentTs, m_unscheduledEvents);
+    }
   next.impl->Unref ();
 
   ProcessEventsWithContext ();
@@ -161,33 +195,62 @@ DefaultSimulatorImpl::IsFinished (void) const
 void
 DefaultSimulatorImpl::ProcessEventsWithContext (void)
 {
-  if (m_eventsWithContextEmpty)
+  if (m_eventsWithContext.IsEmpty ()
+      && __atomic_load_n (&m_eventsWithContextOverflowing, __ATOMIC_RELAXED) == 0)
     {
       return;
     }
 
-  // swap queues
-  EventsWithContext eventsWithContext;
-  {
-    CriticalSection cs (m_eventsWithContextMutex);
-    m_eventsWithContext.swap(eventsWithContext);
-    m_eventsWithContextEmpty = true;
-  }
-  while (!eventsWithContext.empty ())
+  EventWithContext event;
+  while (m_eventsWithContext.Dequeue (event))
     {
-       EventWithContext event = eventsWithContext.front ();
-       eventsWithContext.pop_front ();
-       Scheduler::Event ev;
-       ev.impl = event.event;
-       ev.key.m_ts = m_currentTs + event.timestamp;
-       ev.key.m_context = event.context;
-       ev.key.m_uid = m_uid;
-       m_uid++;
-       m_unscheduledEvents++;
-       m_events->Insert (ev);
+      InsertEventWithContext (event);
+    }
+  if (__atomic_load_n (&m_eventsWithContextOverflowing, __ATOMIC_ACQUIRE) != 0)
+    {
+      EventsWithContext eventsWithContext;
+      {
+        CriticalSection cs (m_eventsWithContextMutex);
+        m_eventsWithContextOverflow.swap (eventsWithContext);
+        // a thread appends to the overflow list only after claiming the
+        // cells of its previous events, which must run first; another
+        // thread may still be publishing an earlier cell, where Dequeue
+        // stops, so wait for every claimed cell
+        for (uint32_t claimed = m_eventsWithContext.GetClaimed (); claimed > 0; )
+          {
+            if (m_eventsWithContext.Dequeue (event))
+              {
+                InsertEventWithContext (event);
+                claimed--;
+              }
+            else
+              {
+                sched_yield ();
+              }
+          }
+        __atomic_store_n (&m_eventsWithContextOverflowing, 0, __ATOMIC_RELEASE);
+      }
+      while (!eventsWithContext.empty ())
+        {
+          InsertEventWithContext (eventsWithContext.front ());
+          eventsWithContext.pop_front ();
+        }
     }
 }
 
+void
+DefaultSimulatorImpl::InsertEventWithContext (const EventWithContext &event)
+{
+  Scheduler::Event ev;
+  ev.impl = event.event;
+  ev.key.m_ts = m_currentTs + event.timestamp;
+  ev.key.m_context = event.context;
+  ev.key.m_uid = m_uid;
+  m_uid++;
+  m_unscheduledEvents++;
+  m_events->Insert (ev);
+}
+
 void
 DefaultSimulatorImpl::Run (void)
 {
@@ -196,6 +259,10 @@ DefaultSimulatorImpl::Run (void)
   m_main = SystemThread::Self();
   ProcessEventsWithContext ();
   m_stop = false;
+  if (!m_profileFile.empty () && m_profiler == 0)
+    {
+      m_profiler = new EventProfiler (m_profileInterval.GetTimeStep ());
+    }
 
   while (!m_events->IsEmpty () && !m_stop) 
     {
@@ -269,11 +336,14 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
       // Current time added in ProcessEventsWithContext()
       ev.timestamp = delay.GetTimeStep ();
       ev.event = event;
-      {
-        CriticalSection cs (m_eventsWithContextMutex);
-        m_eventsWithContext.push_back(ev);
-        m_eventsWithContextEmpty = false;
-      }
+      if (__atomic_load_n (&m_eventsWithContextOverflowing, __ATOMIC_ACQUIRE) == 0
+          && m_eventsWithContext.Enqueue (ev))
+        {
+          return;
+        }
+      CriticalSection cs (m_eventsWithContextMutex);
+      m_eventsWithContextOverflow.push_back (ev);
+      __atomic_store_n (&m_eventsWithContextOverflowing, 1, __ATOMIC_RELEASE);
     }
 }
 
@@ -414,4 +484,10 @@ DefaultSimulatorImpl::GetContext (void) const
   return m_currentContext;
 }
 
+uint64_t
+DefaultSimulatorImpl::GetEventCount (void) const
+{
+  return m_eventCount;
+}
+
 } // namespace ns3
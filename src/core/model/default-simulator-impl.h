@@ -24,12 +24,15 @@
 #include "simulator-impl.h"
 #include "scheduler.h"
 #include "event-impl.h"
+#include "mpsc-queue.h"
 #include "system-thread.h"
 #include "ns3/system-mutex.h"
+#include "nstime.h"
 
 #include "ptr.h"
 
 #include <list>
+#include <string>
 
 /**
  * \file
@@ -39,6 +42,8 @@
 
 namespace ns3 {
 
+class EventProfiler;
+
 /**
  * \ingroup simulator
  *
@@ -77,6 +82,7 @@ public:
   virtual void SetScheduler (ObjectFactory schedulerFactory);
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
+  virtual uint64_t GetEventCount (void) const;
 
 private:
   virtual void DoDispose (void);
@@ -95,16 +101,35 @@ private:
     /** The event implementation. */
     EventImpl *event;
   };
+  /**
+   * Insert an event from a different context in the event list.
+   * \param [in] event The event.
+   */
+  void InsertEventWithContext (const EventWithContext &event);
+  /**
+   * Number of events from a different context that can wait in
+   * m_eventsWithContext.
+   */
+  enum { EVENTS_WITH_CONTEXT_CAPACITY = 1024 };
+  /**
+   * The events from a different context. Other threads inject their
+   * events there without taking a lock, and the main thread polls it
+   * after every event.
+   */
+  MpscQueue<struct EventWithContext> m_eventsWithContext;
   /** Container type for the events from a different context. */
   typedef std::list<struct EventWithContext> EventsWithContext;
-  /** The container of events from a different context. */
-  EventsWithContext m_eventsWithContext;
   /**
-   * Flag \c true if all events with context have been moved to the
-   * primary event queue.
+   * The events from a different context which did not fit in
+   * m_eventsWithContext.
    */
-  bool m_eventsWithContextEmpty;
-  /** Mutex to control access to the list of events with context. */
+  EventsWithContext m_eventsWithContextOverflow;
+  /**
+   * Non zero while m_eventsWithContextOverflow holds events. Other
+   * threads then append their events to it too, to keep them in order.
+   */
+  uint32_t m_eventsWithContextOverflowing;
+  /** Mutex to control access to m_eventsWithContextOverflow. */
   SystemMutex m_eventsWithContextMutex;
 
   /** Container type for the events to run at Simulator::Destroy() */
@@ -122,6 +147,8 @@ private:
   uint32_t m_currentUid;
   /** Timestamp of the current event. */
   uint64_t m_currentTs;
+  /** Number of events executed so far. */
+  uint64_t m_eventCount;
   /** Execution context of the current event. */
   uint32_t m_currentContext;
   /**
@@ -132,6 +159,13 @@ private:
 
   /** Main execution thread. */
   SystemThread::ThreadId m_main;
+
+  /** File to write the event profile to, empty to disable profiling. */
+  std::string m_profileFile;
+  /** Sampling interval of the pending events in the profile. */
+  Time m_profileInterval;
+  /** The event profiler, created by Run() when profiling is enabled. */
+  EventProfiler *m_profiler;
 };
 
 } // namespace ns3
@@ -19,6 +19,7 @@
  */
 
 #include "event-impl.h"
+#include "size-class-pool.h"
 #include "log.h"
 
 /**
@@ -31,6 +32,77 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+namespace {
+
+/**
+ * Whether events are allocated from the free lists. Read by every thread,
+ * so it is only accessed atomically.
+ */
+bool g_poolEnabled = true;
+/** Free lists of the events of the calling thread. */
+__thread SizeClassPool::Lists g_freeLists;
+
+/**
+ * \returns Whether the free lists are enabled.
+ */
+bool
+PoolEnabled (void)
+{
+  return __atomic_load_n (&g_poolEnabled, __ATOMIC_RELAXED);
+}
+
+} // anonymous namespace
+
+void *
+EventImpl::operator new (std::size_t size)
+{
+  // always allocate the whole size class, so that the block can be
+  // reused by any event of the class once freed
+  return SizeClassPool::Allocate (g_freeLists, SizeClassPool::GetBlockSize (size));
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  if (p == 0)
+    {
+      return;
+    }
+  SizeClassPool::Free (g_freeLists, p, SizeClassPool::GetBlockSize (size), PoolEnabled ());
+}
+
+void
+EventImpl::SetPoolEnabled (bool enabled)
+{
+  // no logging: called while the simulator is created
+  __atomic_store_n (&g_poolEnabled, enabled, __ATOMIC_RELAXED);
+  if (!enabled)
+    {
+      SizeClassPool::Release (g_freeLists, false);
+    }
+}
+
+bool
+EventImpl::IsPoolEnabled (void)
+{
+  return PoolEnabled ();
+}
+
+EventImpl::PoolStats
+EventImpl::GetPoolStats (void)
+{
+  SizeClassPool::Stats const &lists = g_freeLists.m_stats;
+  EventImpl::PoolStats stats = { lists.m_allocations, lists.m_allocations - lists.m_hits,
+                                 lists.m_frees, lists.m_heapFrees };
+  return stats;
+}
+
+void
+EventImpl::ResetPoolStats (void)
+{
+  SizeClassPool::ResetStats (g_freeLists);
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
@@ -66,4 +138,10 @@ EventImpl::IsCancelled (void)
   return m_cancel;
 }
 
+const void *
+EventImpl::GetFunction (void) const
+{
+  return 0;
+}
+
 } // namespace ns3
@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 /**
@@ -65,6 +66,63 @@ public:
    * Checked by the simulation engine before calling Invoke().
    */
   bool IsCancelled (void);
+  /**
+   * \returns The address of the function this event calls, or 0 if it is
+   *          not known.
+   *
+   * Used by EventProfiler to account for events per target. The events
+   * created by MakeEvent() return the function or class method they bind.
+   */
+  virtual const void * GetFunction (void) const;
+
+  /**
+   * \name Event allocation
+   *
+   * Events are allocated and freed at a high rate, so each thread keeps
+   * the memory of the events it freed in the free lists of a
+   * SizeClassPool, and allocates new events from them. While the pool
+   * is disabled, freed events return to the heap.
+   */
+  /**@{*/
+  /**
+   * Allocate the memory of an event.
+   * \param [in] size The size of the event.
+   * \returns The memory.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Release the memory of an event.
+   * \param [in] p The memory.
+   * \param [in] size The size of the event.
+   */
+  static void operator delete (void *p, std::size_t size);
+  /**
+   * Enable or disable the free lists. Disabling them releases the memory
+   * kept in the free lists of the calling thread. This is what the
+   * EventPool global value controls, when the simulator is created.
+   * \param [in] enabled Whether to allocate events from the free lists.
+   */
+  static void SetPoolEnabled (bool enabled);
+  /**
+   * \returns \c true if events are allocated from the free lists.
+   */
+  static bool IsPoolEnabled (void);
+
+  /** Allocation counters of a thread. */
+  struct PoolStats
+  {
+    uint64_t m_allocations;      /**< Events allocated. */
+    uint64_t m_heapAllocations;  /**< Events allocated from the heap. */
+    uint64_t m_frees;            /**< Events freed. */
+    uint64_t m_heapFrees;        /**< Events returned to the heap. */
+  };
+  /**
+   * \returns The allocation counters of the calling thread.
+   */
+  static PoolStats GetPoolStats (void);
+  /** Reset the allocation counters of the calling thread. */
+  static void ResetPoolStats (void);
+  /**@}*/
 
 protected:
   /**
@@ -0,0 +1,268 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/core-config.h"
+#include "event-profiler.h"
+#include "event-impl.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <time.h>
+
+#if (__GNUC__ >= 3)
+#include <cxxabi.h>
+#endif
+#ifdef HAVE_DLFCN_H
+#include <dlfcn.h>
+#endif
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::EventProfiler implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EventProfiler");
+
+namespace {
+
+/**
+ * Demangle a C++ symbol.
+ * \param [in] mangled The mangled symbol.
+ * \returns The demangled symbol, or \p mangled if it cannot be demangled.
+ */
+std::string
+Demangle (const char *mangled)
+{
+  std::string ret = mangled;
+#if (__GNUC__ >= 3)
+  int status;
+  char *demangled = abi::__cxa_demangle (mangled, 0, 0, &status);
+  if (status == 0)
+    {
+      ret = demangled;
+    }
+  std::free (demangled);
+#endif
+  return ret;
+}
+
+/**
+ * Extract the function signature of a MakeEvent type, which is its first
+ * template argument.
+ * \param [in] type The demangled event type.
+ * \returns The signature, or \p type if it is not a MakeEvent type.
+ */
+std::string
+GetSignature (const std::string &type)
+{
+  std::string::size_type start = type.find ("MakeEvent<");
+  if (start == std::string::npos)
+    {
+      return type;
+    }
+  start += 10;
+  int depth = 0;
+  for (std::string::size_type i = start; i < type.size (); i++)
+    {
+      char c = type[i];
+      if (c == '<' || c == '(')
+        {
+          depth++;
+        }
+      else if (c == '>' || c == ')')
+        {
+          if (depth == 0)
+            {
+              return type.substr (start, i - start);
+            }
+          depth--;
+        }
+      else if (c == ',' && depth == 0)
+        {
+          return type.substr (start, i - start);
+        }
+    }
+  return type;
+}
+
+/** Order (name, counters) pairs by decreasing wall clock time. */
+template <typename T>
+struct MoreWall
+{
+  bool operator () (const std::pair<std::string, T> &a, const std::pair<std::string, T> &b) const
+  {
+    return a.second.m_wall > b.second.m_wall;
+  }
+};
+
+} // anonymous namespace
+
+EventProfiler::EventProfiler (uint64_t interval)
+  : m_interval (interval),
+    m_nextSample (0),
+    m_events (0),
+    m_wall (0),
+    m_lastTarget (0, 0),
+    m_lastId (0)
+{
+  NS_LOG_FUNCTION (this << interval);
+}
+
+uint64_t
+EventProfiler::GetWallClock (void)
+{
+  struct timespec t;
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return uint64_t (t.tv_sec) * 1000000000 + t.tv_nsec;
+}
+
+void
+EventProfiler::Invoke (uint32_t context, EventImpl *event, uint64_t ts, uint32_t pending)
+{
+  if (ts >= m_nextSample)
+    {
+      Sample sample = { ts, pending, m_events, m_wall };
+      m_samples.push_back (sample);
+      m_nextSample = (m_interval == 0) ? ts + 1 : (ts / m_interval + 1) * m_interval;
+    }
+
+  Target target (&typeid (*event), event->GetFunction ());
+  if (target != m_lastTarget || m_events == 0)
+    {
+      std::map<Target, uint32_t>::const_iterator i =
+        m_targets.insert (std::make_pair (target, uint32_t (m_targets.size ()))).first;
+      m_lastTarget = target;
+      m_lastId = i->second;
+    }
+  bool cancelled = event->IsCancelled ();
+
+  uint64_t start = GetWallClock ();
+  event->Invoke ();
+  uint64_t wall = GetWallClock () - start;
+
+  Counters zero = { 0, 0, 0 };
+  Counters &counters = m_counters.insert (std::make_pair (std::make_pair (context, m_lastId), zero)).first->second;
+  counters.m_events++;
+  counters.m_cancelled += cancelled;
+  counters.m_wall += wall;
+  m_events++;
+  m_wall += wall;
+}
+
+std::string
+EventProfiler::GetName (Target target)
+{
+  std::string type = Demangle (target.first->name ());
+#ifdef HAVE_DLFCN_H
+  Dl_info info;
+  if (target.second != 0 && dladdr (target.second, &info) != 0
+      && info.dli_sname != 0 && info.dli_saddr == target.second)
+    {
+      return Demangle (info.dli_sname);
+    }
+#endif
+  if (target.second == 0)
+    {
+      return GetSignature (type);
+    }
+  // the address keeps apart the functions of the same signature; it is an
+  // offset in the virtual table for virtual methods
+  std::ostringstream oss;
+  oss << GetSignature (type) << " at " << target.second;
+  return oss.str ();
+}
+
+bool
+EventProfiler::Write (std::string filename) const
+{
+  NS_LOG_FUNCTION (this << filename);
+  std::ofstream os (filename.c_str ());
+  if (!os.is_open ())
+    {
+      NS_LOG_WARN ("cannot write the event profile to " << filename);
+      return false;
+    }
+
+  // targets of the same name, e.g. the same template event instantiated
+  // in several libraries, are merged
+  std::vector<std::string> names (m_targets.size ());
+  std::map<std::string, uint32_t> ids;
+  std::vector<uint32_t> merged (m_targets.size ());
+  for (std::map<Target, uint32_t>::const_iterator i = m_targets.begin (); i != m_targets.end (); ++i)
+    {
+      names[i->second] = GetName (i->first);
+    }
+  for (uint32_t i = 0; i < names.size (); i++)
+    {
+      merged[i] = ids.insert (std::make_pair (names[i], uint32_t (ids.size ()))).first->second;
+    }
+
+  std::vector<std::pair<std::string, Counters> > totals (ids.size ());
+  std::map<std::pair<uint32_t, uint32_t>, Counters> contexts;
+  for (std::map<std::string, uint32_t>::const_iterator i = ids.begin (); i != ids.end (); ++i)
+    {
+      Counters zero = { 0, 0, 0 };
+      totals[i->second] = std::make_pair (i->first, zero);
+    }
+  for (std::map<std::pair<uint32_t, uint32_t>, Counters>::const_iterator i = m_counters.begin ();
+       i != m_counters.end (); ++i)
+    {
+      uint32_t id = merged[i->first.second];
+      Counters zero = { 0, 0, 0 };
+      Counters &total = totals[id].second;
+      Counters &context = contexts.insert (std::make_pair (std::make_pair (i->first.first, id), zero)).first->second;
+      total.m_events += i->second.m_events;
+      total.m_cancelled += i->second.m_cancelled;
+      total.m_wall += i->second.m_wall;
+      context.m_events += i->second.m_events;
+      context.m_cancelled += i->second.m_cancelled;
+      context.m_wall += i->second.m_wall;
+    }
+
+  // number the targets by decreasing wall clock time
+  std::vector<std::pair<std::string, Counters> > sorted = totals;
+  std::stable_sort (sorted.begin (), sorted.end (), MoreWall<Counters> ());
+  std::map<std::string, uint32_t> rank;
+  os << "# events " << m_events << " wall_ns " << m_wall << std::endl;
+  os << "# T target events cancelled wall_ns name" << std::endl;
+  for (uint32_t i = 0; i < sorted.size (); i++)
+    {
+      rank[sorted[i].first] = i;
+      os << "T " << i << " " << sorted[i].second.m_events << " " << sorted[i].second.m_cancelled
+         << " " << sorted[i].second.m_wall << " " << sorted[i].first << std::endl;
+    }
+  os << "# C context target events cancelled wall_ns" << std::endl;
+  for (std::map<std::pair<uint32_t, uint32_t>, Counters>::const_iterator i = contexts.begin ();
+       i != contexts.end (); ++i)
+    {
+      os << "C " << int32_t (i->first.first) << " " << rank[totals[i->first.second].first]
+         << " " << i->second.m_events << " " << i->second.m_cancelled << " " << i->second.m_wall << std::endl;
+    }
+  os << "# Q time_ns pending events wall_ns" << std::endl;
+  for (std::vector<Sample>::const_iterator i = m_samples.begin (); i != m_samples.end (); ++i)
+    {
+      os << "Q " << i->m_ts << " " << i->m_pending << " " << i->m_events << " " << i->m_wall << std::endl;
+    }
+  return os.good ();
+}
+
+} // namespace ns3
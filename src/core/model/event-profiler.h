@@ -0,0 +1,139 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef EVENT_PROFILER_H
+#define EVENT_PROFILER_H
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::EventProfiler declaration.
+ */
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup simulator
+ * \brief Event loop accounting, per context and per event target.
+ *
+ * The simulator hands every event it runs to Invoke(), which measures the
+ * wall clock time the event takes. Events are accounted per context (the
+ * node id, or -1 without context) and per target: the function the event
+ * calls, as returned by EventImpl::GetFunction, and the type of the event.
+ * Every sampling interval of simulated time, the profiler also records the
+ * number of pending events.
+ *
+ * Write() produces a text file with three kinds of lines:
+ * \verbatim
+   T <target> <events> <cancelled> <wall ns> <name>
+   C <context> <target> <events> <cancelled> <wall ns>
+   Q <time ns> <pending events> <events run> <wall ns>
+   \endverbatim
+ * T lines give the totals of each target, latest wall time first, C lines
+ * split them by context and Q lines sample the event list over time.
+ * Targets are named after their function when the symbol can be resolved,
+ * and after the signature bound by MakeEvent and the function address
+ * otherwise.
+ *
+ * DefaultSimulatorImpl creates a profiler when its ProfileFile attribute
+ * is set, and writes it at Simulator::Destroy.
+ */
+class EventProfiler
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] interval The sampling interval of the pending events, in
+   *             dimensionless time units.
+   */
+  EventProfiler (uint64_t interval);
+  /**
+   * Run an event and account for it.
+   * \param [in] context The context of the event.
+   * \param [in] event The event.
+   * \param [in] ts The time of the event, in dimensionless time units.
+   * \param [in] pending The number of events still in the event list.
+   */
+  void Invoke (uint32_t context, EventImpl *event, uint64_t ts, uint32_t pending);
+  /**
+   * Write the accounting to a file.
+   * \param [in] filename The file name.
+   * \returns \c false if the file could not be written.
+   */
+  bool Write (std::string filename) const;
+
+private:
+  /** Target key: type of the event and function it calls. */
+  typedef std::pair<const std::type_info *, const void *> Target;
+  /** Counters of a (context, target) pair. */
+  struct Counters
+  {
+    uint64_t m_events;      /**< Events run. */
+    uint64_t m_cancelled;   /**< Cancelled events. */
+    uint64_t m_wall;        /**< Wall clock time, in ns. */
+  };
+  /** Event list sample. */
+  struct Sample
+  {
+    uint64_t m_ts;          /**< Simulated time. */
+    uint32_t m_pending;     /**< Pending events. */
+    uint64_t m_events;      /**< Events run so far. */
+    uint64_t m_wall;        /**< Wall clock time so far, in ns. */
+  };
+
+  /**
+   * Get the name of a target.
+   * \param [in] target The target.
+   * \returns The name of the function or of the event type.
+   */
+  static std::string GetName (Target target);
+  /**
+   * \returns The monotonic wall clock time, in ns.
+   */
+  static uint64_t GetWallClock (void);
+
+  /** Identifiers of the targets. */
+  std::map<Target, uint32_t> m_targets;
+  /** Counters by (context, target identifier). */
+  std::map<std::pair<uint32_t, uint32_t>, Counters> m_counters;
+  /** Samples of the event list. */
+  std::vector<Sample> m_samples;
+  /** Sampling interval. */
+  uint64_t m_interval;
+  /** Time of the next sample. */
+  uint64_t m_nextSample;
+  /** Events run. */
+  uint64_t m_events;
+  /** Wall clock time spent in events, in ns. */
+  uint64_t m_wall;
+  /** Last target, to skip the lookup for runs of the same target. */
+  Target m_lastTarget;
+  /** Identifier of m_lastTarget. */
+  uint32_t m_lastId;
+};
+
+} // namespace ns3
+
+#endif /* EVENT_PROFILER_H */
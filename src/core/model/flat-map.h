@@ -0,0 +1,264 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLAT_MAP_H
+#define FLAT_MAP_H
+
+#include "assert.h"
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::FlatMap declaration and implementation.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup core
+ *
+ * \brief Hash map from an unsigned integer key (an IPv4 address as uint32_t,
+ * or an address and an ID packed into a uint64_t) to T.
+ *
+ * Entries are kept densely in a vector, so iterating costs O(size), and an
+ * open addressing index with linear probing maps keys to entry positions.
+ * Erasing moves the last entry into the hole: it invalidates iterators and
+ * pointers to the last entry, and changes the iteration order.
+ */
+template <typename Key, typename T>
+class FlatMap
+{
+public:
+  /// Entry type
+  typedef std::pair<Key, T> value_type;
+  /// Iterator over the entries
+  typedef typename std::vector<value_type>::iterator iterator;
+  /// Const iterator over the entries
+  typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+  /// c-tor
+  FlatMap ();
+  /// Return value of key or 0. Valid until the next insertion or removal.
+  T * Find (Key key);
+  /// Return value of key or 0. Valid until the next insertion or removal.
+  T const * Find (Key key) const;
+  /**
+   * Insert key with value unless key is already present.
+   * \return the value stored for key and true if it was inserted
+   */
+  std::pair<T *, bool> Insert (Key key, T const & value);
+  /// Remove key. \return true if key was present
+  bool Erase (Key key);
+  /**
+   * Remove the entry at i.
+   * \return iterator to the entry that took its place, End () if i was the last one
+   */
+  iterator Erase (iterator i);
+  /// Remove all entries
+  void Clear ();
+  /// Return number of entries
+  uint32_t GetSize () const { return m_entries.size (); }
+  /// Check that there are no entries
+  bool IsEmpty () const { return m_entries.empty (); }
+  ///\name Iteration over the entries, in no particular order
+  //\{
+  iterator Begin () { return m_entries.begin (); }
+  iterator End () { return m_entries.end (); }
+  const_iterator Begin () const { return m_entries.begin (); }
+  const_iterator End () const { return m_entries.end (); }
+  //\}
+
+private:
+  /// Preferred index slot of key
+  uint32_t Hash (Key key) const;
+  /// Return index slot of key or -1
+  int32_t FindSlot (Key key) const;
+  /// Free index slot, moving later members of its probe run back
+  void EraseSlot (uint32_t slot);
+  /// Double the index size and reinsert all entries
+  void Grow ();
+
+  /// Entries
+  std::vector<value_type> m_entries;
+  /// Index slots: entry position + 1, 0 if the slot is free. Size is a power of two.
+  std::vector<uint32_t> m_index;
+  /// m_index.size () - 1
+  uint32_t m_mask;
+};
+
+/// Initial number of index slots, must be a power of two
+static const uint32_t FLAT_MAP_INITIAL_SLOTS = 16;
+
+template <typename Key, typename T>
+FlatMap<Key, T>::FlatMap ()
+  : m_index (FLAT_MAP_INITIAL_SLOTS, 0),
+    m_mask (FLAT_MAP_INITIAL_SLOTS - 1)
+{
+}
+
+template <typename Key, typename T>
+uint32_t
+FlatMap<Key, T>::Hash (Key key) const
+{
+  // Fibonacci hashing; the high half of the product mixes all key bits
+  uint64_t h = uint64_t (key) * 0x9E3779B97F4A7C15ULL;
+  return uint32_t (h >> 32) & m_mask;
+}
+
+template <typename Key, typename T>
+int32_t
+FlatMap<Key, T>::FindSlot (Key key) const
+{
+  for (uint32_t i = Hash (key);; i = (i + 1) & m_mask)
+    {
+      uint32_t position = m_index[i];
+      if (position == 0)
+        {
+          return -1;
+        }
+      if (m_entries[position - 1].first == key)
+        {
+          return i;
+        }
+    }
+}
+
+template <typename Key, typename T>
+T *
+FlatMap<Key, T>::Find (Key key)
+{
+  int32_t slot = FindSlot (key);
+  return (slot < 0) ? 0 : &m_entries[m_index[slot] - 1].second;
+}
+
+template <typename Key, typename T>
+T const *
+FlatMap<Key, T>::Find (Key key) const
+{
+  int32_t slot = FindSlot (key);
+  return (slot < 0) ? 0 : &m_entries[m_index[slot] - 1].second;
+}
+
+template <typename Key, typename T>
+std::pair<T *, bool>
+FlatMap<Key, T>::Insert (Key key, T const & value)
+{
+  int32_t slot = FindSlot (key);
+  if (slot >= 0)
+    {
+      return std::make_pair (&m_entries[m_index[slot] - 1].second, false);
+    }
+  // keep the load factor at or below 1/2 so probe sequences stay short
+  if (2 * (m_entries.size () + 1) > m_index.size ())
+    {
+      Grow ();
+    }
+  uint32_t i = Hash (key);
+  while (m_index[i] != 0)
+    {
+      i = (i + 1) & m_mask;
+    }
+  m_entries.push_back (std::make_pair (key, value));
+  m_index[i] = m_entries.size ();
+  return std::make_pair (&m_entries.back ().second, true);
+}
+
+template <typename Key, typename T>
+void
+FlatMap<Key, T>::EraseSlot (uint32_t hole)
+{
+  // backward shift deletion: move later members of the probe run into the
+  // hole so that lookups never need tombstones
+  for (uint32_t i = (hole + 1) & m_mask; m_index[i] != 0; i = (i + 1) & m_mask)
+    {
+      uint32_t home = Hash (m_entries[m_index[i] - 1].first);
+      // move the slot unless its home lies cyclically in (hole, i]
+      bool stays = (hole <= i) ? (hole < home && home <= i) : (hole < home || home <= i);
+      if (!stays)
+        {
+          m_index[hole] = m_index[i];
+          hole = i;
+        }
+    }
+  m_index[hole] = 0;
+}
+
+template <typename Key, typename T>
+typename FlatMap<Key, T>::iterator
+FlatMap<Key, T>::Erase (iterator i)
+{
+  uint32_t position = i - m_entries.begin ();
+  int32_t slot = FindSlot (i->first);
+  NS_ASSERT (slot >= 0 && m_index[slot] == position + 1);
+  EraseSlot (slot);
+  uint32_t last = m_entries.size () - 1;
+  if (position != last)
+    {
+      // the last entry fills the hole, repoint its slot
+      int32_t lastSlot = FindSlot (m_entries[last].first);
+      NS_ASSERT (lastSlot >= 0);
+      m_index[lastSlot] = position + 1;
+      m_entries[position] = m_entries[last];
+    }
+  m_entries.pop_back ();
+  return m_entries.begin () + position;
+}
+
+template <typename Key, typename T>
+bool
+FlatMap<Key, T>::Erase (Key key)
+{
+  int32_t slot = FindSlot (key);
+  if (slot < 0)
+    {
+      return false;
+    }
+  Erase (m_entries.begin () + (m_index[slot] - 1));
+  return true;
+}
+
+template <typename Key, typename T>
+void
+FlatMap<Key, T>::Clear ()
+{
+  m_entries.clear ();
+  m_index.assign (FLAT_MAP_INITIAL_SLOTS, 0);
+  m_mask = FLAT_MAP_INITIAL_SLOTS - 1;
+}
+
+template <typename Key, typename T>
+void
+FlatMap<Key, T>::Grow ()
+{
+  m_index.assign (2 * m_index.size (), 0);
+  m_mask = m_index.size () - 1;
+  for (uint32_t position = 0; position < m_entries.size (); ++position)
+    {
+      uint32_t i = Hash (m_entries[position].first);
+      while (m_index[i] != 0)
+        {
+          i = (i + 1) & m_mask;
+        }
+      m_index[i] = position + 1;
+    }
+}
+
+} // namespace ns3
+
+#endif /* FLAT_MAP_H */
@@ -236,6 +236,14 @@ HeapScheduler::Remove (const Event &ev)
           NS_ASSERT (m_heap[i].impl == ev.impl);
           Exch (i, Last ());
           m_heap.pop_back ();
+          // the last event, moved into the hole, may be earlier than
+          // the parent of the hole as well as later than its children
+          while (i < m_heap.size () && !IsRoot (i)
+                 && IsLessStrictly (i, Parent (i)))
+            {
+              Exch (i, Parent (i));
+              i = Parent (i);
+            }
           TopDown (i);
           return;
         }
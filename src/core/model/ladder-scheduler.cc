@@ -0,0 +1,334 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include <algorithm>
+#include <limits>
+#include "assert.h"
+#include "log.h"
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+namespace {
+
+/** Number of events above which a bucket is spread over a new rung. */
+const uint32_t THRESHOLD = 50;
+/** Maximum number of rungs. */
+const uint32_t MAX_RUNGS = 8;
+
+/** Order events latest first, so that Bottom is consumed from its end. */
+struct Later
+{
+  bool operator () (const Scheduler::Event &a, const Scheduler::Event &b) const
+  {
+    return a.key > b.key;
+  }
+};
+
+} // anonymous namespace
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topStart (0),
+    m_topMin (std::numeric_limits<uint64_t>::max ()),
+    m_topMax (0),
+    m_rungs (MAX_RUNGS),
+    m_nRungs (0),
+    m_bottomLimit (2 * THRESHOLD)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      m_top.push_back (ev);
+      m_topMin = std::min (m_topMin, ts);
+      m_topMax = std::max (m_topMax, ts);
+    }
+  else
+    {
+      uint32_t i = 0;
+      for (; i < m_nRungs; i++)
+        {
+          Rung &rung = m_rungs[i];
+          if (ts >= rung.m_start + rung.m_current * rung.m_width)
+            {
+              rung.m_buckets[(ts - rung.m_start) / rung.m_width].push_back (ev);
+              break;
+            }
+        }
+      if (i == m_nRungs)
+        {
+          InsertBottom (ev);
+        }
+    }
+  if (m_bottom.empty ())
+    {
+      Refill ();
+    }
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  // Refill keeps Bottom non-empty while there are events anywhere
+  return m_bottom.empty ();
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  return m_bottom.back ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Scheduler::Event ev = m_bottom.back ();
+  m_bottom.pop_back ();
+  if (m_bottom.empty ())
+    {
+      Refill ();
+    }
+  NS_LOG_DEBUG (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  return ev;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      // Top can be large: drop the event only when Top is spread over a rung
+      m_topRemoved.push_back (ev.key.m_uid);
+      return;
+    }
+  Bucket *bucket = 0;
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      Rung &rung = m_rungs[i];
+      if (ts >= rung.m_start + rung.m_current * rung.m_width)
+        {
+          bucket = &rung.m_buckets[(ts - rung.m_start) / rung.m_width];
+          break;
+        }
+    }
+  if (bucket == 0)
+    {
+      Bucket::iterator i = std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, Later ());
+      NS_ASSERT (i != m_bottom.end () && i->key.m_uid == ev.key.m_uid);
+      NS_ASSERT (i->impl == ev.impl);
+      m_bottom.erase (i);
+    }
+  else
+    {
+      // buckets are unsorted, swap the last event into the hole
+      Bucket::iterator i = bucket->begin ();
+      while (i != bucket->end () && i->key.m_uid != ev.key.m_uid)
+        {
+          ++i;
+        }
+      NS_ASSERT (i != bucket->end ());
+      NS_ASSERT (i->impl == ev.impl);
+      *i = bucket->back ();
+      bucket->pop_back ();
+    }
+  if (m_bottom.empty ())
+    {
+      Refill ();
+    }
+}
+
+void
+LadderScheduler::InsertBottom (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts);
+  m_bottom.insert (std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, Later ()), ev);
+  if (m_bottom.size () > m_bottomLimit && m_nRungs < MAX_RUNGS
+      && m_bottom.front ().key.m_ts != m_bottom.back ().key.m_ts)
+    {
+      // many events were inserted close to the present: spread them over
+      // a new rung rather than paying for a linear insertion every time
+      NS_LOG_LOGIC ("spawn rung " << m_nRungs << " from bottom");
+      Spawn (m_bottom, m_bottom.back ().key.m_ts, GetBottomEnd ());
+    }
+}
+
+void
+LadderScheduler::Spawn (Bucket &events, uint64_t start, uint64_t end)
+{
+  NS_LOG_FUNCTION (this << events.size () << start << end);
+  NS_ASSERT (m_nRungs < MAX_RUNGS && start < end && !events.empty ());
+  uint64_t n = events.size ();
+  uint64_t span = end - start;
+  Rung &rung = m_rungs[m_nRungs];
+  rung.m_width = span / n + (span % n != 0);
+  rung.m_nBuckets = span / rung.m_width + (span % rung.m_width != 0);
+  rung.m_start = start;
+  rung.m_current = 0;
+  if (rung.m_buckets.size () < rung.m_nBuckets)
+    {
+      rung.m_buckets.resize (rung.m_nBuckets);
+    }
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      rung.m_buckets[(i->key.m_ts - start) / rung.m_width].push_back (*i);
+    }
+  events.clear ();
+  m_nRungs++;
+}
+
+uint64_t
+LadderScheduler::GetBottomEnd (void) const
+{
+  if (m_nRungs == 0)
+    {
+      return m_topStart;
+    }
+  const Rung &rung = m_rungs[m_nRungs - 1];
+  return rung.m_start + rung.m_current * rung.m_width;
+}
+
+void
+LadderScheduler::Refill (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_bottom.empty ());
+  while (true)
+    {
+      if (m_nRungs == 0)
+        {
+          PurgeTop ();
+          if (m_top.empty ())
+            {
+              return;
+            }
+          uint64_t topMax = m_topMax;
+          if (m_top.size () <= THRESHOLD || m_topMin == topMax)
+            {
+              m_bottom.swap (m_top);
+            }
+          else
+            {
+              NS_LOG_LOGIC ("spawn rung 0 from " << m_top.size () << " events in top");
+              Spawn (m_top, m_topMin, topMax + 1);
+              topMax = m_rungs[0].m_start + m_rungs[0].m_nBuckets * m_rungs[0].m_width - 1;
+            }
+          m_topStart = topMax + 1;
+          m_topMin = std::numeric_limits<uint64_t>::max ();
+          m_topMax = 0;
+          if (!m_bottom.empty ())
+            {
+              SortBottom ();
+              return;
+            }
+        }
+      Rung &rung = m_rungs[m_nRungs - 1];
+      while (rung.m_current < rung.m_nBuckets && rung.m_buckets[rung.m_current].empty ())
+        {
+          rung.m_current++;
+        }
+      if (rung.m_current == rung.m_nBuckets)
+        {
+          // the rung is exhausted, resume with the one above
+          m_nRungs--;
+          continue;
+        }
+      Bucket &bucket = rung.m_buckets[rung.m_current];
+      uint64_t start = rung.m_start + rung.m_current * rung.m_width;
+      uint64_t width = rung.m_width;
+      rung.m_current++;
+      if (bucket.size () > THRESHOLD && width > 1 && m_nRungs < MAX_RUNGS)
+        {
+          NS_LOG_LOGIC ("spawn rung " << m_nRungs << " from " << bucket.size () << " events");
+          Spawn (bucket, start, start + width);
+          continue;
+        }
+      m_bottom.swap (bucket);
+      SortBottom ();
+      return;
+    }
+}
+
+void
+LadderScheduler::PurgeTop (void)
+{
+  NS_LOG_FUNCTION (this << m_topRemoved.size ());
+  if (m_topRemoved.empty ())
+    {
+      return;
+    }
+  std::sort (m_topRemoved.begin (), m_topRemoved.end ());
+  Bucket::iterator end = m_top.begin ();
+  for (Bucket::const_iterator i = m_top.begin (); i != m_top.end (); ++i)
+    {
+      if (!std::binary_search (m_topRemoved.begin (), m_topRemoved.end (), i->key.m_uid))
+        {
+          *end++ = *i;
+        }
+    }
+  m_top.erase (end, m_top.end ());
+  m_topRemoved.clear ();
+}
+
+void
+LadderScheduler::SortBottom (void)
+{
+  NS_LOG_FUNCTION (this << m_bottom.size ());
+  std::sort (m_bottom.begin (), m_bottom.end (), Later ());
+  m_bottomLimit = 2 * std::max<uint32_t> (m_bottom.size (), THRESHOLD);
+}
+
+} // namespace ns3
@@ -0,0 +1,144 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue described in
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by Wai Teng Tang, Rick Siow Mong Goh and
+ * Ian Li-Jin Thng (ACM TOMACS, 2005). The event list is split in three
+ * tiers:
+ *  - Top: an unsorted array of the events far in the future. Events
+ *    removed from it are only dropped when it is spread over a new rung;
+ *  - Ladder: up to eight rungs of buckets. Each rung covers one bucket
+ *    of the rung above it with narrower buckets, and buckets are unsorted;
+ *  - Bottom: a small sorted array of the earliest events.
+ *
+ * Events are dequeued from Bottom. When it runs empty, the first non-empty
+ * bucket of the lowest rung is either sorted into Bottom, or spread over
+ * a new rung if it holds too many events. Unlike a calendar queue, the
+ * bucket width of each rung adapts to the events it holds when it is
+ * created, so skewed or bursty time distributions do not need a global
+ * resize. Insert and RemoveNext are amortized O(1) in the number of events.
+ *
+ * All tiers store their events in std::vector, and the buckets of the
+ * rungs are recycled, so the queue does not allocate once it reached its
+ * working size.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Bucket type: an array of Events. */
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /** A rung of the ladder. */
+  struct Rung
+  {
+    /** The buckets, only the first m_nBuckets are in use. */
+    std::vector<Bucket> m_buckets;
+    /** Number of buckets in use. */
+    uint32_t m_nBuckets;
+    /** Start of the first bucket, in dimensionless time units. */
+    uint64_t m_start;
+    /** Duration of a bucket, in dimensionless time units. */
+    uint64_t m_width;
+    /** First bucket not yet moved to a lower rung or to Bottom. */
+    uint32_t m_current;
+  };
+
+  /**
+   * Insert an event in Bottom, keeping it sorted.
+   * \param [in] ev The event.
+   */
+  void InsertBottom (const Scheduler::Event &ev);
+  /**
+   * Add a rung below the lowest one and move events into it.
+   * \param [in,out] events The events to move, cleared on return.
+   * \param [in] start The start of the rung, no later than the earliest event.
+   * \param [in] end The end of the rung, later than the latest event.
+   */
+  void Spawn (Bucket &events, uint64_t start, uint64_t end);
+  /**
+   * Get the time before which events belong in Bottom.
+   * \returns The end of Bottom, in dimensionless time units.
+   */
+  uint64_t GetBottomEnd (void) const;
+  /** Move the earliest events to Bottom, which must be empty. */
+  void Refill (void);
+  /** Drop the events removed from Top. */
+  void PurgeTop (void);
+  /** Sort the events of Bottom, latest first. */
+  void SortBottom (void);
+
+  /** Unsorted events at or after m_topStart. */
+  Bucket m_top;
+  /** Unique ids of the events removed from Top but still in m_top. */
+  std::vector<uint32_t> m_topRemoved;
+  /** Start of Top, in dimensionless time units. */
+  uint64_t m_topStart;
+  /** Earliest event time in Top. */
+  uint64_t m_topMin;
+  /** Latest event time in Top. */
+  uint64_t m_topMax;
+  /** The rungs, only the first m_nRungs are in use. */
+  std::vector<Rung> m_rungs;
+  /** Number of rungs in use. */
+  uint32_t m_nRungs;
+  /** Sorted earliest events, latest first. */
+  Bucket m_bottom;
+  /** Size above which Bottom is spread over a new rung. */
+  uint32_t m_bottomLimit;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
@@ -263,6 +263,7 @@ EventImpl * MakeEvent (void (*f)(U1,U2,U3,U4,U5), T1 a1, T2 a2, T3 a3, T4 a4, T5
 
 #include "event-impl.h"
 #include "type-traits.h"
+#include <cstring>
 
 namespace ns3 {
 
@@ -302,6 +303,24 @@ struct EventMemberImplObjTraits<T *>
   }
 };
 
+/**
+ * \ingroup events
+ * Helper for the MakeEvent functions, which implements
+ * EventImpl::GetFunction.
+ *
+ * \tparam F \deduced The function or class method pointer type.
+ * \param [in] f The function or class method pointer.
+ * \return The first pointer-sized word of \p f, which is the address of
+ *          the code called, unless \p f is a virtual method.
+ */
+template <typename F>
+const void * GetEventFunctionAddress (F f)
+{
+  const void *address = 0;
+  std::memcpy (&address, &f, sizeof (address) < sizeof (f) ? sizeof (address) : sizeof (f));
+  return address;
+}
+
 template <typename MEM, typename OBJ>
 EventImpl * MakeEvent (MEM mem_ptr, OBJ obj)
 {
@@ -322,6 +341,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)();
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventFunctionAddress (m_function);
+    }
     OBJ m_obj;
     MEM m_function;
   } *ev = new EventMemberImpl0 (obj, mem_ptr);
@@ -352,6 +375,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventFunctionAddress (m_function);
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -383,6 +410,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1, m_a2);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventFunctionAddress (m_function);
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -416,6 +447,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1, m_a2, m_a3);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventFunctionAddress (m_function);
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -451,6 +486,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1, m_a2, m_a3, m_a4);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventFunctionAddress (m_function);
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -489,6 +528,10 @@ private:
     {
       (EventMemberImplObjTraits<OBJ>::GetReference (m_obj).*m_function)(m_a1, m_a2, m_a3, m_a4, m_a5);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventFunctionAddress (m_function);
+    }
     OBJ m_obj;
     MEM m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
@@ -523,6 +566,10 @@ private:
     {
       (*m_function)(m_a1);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventFunctionAddress (m_function);
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
   } *ev = new EventFunctionImpl1 (f, a1);
@@ -553,6 +600,10 @@ private:
     {
       (*m_function)(m_a1, m_a2);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventFunctionAddress (m_function);
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
     typename TypeTraits<T2>::ReferencedType m_a2;
@@ -586,6 +637,10 @@ private:
     {
       (*m_function)(m_a1, m_a2, m_a3);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventFunctionAddress (m_function);
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
     typename TypeTraits<T2>::ReferencedType m_a2;
@@ -621,6 +676,10 @@ private:
     {
       (*m_function)(m_a1, m_a2, m_a3, m_a4);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventFunctionAddress (m_function);
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
     typename TypeTraits<T2>::ReferencedType m_a2;
@@ -658,6 +717,10 @@ private:
     {
       (*m_function)(m_a1, m_a2, m_a3, m_a4, m_a5);
     }
+    virtual const void * GetFunction (void) const
+    {
+      return GetEventFunctionAddress (m_function);
+    }
     F m_function;
     typename TypeTraits<T1>::ReferencedType m_a1;
     typename TypeTraits<T2>::ReferencedType m_a2;
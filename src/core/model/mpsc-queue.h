@@ -0,0 +1,217 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include "assert.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup thread
+ * ns3::MpscQueue declaration and implementation.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup thread
+ * \brief A bounded lock-free queue with many producers and one consumer.
+ *
+ * The queue is a ring of cells allocated by the constructor. Each cell
+ * holds a sequence number which tells whether it is free for the producer
+ * of a given position or full for the consumer: producers claim a
+ * position with a compare-and-swap on the tail and publish their item by
+ * advancing the sequence number of its cell, so that neither Enqueue nor
+ * Dequeue takes a lock or allocates memory.
+ *
+ * Any number of threads may call Enqueue() concurrently, while Dequeue()
+ * and IsEmpty() must only be called by a single consumer thread. The
+ * items of a producer are dequeued in the order it enqueued them.
+ *
+ * \tparam T \explicit The item type, which must be copyable.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] capacity The maximum number of items in the queue,
+   *             rounded up to a power of two.
+   */
+  MpscQueue (uint32_t capacity);
+  /**
+   * Append an item to the queue.
+   * \param [in] item The item.
+   * \returns \c false if the queue is full.
+   */
+  bool Enqueue (const T &item);
+  /**
+   * Remove the first item of the queue. Only the consumer thread may call
+   * this method.
+   * \param [out] item The item.
+   * \returns \c false if the queue is empty.
+   */
+  bool Dequeue (T &item);
+  /**
+   * \returns \c true if the queue has no item ready to be dequeued.
+   *
+   * Only the consumer thread may call this method. This is a single load
+   * of the cell at the head of the queue, cheap enough to poll after
+   * every event.
+   */
+  bool IsEmpty (void) const;
+  /**
+   * \returns The number of positions claimed by the producers and not
+   * dequeued yet, including those whose item is still being published.
+   *
+   * Only the consumer thread may call this method. Dequeue() stops at the
+   * first position whose item is not published, so that a consumer which
+   * must see every item enqueued so far dequeues this many items.
+   */
+  uint32_t GetClaimed (void) const;
+  /**
+   * \returns The maximum number of items in the queue.
+   */
+  uint32_t GetCapacity (void) const;
+
+private:
+  /** A slot of the ring. */
+  struct Cell
+  {
+    /**
+     * Position the cell is free for if it equals the position, full for
+     * the consumer if it equals the position plus one.
+     */
+    uint32_t m_sequence;
+    T m_item;   /**< The item. */
+  };
+
+  /** Pad the producer and consumer positions to their own cache line. */
+  enum { PADDING = 64 };
+
+  std::vector<Cell> m_cells;  /**< The ring. */
+  uint32_t m_mask;            /**< Capacity minus one. */
+  char m_pad0[PADDING];       /**< Padding. */
+  uint32_t m_tail;            /**< Next position to enqueue, shared by the producers. */
+  char m_pad1[PADDING];       /**< Padding. */
+  uint32_t m_head;            /**< Next position to dequeue, owned by the consumer. */
+};
+
+} // namespace ns3
+
+
+/********************************************************************
+ *  Implementation of the templates declared above.
+ ********************************************************************/
+
+namespace ns3 {
+
+template <typename T>
+MpscQueue<T>::MpscQueue (uint32_t capacity)
+  : m_tail (0),
+    m_head (0)
+{
+  NS_ASSERT (capacity > 0 && capacity <= (1U << 31));
+  uint32_t size = 1;
+  while (size < capacity)
+    {
+      size <<= 1;
+    }
+  m_cells.resize (size);
+  for (uint32_t i = 0; i < size; i++)
+    {
+      m_cells[i].m_sequence = i;
+    }
+  m_mask = size - 1;
+}
+
+template <typename T>
+bool
+MpscQueue<T>::Enqueue (const T &item)
+{
+  uint32_t position = __atomic_load_n (&m_tail, __ATOMIC_RELAXED);
+  for (;;)
+    {
+      Cell *cell = &m_cells[position & m_mask];
+      uint32_t sequence = __atomic_load_n (&cell->m_sequence, __ATOMIC_ACQUIRE);
+      int32_t diff = int32_t (sequence - position);
+      if (diff == 0)
+        {
+          // on failure, position is reloaded with the current tail
+          if (__atomic_compare_exchange_n (&m_tail, &position, position + 1, true,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+              cell->m_item = item;
+              __atomic_store_n (&cell->m_sequence, position + 1, __ATOMIC_RELEASE);
+              return true;
+            }
+        }
+      else if (diff < 0)
+        {
+          // the consumer has not freed the cell of this position yet
+          return false;
+        }
+      else
+        {
+          position = __atomic_load_n (&m_tail, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+template <typename T>
+bool
+MpscQueue<T>::Dequeue (T &item)
+{
+  Cell *cell = &m_cells[m_head & m_mask];
+  if (__atomic_load_n (&cell->m_sequence, __ATOMIC_ACQUIRE) != m_head + 1)
+    {
+      return false;
+    }
+  item = cell->m_item;
+  __atomic_store_n (&cell->m_sequence, m_head + m_mask + 1, __ATOMIC_RELEASE);
+  m_head++;
+  return true;
+}
+
+template <typename T>
+bool
+MpscQueue<T>::IsEmpty (void) const
+{
+  const Cell *cell = &m_cells[m_head & m_mask];
+  return __atomic_load_n (&cell->m_sequence, __ATOMIC_ACQUIRE) != m_head + 1;
+}
+
+template <typename T>
+uint32_t
+MpscQueue<T>::GetClaimed (void) const
+{
+  return __atomic_load_n (&m_tail, __ATOMIC_RELAXED) - m_head;
+}
+
+template <typename T>
+uint32_t
+MpscQueue<T>::GetCapacity (void) const
+{
+  return m_mask + 1;
+}
+
+} // namespace ns3
+
+#endif /* MPSC_QUEUE_H */
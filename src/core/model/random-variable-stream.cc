@@ -72,7 +72,9 @@ RandomVariableStream::GetTypeId (void)
 }
 
 RandomVariableStream::RandomVariableStream()
-  : m_rng (0)
+  : m_rng (0),
+    m_index (0),
+    m_restart (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -107,20 +109,19 @@ RandomVariableStream::SetStream (int64_t stream)
       // number assignment.
       uint64_t nextStream = RngSeedManager::GetNextStreamIndex ();
       NS_ASSERT(nextStream <= ((1ULL)<<63));
-      m_rng = new RngStream (RngSeedManager::GetSeed (),
-                             nextStream,
-                             RngSeedManager::GetRun ());
+      m_index = nextStream;
     }
   else
     {
       // The last 2^63 streams are reserved for deterministic stream
       // number assignment.
       uint64_t base = ((1ULL)<<63);
-      uint64_t target = base + stream;
-      m_rng = new RngStream (RngSeedManager::GetSeed (),
-                             target,
-                             RngSeedManager::GetRun ());
+      m_index = base + stream;
     }
+  m_rng = new RngStream (RngSeedManager::GetSeed (),
+                         m_index,
+                         RngSeedManager::GetRun ());
+  m_restart = RngSeedManager::GetRestartCount ();
   m_stream = stream;
 }
 int64_t
@@ -134,6 +135,14 @@ RngStream *
 RandomVariableStream::Peek(void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_restart != RngSeedManager::GetRestartCount ())
+    {
+      delete m_rng;
+      m_rng = new RngStream (RngSeedManager::GetSeed (),
+                             m_index,
+                             RngSeedManager::GetRun ());
+      m_restart = RngSeedManager::GetRestartCount ();
+    }
   return m_rng;
 }
 
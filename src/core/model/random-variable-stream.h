@@ -177,8 +177,8 @@ private:
    */
   RandomVariableStream &operator = (const RandomVariableStream &o);
 
-  /** Pointer to the underlying RNG stream. */
-  RngStream *m_rng;
+  /** Pointer to the underlying RNG stream, replaced when the streams restart. */
+  mutable RngStream *m_rng;
 
   /** Indicates if antithetic values should be generated by this RNG stream. */
   bool m_isAntithetic;
@@ -186,6 +186,12 @@ private:
   /** The stream number for this RNG stream. */
   int64_t m_stream;
 
+  /** The index of the underlying RNG stream. */
+  uint64_t m_index;
+
+  /** RngSeedManager::GetRestartCount when the RNG stream was created. */
+  mutable uint64_t m_restart;
+
 };  // class RandomVariableStream
 
   
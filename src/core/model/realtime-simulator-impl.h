@@ -107,6 +107,7 @@ public:
   virtual void SetScheduler (ObjectFactory schedulerFactory);
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
+  virtual uint64_t GetEventCount (void) const;
 
   /** \copydoc ScheduleWithContext(uint32_t,const Time&,EventImpl*) */
   void ScheduleRealtimeWithContext (uint32_t context, const Time &delay, EventImpl *event);
@@ -200,6 +201,8 @@ private:
   uint32_t m_currentUid;
   /**< Timestep of the current event. */
   uint64_t m_currentTs;
+  /**< Number of events executed so far. */
+  uint64_t m_eventCount;
   /**< Execution context. */
   uint32_t m_currentContext;  
   /**@}*/
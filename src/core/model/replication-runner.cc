@@ -0,0 +1,196 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "replication-runner.h"
+#include "rng-seed-manager.h"
+#include "fatal-error.h"
+#include "log.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * \file
+ * \ingroup system
+ * ns3::ReplicationRunner implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ReplicationRunner");
+
+namespace {
+
+/** A running replication. */
+struct Child
+{
+  pid_t pid;     /**< Child process. */
+  int fd;        /**< Read end of the output pipe. */
+  uint64_t run;  /**< Run number. */
+};
+
+} // anonymous namespace
+
+ReplicationRunner::ReplicationRunner (uint32_t jobs)
+  : m_jobs (jobs)
+{
+  NS_LOG_FUNCTION (this << jobs);
+  if (m_jobs == 0)
+    {
+      long processors = sysconf (_SC_NPROCESSORS_ONLN);
+      m_jobs = processors > 0 ? processors : 1;
+    }
+}
+
+uint32_t
+ReplicationRunner::GetJobs (void) const
+{
+  return m_jobs;
+}
+
+void
+ReplicationRunner::RunChild (uint64_t run, int fd, Replication replication)
+{
+  RngSeedManager::SetRun (run);
+  RngSeedManager::RestartStreams ();
+  std::ostringstream os;
+  replication (run, os);
+  std::string output = os.str ();
+  const char *p = output.data ();
+  size_t left = output.size ();
+  while (left > 0)
+    {
+      ssize_t written = write (fd, p, left);
+      if (written < 0 && errno == EINTR)
+        {
+          continue;
+        }
+      if (written <= 0)
+        {
+          _exit (1);
+        }
+      p += written;
+      left -= written;
+    }
+  close (fd);
+  // the parent owns the rest of the process state: skip the destructors
+  // of the static objects
+  std::cout.flush ();
+  std::cerr.flush ();
+  fflush (0);
+  _exit (0);
+}
+
+uint32_t
+ReplicationRunner::Run (uint64_t firstRun, uint32_t count, Replication replication, std::ostream &os)
+{
+  NS_LOG_FUNCTION (this << firstRun << count);
+
+  std::deque<Child> children;
+  uint32_t failed = 0;
+  uint64_t next = firstRun;
+  uint64_t end = firstRun + count;
+
+  // the children inherit the buffers
+  os.flush ();
+  std::cout.flush ();
+  std::cerr.flush ();
+  fflush (0);
+
+  while (next < end || !children.empty ())
+    {
+      if (next < end && children.size () < m_jobs)
+        {
+          int fds[2];
+          if (pipe (fds) != 0)
+            {
+              NS_FATAL_ERROR ("pipe: " << std::strerror (errno));
+            }
+          pid_t pid = fork ();
+          if (pid < 0)
+            {
+              NS_FATAL_ERROR ("fork: " << std::strerror (errno));
+            }
+          if (pid == 0)
+            {
+              close (fds[0]);
+              for (std::deque<Child>::const_iterator i = children.begin (); i != children.end (); ++i)
+                {
+                  close (i->fd);
+                }
+              RunChild (next, fds[1], replication);
+            }
+          close (fds[1]);
+          NS_LOG_LOGIC ("run " << next << " in process " << pid);
+          Child child;
+          child.pid = pid;
+          child.fd = fds[0];
+          child.run = next;
+          children.push_back (child);
+          next++;
+          continue;
+        }
+
+      // collect the oldest replication, so that the outputs stay in order
+      Child child = children.front ();
+      children.pop_front ();
+      std::string output;
+      char buffer[4096];
+      for (;;)
+        {
+          ssize_t n = read (child.fd, buffer, sizeof (buffer));
+          if (n < 0 && errno == EINTR)
+            {
+              continue;
+            }
+          if (n <= 0)
+            {
+              break;
+            }
+          output.append (buffer, n);
+        }
+      close (child.fd);
+      int status;
+      while (waitpid (child.pid, &status, 0) < 0)
+        {
+          if (errno != EINTR)
+            {
+              NS_FATAL_ERROR ("waitpid: " << std::strerror (errno));
+            }
+        }
+      if (WIFEXITED (status) && WEXITSTATUS (status) == 0)
+        {
+          os << output;
+        }
+      else
+        {
+          NS_LOG_WARN ("run " << child.run << " failed with status " << status);
+          failed++;
+        }
+    }
+  os.flush ();
+  return failed;
+}
+
+} // namespace ns3
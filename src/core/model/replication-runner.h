@@ -0,0 +1,100 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef REPLICATION_RUNNER_H
+#define REPLICATION_RUNNER_H
+
+#include "callback.h"
+
+#include <ostream>
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup system
+ * ns3::ReplicationRunner declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup system
+ * \brief Run independent replications of a simulation built once.
+ *
+ * Building a scenario, from the TypeId registration to the topology, can
+ * cost as much as running it. ReplicationRunner forks one child process
+ * for each replication from the state of the calling process, once the
+ * scenario is built and before Simulator::Run. Each child sets its own
+ * RngRun, restarts the random variable streams with
+ * RngSeedManager::RestartStreams, and calls the replication callback,
+ * which runs the simulation and writes its statistics to the stream it
+ * is given. The parent gathers the outputs of the replications and
+ * writes them in run order.
+ *
+ * The replications share what the scenario drew from its random
+ * variables while it was built, such as a random topology, and differ in
+ * everything drawn while they run.
+ *
+ * The calling process must not run other threads when it forks.
+ */
+class ReplicationRunner
+{
+public:
+  /**
+   * A replication: runs the simulation for a run number and writes its
+   * output to a stream.
+   */
+  typedef Callback<void, uint64_t, std::ostream &> Replication;
+
+  /**
+   * Constructor.
+   * \param [in] jobs The number of replications to run at once, 0 for
+   *             one per processor.
+   */
+  ReplicationRunner (uint32_t jobs = 0);
+
+  /**
+   * \returns The number of replications run at once.
+   */
+  uint32_t GetJobs (void) const;
+
+  /**
+   * Run replications, each in a child process.
+   *
+   * \param [in] firstRun The run number of the first replication.
+   * \param [in] count The number of replications.
+   * \param [in] replication The replication, called in the children.
+   * \param [in,out] os The stream the outputs of the replications which
+   *             succeeded are written to, in run order.
+   * \returns The number of replications which failed.
+   */
+  uint32_t Run (uint64_t firstRun, uint32_t count, Replication replication, std::ostream &os);
+
+private:
+  /**
+   * Run a replication in the child process and exit.
+   * \param [in] run The run number.
+   * \param [in] fd The pipe the output is written to.
+   * \param [in] replication The replication.
+   */
+  static void RunChild (uint64_t run, int fd, Replication replication);
+
+  uint32_t m_jobs;  /**< Number of replications run at once. */
+};
+
+} // namespace ns3
+
+#endif /* REPLICATION_RUNNER_H */
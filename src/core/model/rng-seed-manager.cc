@@ -40,6 +40,7 @@ NS_LOG_COMPONENT_DEFINE ("RngSeedManager");
  * for automatic assignment.
  */
 static uint64_t g_nextStreamIndex = 0;
+static uint64_t g_restartCount = 0;
 /**
  * \relates RngSeedManager
  * The random number generator seed number global value.  This is used to
@@ -105,4 +106,15 @@ uint64_t RngSeedManager::GetNextStreamIndex (void)
   return next;
 }
 
+void RngSeedManager::RestartStreams (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  g_restartCount++;
+}
+
+uint64_t RngSeedManager::GetRestartCount (void)
+{
+  return g_restartCount;
+}
+
 } // namespace ns3
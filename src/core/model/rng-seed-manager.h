@@ -105,6 +105,23 @@ public:
    */
   static uint64_t GetNextStreamIndex(void);
 
+  /**
+   * \brief Restart the existing streams with the current seed and run.
+   *
+   * A RandomVariableStream draws from the run which was current when its
+   * stream number was assigned. After this call, each existing
+   * RandomVariableStream restarts at its next draw from the beginning of
+   * its stream, for the current seed and run, keeping its stream number.
+   * This lets replications forked from a simulation built once, such as
+   * those of ReplicationRunner, draw from their own run.
+   */
+  static void RestartStreams (void);
+  /**
+   * Get the number of calls to RestartStreams.
+   * \returns The number of restarts.
+   */
+  static uint64_t GetRestartCount (void);
+
 };
 
 /** Alias for compatibility. */
@@ -27,6 +27,7 @@
 
 #include "ptr.h"
 #include "string.h"
+#include "boolean.h"
 #include "object-factory.h"
 #include "global-value.h"
 #include "assert.h"
@@ -76,6 +77,17 @@ static GlobalValue g_schedTypeImpl = GlobalValue ("SchedulerType",
                                                   TypeIdValue (MapScheduler::GetTypeId ()),
                                                   MakeTypeIdChecker ());
 
+/**
+ * \ingroup events
+ * Whether events are allocated from per-thread free lists.
+ *
+ * \see EventImpl::SetPoolEnabled
+ */
+static GlobalValue g_eventPool = GlobalValue ("EventPool",
+                                              "Whether events are allocated from free lists instead of the heap",
+                                              BooleanValue (true),
+                                              MakeBooleanChecker ());
+
 /**
  * \ingroup logging
  * Default TimePrinter implementation.
@@ -147,6 +159,11 @@ static SimulatorImpl * GetImpl (void)
         factory.SetTypeId (s.Get ());
         (*pimpl)->SetScheduler (factory);
       }
+      {
+        BooleanValue pool;
+        g_eventPool.GetValue (pool);
+        EventImpl::SetPoolEnabled (pool.Get ());
+      }
 
 //
 // Note: we call LogSetTimePrinter _after_ creating the implementation
@@ -355,6 +372,12 @@ Simulator::GetContext (void)
   return GetImpl ()->GetContext ();
 }
 
+uint64_t
+Simulator::GetEventCount (void)
+{
+  return GetImpl ()->GetEventCount ();
+}
+
 uint32_t
 Simulator::GetSystemId (void)
 {
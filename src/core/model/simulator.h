@@ -184,6 +184,16 @@ public:
    */
   static uint32_t GetContext (void);
 
+  /**
+   * Get the number of events executed so far.
+   *
+   * Only the events of this simulator instance are counted, and
+   * the Destroy events run by Simulator::Destroy are not included.
+   *
+   * @return The number of events executed
+   */
+  static uint64_t GetEventCount (void);
+
   /** Context enum values. */
   enum {
     /**
@@ -0,0 +1,219 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "size-class-pool.h"
+#include "assert.h"
+#include "ns3/core-config.h"
+
+#include <algorithm>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
+
+namespace ns3 {
+
+namespace {
+
+/** Log2 of the size of the smallest class. */
+const uint32_t MIN_SHIFT = 5;
+/** Bytes each class can retain. */
+const uint32_t MAX_RETAINED = 1 << 20;
+
+/**
+ * \param [in] size A block size.
+ * \returns The class of the size, SizeClassPool::CLASSES if too large.
+ */
+uint32_t
+GetClass (uint32_t size)
+{
+  uint32_t c = 0;
+  while (c < SizeClassPool::CLASSES && (1U << (c + MIN_SHIFT)) < size)
+    {
+      c++;
+    }
+  return c;
+}
+
+/** The lists of the calling thread released at its exit, linked through m_next. */
+__thread SizeClassPool::Lists *g_threadLists;
+/**
+ * Whether the lists of the calling thread were released at its exit.
+ * The blocks it frees afterwards go to the heap.
+ */
+__thread bool g_exited;
+
+/**
+ * Release the lists of the calling thread, which exits.
+ */
+void
+ReleaseThreadLists (void)
+{
+  // each release unlinks the lists
+  while (g_threadLists != 0)
+    {
+      SizeClassPool::Release (*g_threadLists, true);
+    }
+  g_exited = true;
+}
+
+#ifdef HAVE_PTHREAD_H
+/** Key whose destructor releases the lists of an exiting thread. */
+pthread_key_t g_exitKey;
+/** Creates g_exitKey once. */
+pthread_once_t g_exitKeyOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Destructor of g_exitKey.
+ * \param [in] value The value of g_exitKey, unused.
+ */
+void
+ReleaseAtThreadExit (void *value)
+{
+  ReleaseThreadLists ();
+}
+
+/** Create g_exitKey. */
+void
+CreateExitKey (void)
+{
+  pthread_key_create (&g_exitKey, &ReleaseAtThreadExit);
+}
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * Have lists released when the calling thread exits.
+ * \param [in,out] lists The lists of the calling thread.
+ */
+void
+RegisterThreadExit (SizeClassPool::Lists &lists)
+{
+  lists.m_registered = true;
+  lists.m_next = g_threadLists;
+  g_threadLists = &lists;
+#ifdef HAVE_PTHREAD_H
+  pthread_once (&g_exitKeyOnce, &CreateExitKey);
+  // the destructor only runs for a non null value
+  pthread_setspecific (g_exitKey, g_threadLists);
+#endif /* HAVE_PTHREAD_H */
+}
+
+/**
+ * \brief Release the lists of the main thread at exit.
+ *
+ * The main thread runs no pthread key destructor. The core library is
+ * destroyed after the libraries which use the pool, so this comes last.
+ */
+struct MainThreadRelease
+{
+  ~MainThreadRelease ()
+  {
+    ReleaseThreadLists ();
+  }
+} g_mainThreadRelease; //!< Releases the lists of the main thread at exit.
+
+} // anonymous namespace
+
+uint32_t
+SizeClassPool::GetBlockSize (uint32_t size)
+{
+  uint32_t c = GetClass (size);
+  return c < CLASSES ? 1U << (c + MIN_SHIFT) : size;
+}
+
+void *
+SizeClassPool::Allocate (Lists &lists, uint32_t size)
+{
+  lists.m_stats.m_allocations++;
+  lists.m_stats.m_maxBlockSize = std::max<uint64_t> (lists.m_stats.m_maxBlockSize, size);
+  uint32_t c = GetClass (size);
+  if (c < CLASSES && lists.m_head[c] != 0)
+    {
+      NS_ASSERT (size == 1U << (c + MIN_SHIFT));
+      void *p = lists.m_head[c];
+      lists.m_head[c] = *static_cast<void **> (p);
+      lists.m_count[c]--;
+      lists.m_stats.m_hits++;
+      lists.m_stats.m_bytesRetained -= size;
+      return p;
+    }
+  return new uint8_t [size];
+}
+
+void
+SizeClassPool::Free (Lists &lists, void *p, uint32_t size, bool retain)
+{
+  lists.m_stats.m_frees++;
+  uint32_t c = GetClass (size);
+  if (retain && c < CLASSES && !lists.m_released && !g_exited
+      && (lists.m_count[c] + 1) * size <= MAX_RETAINED)
+    {
+      if (!lists.m_registered)
+        {
+          RegisterThreadExit (lists);
+        }
+      NS_ASSERT (size == 1U << (c + MIN_SHIFT));
+      *static_cast<void **> (p) = lists.m_head[c];
+      lists.m_head[c] = p;
+      lists.m_count[c]++;
+      lists.m_stats.m_bytesRetained += size;
+      lists.m_stats.m_maxBytesRetained = std::max (lists.m_stats.m_maxBytesRetained,
+                                                   lists.m_stats.m_bytesRetained);
+      return;
+    }
+  lists.m_stats.m_heapFrees++;
+  delete [] static_cast<uint8_t *> (p);
+}
+
+void
+SizeClassPool::Release (Lists &lists, bool atExit)
+{
+  for (uint32_t c = 0; c < CLASSES; c++)
+    {
+      while (lists.m_head[c] != 0)
+        {
+          void *p = lists.m_head[c];
+          lists.m_head[c] = *static_cast<void **> (p);
+          delete [] static_cast<uint8_t *> (p);
+          lists.m_stats.m_heapFrees++;
+        }
+      lists.m_count[c] = 0;
+    }
+  lists.m_stats.m_bytesRetained = 0;
+  lists.m_released = lists.m_released || atExit;
+  if (atExit && lists.m_registered)
+    {
+      Lists **link = &g_threadLists;
+      while (*link != &lists)
+        {
+          link = &(*link)->m_next;
+        }
+      *link = lists.m_next;
+      lists.m_registered = false;
+    }
+}
+
+void
+SizeClassPool::ResetStats (Lists &lists)
+{
+  lists.m_stats.m_allocations = 0;
+  lists.m_stats.m_hits = 0;
+  lists.m_stats.m_frees = 0;
+  lists.m_stats.m_heapFrees = 0;
+  lists.m_stats.m_maxBytesRetained = lists.m_stats.m_bytesRetained;
+  lists.m_stats.m_maxBlockSize = 0;
+}
+
+} // namespace ns3
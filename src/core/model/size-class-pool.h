@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SIZE_CLASS_POOL_H
+#define SIZE_CLASS_POOL_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup core
+ * \brief Free lists of memory blocks, one per power of two size class.
+ *
+ * EventImpl, Buffer, PacketMetadata and the packet tag lists keep the
+ * memory of the blocks they free in such free lists. A block is allocated
+ * with the whole size of its class, from 32 bytes to 64 KiB, so that it
+ * can serve any later request of the class; larger blocks come from the
+ * heap and return to it. Each class retains at most 1 MiB of free blocks,
+ * so that a burst of large packets does not pin the memory of the small
+ * ones and conversely.
+ *
+ * The lists are not locked: each thread has its own SizeClassPool::Lists,
+ * declared thread-local by the user of the pool. A block freed by another
+ * thread than the one which allocated it goes to the lists of the thread
+ * which frees it. The lists of a thread are released when it exits, and
+ * those of the main thread when the static objects are destroyed.
+ */
+class SizeClassPool
+{
+public:
+  /** Counters of the lists of a thread. */
+  struct Stats
+  {
+    uint64_t m_allocations;       /**< Blocks allocated. */
+    uint64_t m_hits;              /**< Blocks allocated from a free list. */
+    uint64_t m_frees;             /**< Blocks freed. */
+    uint64_t m_heapFrees;         /**< Blocks returned to the heap. */
+    uint64_t m_bytesRetained;     /**< Bytes in the free lists. */
+    uint64_t m_maxBytesRetained;  /**< High-water mark of m_bytesRetained. */
+    uint64_t m_maxBlockSize;      /**< Largest block allocated. */
+  };
+
+  /** Number of size classes. */
+  static const uint32_t CLASSES = 12;
+
+  /**
+   * The free lists of a thread. All zero is the initial state, so that
+   * the lists can be thread-local variables. Lists which do not live as
+   * long as their thread must be released with \c atExit before they are
+   * destroyed.
+   */
+  struct Lists
+  {
+    void *m_head[CLASSES];      /**< Head of the list of each class, linked through the blocks. */
+    uint32_t m_count[CLASSES];  /**< Length of each list. */
+    Stats m_stats;              /**< Counters. */
+    bool m_released;            /**< Whether Release was called at exit. */
+    bool m_registered;          /**< Whether the lists are released at thread exit. */
+    Lists *m_next;              /**< Next lists of the thread released at its exit. */
+  };
+
+  /**
+   * \param [in] size A block size.
+   * \returns The size of the blocks of the class of size, or size if the
+   *          class is too large to be kept in the lists.
+   */
+  static uint32_t GetBlockSize (uint32_t size);
+  /**
+   * Allocate a block.
+   * \param [in,out] lists The lists of the calling thread.
+   * \param [in] size The block size, as returned by GetBlockSize.
+   * \returns The block.
+   */
+  static void *Allocate (Lists &lists, uint32_t size);
+  /**
+   * Free a block.
+   * \param [in,out] lists The lists of the calling thread.
+   * \param [in] p The block.
+   * \param [in] size The block size, as returned by GetBlockSize.
+   * \param [in] retain Whether the block may be kept in the lists,
+   *             rather than returned to the heap.
+   */
+  static void Free (Lists &lists, void *p, uint32_t size, bool retain = true);
+  /**
+   * Return the blocks of the lists to the heap.
+   * \param [in,out] lists The lists of the calling thread.
+   * \param [in] atExit Whether the lists are about to be destroyed, in
+   *             which case the blocks freed later go to the heap and the
+   *             lists are no longer released at thread exit.
+   */
+  static void Release (Lists &lists, bool atExit);
+  /**
+   * Reset the counters, except those of the retained bytes.
+   * \param [in,out] lists The lists of the calling thread.
+   */
+  static void ResetStats (Lists &lists);
+};
+
+} // namespace ns3
+
+#endif /* SIZE_CLASS_POOL_H */
@@ -1168,12 +1168,6 @@ TypeId::LookupTraceSourceByName (std::string name) const
   return LookupTraceSourceByName (name, &info);
 }
 
-uint16_t 
-TypeId::GetUid (void) const
-{
-  NS_LOG_FUNCTION (this);
-  return m_tid;
-}
 void 
 TypeId::SetUid (uint16_t uid)
 {
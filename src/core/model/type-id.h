@@ -517,7 +517,7 @@ public:
    * This is really an internal method which users are not expected
    * to use.
    */
-  uint16_t GetUid (void) const;
+  inline uint16_t GetUid (void) const;
   /**
    * Set the internal id of this TypeId.
    *
@@ -625,6 +625,10 @@ TypeId &TypeId::operator = (const TypeId &o)
 TypeId::~TypeId ()
 {
 }
+uint16_t TypeId::GetUid (void) const
+{
+  return m_tid;
+}
 inline bool operator == (TypeId a, TypeId b)
 {
   return a.m_tid == b.m_tid;
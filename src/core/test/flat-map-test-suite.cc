@@ -0,0 +1,112 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/flat-map.h"
+
+using namespace ns3;
+
+/**
+ * \brief Insertion, lookup and removal in a FlatMap
+ */
+class FlatMapTestCase : public TestCase
+{
+public:
+  FlatMapTestCase ();
+  virtual void DoRun (void);
+};
+
+FlatMapTestCase::FlatMapTestCase ()
+  : TestCase ("FlatMap")
+{
+}
+
+void
+FlatMapTestCase::DoRun (void)
+{
+  FlatMap<uint32_t, uint32_t> m;
+  NS_TEST_EXPECT_MSG_EQ (m.IsEmpty (), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ ((m.Find (1) == 0), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (m.Insert (1, 10).second, true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (m.Insert (1, 20).second, false, "key already present");
+  NS_TEST_EXPECT_MSG_EQ (*m.Find (1), 10, "insert must not overwrite");
+  NS_TEST_EXPECT_MSG_EQ (m.Erase (1), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (m.Erase (1), false, "trivial");
+  NS_TEST_EXPECT_MSG_EQ (m.IsEmpty (), true, "trivial");
+
+  // addresses of a /16 subnet, enough to grow the index several times
+  // and to build long probe runs
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      m.Insert (0x0a000000 + i * 256, i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (m.GetSize (), 1000, "trivial");
+  for (uint32_t i = 0; i < 1000; i += 3)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m.Erase (0x0a000000 + i * 256), true, "trivial");
+    }
+  bool found = true;
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      uint32_t const * v = m.Find (0x0a000000 + i * 256);
+      found = found && ((i % 3 == 0) ? (v == 0) : (v != 0 && *v == i));
+    }
+  NS_TEST_EXPECT_MSG_EQ (found, true, "lookups after erasing every third key");
+  NS_TEST_EXPECT_MSG_EQ (m.GetSize (), 666, "trivial");
+
+  // erase the odd values while iterating
+  uint32_t visited = 0;
+  for (FlatMap<uint32_t, uint32_t>::iterator i = m.Begin (); i != m.End ();)
+    {
+      ++visited;
+      if (i->second % 2 == 1)
+        {
+          i = m.Erase (i);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (visited, 666, "every entry is visited once");
+  NS_TEST_EXPECT_MSG_EQ (m.GetSize (), 333, "trivial");
+  found = true;
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      found = found && ((m.Find (0x0a000000 + i * 256) != 0) == (i % 3 != 0 && i % 2 == 0));
+    }
+  NS_TEST_EXPECT_MSG_EQ (found, true, "lookups after erasing while iterating");
+  m.Clear ();
+  NS_TEST_EXPECT_MSG_EQ (m.IsEmpty (), true, "trivial");
+  NS_TEST_EXPECT_MSG_EQ ((m.Find (0x0a000000 + 2 * 256) == 0), true, "trivial");
+}
+
+/**
+ * \brief FlatMap test suite
+ */
+class FlatMapTestSuite : public TestSuite
+{
+public:
+  FlatMapTestSuite ();
+};
+
+FlatMapTestSuite::FlatMapTestSuite ()
+  : TestSuite ("flat-map", UNIT)
+{
+  AddTestCase (new FlatMapTestCase, TestCase::QUICK);
+}
+
+static FlatMapTestSuite g_flatMapTestSuite;
@@ -0,0 +1,196 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/replication-runner.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace ns3;
+
+/**
+ * \ingroup tests
+ * Existing streams draw from the current run after RestartStreams.
+ */
+class RestartStreamsTestCase : public TestCase
+{
+public:
+  RestartStreamsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+RestartStreamsTestCase::RestartStreamsTestCase ()
+  : TestCase ("RestartStreams reseeds the existing streams with the current run")
+{
+}
+
+void
+RestartStreamsTestCase::DoRun (void)
+{
+  uint64_t run = RngSeedManager::GetRun ();
+
+  RngSeedManager::SetRun (1);
+  Ptr<UniformRandomVariable> automatic = CreateObject<UniformRandomVariable> ();
+  Ptr<UniformRandomVariable> fixed = CreateObject<UniformRandomVariable> ();
+  fixed->SetStream (7);
+  double first = automatic->GetValue ();
+  automatic->GetValue ();
+  double fixedFirst = fixed->GetValue ();
+
+  RngSeedManager::SetRun (2);
+  Ptr<UniformRandomVariable> expected = CreateObject<UniformRandomVariable> ();
+  expected->SetStream (7);
+  RngSeedManager::RestartStreams ();
+  NS_TEST_EXPECT_MSG_EQ (fixed->GetValue (), expected->GetValue (), "Restarted stream not at the start of run 2");
+  NS_TEST_EXPECT_MSG_EQ ((fixed->GetStream () == 7), true, "Restart changed the stream number");
+
+  RngSeedManager::SetRun (1);
+  RngSeedManager::RestartStreams ();
+  NS_TEST_EXPECT_MSG_EQ (automatic->GetValue (), first, "Restarted automatic stream not at the start of run 1");
+  NS_TEST_EXPECT_MSG_EQ (fixed->GetValue (), fixedFirst, "Restarted stream not at the start of run 1");
+
+  RngSeedManager::SetRun (run);
+}
+
+/**
+ * \ingroup tests
+ * Replications run in their own process and run number, and their
+ * outputs come back in run order.
+ */
+class ReplicationRunnerTestCase : public TestCase
+{
+public:
+  ReplicationRunnerTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /** Draw from the variable at 1 s. */
+  void Draw (void);
+  /**
+   * The replication.
+   * \param [in] run The run number.
+   * \param [in] os The output stream.
+   */
+  void Replicate (uint64_t run, std::ostream &os);
+
+  Ptr<UniformRandomVariable> m_random;  //!< Variable of the scenario.
+  double m_value;                       //!< Value drawn at 1 s.
+};
+
+ReplicationRunnerTestCase::ReplicationRunnerTestCase ()
+  : TestCase ("ReplicationRunner forks the replications and gathers their output")
+{
+}
+
+void
+ReplicationRunnerTestCase::Draw (void)
+{
+  m_value = m_random->GetValue ();
+}
+
+void
+ReplicationRunnerTestCase::Replicate (uint64_t run, std::ostream &os)
+{
+  if (run == 4)
+    {
+      _exit (2);
+    }
+  Simulator::Run ();
+  os << std::setprecision (17) << run << ' ' << RngSeedManager::GetRun ()
+     << ' ' << Simulator::Now ().GetSeconds () << ' ' << m_value << '\n';
+}
+
+void
+ReplicationRunnerTestCase::DoRun (void)
+{
+  uint64_t run = RngSeedManager::GetRun ();
+
+  // the values each run draws first from stream 3
+  std::vector<double> expected;
+  for (uint64_t i = 1; i <= 5; i++)
+    {
+      RngSeedManager::SetRun (i);
+      Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+      random->SetStream (3);
+      expected.push_back (random->GetValue ());
+    }
+
+  RngSeedManager::SetRun (1);
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (3);
+  m_value = 0;
+  Simulator::Schedule (Seconds (1), &ReplicationRunnerTestCase::Draw, this);
+
+  ReplicationRunner runner (2);
+  NS_TEST_EXPECT_MSG_EQ (runner.GetJobs (), 2, "Wrong number of jobs");
+  std::ostringstream os;
+  uint32_t failed = runner.Run (1, 5, MakeCallback (&ReplicationRunnerTestCase::Replicate, this), os);
+  NS_TEST_EXPECT_MSG_EQ (failed, 1, "Run 4 should have failed");
+
+  std::istringstream is (os.str ());
+  uint64_t runs[] = { 1, 2, 3, 5 };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      uint64_t output, current;
+      double now, value;
+      is >> output >> current >> now >> value;
+      NS_TEST_EXPECT_MSG_EQ (output, runs[i], "Output out of run order");
+      NS_TEST_EXPECT_MSG_EQ (current, runs[i], "Replication not in its RngRun");
+      NS_TEST_EXPECT_MSG_EQ (now, 1, "Replication did not run the simulation");
+      NS_TEST_EXPECT_MSG_EQ (value, expected[runs[i] - 1], "Replication did not restart its streams");
+    }
+  std::string rest;
+  is >> rest;
+  NS_TEST_EXPECT_MSG_EQ (rest, "", "Unexpected output");
+
+  // the replications left the parent alone
+  NS_TEST_EXPECT_MSG_EQ (m_value, 0, "The parent ran the replication");
+  NS_TEST_EXPECT_MSG_EQ (RngSeedManager::GetRun (), 1, "The parent run changed");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now ().GetSeconds (), 0, "The parent simulation ran");
+  Simulator::Destroy ();
+  m_random = 0;
+
+  RngSeedManager::SetRun (run);
+}
+
+/**
+ * \ingroup tests
+ * ReplicationRunner test suite.
+ */
+class ReplicationRunnerTestSuite : public TestSuite
+{
+public:
+  ReplicationRunnerTestSuite ();
+};
+
+ReplicationRunnerTestSuite::ReplicationRunnerTestSuite ()
+  : TestSuite ("replication-runner")
+{
+  AddTestCase (new RestartStreamsTestCase, TestCase::QUICK);
+  AddTestCase (new ReplicationRunnerTestCase, TestCase::QUICK);
+}
+
+static ReplicationRunnerTestSuite g_replicationRunnerTestSuite;
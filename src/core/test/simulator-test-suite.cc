@@ -23,6 +23,14 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/event-impl.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include <fstream>
+#include <sstream>
+#include <vector>
 
 using namespace ns3;
 
@@ -136,6 +144,7 @@ SimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_b, true, "Event B did not run ?");
   NS_TEST_EXPECT_MSG_EQ (m_c, true, "Event C did not run ?");
   NS_TEST_EXPECT_MSG_EQ (m_d, true, "Event D did not run ?");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetEventCount (), 3u, "Events A (cancelled), B and D should have been executed");
 
   EventId anId = Simulator::ScheduleNow (&SimulatorEventsTestCase::Eventfoo0, this);
   EventId anotherId = anId;
@@ -459,6 +468,272 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  ObjectFactory m_schedulerFactory;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check the event order against ns3::MapScheduler with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  Ptr<Scheduler> reference = CreateObject<MapScheduler> ();
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+
+  // every step runs the next event, which schedules a few more: mostly
+  // short delays, sometimes a broadcast burst of simultaneous receptions
+  // and sometimes a far timer; a few pending events are removed
+  std::vector<Scheduler::Event> pending;
+  uint64_t now = 0;
+  uint32_t uid = 0;
+  bool ok = true;
+  // the stop event, far in the future, comes first
+  Scheduler::Event stop;
+  stop.impl = 0;
+  stop.key.m_ts = 2000000000000ULL;
+  stop.key.m_uid = uid++;
+  stop.key.m_context = 0;
+  scheduler->Insert (stop);
+  reference->Insert (stop);
+  for (uint32_t step = 0; step < 50000 && ok; step++)
+    {
+      uint32_t count = (step < 1000) ? 1 : rng->GetInteger (0, 2);
+      for (uint32_t i = 0; i < count; i++)
+        {
+          uint32_t kind = rng->GetInteger (0, 99);
+          uint32_t burst = 1;
+          uint64_t delay;
+          if (kind < 10)
+            {
+              delay = 0;
+            }
+          else if (kind < 70)
+            {
+              delay = rng->GetInteger (1, 100000);
+            }
+          else if (kind < 95)
+            {
+              delay = rng->GetInteger (1, 10000000);
+              burst = (kind < 75) ? rng->GetInteger (1, 100) : 1;
+            }
+          else
+            {
+              delay = rng->GetInteger (1, 1000) * 1000000000ULL;
+            }
+          for (uint32_t j = 0; j < burst; j++)
+            {
+              Scheduler::Event ev;
+              ev.impl = 0;
+              ev.key.m_ts = now + delay;
+              ev.key.m_uid = uid++;
+              ev.key.m_context = 0;
+              scheduler->Insert (ev);
+              reference->Insert (ev);
+              pending.push_back (ev);
+            }
+        }
+      if (rng->GetInteger (0, 9) == 0)
+        {
+          // remove a random event, unless it already ran
+          uint32_t i = rng->GetInteger (0, pending.size () - 1);
+          Scheduler::Event ev = pending[i];
+          pending[i] = pending.back ();
+          pending.pop_back ();
+          if (ev.key.m_ts > now)
+            {
+              scheduler->Remove (ev);
+              reference->Remove (ev);
+            }
+        }
+      ok = (scheduler->IsEmpty () == reference->IsEmpty ());
+      if (ok && !reference->IsEmpty ())
+        {
+          Scheduler::Event expected = reference->RemoveNext ();
+          ok = (scheduler->PeekNext ().key.m_uid == expected.key.m_uid)
+            && (scheduler->RemoveNext ().key.m_uid == expected.key.m_uid);
+          now = expected.key.m_ts;
+        }
+    }
+  while (ok && !reference->IsEmpty ())
+    {
+      ok = (scheduler->RemoveNext ().key.m_uid == reference->RemoveNext ().key.m_uid);
+    }
+  NS_TEST_EXPECT_MSG_EQ (ok, true, "Events out of order");
+  NS_TEST_EXPECT_MSG_EQ (scheduler->IsEmpty (), true, "Events left in the scheduler");
+}
+
+class EventPoolTestCase : public TestCase
+{
+public:
+  EventPoolTestCase ();
+  virtual void DoRun (void);
+  void Step (uint32_t left, uint64_t a, double b, std::string c);
+  uint32_t m_run;
+};
+
+EventPoolTestCase::EventPoolTestCase ()
+  : TestCase ("Check that events are allocated from the free lists")
+{
+}
+
+void
+EventPoolTestCase::Step (uint32_t left, uint64_t a, double b, std::string c)
+{
+  m_run++;
+  if (left > 0)
+    {
+      Simulator::Schedule (MicroSeconds (1), &EventPoolTestCase::Step, this, left - 1, a, b, c);
+    }
+}
+
+void
+EventPoolTestCase::DoRun (void)
+{
+  bool enabled = EventImpl::IsPoolEnabled ();
+
+  EventImpl::SetPoolEnabled (true);
+  m_run = 0;
+  Simulator::Schedule (MicroSeconds (1), &EventPoolTestCase::Step, this, 1000, 1, 2.0, "three");
+  Simulator::Run ();
+  EventImpl::ResetPoolStats ();
+  Simulator::Schedule (MicroSeconds (1), &EventPoolTestCase::Step, this, 1000, 1, 2.0, "three");
+  Simulator::Run ();
+  EventImpl::PoolStats stats = EventImpl::GetPoolStats ();
+  NS_TEST_EXPECT_MSG_EQ (m_run, 2002, "Events did not run");
+  NS_TEST_EXPECT_MSG_EQ (stats.m_allocations, 1001, "Wrong number of events");
+  NS_TEST_EXPECT_MSG_EQ (stats.m_heapAllocations, 0, "Events not reused");
+  NS_TEST_EXPECT_MSG_EQ (stats.m_frees, 1001, "Events not freed");
+
+  // disable the pool while the first event is pending
+  m_run = 0;
+  EventImpl::ResetPoolStats ();
+  Simulator::Schedule (MicroSeconds (1), &EventPoolTestCase::Step, this, 1000, 1, 2.0, "three");
+  EventImpl::SetPoolEnabled (false);
+  Simulator::Run ();
+  stats = EventImpl::GetPoolStats ();
+  NS_TEST_EXPECT_MSG_EQ (m_run, 1001, "Events did not run");
+  NS_TEST_EXPECT_MSG_EQ (stats.m_heapAllocations, 1000, "Events allocated from the free lists");
+  NS_TEST_EXPECT_MSG_EQ ((stats.m_heapFrees > 1001), true, "Free lists not released");
+  Simulator::Destroy ();
+
+  EventImpl::SetPoolEnabled (enabled);
+}
+
+class EventProfilerTestCase : public TestCase
+{
+public:
+  EventProfilerTestCase ();
+  virtual void DoRun (void);
+  void Member (uint32_t i);
+  static void Function (EventProfilerTestCase *test);
+};
+
+EventProfilerTestCase::EventProfilerTestCase ()
+  : TestCase ("Check the event profile of DefaultSimulatorImpl")
+{
+}
+
+void
+EventProfilerTestCase::Member (uint32_t i)
+{
+}
+
+void
+EventProfilerTestCase::Function (EventProfilerTestCase *test)
+{
+}
+
+void
+EventProfilerTestCase::DoRun (void)
+{
+  std::string file = CreateTempDirFilename ("event-profile.txt");
+  Simulator::Destroy ();
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::ProfileFile", StringValue (file));
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::ProfileInterval", TimeValue (Seconds (1)));
+
+  Simulator::ScheduleWithContext (1, Seconds (0.5), &EventProfilerTestCase::Member, this, 1);
+  Simulator::ScheduleWithContext (1, Seconds (1.5), &EventProfilerTestCase::Member, this, 2);
+  Simulator::ScheduleWithContext (1, Seconds (2.5), &EventProfilerTestCase::Member, this, 3);
+  Simulator::Schedule (Seconds (0.6), &EventProfilerTestCase::Function, this);
+  Simulator::Schedule (Seconds (0.7), &EventProfilerTestCase::Function, this);
+  EventId cancelled = Simulator::Schedule (Seconds (0.8), &EventProfilerTestCase::Function, this);
+  Simulator::Cancel (cancelled);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::ProfileFile", StringValue (""));
+  Config::SetDefault ("ns3::DefaultSimulatorImpl::ProfileInterval", TimeValue (MilliSeconds (100)));
+
+  std::ifstream in (file.c_str ());
+  NS_TEST_ASSERT_MSG_EQ (in.is_open (), true, "Profile not written");
+  std::vector<std::string> names;
+  uint64_t events[2] = { 0, 0 };
+  uint64_t cancelledEvents[2] = { 0, 0 };
+  uint64_t contextEvents[2] = { 0, 0 };
+  std::vector<uint64_t> samples;
+  std::string line;
+  while (std::getline (in, line))
+    {
+      std::istringstream is (line);
+      std::string type;
+      is >> type;
+      if (type == "T")
+        {
+          uint32_t target;
+          uint64_t n, c, wall;
+          std::string name;
+          is >> target >> n >> c >> wall;
+          std::getline (is, name);
+          NS_TEST_ASSERT_MSG_EQ ((target < 2), true, "Too many targets");
+          bool member = name.find ("uint") != std::string::npos
+            || name.find ("unsigned int") != std::string::npos;
+          events[member] = n;
+          cancelledEvents[member] = c;
+          names.push_back (name);
+        }
+      else if (type == "C")
+        {
+          int32_t context;
+          is >> context;
+          NS_TEST_ASSERT_MSG_EQ ((context == 1 || context == -1), true, "Unexpected context " << context);
+          uint64_t target, n;
+          is >> target >> n;
+          contextEvents[context == 1] += n;
+        }
+      else if (type == "Q")
+        {
+          uint64_t ts;
+          is >> ts;
+          samples.push_back (ts);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (names.size (), 2, "Wrong number of targets");
+  for (uint32_t i = 0; i < names.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_NE (names[i].find ("EventProfilerTestCase"), std::string::npos,
+                             "Target not named after the event: " << names[i]);
+    }
+  NS_TEST_EXPECT_MSG_EQ (events[1], 3, "Wrong number of member events");
+  NS_TEST_EXPECT_MSG_EQ (events[0], 3, "Wrong number of function events");
+  NS_TEST_EXPECT_MSG_EQ (cancelledEvents[0], 1, "Cancelled event not accounted");
+  NS_TEST_EXPECT_MSG_EQ (contextEvents[1], 3, "Wrong number of events in context 1");
+  NS_TEST_EXPECT_MSG_EQ (contextEvents[0], 3, "Wrong number of events without context");
+  NS_TEST_ASSERT_MSG_EQ (samples.size (), 3, "Wrong number of samples");
+  NS_TEST_EXPECT_MSG_EQ (samples[0], uint64_t (Seconds (0.5).GetTimeStep ()), "Wrong sample time");
+  NS_TEST_EXPECT_MSG_EQ (samples[2], uint64_t (Seconds (2.5).GetTimeStep ()), "Wrong sample time");
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +750,15 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+
+    AddTestCase (new EventPoolTestCase, TestCase::QUICK);
+    AddTestCase (new EventProfilerTestCase, TestCase::QUICK);
   }
 } g_simulatorTestSuite;
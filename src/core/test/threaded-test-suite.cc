@@ -26,10 +26,13 @@
 #include "ns3/config.h"
 #include "ns3/string.h"
 #include "ns3/system-thread.h"
+#include "ns3/mpsc-queue.h"
 
 #include <ctime>
 #include <list>
 #include <utility>
+#include <vector>
+#include <sched.h>
 
 using namespace ns3;
 
@@ -225,6 +228,171 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_a, m_d, "Bad scheduling");
 }
 
+class MpscQueueTestCase : public TestCase
+{
+public:
+  MpscQueueTestCase ();
+  static void Producer (std::pair<MpscQueueTestCase *, uint32_t> context);
+  MpscQueue<std::pair<uint32_t, uint32_t> > m_queue;
+  uint32_t m_items;
+
+private:
+  virtual void DoRun (void);
+};
+
+MpscQueueTestCase::MpscQueueTestCase ()
+  : TestCase ("Check that ns3::MpscQueue keeps the items of each producer in order"),
+    m_queue (100),
+    m_items (100000)
+{
+}
+
+void
+MpscQueueTestCase::Producer (std::pair<MpscQueueTestCase *, uint32_t> context)
+{
+  MpscQueueTestCase *me = context.first;
+  for (uint32_t i = 0; i < me->m_items; i++)
+    {
+      while (!me->m_queue.Enqueue (std::make_pair (context.second, i)))
+        {
+          sched_yield ();
+        }
+    }
+}
+
+void
+MpscQueueTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_queue.GetCapacity (), 128, "Capacity not rounded to a power of two");
+
+  // single thread: the queue fills up and empties
+  std::pair<uint32_t, uint32_t> item;
+  NS_TEST_EXPECT_MSG_EQ (m_queue.IsEmpty (), true, "New queue not empty");
+  for (uint32_t i = 0; i < 128; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_queue.Enqueue (std::make_pair (0U, i)), true, "Queue full too early");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_queue.Enqueue (std::make_pair (0U, 128U)), false, "Queue over capacity");
+  for (uint32_t i = 0; i < 128; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((m_queue.Dequeue (item) && item.second == i), true, "Wrong item");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_queue.Dequeue (item), false, "Queue not empty");
+  m_queue.Enqueue (std::make_pair (0U, 0U));
+  m_queue.Enqueue (std::make_pair (0U, 1U));
+  NS_TEST_EXPECT_MSG_EQ (m_queue.GetClaimed (), 2, "Wrong number of claimed items");
+  m_queue.Dequeue (item);
+  m_queue.Dequeue (item);
+  NS_TEST_EXPECT_MSG_EQ (m_queue.GetClaimed (), 0, "Wrong number of claimed items");
+
+  // concurrent producers
+  const uint32_t producers = 4;
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < producers; i++)
+    {
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (&MpscQueueTestCase::Producer,
+                                                                  std::make_pair (this, i))));
+      threads.back ()->Start ();
+    }
+  std::vector<uint32_t> next (producers, 0);
+  uint32_t received = 0;
+  bool ordered = true;
+  while (received < producers * m_items)
+    {
+      if (!m_queue.Dequeue (item))
+        {
+          sched_yield ();
+          continue;
+        }
+      ordered = ordered && item.first < producers && item.second == next[item.first];
+      next[item.first] = item.second + 1;
+      received++;
+    }
+  for (uint32_t i = 0; i < producers; i++)
+    {
+      threads[i]->Join ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (ordered, true, "Items of a producer out of order");
+  NS_TEST_EXPECT_MSG_EQ (m_queue.IsEmpty (), true, "Items left in the queue");
+}
+
+class InjectionOrderTestCase : public TestCase
+{
+public:
+  InjectionOrderTestCase (uint32_t producers, uint32_t events);
+  static void Producer (std::pair<InjectionOrderTestCase *, uint32_t> context);
+  void Receive (uint32_t producer, uint32_t i);
+  void Poll (void);
+  std::vector<uint32_t> m_next;
+  uint32_t m_received;
+  uint32_t m_producers;
+  uint32_t m_events;
+  bool m_ordered;
+
+private:
+  virtual void DoRun (void);
+};
+
+InjectionOrderTestCase::InjectionOrderTestCase (uint32_t producers, uint32_t events)
+  : TestCase ("Check that the events injected by other threads run in order"),
+    m_producers (producers),
+    m_events (events)
+{
+}
+
+void
+InjectionOrderTestCase::Producer (std::pair<InjectionOrderTestCase *, uint32_t> context)
+{
+  // bursts larger than the lock-free queue of the simulator overflow it
+  for (uint32_t i = 0; i < context.first->m_events; i++)
+    {
+      Simulator::ScheduleWithContext (context.second, Seconds (0),
+                                      &InjectionOrderTestCase::Receive, context.first, context.second, i);
+    }
+}
+
+void
+InjectionOrderTestCase::Receive (uint32_t producer, uint32_t i)
+{
+  m_ordered = m_ordered && Simulator::GetContext () == producer && m_next[producer] == i;
+  m_next[producer] = i + 1;
+  m_received++;
+}
+
+void
+InjectionOrderTestCase::Poll (void)
+{
+  if (m_received < m_next.size () * m_events)
+    {
+      Simulator::Schedule (NanoSeconds (1), &InjectionOrderTestCase::Poll, this);
+    }
+}
+
+void
+InjectionOrderTestCase::DoRun (void)
+{
+  const uint32_t producers = m_producers;
+  m_next.assign (producers, 0);
+  m_received = 0;
+  m_ordered = true;
+  Simulator::Schedule (NanoSeconds (1), &InjectionOrderTestCase::Poll, this);
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < producers; i++)
+    {
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (&InjectionOrderTestCase::Producer,
+                                                                  std::make_pair (this, i))));
+      threads.back ()->Start ();
+    }
+  Simulator::Run ();
+  for (uint32_t i = 0; i < producers; i++)
+    {
+      threads[i]->Join ();
+    }
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (m_received, producers * m_events, "Injected events lost");
+  NS_TEST_EXPECT_MSG_EQ (m_ordered, true, "Injected events out of order");
+}
+
 class ThreadedSimulatorTestSuite : public TestSuite
 {
 public:
@@ -241,7 +409,8 @@ public:
       "ns3::ListScheduler",
       "ns3::HeapScheduler",
       "ns3::MapScheduler",
-      "ns3::CalendarScheduler"
+      "ns3::CalendarScheduler",
+      "ns3::LadderScheduler"
     };
     unsigned int threadcounts[] = {
       0,
@@ -262,5 +431,9 @@ public:
               }
           }
       }
+    AddTestCase (new MpscQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new InjectionOrderTestCase (4, 20000), TestCase::QUICK);
+    // many producers overflow the queue while others are still publishing
+    AddTestCase (new InjectionOrderTestCase (16, 10000), TestCase::QUICK);
   }
 } g_threadedSimulatorTestSuite;
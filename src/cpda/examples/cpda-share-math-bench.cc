@@ -0,0 +1,183 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/cpda-share-math.h"
+
+/**
+ * \file
+ * Microbenchmark of the CPDA share arithmetic.
+ *
+ * Runs one aggregation round of a cluster, every member splitting a batch of
+ * readings into shares and the leader solving for the sum, once with a
+ * scalar reference (Horner with a modulo per step, Lagrange weights computed
+ * per round) and once with ns3::cpda::ShareMath. Both must give the same
+ * sums.
+ *
+ * \verbatim
+   ./waf --run="cpda-share-math-bench --members=20 --batch=4 --rounds=2000"
+   \endverbatim
+ */
+
+using namespace ns3;
+using namespace ns3::cpda;
+
+namespace {
+
+uint32_t const P = ShareMath::PRIME;
+
+uint32_t
+NaiveInv (uint32_t a)
+{
+  uint32_t result = 1;
+  for (uint32_t e = P - 2; e != 0; e >>= 1)
+    {
+      if (e & 1)
+        {
+          result = (uint64_t (result) * a) % P;
+        }
+      a = (uint64_t (a) * a) % P;
+    }
+  return result;
+}
+
+/// Scalar reference: one round, returns the B cluster sums
+std::vector<uint32_t>
+NaiveRound (std::vector<uint32_t> const & coefficients, uint32_t members, uint32_t batch)
+{
+  std::vector<std::vector<uint32_t> > assembled (members, std::vector<uint32_t> (batch, 0));
+  for (uint32_t i = 0; i < members; ++i)
+    {
+      for (uint32_t j = 0; j < members; ++j)
+        {
+          for (uint32_t b = 0; b < batch; ++b)
+            {
+              uint32_t const * c = &coefficients[(i * batch + b) * members];
+              uint32_t share = 0;
+              for (uint32_t k = members; k-- > 0;)
+                {
+                  share = (uint64_t (share) * (j + 1) + c[k]) % P;
+                }
+              assembled[j][b] = (assembled[j][b] + share) % P;
+            }
+        }
+    }
+  std::vector<uint32_t> sums (batch, 0);
+  for (uint32_t j = 0; j < members; ++j)
+    {
+      uint32_t num = 1;
+      uint32_t den = 1;
+      for (uint32_t k = 0; k < members; ++k)
+        {
+          if (k != j)
+            {
+              num = (uint64_t (num) * (k + 1)) % P;
+              den = (uint64_t (den) * ((k + P - j) % P)) % P;
+            }
+        }
+      uint32_t weight = (uint64_t (num) * NaiveInv (den)) % P;
+      for (uint32_t b = 0; b < batch; ++b)
+        {
+          sums[b] = (sums[b] + uint64_t (weight) * assembled[j][b]) % P;
+        }
+    }
+  return sums;
+}
+
+/// Same round with ShareMath
+void
+FastRound (ShareMath & math, std::vector<uint32_t> const & coefficients,
+           std::vector<uint32_t> & shares, std::vector<uint32_t> & assembled,
+           uint32_t members, uint32_t batch, std::vector<uint32_t> & sums)
+{
+  math.SetSize (members, batch);
+  std::fill (assembled.begin (), assembled.end (), 0);
+  for (uint32_t i = 0; i < members; ++i)
+    {
+      math.Evaluate (&coefficients[i * batch * members], &shares[0]);
+      for (uint32_t c = 0; c < assembled.size (); ++c)
+        {
+          assembled[c] = ShareMath::Add (assembled[c], shares[c]);
+        }
+    }
+  math.Solve (&assembled[0], &sums[0]);
+}
+
+} // namespace
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t members = 20;
+  uint32_t batch = 4;
+  uint32_t rounds = 2000;
+
+  CommandLine cmd;
+  cmd.AddValue ("members", "Cluster size", members);
+  cmd.AddValue ("batch", "Readings per member and round", batch);
+  cmd.AddValue ("rounds", "Aggregation rounds to time", rounds);
+  cmd.Parse (argc, argv);
+
+  if (members == 0 || batch == 0 || rounds == 0)
+    {
+      std::cerr << "members, batch and rounds must be positive" << std::endl;
+      return 1;
+    }
+
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  std::vector<uint32_t> coefficients (members * batch * members);
+  for (uint32_t c = 0; c < coefficients.size (); ++c)
+    {
+      coefficients[c] = rng->GetInteger (0, P - 1);
+    }
+
+  std::vector<uint32_t> naiveSums;
+  clock_t start = clock ();
+  for (uint32_t r = 0; r < rounds; ++r)
+    {
+      naiveSums = NaiveRound (coefficients, members, batch);
+    }
+  double naive = double (clock () - start) / CLOCKS_PER_SEC;
+
+  ShareMath math;
+  std::vector<uint32_t> shares (members * batch);
+  std::vector<uint32_t> assembled (members * batch);
+  std::vector<uint32_t> fastSums (batch);
+  start = clock ();
+  for (uint32_t r = 0; r < rounds; ++r)
+    {
+      FastRound (math, coefficients, shares, assembled, members, batch, fastSums);
+    }
+  double fast = double (clock () - start) / CLOCKS_PER_SEC;
+
+  bool match = (naiveSums == fastSums);
+  std::cout << "members " << members << " batch " << batch << " rounds " << rounds << std::endl;
+  std::cout << std::fixed << std::setprecision (3)
+            << "naive         " << std::setw (8) << naive << " s" << std::endl
+            << "ShareMath     " << std::setw (8) << fast << " s" << std::endl;
+  if (fast > 0)
+    {
+      std::cout << "speedup       " << std::setw (8) << naive / fast << std::endl;
+    }
+  std::cout << "sums " << (match ? "match" : "DIFFER") << std::endl;
+  return match ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "cpda-helper.h"
+#include "ns3/cpda-application.h"
+#include "ns3/names.h"
+
+namespace ns3 {
+
+CpdaHelper::CpdaHelper ()
+{
+  m_factory.SetTypeId (CpdaApplication::GetTypeId ());
+}
+
+void
+CpdaHelper::SetAttribute (std::string name, const AttributeValue &value)
+{
+  m_factory.Set (name, value);
+}
+
+ApplicationContainer
+CpdaHelper::Install (Ptr<Node> node) const
+{
+  return ApplicationContainer (InstallPriv (node));
+}
+
+ApplicationContainer
+CpdaHelper::Install (std::string nodeName) const
+{
+  Ptr<Node> node = Names::Find<Node> (nodeName);
+  return ApplicationContainer (InstallPriv (node));
+}
+
+ApplicationContainer
+CpdaHelper::Install (NodeContainer c) const
+{
+  ApplicationContainer apps;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      apps.Add (InstallPriv (*i));
+    }
+
+  return apps;
+}
+
+int64_t
+CpdaHelper::AssignStreams (ApplicationContainer apps, int64_t stream)
+{
+  int64_t currentStream = stream;
+  for (ApplicationContainer::Iterator i = apps.Begin (); i != apps.End (); ++i)
+    {
+      Ptr<CpdaApplication> cpda = DynamicCast<CpdaApplication> (*i);
+      if (cpda)
+        {
+          currentStream += cpda->AssignStreams (currentStream);
+        }
+    }
+  return (currentStream - stream);
+}
+
+Ptr<Application>
+CpdaHelper::InstallPriv (Ptr<Node> node) const
+{
+  Ptr<Application> app = m_factory.Create<CpdaApplication> ();
+  node->AddApplication (app);
+
+  return app;
+}
+
+} // namespace ns3
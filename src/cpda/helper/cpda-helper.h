@@ -0,0 +1,96 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CPDA_HELPER_H
+#define CPDA_HELPER_H
+
+#include <stdint.h>
+#include "ns3/application-container.h"
+#include "ns3/node-container.h"
+#include "ns3/object-factory.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup cpda
+ * \brief Install a CpdaApplication on a set of nodes.
+ *
+ * Every node of the aggregation runs one application; exactly one of them
+ * should have the "Root" attribute set.
+ */
+class CpdaHelper
+{
+public:
+  CpdaHelper ();
+
+  /**
+   * Record an attribute to be set in each Application after it is is created.
+   *
+   * \param name the name of the attribute to set
+   * \param value the value of the attribute to set
+   */
+  void SetAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * Create a CpdaApplication on the specified Node.
+   *
+   * \param node The node on which to create the Application.
+   * \returns An ApplicationContainer holding the Application created.
+   */
+  ApplicationContainer Install (Ptr<Node> node) const;
+
+  /**
+   * Create a CpdaApplication on the specified node
+   *
+   * \param nodeName The node on which to create the application.  The node
+   *                 is specified by a node name previously registered with
+   *                 the Object Name Service.
+   * \returns An ApplicationContainer holding the Application created.
+   */
+  ApplicationContainer Install (std::string nodeName) const;
+
+  /**
+   * \param c The nodes on which to create the Applications.
+   * \returns The applications created, one Application per Node in the
+   *          NodeContainer.
+   */
+  ApplicationContainer Install (NodeContainer c) const;
+
+  /**
+   * Assign a fixed random variable stream number to the random variables used
+   * by the CPDA applications of the given applications.
+   *
+   * \param apps applications created by this helper
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (ApplicationContainer apps, int64_t stream);
+
+private:
+  /**
+   * Install a CpdaApplication on the node configured with all the
+   * attributes set with SetAttribute.
+   *
+   * \param node The node on which a CpdaApplication will be installed.
+   * \returns Ptr to the application installed.
+   */
+  Ptr<Application> InstallPriv (Ptr<Node> node) const;
+
+  ObjectFactory m_factory; //!< Object factory.
+};
+
+} // namespace ns3
+
+#endif /* CPDA_HELPER_H */
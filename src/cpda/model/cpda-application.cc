@@ -0,0 +1,1260 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "cpda-application.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/ipv4.h"
+#include "ns3/socket.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/trace-source-accessor.h"
+#include <algorithm>
+#include <limits>
+
+// =========================== CPDA PARAMETERS ===========================
+#define CLUSTER_MEMBERS_NUM 20 // initilization number for cluster members vector
+#define CPDA_BATCH_SIZE 4 // values aggregated per round, all shares of a round travel in one packet
+#define CPDA_MAX_READING 100 // readings are drawn from [0, CPDA_MAX_READING)
+#define CPDA_MAX_DATAGRAM 65507 // largest UDP payload over IPv4, the share relay must fit in it
+#define PATH_KEY_REQUEST_DELAY 100 // ms after the key window, lets the key broadcasts of all neighbors arrive first
+// =======================================================================
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CpdaApplication");
+
+NS_OBJECT_ENSURE_REGISTERED (CpdaApplication);
+
+using namespace cpda;
+
+const uint16_t CpdaApplication::CPDA_PORT = 655;
+
+TypeId
+CpdaApplication::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CpdaApplication")
+    .SetParent<Application> ()
+    .SetGroupName ("Cpda")
+    .AddConstructor<CpdaApplication> ()
+    .AddAttribute ("Root", "Indicates that this is the root query node.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&CpdaApplication::m_root),
+                   MakeBooleanChecker ())
+    .AddAttribute ("LeaderProbability", "Probability that a node receiving a query becomes a cluster leader.",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&CpdaApplication::m_leaderProbability),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("KeyPoolSize", "Number of keys in the pool the key rings are drawn from.",
+                   UintegerValue (10000),
+                   MakeUintegerAccessor (&CpdaApplication::m_keyTotal),
+                   MakeUintegerChecker<uint16_t> (1))
+    .AddAttribute ("KeyRingSize", "Number of keys each node draws from the key pool.",
+                   UintegerValue (200),
+                   MakeUintegerAccessor (&CpdaApplication::m_keySelection),
+                   MakeUintegerChecker<uint16_t> (1))
+    .AddAttribute ("KeyPoolSecret", "Secret the values of the pool keys are derived from, the same on every node.",
+                   UintegerValue (0x43504441),
+                   MakeUintegerAccessor (&CpdaApplication::m_keyPoolSecret),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("JoinTimeout", "How long JOIN messages are collected after joining or leading a cluster.",
+                   TimeValue (MilliSeconds (500)),
+                   MakeTimeAccessor (&CpdaApplication::m_clusterJoinTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("ShareTimeout", "How long a leader waits for shares, then for assembled sums.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&CpdaApplication::m_shareTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("ResultTimeout", "How long a leader waits for the results of its child leaders.",
+                   TimeValue (MilliSeconds (3000)),
+                   MakeTimeAccessor (&CpdaApplication::m_resultTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("MinJitter", "Lower bound of the random delay of broadcasts answering another message.",
+                   TimeValue (MilliSeconds (0)),
+                   MakeTimeAccessor (&CpdaApplication::m_minJitter),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxJitter", "Upper bound of the random delay of broadcasts answering another message.",
+                   TimeValue (MilliSeconds (20)),
+                   MakeTimeAccessor (&CpdaApplication::m_maxJitter),
+                   MakeTimeChecker ())
+    .AddAttribute ("KeySchedule", "When the first key ring announcement is sent.",
+                   EnumValue (KEY_SCHEDULE_JITTERED),
+                   MakeEnumAccessor (&CpdaApplication::m_keySchedule),
+                   MakeEnumChecker (KEY_SCHEDULE_IMMEDIATE, "Immediate",
+                                    KEY_SCHEDULE_JITTERED, "Jittered",
+                                    KEY_SCHEDULE_SLOTTED, "Slotted"))
+    .AddAttribute ("KeyWindow", "Time over which the first key ring announcements are spread.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&CpdaApplication::m_keyWindow),
+                   MakeTimeChecker ())
+    .AddAttribute ("KeySlots", "Number of slots of the key window in the Slotted schedule, picked by node ID.",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&CpdaApplication::m_keySlots),
+                   MakeUintegerChecker<uint16_t> (1))
+    .AddAttribute ("KeyRetries", "Number of repeated key ring announcements, skipped once all neighbors heard confirmed ours.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&CpdaApplication::m_keyRetries),
+                   MakeUintegerChecker<uint8_t> ())
+    .AddAttribute ("KeyRetryInterval", "Time between key ring announcements.",
+                   TimeValue (MilliSeconds (200)),
+                   MakeTimeAccessor (&CpdaApplication::m_keyRetryInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("KeyEncoding", "How the key ring is encoded in CPDA_KEY messages.",
+                   EnumValue (KEY_ENCODING_DELTA),
+                   MakeEnumAccessor (&CpdaApplication::m_keyEncoding),
+                   MakeEnumChecker (KEY_ENCODING_PLAIN, "Plain",
+                                    KEY_ENCODING_DELTA, "Delta",
+                                    KEY_ENCODING_SEED, "Seed"))
+    .AddAttribute ("AggregationBatchSize", "Number of values aggregated per CPDA round.",
+                   UintegerValue (CPDA_BATCH_SIZE),
+                   MakeUintegerAccessor (&CpdaApplication::m_batchSize),
+                   MakeUintegerChecker<uint8_t> (1))
+    .AddTraceSource ("KeyDiscovery", "Key exchange finished: neighbors heard and when the last one was.",
+                     MakeTraceSourceAccessor (&CpdaApplication::m_keyDiscoveryTrace),
+                     "ns3::CpdaApplication::KeyDiscoveryTracedCallback")
+    .AddTraceSource ("Reading", "Private readings this node contributes to a round.",
+                     MakeTraceSourceAccessor (&CpdaApplication::m_readingTrace),
+                     "ns3::CpdaApplication::ReadingTracedCallback")
+    .AddTraceSource ("Result", "Aggregate of a round as it reaches the root.",
+                     MakeTraceSourceAccessor (&CpdaApplication::m_resultTrace),
+                     "ns3::CpdaApplication::ResultTracedCallback")
+  ;
+  return tid;
+}
+
+CpdaApplication::CpdaApplication ()
+  : m_root (false),
+    m_leaderProbability (0.25),
+    m_minJitter (MilliSeconds (0)),
+    m_maxJitter (MilliSeconds (20)),
+    m_keyTotal (10000),
+    m_keySelection (200),
+    m_keyPoolSecret (0x43504441),
+    m_keyRing (m_keyTotal),
+    m_keyEncoding (KEY_ENCODING_DELTA),
+    m_keySeed (0),
+    m_keySchedule (KEY_SCHEDULE_JITTERED),
+    m_keyWindow (MilliSeconds (100)),
+    m_keySlots (16),
+    m_keyRetries (1),
+    m_keyRetryInterval (MilliSeconds (200)),
+    m_keyAnnouncements (0),
+    m_keyReplyPending (false),
+    m_keyTimer (Timer::CANCEL_ON_DESTROY),
+    m_clusterState (CLUSTER_IDLE),
+    m_isClusterLeader (false),
+    m_clusterJoinTimeout (MilliSeconds (500)),
+    m_clusterTimer (Timer::CANCEL_ON_DESTROY),
+    m_maxClusterSize (0),
+    m_round (0),
+    m_roundMessages (0),
+    m_batchSize (CPDA_BATCH_SIZE),
+    m_aggregationPhase (AGGREGATION_IDLE),
+    m_assembledCount (0),
+    m_subtreeContributors (0),
+    m_subtreeMessages (0),
+    m_shareTimeout (MilliSeconds (100)),
+    m_resultTimeout (MilliSeconds (3000)),
+    m_aggregationTimer (Timer::CANCEL_ON_DESTROY)
+{
+  NS_LOG_FUNCTION (this);
+  m_uniformRandomVariable = CreateObject<UniformRandomVariable> ();
+  m_keyTimer.SetFunction (&CpdaApplication::KeyTimerExpire, this);
+  m_clusterTimer.SetFunction (&CpdaApplication::ClusterTimerExpire, this);
+  m_aggregationTimer.SetFunction (&CpdaApplication::AggregationTimerExpire, this);
+}
+
+CpdaApplication::~CpdaApplication ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+CpdaApplication::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_socket = 0;
+  Application::DoDispose ();
+}
+
+int64_t
+CpdaApplication::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_uniformRandomVariable->SetStream (stream);
+  return 1;
+}
+
+void
+CpdaApplication::StartApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<Ipv4> ipv4 = GetNode ()->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4 != 0, "CpdaApplication needs an IPv4 stack");
+  for (uint32_t i = 0; i < ipv4->GetNInterfaces (); ++i)
+    {
+      if (ipv4->GetNAddresses (i) > 0 && ipv4->GetAddress (i, 0).GetLocal () != Ipv4Address::GetLoopback ())
+        {
+          m_address = ipv4->GetAddress (i, 0).GetLocal ();
+          break;
+        }
+    }
+
+  if (m_socket == 0)
+    {
+      TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+      m_socket = Socket::CreateSocket (GetNode (), tid);
+      m_socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), CPDA_PORT));
+      m_socket->SetAllowBroadcast (true);
+    }
+  m_socket->SetRecvCallback (MakeCallback (&CpdaApplication::HandleRead, this));
+
+  // Key selection pre-distribution
+  NS_ABORT_MSG_IF (m_keySelection > m_keyTotal, "KeyRingSize " << m_keySelection
+                   << " exceeds the key pool of " << m_keyTotal << " keys");
+  NS_ABORT_MSG_IF (m_minJitter > m_maxJitter, "MinJitter " << m_minJitter
+                   << " exceeds MaxJitter " << m_maxJitter);
+  m_keyRing.SetPoolSize (m_keyTotal);
+  m_keyRing.SetPoolSecret (m_keyPoolSecret);
+  if (m_keyEncoding == KEY_ENCODING_SEED)
+    {
+      // the ring must be reproducible from the seed we announce
+      m_keySeed = m_uniformRandomVariable->GetInteger (0, std::numeric_limits<uint32_t>::max ());
+      m_keyRing.Generate (m_keySeed, m_keySelection);
+    }
+  else
+    {
+      m_keyRing.Generate (m_uniformRandomVariable, m_keySelection);
+    }
+
+  // the leader relays the m (m - 1) shares of its cluster in one datagram
+  uint32_t maxShares = (CPDA_MAX_DATAGRAM - TypeHeader ().GetSerializedSize ()
+                        - ShareHeader (0, m_batchSize).GetSerializedSize ()) / ShareHeader::GetShareSize (m_batchSize);
+  m_maxClusterSize = 1;
+  while ((m_maxClusterSize + 1) * m_maxClusterSize <= maxShares)
+    {
+      m_maxClusterSize++;
+    }
+
+  if (m_root)
+    {
+      // the root leads its own cluster and has no TAG tree parent
+      m_isClusterLeader = true;
+      StartClusterFormation (m_address, Ipv4Address ());
+      m_round++;
+      m_roundStart = Simulator::Now ();
+      SendQuery ();
+    }
+
+  m_keyStart = Simulator::Now ();
+  m_keyDiscovered = m_keyStart;
+  m_keyTimer.Schedule (GetKeyDelay ());
+}
+
+void
+CpdaApplication::StopApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_keyTimer.Cancel ();
+  Simulator::Cancel (m_keyReplyEvent);
+  Simulator::Cancel (m_keyDiscoveryEvent);
+  m_clusterTimer.Cancel ();
+  m_aggregationTimer.Cancel ();
+  if (m_socket != 0)
+    {
+      m_socket->Close ();
+      m_socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+      m_socket = 0;
+    }
+}
+
+void
+CpdaApplication::HandleRead (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  Ptr<Packet> packet;
+  Address from;
+  while ((packet = socket->RecvFrom (from)))
+    {
+      Ipv4Address sender = InetSocketAddress::ConvertFrom (from).GetIpv4 ();
+      if (sender == m_address)
+        {
+          continue;
+        }
+      TypeHeader tHeader;
+      packet->RemoveHeader (tHeader);
+      if (!tHeader.IsValid ())
+        {
+          NS_LOG_DEBUG ("CPDA message " << packet->GetUid () << " with unknown type received: " << tHeader.Get () << ". Drop");
+          continue;
+        }
+      switch (tHeader.Get ())
+        {
+        case CPDATYPE_KEY:
+          RecvKey (packet, sender);
+          break;
+        case CPDATYPE_QUERY:
+          RecvQuery (packet, sender);
+          break;
+        case CPDATYPE_JOIN:
+          RecvJoin (packet, sender);
+          break;
+        case CPDATYPE_PATH_KEY_REQ:
+          RecvPathKeyRequest (packet, sender);
+          break;
+        case CPDATYPE_PATH_KEY:
+          RecvPathKey (packet, sender);
+          break;
+        case CPDATYPE_ROSTER:
+          RecvRoster (packet, sender);
+          break;
+        case CPDATYPE_SHARE:
+          RecvShare (packet, sender);
+          break;
+        case CPDATYPE_SHARE_RELAY:
+          RecvShareRelay (packet, sender);
+          break;
+        case CPDATYPE_ASSEMBLED:
+          RecvAssembled (packet, sender);
+          break;
+        case CPDATYPE_RESULT:
+          RecvResult (packet, sender);
+          break;
+        }
+    }
+}
+
+void
+CpdaApplication::SendTo (Ptr<Packet> packet, Ipv4Address dst)
+{
+  if (m_socket == 0)
+    {
+      return; // stopped meanwhile
+    }
+  // the UDP socket turns a limited broadcast dst into a subnet directed
+  // broadcast on every interface
+  m_socket->SendTo (packet, 0, InetSocketAddress (dst, CPDA_PORT));
+}
+
+void
+CpdaApplication::SendBroadcast (Header const & header, MessageType type, Time delay)
+{
+  NS_LOG_FUNCTION (this << type << delay);
+  SendUnicast (header, type, Ipv4Address::GetBroadcast (), delay);
+}
+
+void
+CpdaApplication::SendUnicast (Header const & header, MessageType type, Ipv4Address dst, Time delay)
+{
+  NS_LOG_FUNCTION (this << type << dst << delay);
+  Ptr<Packet> packet = Create<Packet> ();
+  // Add tag for IP 1-hop broadcast, or unicast to a neighbor
+  SocketIpTtlTag tag;
+  tag.SetTtl (1);
+  packet->AddPacketTag (tag);
+  packet->AddHeader (header);
+  TypeHeader tHeader (type);
+  packet->AddHeader (tHeader);
+  Simulator::Schedule (delay, &CpdaApplication::SendTo, this, packet, dst);
+}
+
+void
+CpdaApplication::SendRoundBroadcast (Header const & header, MessageType type, Time delay)
+{
+  SendBroadcast (header, type, delay);
+  m_roundMessages++;
+}
+
+Time
+CpdaApplication::GetJitter ()
+{
+  return Seconds (m_uniformRandomVariable->GetValue (m_minJitter.GetSeconds (), m_maxJitter.GetSeconds ()));
+}
+
+//-----------------------------------------------------------------------------
+// Key exchange
+//-----------------------------------------------------------------------------
+/*
+ * Delay of the first key ring announcement. Spreading the announcements of
+ * all nodes over the key window keeps them from colliding at start up.
+ */
+Time
+CpdaApplication::GetKeyDelay ()
+{
+  switch (m_keySchedule)
+    {
+    case KEY_SCHEDULE_IMMEDIATE:
+      {
+        return Seconds (0);
+      }
+    case KEY_SCHEDULE_JITTERED:
+      {
+        return Seconds (m_uniformRandomVariable->GetValue (0, m_keyWindow.GetSeconds ()));
+      }
+    case KEY_SCHEDULE_SLOTTED:
+      {
+        // neighbors usually have consecutive IDs and so land in different slots
+        double slot = m_keyWindow.GetSeconds () / m_keySlots;
+        uint32_t index = GetNode ()->GetId () % m_keySlots;
+        return Seconds (slot * index + m_uniformRandomVariable->GetValue (0, slot));
+      }
+    }
+  return Seconds (0);
+}
+
+void
+CpdaApplication::KeyTimerExpire ()
+{
+  NS_LOG_FUNCTION (this);
+  // repeat only while some neighbor we heard hasn't confirmed our key ring,
+  // or if we heard nobody at all
+  if (m_keyAnnouncements == 0 || m_keyHeard.empty () || m_keyConfirmed.size () < m_keyHeard.size ())
+    {
+      SendKey ();
+    }
+  m_keyAnnouncements++;
+  if (m_keyAnnouncements <= m_keyRetries)
+    {
+      m_keyTimer.Schedule (m_keyRetryInterval + GetJitter ());
+    }
+  else
+    {
+      // leave time for the answers to the last announcement
+      m_keyDiscoveryEvent = Simulator::Schedule (m_keyRetryInterval, &CpdaApplication::KeyDiscoveryDone, this);
+    }
+}
+
+void
+CpdaApplication::KeyDiscoveryDone ()
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_LOGIC (m_address << " heard " << m_keyHeard.size () << " key rings, the last after "
+                          << (m_keyDiscovered - m_keyStart).GetSeconds () << " s");
+  m_keyDiscoveryTrace (m_keyHeard.size (), m_keyDiscovered - m_keyStart);
+}
+
+/*
+ * Announce our key ring. All but the first announcement also list the
+ * neighbors whose rings we heard, which tells the others whether to repeat
+ * their own.
+ */
+void
+CpdaApplication::SendKey ()
+{
+  NS_LOG_FUNCTION (this);
+  m_keyReplyEvent.Cancel ();
+  m_keyReplyPending = false;
+  KeyHeader keyHeader (m_address);
+  keyHeader.SetKeyEncoding (m_keyEncoding);
+  if (m_keyEncoding == KEY_ENCODING_SEED)
+    {
+      keyHeader.SetKeySeed (m_keySeed, m_keyTotal);
+    }
+  keyHeader.SetKey (m_keyRing.GetKeys ());
+  if (m_keyAnnouncements > 0)
+    {
+      keyHeader.SetHeard (m_keyHeard);
+    }
+  SendBroadcast (keyHeader, CPDATYPE_KEY, Seconds (0));
+}
+
+void
+CpdaApplication::RecvKey (Ptr<Packet> p, Ipv4Address sender)
+{
+  NS_LOG_FUNCTION (this << " src " << sender);
+  KeyHeader keyHeader;
+  p->RemoveHeader (keyHeader);
+  if (!keyHeader.IsValid ())
+    {
+      NS_LOG_DEBUG ("Malformed CPDA_KEY from " << sender << ". Drop");
+      return;
+    }
+
+  if (keyHeader.HasHeard ())
+    {
+      std::vector<Ipv4Address> const & heard = keyHeader.GetHeard ();
+      if (std::binary_search (heard.begin (), heard.end (), m_address))
+        {
+          InsertMember (m_keyConfirmed, sender);
+        }
+      else if (m_keyAnnouncements > 0 && !m_keyReplyPending)
+        {
+          // our announcement got lost on the way to sender, repeat it
+          m_keyReplyPending = true;
+          m_keyReplyEvent = Simulator::Schedule (GetJitter (), &CpdaApplication::SendKey, this);
+        }
+    }
+  if (!InsertMember (m_keyHeard, sender))
+    {
+      return; // repeated announcement, the ring is known already
+    }
+  m_keyDiscovered = Simulator::Now ();
+
+  // Find all keys shared with the neighbor, O(ring size) thanks to the key ring bitset
+  std::vector<uint16_t> sharedKeys;
+  m_keyRing.Intersect (keyHeader.GetKey (), sharedKeys);
+  NS_LOG_LOGIC ("S:" << sender << " R:" << m_address << " shared keys:" << sharedKeys.size ());
+
+  if (!sharedKeys.empty ())
+    {
+      m_keyMap.AddKeys (sender, sharedKeys); // keep all of them, any one secures the link
+    }
+  else if (!m_keyMap.HasKey (sender))
+    {
+      // no key in common: ask a neighbor that shares keys with both of us for a path key
+      Time delay = MilliSeconds (PATH_KEY_REQUEST_DELAY) + GetJitter ();
+      Time windowEnd = m_keyStart + m_keyWindow;
+      if (windowEnd > Simulator::Now ())
+        {
+          delay += windowEnd - Simulator::Now ();
+        }
+      Simulator::Schedule (delay, &CpdaApplication::SendPathKeyRequest, this, sender);
+    }
+}
+
+/*
+ * Broadcast a request for a path key to target. Any common neighbor that
+ * shares keys with both this node and target may answer.
+ */
+void
+CpdaApplication::SendPathKeyRequest (Ipv4Address target)
+{
+  NS_LOG_FUNCTION (this << target);
+  if (m_keyMap.HasKey (target))
+    {
+      return; // secured meanwhile by a request of target itself
+    }
+  PathKeyHeader pathKeyHeader (/*origin=*/ m_address, /*target=*/ target);
+  SendBroadcast (pathKeyHeader, CPDATYPE_PATH_KEY_REQ, Seconds (0));
+}
+
+/*
+ * A node sharing keys with both ends of the request becomes a proxy candidate
+ * and answers after a random delay, unless another proxy answers first.
+ */
+void
+CpdaApplication::RecvPathKeyRequest (Ptr<Packet> p, Ipv4Address sender)
+{
+  NS_LOG_FUNCTION (this << " src " << sender);
+  PathKeyHeader pathKeyHeader;
+  p->RemoveHeader (pathKeyHeader);
+  Ipv4Address origin = pathKeyHeader.GetOrigin ();
+  Ipv4Address target = pathKeyHeader.GetTarget ();
+
+  if (!m_keyMap.HasSharedKey (origin) || !m_keyMap.HasSharedKey (target))
+    {
+      return; // can't vouch for both ends
+    }
+  std::pair<uint32_t, uint32_t> link (std::min (origin.Get (), target.Get ()),
+                                      std::max (origin.Get (), target.Get ()));
+  if (m_pathKeyAnswered.find (link) != m_pathKeyAnswered.end ())
+    {
+      return;
+    }
+  Time jitter = GetJitter ();
+  Simulator::Schedule (jitter, &CpdaApplication::SendPathKey, this, origin, target);
+}
+
+namespace {
+/// Key stream that encrypts the value of path key pathKey under a pool key value
+uint32_t
+PathKeyMask (uint32_t keyValue, uint32_t pathKey)
+{
+  return uint32_t (Mix64 (uint64_t (keyValue) << 32 | pathKey));
+}
+}
+
+/*
+ * Proxy side: send a fresh path key to origin and target. Each copy carries
+ * the key value encrypted under a pool key the proxy shares with that end, so
+ * no other neighbor learns it.
+ */
+void
+CpdaApplication::SendPathKey (Ipv4Address origin, Ipv4Address target)
+{
+  NS_LOG_FUNCTION (this << origin << target);
+  std::pair<uint32_t, uint32_t> link (std::min (origin.Get (), target.Get ()),
+                                      std::max (origin.Get (), target.Get ()));
+  if (!m_pathKeyAnswered.insert (link).second)
+    {
+      return; // another proxy, or an earlier request, was answered meanwhile
+    }
+  // path key IDs lie above the pool key IDs, so the two never get confused
+  uint32_t pathKey = m_uniformRandomVariable->GetInteger (0x10000, std::numeric_limits<uint32_t>::max ());
+  uint32_t pathKeyValue = m_uniformRandomVariable->GetInteger (1, std::numeric_limits<uint32_t>::max ());
+  Ipv4Address ends[2] = { origin, target };
+  for (uint32_t e = 0; e < 2; ++e)
+    {
+      uint16_t keyId = m_keyMap.GetKey (ends[e]);
+      PathKeyHeader pathKeyHeader (/*origin=*/ origin, /*target=*/ target,
+                                   /*proxy=*/ m_address, /*path key=*/ pathKey, /*key ID=*/ keyId,
+                                   pathKeyValue ^ PathKeyMask (m_keyRing.GetKeyValue (keyId), pathKey));
+      SendUnicast (pathKeyHeader, CPDATYPE_PATH_KEY, ends[e], Seconds (0));
+    }
+}
+
+/*
+ * Both ends decrypt and install the path key.
+ */
+void
+CpdaApplication::RecvPathKey (Ptr<Packet> p, Ipv4Address sender)
+{
+  NS_LOG_FUNCTION (this << " src " << sender);
+  PathKeyHeader pathKeyHeader;
+  p->RemoveHeader (pathKeyHeader);
+  Ipv4Address origin = pathKeyHeader.GetOrigin ();
+  Ipv4Address target = pathKeyHeader.GetTarget ();
+  m_pathKeyAnswered.insert (std::make_pair (std::min (origin.Get (), target.Get ()),
+                                            std::max (origin.Get (), target.Get ())));
+
+  Ipv4Address peer;
+  if (m_address == origin)
+    {
+      peer = target;
+    }
+  else if (m_address == target)
+    {
+      peer = origin;
+    }
+  else
+    {
+      return;
+    }
+  KeyMap::Entry const * entry = m_keyMap.Lookup (peer);
+  if (entry != 0 && !entry->m_keys.empty ())
+    {
+      return; // a shared key already secures the link
+    }
+  uint32_t keyValue = m_keyRing.GetKeyValue (pathKeyHeader.GetKeyId ());
+  if (keyValue == 0)
+    {
+      NS_LOG_DEBUG (m_address << " does not hold key " << pathKeyHeader.GetKeyId ()
+                              << " of path key from " << sender << ". Drop");
+      return;
+    }
+  // if two proxies answered, both ends keep the key of the lower proxy address
+  if (entry == 0 || entry->m_pathKey == 0 || pathKeyHeader.GetProxy () < entry->m_proxy)
+    {
+      NS_LOG_LOGIC (m_address << " path key " << pathKeyHeader.GetPathKey () << " to " << peer
+                              << " via " << pathKeyHeader.GetProxy ());
+      m_keyMap.SetPathKey (peer, pathKeyHeader.GetProxy (), pathKeyHeader.GetPathKey (),
+                           pathKeyHeader.GetPathKeyValue () ^ PathKeyMask (keyValue, pathKeyHeader.GetPathKey ()));
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Cluster formation
+//-----------------------------------------------------------------------------
+/*
+ * Root node will broadcast a query that will propagate through the network
+ * to establish the TAG tree
+ */
+void
+CpdaApplication::SendQuery ()
+{
+  NS_LOG_FUNCTION (this);
+  QueryHeader queryHeader (/*origin=*/ m_address, /*round=*/ m_round);
+  Time jitter = GetJitter ();
+  SendRoundBroadcast (queryHeader, CPDATYPE_QUERY, jitter);
+}
+
+/*
+ * Upon receiving a Query a node either selects itself as a cluster leader to propagate a query message
+ * or sends a Join message to join the sender of the Query message
+ */
+void
+CpdaApplication::RecvQuery (Ptr<Packet> p, Ipv4Address sender)
+{
+  NS_LOG_FUNCTION (this << " src " << sender);
+  QueryHeader queryHeader;
+  p->RemoveHeader (queryHeader);
+
+  // Only the first query counts, later ones come from other leaders around us
+  if (m_clusterState != CLUSTER_IDLE || m_root)
+    {
+      return;
+    }
+  m_round = queryHeader.GetRound ();
+
+  // probability of self selecting as cluster leader to propagate queries
+  if (m_uniformRandomVariable->GetValue () < m_leaderProbability)
+    {
+      m_isClusterLeader = true;
+      NS_LOG_LOGIC ("Cluster Leader: " << m_address << " parent " << sender);
+      // lead our own cluster, the sender of the query becomes our TAG tree parent
+      StartClusterFormation (m_address, sender);
+      SendQuery (); // forward query
+    }
+  else
+    {
+      // join the cluster of the sender
+      StartClusterFormation (sender, Ipv4Address ());
+      InsertMember (m_clusterMembers, sender);
+    }
+  SendJoin (sender, m_isClusterLeader); // Send a Join msg back to the sender of the query
+}
+
+/*
+ * Reply to Query messages with a Join msg. This is broadcasted so other cluster members
+ * can snoop on the message and add to their list of cluster member IPs
+ */
+void
+CpdaApplication::SendJoin (Ipv4Address leader, bool isLeader)
+{
+  NS_LOG_FUNCTION (this << leader << isLeader);
+  JoinHeader joinHeader (/*leader=*/ leader, /*origin=*/ m_address, /*round=*/ m_round);
+  joinHeader.SetClusterLeader (isLeader);
+  // jitter keeps the JOINs of all nodes that heard the same query from colliding
+  Time jitter = GetJitter ();
+  SendRoundBroadcast (joinHeader, CPDATYPE_JOIN, jitter);
+}
+
+/*
+ * Upon receiving a Join message, we add it to our set of other cluster members if the leader matches
+ * our cluster leader IP. A leader joining us marks itself as our TAG tree child instead.
+ */
+void
+CpdaApplication::RecvJoin (Ptr<Packet> p, Ipv4Address sender)
+{
+  NS_LOG_FUNCTION (this << " src " << sender);
+  JoinHeader joinHeader;
+  p->RemoveHeader (joinHeader);
+
+  if (m_clusterState == CLUSTER_IDLE)
+    {
+      return;
+    }
+  if (m_clusterState == CLUSTER_FORMED)
+    {
+      NS_LOG_LOGIC ("Ignoring late JOIN of " << sender << ", cluster already formed");
+      return;
+    }
+
+  if (joinHeader.GetClusterLeader ())
+    {
+      // child leaders only matter to the node they joined
+      if (joinHeader.GetLeader () == m_address && InsertMember (m_childLeaders, sender))
+        {
+          NS_LOG_LOGIC (m_address << " child leader " << sender);
+        }
+    }
+  else if (joinHeader.GetLeader () == m_clusterLeaderIp)
+    {
+      if (m_isClusterLeader && m_clusterMembers.size () + 1 >= m_maxClusterSize)
+        {
+          NS_LOG_LOGIC ("Cluster of " << m_address << " is full, ignoring JOIN of " << sender);
+          return;
+        }
+      // snoop other nodes joins by checking if the leader matches ours
+      if (InsertMember (m_clusterMembers, sender))
+        {
+          NS_LOG_LOGIC (m_address << " added " << sender << " joining leader " << m_clusterLeaderIp);
+        }
+    }
+}
+
+/*
+ * Enter CLUSTER_FORMING: JOIN messages are collected until the join timeout
+ */
+void
+CpdaApplication::StartClusterFormation (Ipv4Address leader, Ipv4Address parent)
+{
+  NS_LOG_FUNCTION (this << leader << parent);
+  NS_ASSERT (m_clusterState == CLUSTER_IDLE);
+  m_clusterState = CLUSTER_FORMING;
+  m_clusterLeaderIp = leader;
+  m_parentIp = parent;
+  m_clusterMembers.clear ();
+  m_clusterMembers.reserve (CLUSTER_MEMBERS_NUM);
+  m_childLeaders.clear ();
+  m_clusterTimer.Cancel ();
+  m_clusterTimer.Schedule (m_clusterJoinTimeout);
+}
+
+void
+CpdaApplication::ClusterTimerExpire ()
+{
+  NS_LOG_FUNCTION (this);
+  m_clusterState = CLUSTER_FORMED;
+  ClusterFormed ();
+}
+
+/*
+ * Membership is known from here on
+ */
+void
+CpdaApplication::ClusterFormed ()
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_LOGIC ("Cluster of " << m_clusterLeaderIp << " formed with " << m_clusterMembers.size ()
+                              << " other members and " << m_childLeaders.size () << " child leaders");
+  // the leader's view of the membership is the one everybody uses
+  if (m_isClusterLeader)
+    {
+      SendRoster ();
+    }
+}
+
+bool
+CpdaApplication::InsertMember (std::vector<Ipv4Address> & members, Ipv4Address ip)
+{
+  std::vector<Ipv4Address>::iterator i = std::lower_bound (members.begin (), members.end (), ip);
+  if (i != members.end () && *i == ip)
+    {
+      return false;
+    }
+  members.insert (i, ip);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// Aggregation round
+//-----------------------------------------------------------------------------
+/*
+ * One round, per cluster of m members with evaluation points x_j = j + 1
+ * (j = position in the roster):
+ *  1. the leader announces the roster
+ *  2. member i hides each reading d_i in a random polynomial of degree m - 1,
+ *     P_i(x) = d_i + r_1 x + ... + r_(m-1) x^(m-1), and sends P_i(x_j) for every
+ *     other member j, encrypted with the link key to j, in one packet to the leader
+ *  3. the leader relays all shares in one broadcast, which bounds the cluster size
+ *  4. member j sends F_j = sum_i P_i(x_j) to the leader
+ *  5. the leader solves the Vandermonde system for the constant term of
+ *     sum_i P_i, which is the cluster sum, adds the results of its child leaders
+ *     and forwards the total to its TAG tree parent
+ * All readings of a round travel as one batch of m_batchSize values.
+ */
+namespace {
+/// Key stream used to encrypt a share; only both ends know the link key value
+uint32_t
+ShareMask (uint32_t keyValue, uint32_t round, Ipv4Address origin, Ipv4Address dst, uint32_t index)
+{
+  uint64_t z = (uint64_t (keyValue) << 32 | round) ^ (uint64_t (origin.Get ()) << 32 | dst.Get ()) ^ (uint64_t (index) * 0x9e3779b97f4a7c15ULL);
+  return Mix64 (z) % ShareMath::PRIME;
+}
+}
+
+void
+CpdaApplication::SendRoster ()
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Ipv4Address> roster = m_clusterMembers;
+  InsertMember (roster, m_clusterLeaderIp);
+
+  RosterHeader rosterHeader (m_round, m_clusterLeaderIp);
+  rosterHeader.SetMembers (roster);
+  if (roster.size () > 1)
+    {
+      SendRoundBroadcast (rosterHeader, CPDATYPE_ROSTER, Seconds (0));
+    }
+  StartAggregation (roster);
+}
+
+void
+CpdaApplication::RecvRoster (Ptr<Packet> p, Ipv4Address sender)
+{
+  NS_LOG_FUNCTION (this << " src " << sender);
+  RosterHeader rosterHeader;
+  p->RemoveHeader (rosterHeader);
+
+  if (m_isClusterLeader || sender != m_clusterLeaderIp || rosterHeader.GetRound () != m_round
+      || m_aggregationPhase != AGGREGATION_IDLE)
+    {
+      return;
+    }
+  std::vector<Ipv4Address> const & roster = rosterHeader.GetMembers ();
+  if (!std::binary_search (roster.begin (), roster.end (), m_address))
+    {
+      NS_LOG_LOGIC (m_address << " missing from the roster of " << sender);
+      return;
+    }
+  // the roster replaces whatever membership we snooped
+  m_clusterMembers = roster;
+  m_clusterMembers.erase (std::lower_bound (m_clusterMembers.begin (), m_clusterMembers.end (), m_address));
+  StartAggregation (roster);
+}
+
+/*
+ * Draw this round's readings and share them: every other member gets one
+ * evaluation of our polynomials, all of them batched in a single packet.
+ */
+void
+CpdaApplication::StartAggregation (std::vector<Ipv4Address> const & roster)
+{
+  NS_LOG_FUNCTION (this << roster.size ());
+  m_roster = roster;
+  uint32_t members = roster.size ();
+
+  m_readings.resize (m_batchSize);
+  for (uint8_t b = 0; b < m_batchSize; ++b)
+    {
+      m_readings[b] = m_uniformRandomVariable->GetInteger (0, CPDA_MAX_READING - 1);
+    }
+  m_readingTrace (m_round, m_readings);
+
+  // m_coefficients[b * members + k] is the coefficient of x^k of the polynomial hiding reading b
+  m_shareMath.SetSize (members, m_batchSize);
+  m_coefficients.resize (m_batchSize * members);
+  for (uint8_t b = 0; b < m_batchSize; ++b)
+    {
+      m_coefficients[b * members] = m_readings[b];
+      for (uint32_t k = 1; k < members; ++k)
+        {
+          m_coefficients[b * members + k] = m_uniformRandomVariable->GetInteger (0, ShareMath::PRIME - 1);
+        }
+    }
+  // m_shares[j * batch + b] = share of reading b for member j
+  m_shares.resize (members * m_batchSize);
+  m_shareMath.Evaluate (&m_coefficients[0], &m_shares[0]);
+
+  ShareHeader shareHeader (m_round, m_batchSize);
+  for (uint32_t j = 0; j < members; ++j)
+    {
+      uint32_t const * values = &m_shares[j * m_batchSize];
+      if (roster[j] == m_address)
+        {
+          m_ownShares.assign (values, values + m_batchSize);
+          continue;
+        }
+      Share share;
+      share.m_origin = m_address;
+      share.m_dst = roster[j];
+      share.m_keyId = m_keyMap.GetKey (roster[j]);
+      if (share.m_keyId == 0)
+        {
+          NS_LOG_LOGIC (m_address << " has no key with " << roster[j] << ", share sent in the clear");
+        }
+      uint32_t keyValue = GetLinkKeyValue (roster[j], share.m_keyId);
+      share.m_values.resize (m_batchSize);
+      for (uint8_t b = 0; b < m_batchSize; ++b)
+        {
+          share.m_values[b] = ShareMath::Add (values[b], ShareMask (keyValue, m_round, m_address, roster[j], b));
+        }
+      shareHeader.AddShare (share);
+    }
+
+  if (m_isClusterLeader)
+    {
+      m_collectedShares = shareHeader.GetShares ();
+      m_shareOrigins.assign (1, m_address);
+      m_assembled.resize (members * m_batchSize);
+      m_assembledFrom.assign (members, false);
+      m_assembledCount = 0;
+      m_subtreeSum.resize (m_batchSize, 0); // child results may already be in
+      m_aggregationPhase = AGGREGATION_SHARES;
+      if (m_shareOrigins.size () == members)
+        {
+          SendShareRelay ();
+        }
+      else
+        {
+          m_aggregationTimer.Schedule (m_shareTimeout);
+        }
+    }
+  else
+    {
+      m_aggregationPhase = AGGREGATION_RELAY;
+      Time jitter = GetJitter ();
+      SendRoundBroadcast (shareHeader, CPDATYPE_SHARE, jitter);
+    }
+}
+
+void
+CpdaApplication::RecvShare (Ptr<Packet> p, Ipv4Address sender)
+{
+  NS_LOG_FUNCTION (this << " src " << sender);
+  ShareHeader shareHeader;
+  p->RemoveHeader (shareHeader);
+
+  if (m_aggregationPhase != AGGREGATION_SHARES || shareHeader.GetRound () != m_round
+      || shareHeader.GetBatchSize () != m_batchSize
+      || !std::binary_search (m_roster.begin (), m_roster.end (), sender))
+    {
+      return;
+    }
+  if (!InsertMember (m_shareOrigins, sender))
+    {
+      return;
+    }
+  std::vector<Share> const & shares = shareHeader.GetShares ();
+  m_collectedShares.insert (m_collectedShares.end (), shares.begin (), shares.end ());
+  if (m_shareOrigins.size () == m_roster.size ())
+    {
+      m_aggregationTimer.Cancel ();
+      SendShareRelay ();
+    }
+}
+
+void
+CpdaApplication::SendShareRelay ()
+{
+  NS_LOG_FUNCTION (this << m_shareOrigins.size () << m_roster.size ());
+  ShareHeader relayHeader (m_round, m_batchSize);
+  for (std::vector<Share>::const_iterator i = m_collectedShares.begin (); i != m_collectedShares.end (); ++i)
+    {
+      relayHeader.AddShare (*i);
+    }
+  NS_ASSERT_MSG (TypeHeader ().GetSerializedSize () + relayHeader.GetSerializedSize () <= CPDA_MAX_DATAGRAM,
+                 "Share relay of " << m_roster.size () << " members exceeds a UDP datagram");
+  if (m_roster.size () > 1)
+    {
+      SendRoundBroadcast (relayHeader, CPDATYPE_SHARE_RELAY, Seconds (0));
+    }
+
+  // our own assembled sum
+  m_aggregationPhase = AGGREGATION_ASSEMBLE;
+  uint32_t index = std::lower_bound (m_roster.begin (), m_roster.end (), m_address) - m_roster.begin ();
+  std::vector<uint32_t> assembled = AssembleShares (m_collectedShares);
+  std::copy (assembled.begin (), assembled.end (), m_assembled.begin () + index * m_batchSize);
+  m_assembledFrom[index] = true;
+  m_assembledCount = 1;
+  m_collectedShares.clear ();
+  if (m_assembledCount == m_roster.size ())
+    {
+      SolveClusterSum ();
+    }
+  else
+    {
+      m_aggregationTimer.Schedule (m_shareTimeout);
+    }
+}
+
+void
+CpdaApplication::RecvShareRelay (Ptr<Packet> p, Ipv4Address sender)
+{
+  NS_LOG_FUNCTION (this << " src " << sender);
+  ShareHeader relayHeader;
+  p->RemoveHeader (relayHeader);
+
+  if (m_aggregationPhase != AGGREGATION_RELAY || sender != m_clusterLeaderIp
+      || relayHeader.GetRound () != m_round || relayHeader.GetBatchSize () != m_batchSize)
+    {
+      return;
+    }
+  SumHeader assembledHeader (m_clusterLeaderIp, m_round);
+  assembledHeader.SetValues (AssembleShares (relayHeader.GetShares ()));
+  assembledHeader.SetMessages (m_roundMessages + 1); // including this one
+  m_aggregationPhase = AGGREGATION_DONE;
+  Time jitter = GetJitter ();
+  SendRoundBroadcast (assembledHeader, CPDATYPE_ASSEMBLED, jitter);
+}
+
+/*
+ * F_me = sum over every member i whose shares the leader relayed of P_i(x_me)
+ */
+std::vector<uint32_t>
+CpdaApplication::AssembleShares (std::vector<Share> const & shares) const
+{
+  std::vector<uint32_t> assembled (m_batchSize, 0);
+  bool relayed = (m_roster.size () == 1); // a lone leader has no shares to relay
+  for (std::vector<Share>::const_iterator i = shares.begin (); i != shares.end (); ++i)
+    {
+      if (i->m_origin == m_address)
+        {
+          relayed = true;
+          continue;
+        }
+      if (i->m_dst != m_address)
+        {
+          continue;
+        }
+      uint32_t keyValue = GetLinkKeyValue (i->m_origin, i->m_keyId);
+      if (i->m_keyId != 0 && keyValue == 0)
+        {
+          NS_LOG_WARN (m_address << " does not hold key " << i->m_keyId << " of " << i->m_origin);
+        }
+      for (uint8_t b = 0; b < m_batchSize; ++b)
+        {
+          uint32_t mask = ShareMask (keyValue, m_round, i->m_origin, m_address, b);
+          assembled[b] = ShareMath::Add (assembled[b], ShareMath::Sub (i->m_values[b], mask));
+        }
+    }
+  // our shares were relayed, so our own polynomial counts as well
+  if (relayed)
+    {
+      for (uint8_t b = 0; b < m_batchSize; ++b)
+        {
+          assembled[b] = ShareMath::Add (assembled[b], m_ownShares[b]);
+        }
+    }
+  return assembled;
+}
+
+uint32_t
+CpdaApplication::GetLinkKeyValue (Ipv4Address neighbor, uint32_t keyId) const
+{
+  if (keyId == 0)
+    {
+      return 0;
+    }
+  // pool key IDs fit in 16 bits, path key IDs lie above them
+  if (keyId <= 0xffff)
+    {
+      return m_keyRing.GetKeyValue (keyId);
+    }
+  KeyMap::Entry const * entry = m_keyMap.Lookup (neighbor);
+  return (entry != 0 && entry->m_pathKey == keyId) ? entry->m_pathKeyValue : 0;
+}
+
+void
+CpdaApplication::RecvAssembled (Ptr<Packet> p, Ipv4Address sender)
+{
+  NS_LOG_FUNCTION (this << " src " << sender);
+  SumHeader assembledHeader;
+  p->RemoveHeader (assembledHeader);
+
+  if (m_aggregationPhase != AGGREGATION_ASSEMBLE || assembledHeader.GetDst () != m_address
+      || assembledHeader.GetRound () != m_round || assembledHeader.GetValues ().size () != m_batchSize)
+    {
+      return;
+    }
+  std::vector<Ipv4Address>::const_iterator i = std::lower_bound (m_roster.begin (), m_roster.end (), sender);
+  uint32_t index = i - m_roster.begin ();
+  if (i == m_roster.end () || *i != sender || m_assembledFrom[index])
+    {
+      return;
+    }
+  std::copy (assembledHeader.GetValues ().begin (), assembledHeader.GetValues ().end (),
+             m_assembled.begin () + index * m_batchSize);
+  m_assembledFrom[index] = true;
+  m_assembledCount++;
+  m_subtreeMessages += assembledHeader.GetMessages ();
+  if (m_assembledCount == m_roster.size ())
+    {
+      m_aggregationTimer.Cancel ();
+      SolveClusterSum ();
+    }
+}
+
+/*
+ * The cluster sum is sum_i P_i(0), the constant term of the solution of the
+ * Vandermonde system through the assembled sums F_j.
+ */
+void
+CpdaApplication::SolveClusterSum ()
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t members = m_roster.size ();
+  if (m_assembledCount == members)
+    {
+      std::vector<uint32_t> sums (m_batchSize);
+      m_shareMath.Solve (&m_assembled[0], &sums[0]);
+      for (uint8_t b = 0; b < m_batchSize; ++b)
+        {
+          m_subtreeSum[b] = ShareMath::Add (m_subtreeSum[b], sums[b]);
+        }
+      m_subtreeContributors += m_shareOrigins.size ();
+      NS_LOG_LOGIC ("Cluster " << m_clusterLeaderIp << " sum over " << m_shareOrigins.size () << " of "
+                               << members << " members");
+    }
+  else
+    {
+      NS_LOG_LOGIC ("Cluster " << m_clusterLeaderIp << " lost " << members - m_assembledCount
+                               << " assembled sums, cluster sum dropped");
+    }
+
+  m_aggregationPhase = AGGREGATION_CHILDREN;
+  if (m_childReported.size () == m_childLeaders.size ())
+    {
+      FinishRound ();
+    }
+  else
+    {
+      m_aggregationTimer.Schedule (m_resultTimeout);
+    }
+}
+
+void
+CpdaApplication::RecvResult (Ptr<Packet> p, Ipv4Address sender)
+{
+  NS_LOG_FUNCTION (this << " src " << sender);
+  SumHeader resultHeader;
+  p->RemoveHeader (resultHeader);
+
+  // results of child leaders may arrive before our own cluster sum is known
+  if (!m_isClusterLeader || m_aggregationPhase == AGGREGATION_DONE || resultHeader.GetDst () != m_address
+      || resultHeader.GetRound () != m_round || resultHeader.GetValues ().size () != m_batchSize
+      || !std::binary_search (m_childLeaders.begin (), m_childLeaders.end (), sender)
+      || !InsertMember (m_childReported, sender))
+    {
+      return;
+    }
+  m_subtreeSum.resize (m_batchSize, 0);
+  for (uint8_t b = 0; b < m_batchSize; ++b)
+    {
+      m_subtreeSum[b] = ShareMath::Add (m_subtreeSum[b], resultHeader.GetValues ()[b]);
+    }
+  m_subtreeContributors += resultHeader.GetContributors ();
+  m_subtreeMessages += resultHeader.GetMessages ();
+  if (m_aggregationPhase == AGGREGATION_CHILDREN && m_childReported.size () == m_childLeaders.size ())
+    {
+      m_aggregationTimer.Cancel ();
+      FinishRound ();
+    }
+}
+
+void
+CpdaApplication::FinishRound ()
+{
+  NS_LOG_FUNCTION (this);
+  m_aggregationPhase = AGGREGATION_DONE;
+  if (m_root)
+    {
+      uint32_t messages = m_subtreeMessages + m_roundMessages;
+      Time latency = Simulator::Now () - m_roundStart;
+      NS_LOG_INFO ("CPDA round " << m_round << ": " << m_subtreeContributors << " nodes, "
+                                 << messages << " messages, latency " << latency.GetSeconds () << " s");
+      m_resultTrace (m_round, m_subtreeSum, m_subtreeContributors, messages, latency);
+      return;
+    }
+  SumHeader resultHeader (m_parentIp, m_round);
+  resultHeader.SetValues (m_subtreeSum);
+  resultHeader.SetContributors (m_subtreeContributors);
+  resultHeader.SetMessages (m_subtreeMessages + m_roundMessages + 1); // including this one
+  Time jitter = GetJitter ();
+  SendRoundBroadcast (resultHeader, CPDATYPE_RESULT, jitter);
+}
+
+void
+CpdaApplication::AggregationTimerExpire ()
+{
+  NS_LOG_FUNCTION (this << m_aggregationPhase);
+  switch (m_aggregationPhase)
+    {
+    case AGGREGATION_SHARES:
+      SendShareRelay ();
+      break;
+    case AGGREGATION_ASSEMBLE:
+      SolveClusterSum ();
+      break;
+    case AGGREGATION_CHILDREN:
+      NS_LOG_LOGIC (m_childLeaders.size () - m_childReported.size () << " child leaders never reported");
+      FinishRound ();
+      break;
+    default:
+      break;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,283 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CPDA_APPLICATION_H
+#define CPDA_APPLICATION_H
+
+#include "cpda-packet.h"
+#include "cpda-key-ring.h"
+#include "cpda-key-map.h"
+#include "cpda-share-math.h"
+#include "ns3/application.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/timer.h"
+#include "ns3/traced-callback.h"
+#include "ns3/random-variable-stream.h"
+#include <set>
+#include <vector>
+
+namespace ns3 {
+
+class Socket;
+class Packet;
+
+/**
+ * \ingroup cpda
+ * \brief Cluster-based Private Data Aggregation (CPDA)
+ *
+ * Every node announces its key ring once and secures a link to each neighbor
+ * with a shared or path key. The root then starts a round: its query builds a
+ * TAG tree of cluster leaders, every cluster hides the readings of its members
+ * in polynomial shares and only the cluster sums travel up the tree.
+ *
+ * All CPDA messages are one hop UDP broadcasts on CPDA_PORT, so the
+ * application runs on top of any routing protocol.
+ */
+class CpdaApplication : public Application
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /// UDP port of all CPDA messages
+  static const uint16_t CPDA_PORT;
+
+  CpdaApplication ();
+  virtual ~CpdaApplication ();
+
+  /// When the first key ring announcement is sent
+  enum KeySchedule
+  {
+    KEY_SCHEDULE_IMMEDIATE = 0, //!< at application start
+    KEY_SCHEDULE_JITTERED = 1,  //!< uniformly within the key window
+    KEY_SCHEDULE_SLOTTED = 2,   //!< in the key window slot given by the node ID, jittered within the slot
+  };
+
+  /**
+   * TracedCallback signature for the end of the key exchange of a node.
+   * \param [in] neighbors number of neighbors whose key rings were heard
+   * \param [in] completion time from application start to the last new key ring
+   */
+  typedef void (* KeyDiscoveryTracedCallback)(uint32_t neighbors, Time completion);
+
+  /**
+   * TracedCallback signature for the private readings of a node.
+   * \param [in] round aggregation round
+   * \param [in] readings one value per batch element
+   */
+  typedef void (* ReadingTracedCallback)(uint32_t round, const std::vector<uint32_t> & readings);
+  /**
+   * TracedCallback signature for the aggregate reaching the root.
+   * \param [in] round aggregation round
+   * \param [in] sums one sum per batch element
+   * \param [in] contributors number of nodes included in the sums
+   * \param [in] messages CPDA messages sent for the round by the nodes included
+   * \param [in] latency time since the root sent the query
+   */
+  typedef void (* ResultTracedCallback)(uint32_t round, const std::vector<uint32_t> & sums,
+                                        uint16_t contributors, uint32_t messages, Time latency);
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// Cluster formation state
+  enum ClusterState
+  {
+    CLUSTER_IDLE = 0,    //!< not part of any cluster yet
+    CLUSTER_FORMING = 1, //!< in a cluster, collecting JOIN messages until the join timeout
+    CLUSTER_FORMED = 2,  //!< membership is fixed, aggregation can start
+  };
+
+  /// Aggregation round phase
+  enum AggregationPhase
+  {
+    AGGREGATION_IDLE = 0,     //!< no roster received yet
+    AGGREGATION_SHARES = 1,   //!< leader: collecting member shares
+    AGGREGATION_RELAY = 2,    //!< member: waiting for the leader to relay the shares
+    AGGREGATION_ASSEMBLE = 3, //!< leader: collecting assembled share sums
+    AGGREGATION_CHILDREN = 4, //!< leader: cluster sum known, waiting for child leaders
+    AGGREGATION_DONE = 5,     //!< nothing left to do this round
+  };
+
+  virtual void StartApplication (void);
+  virtual void StopApplication (void);
+
+  /// Receive and dispatch a CPDA message
+  void HandleRead (Ptr<Socket> socket);
+  /// Send a CPDA message to dst, or to all neighbors if dst is the broadcast address
+  void SendTo (Ptr<Packet> packet, Ipv4Address dst);
+  /// 1-hop broadcast of header after delay
+  void SendBroadcast (Header const & header, cpda::MessageType type, Time delay);
+  /// 1-hop unicast of header to the neighbor dst after delay
+  void SendUnicast (Header const & header, cpda::MessageType type, Ipv4Address dst, Time delay);
+  /// SendBroadcast for messages of the round, counted in m_roundMessages
+  void SendRoundBroadcast (Header const & header, cpda::MessageType type, Time delay);
+  /// Random delay between MinJitter and MaxJitter
+  Time GetJitter ();
+
+  ///\name Key exchange
+  //\{
+  /// Delay of the first key ring announcement, following m_keySchedule
+  Time GetKeyDelay ();
+  /// Announce the key ring, then schedule the next retry
+  void KeyTimerExpire ();
+  /// Fire the KeyDiscovery trace
+  void KeyDiscoveryDone ();
+  /// Broadcast our key ring to all neighbors
+  void SendKey ();
+  void RecvKey (Ptr<Packet> p, Ipv4Address sender);
+  /// Ask common neighbors for a path key to target
+  void SendPathKeyRequest (Ipv4Address target);
+  void RecvPathKeyRequest (Ptr<Packet> p, Ipv4Address sender);
+  /// Proxy answer with a fresh path key, sent to each end
+  void SendPathKey (Ipv4Address origin, Ipv4Address target);
+  void RecvPathKey (Ptr<Packet> p, Ipv4Address sender);
+  //\}
+
+  ///\name Cluster formation
+  //\{
+  /// Broadcast the query of the round
+  void SendQuery ();
+  void RecvQuery (Ptr<Packet> p, Ipv4Address sender);
+  /// Answer the query of leader
+  void SendJoin (Ipv4Address leader, bool isLeader);
+  void RecvJoin (Ptr<Packet> p, Ipv4Address sender);
+  /// Enter CLUSTER_FORMING
+  void StartClusterFormation (Ipv4Address leader, Ipv4Address parent);
+  /// Join timeout, membership is now fixed
+  void ClusterTimerExpire ();
+  /// Called once the cluster reaches CLUSTER_FORMED
+  void ClusterFormed ();
+  /// Sorted, duplicate free insert
+  static bool InsertMember (std::vector<Ipv4Address> & members, Ipv4Address ip);
+  //\}
+
+  ///\name Aggregation round
+  //\{
+  /// Leader: announce the final membership
+  void SendRoster ();
+  void RecvRoster (Ptr<Packet> p, Ipv4Address sender);
+  /// Draw readings and send shares
+  void StartAggregation (std::vector<Ipv4Address> const & roster);
+  void RecvShare (Ptr<Packet> p, Ipv4Address sender);
+  /// Leader: relay all collected shares in one broadcast
+  void SendShareRelay ();
+  void RecvShareRelay (Ptr<Packet> p, Ipv4Address sender);
+  std::vector<uint32_t> AssembleShares (std::vector<cpda::Share> const & shares) const;
+  /// Secret value of key keyId, pool or path key, on the link to neighbor; 0 if we don't hold it
+  uint32_t GetLinkKeyValue (Ipv4Address neighbor, uint32_t keyId) const;
+  void RecvAssembled (Ptr<Packet> p, Ipv4Address sender);
+  /// Leader: recover the cluster sum from the assembled sums
+  void SolveClusterSum ();
+  void RecvResult (Ptr<Packet> p, Ipv4Address sender);
+  /// Leader: forward the subtree sum to the parent, or report it at the root
+  void FinishRound ();
+  void AggregationTimerExpire ();
+  //\}
+
+  Ptr<Socket> m_socket;   //!< CPDA broadcast socket
+  Ipv4Address m_address;  //!< Address of this node, first non-loopback interface
+  bool m_root;            //!< Indicates that this node is the root query node
+  double m_leaderProbability; //!< probability of becoming a cluster leader on the first query
+  Ptr<UniformRandomVariable> m_uniformRandomVariable; //!< Provides uniform random variables
+  Time m_minJitter;       //!< lower bound of GetJitter
+  Time m_maxJitter;       //!< upper bound of GetJitter
+
+  // Key management
+  uint16_t m_keyTotal;         //!< total number of possible keys
+  uint16_t m_keySelection;     //!< total number of keys to be selected per node
+  uint64_t m_keyPoolSecret;    //!< secret the pool key values are derived from
+  cpda::KeyRing m_keyRing;     //!< keys for exchange, built once in StartApplication
+  cpda::KeyEncoding m_keyEncoding; //!< wire encoding of the key ring in CPDA_KEY messages
+  uint32_t m_keySeed;          //!< seed of m_keyRing when the SEED encoding is used
+  cpda::KeyMap m_keyMap;       //!< (IP,Keys) mapping for neighbor nodes, shared and path keys
+  std::set<std::pair<uint32_t, uint32_t> > m_pathKeyAnswered; //!< (lower IP, higher IP) pairs that already got a path key
+  KeySchedule m_keySchedule;   //!< when the first key ring announcement is sent
+  Time m_keyWindow;            //!< first announcements are spread over this time
+  uint16_t m_keySlots;         //!< slots of the key window, KEY_SCHEDULE_SLOTTED only
+  uint8_t m_keyRetries;        //!< repeated announcements at most
+  Time m_keyRetryInterval;     //!< time between announcements
+  uint16_t m_keyAnnouncements; //!< announcements so far, including skipped retries; wider than m_keyRetries
+  Time m_keyStart;             //!< when the key exchange started
+  Time m_keyDiscovered;        //!< when the last new key ring was heard
+  std::vector<Ipv4Address> m_keyHeard;     //!< neighbors whose key rings we heard, sorted
+  std::vector<Ipv4Address> m_keyConfirmed; //!< neighbors that listed us as heard, sorted
+  bool m_keyReplyPending;      //!< an announcement answering a neighbor that missed ours is scheduled
+  EventId m_keyReplyEvent;     //!< that announcement
+  EventId m_keyDiscoveryEvent; //!< end of the key exchange
+  Timer m_keyTimer;            //!< next key ring announcement
+
+  // Cluster formation
+  ClusterState m_clusterState;     //!< cluster formation state of this node
+  bool m_isClusterLeader;          //!< flag to check if this node is a cluster leader
+  Ipv4Address m_clusterLeaderIp;   //!< IP of the cluster leader, our own IP if we lead the cluster
+  Ipv4Address m_parentIp;          //!< TAG tree parent of a cluster leader, unset for members and the root
+  std::vector<Ipv4Address> m_clusterMembers; //!< IP of the other cluster members, sorted and duplicate free
+  std::vector<Ipv4Address> m_childLeaders;   //!< IP of the cluster leaders below us in the TAG tree, sorted
+  Time m_clusterJoinTimeout;       //!< how long JOIN messages are collected after joining or leading a cluster
+  Timer m_clusterTimer;            //!< join timeout timer
+  uint32_t m_maxClusterSize;       //!< leader: most members, itself included, whose shares fit in one relay
+
+  // Aggregation round
+  uint32_t m_round;                //!< aggregation round, set by the root and carried in the query
+  Time m_roundStart;               //!< root only: when the query of the round was sent
+  uint32_t m_roundMessages;        //!< CPDA messages this node sent during the round
+  uint8_t m_batchSize;             //!< number of values aggregated per round
+  AggregationPhase m_aggregationPhase; //!< where this node stands in the round
+  std::vector<Ipv4Address> m_roster;   //!< cluster members including the leader, sorted, as announced by the leader
+  std::vector<uint32_t> m_readings;    //!< private values of this node
+  cpda::ShareMath m_shareMath;         //!< share arithmetic, sized to the cluster
+  std::vector<uint32_t> m_coefficients; //!< batch x members polynomial coefficients
+  std::vector<uint32_t> m_shares;       //!< members x batch shares of our readings
+  std::vector<uint32_t> m_ownShares;    //!< shares this node keeps for itself
+  std::vector<cpda::Share> m_collectedShares; //!< leader: shares of all members, relayed as a batch
+  std::vector<Ipv4Address> m_shareOrigins;    //!< leader: members whose shares arrived, sorted
+  std::vector<uint32_t> m_assembled;    //!< leader: members x batch assembled sums, by roster index
+  std::vector<bool> m_assembledFrom;    //!< leader: roster members whose assembled sums arrived
+  uint32_t m_assembledCount;            //!< leader: number of assembled sums received
+  std::vector<uint32_t> m_subtreeSum;   //!< leader: sums of the cluster and the child subtrees
+  uint16_t m_subtreeContributors;       //!< leader: nodes included in m_subtreeSum
+  uint32_t m_subtreeMessages;           //!< leader: messages reported by members and children
+  std::vector<Ipv4Address> m_childReported; //!< leader: child leaders whose result arrived, sorted
+  Time m_shareTimeout;                  //!< leader: how long shares, then assembled sums, are collected
+  Time m_resultTimeout;                 //!< leader: how long child results are awaited
+  Timer m_aggregationTimer;             //!< phase timeout timer
+
+  /// End of the key exchange
+  TracedCallback<uint32_t, Time> m_keyDiscoveryTrace;
+  /// Readings of this node
+  TracedCallback<uint32_t, const std::vector<uint32_t> &> m_readingTrace;
+  /// Aggregate of a round at the root
+  TracedCallback<uint32_t, const std::vector<uint32_t> &, uint16_t, uint32_t, Time> m_resultTrace;
+};
+
+} // namespace ns3
+
+#endif /* CPDA_APPLICATION_H */
@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "cpda-key-map.h"
+#include "ns3/assert.h"
+#include <algorithm>
+#include <iterator>
+
+namespace ns3
+{
+namespace cpda
+{
+
+KeyMap::KeyMap ()
+{
+}
+
+KeyMap::Entry &
+KeyMap::FindOrInsert (Ipv4Address neighbor)
+{
+  std::pair<Entry *, bool> inserted = m_entries.Insert (neighbor.Get (), Entry ());
+  if (inserted.second)
+    {
+      inserted.first->m_neighbor = neighbor;
+    }
+  return *inserted.first;
+}
+
+void
+KeyMap::AddKeys (Ipv4Address neighbor, std::vector<uint16_t> const & keys)
+{
+  Entry & entry = FindOrInsert (neighbor);
+  if (entry.m_keys.empty ())
+    {
+      entry.m_keys = keys;
+      return;
+    }
+  std::vector<uint16_t> merged;
+  merged.reserve (entry.m_keys.size () + keys.size ());
+  std::set_union (entry.m_keys.begin (), entry.m_keys.end (), keys.begin (), keys.end (),
+                  std::back_inserter (merged));
+  entry.m_keys.swap (merged);
+}
+
+void
+KeyMap::AddKey (Ipv4Address neighbor, uint16_t key)
+{
+  Entry & entry = FindOrInsert (neighbor);
+  std::vector<uint16_t>::iterator i = std::lower_bound (entry.m_keys.begin (), entry.m_keys.end (), key);
+  if (i == entry.m_keys.end () || *i != key)
+    {
+      entry.m_keys.insert (i, key);
+    }
+}
+
+void
+KeyMap::SetPathKey (Ipv4Address neighbor, Ipv4Address proxy, uint32_t pathKey, uint32_t pathKeyValue)
+{
+  NS_ASSERT (pathKey != 0);
+  Entry & entry = FindOrInsert (neighbor);
+  entry.m_pathKey = pathKey;
+  entry.m_pathKeyValue = pathKeyValue;
+  entry.m_proxy = proxy;
+}
+
+bool
+KeyMap::DeleteKey (Ipv4Address neighbor)
+{
+  return m_entries.Erase (neighbor.Get ());
+}
+
+KeyMap::Entry const *
+KeyMap::Lookup (Ipv4Address neighbor) const
+{
+  return m_entries.Find (neighbor.Get ());
+}
+
+bool
+KeyMap::HasKey (Ipv4Address neighbor) const
+{
+  Entry const * entry = Lookup (neighbor);
+  return (entry != 0 && entry->IsSecured ());
+}
+
+bool
+KeyMap::HasSharedKey (Ipv4Address neighbor) const
+{
+  Entry const * entry = Lookup (neighbor);
+  return (entry != 0 && !entry->m_keys.empty ());
+}
+
+uint32_t
+KeyMap::GetKey (Ipv4Address neighbor) const
+{
+  Entry const * entry = Lookup (neighbor);
+  if (entry == 0)
+    {
+      return 0;
+    }
+  return entry->m_keys.empty () ? entry->m_pathKey : entry->m_keys.front ();
+}
+
+void
+KeyMap::GetNeighbors (std::vector<Ipv4Address> & neighbors) const
+{
+  for (FlatMap<uint32_t, Entry>::const_iterator i = m_entries.Begin (); i != m_entries.End (); ++i)
+    {
+      neighbors.push_back (i->second.m_neighbor);
+    }
+}
+
+void
+KeyMap::Clear ()
+{
+  m_entries.Clear ();
+}
+
+void
+KeyMap::Print (std::ostream & os) const
+{
+  for (FlatMap<uint32_t, Entry>::const_iterator i = m_entries.Begin (); i != m_entries.End (); ++i)
+    {
+      Entry const & e = i->second;
+      os << "IP: " << e.m_neighbor << " Keys:";
+      for (std::vector<uint16_t>::const_iterator k = e.m_keys.begin (); k != e.m_keys.end (); ++k)
+        {
+          os << " " << *k;
+        }
+      if (e.m_pathKey != 0)
+        {
+          os << " Path key: " << e.m_pathKey << " via " << e.m_proxy;
+        }
+      os << std::endl;
+    }
+}
+
+}
+}
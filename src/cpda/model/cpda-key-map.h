@@ -0,0 +1,112 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CPDA_KEY_MAP_H
+#define CPDA_KEY_MAP_H
+
+#include "ns3/ipv4-address.h"
+#include "ns3/flat-map.h"
+#include <vector>
+#include <ostream>
+#include <stdint.h>
+
+namespace ns3
+{
+namespace cpda
+{
+/**
+ * \ingroup cpda
+ *
+ * \brief CPDA per node key store: keys shared with every secured neighbor.
+ *
+ * A neighbor is secured either directly, by one or more key IDs of both key
+ * rings, or by a path key set up by an intermediary (proxy) node that shares
+ * keys with both ends. Entries live in a FlatMap keyed by the IPv4 address,
+ * so lookups cost O(1) on average.
+ */
+class KeyMap
+{
+public:
+  /// Key material known for one neighbor
+  struct Entry
+  {
+    /// Neighbor address
+    Ipv4Address m_neighbor;
+    /// Key IDs shared with the neighbor, ascending
+    std::vector<uint16_t> m_keys;
+    /// Path key ID, 0 if none was established
+    uint32_t m_pathKey;
+    /// Path key value, known to both ends and the proxy only
+    uint32_t m_pathKeyValue;
+    /// Intermediary that established the path key
+    Ipv4Address m_proxy;
+
+    Entry () : m_pathKey (0), m_pathKeyValue (0) {}
+    /// Check that some key, shared or path key, secures the link
+    bool IsSecured () const { return !m_keys.empty () || m_pathKey != 0; }
+  };
+
+  /// c-tor
+  KeyMap ();
+  /**
+   * Add key IDs shared with neighbor. Keys already known are ignored.
+   * \param neighbor neighbor address
+   * \param keys shared key IDs, ascending
+   */
+  void AddKeys (Ipv4Address neighbor, std::vector<uint16_t> const & keys);
+  /// Add a single shared key ID
+  void AddKey (Ipv4Address neighbor, uint16_t key);
+  /**
+   * Record a path key established through proxy. Replaces any previous path key.
+   * \param neighbor neighbor address
+   * \param proxy node that generated the path key
+   * \param pathKey path key ID, must not be 0
+   * \param pathKeyValue secret path key value
+   */
+  void SetPathKey (Ipv4Address neighbor, Ipv4Address proxy, uint32_t pathKey, uint32_t pathKeyValue);
+  /// Remove all keys of neighbor. \return true if the neighbor was known
+  bool DeleteKey (Ipv4Address neighbor);
+  /// Return entry of neighbor or 0 if it is unknown. Valid until the next insertion or removal.
+  Entry const * Lookup (Ipv4Address neighbor) const;
+  /// Check that a shared key or a path key secures the link to neighbor
+  bool HasKey (Ipv4Address neighbor) const;
+  /// Check that neighbor shares at least one key ID from the key pool
+  bool HasSharedKey (Ipv4Address neighbor) const;
+  /**
+   * Key ID to use on the link to neighbor: the first shared key ID if there
+   * is one, else the path key ID.
+   * \return 0 if the link is not secured
+   */
+  uint32_t GetKey (Ipv4Address neighbor) const;
+  /// Return number of known neighbors
+  uint32_t GetSize () const { return m_entries.GetSize (); }
+  /// Append every known neighbor address to neighbors
+  void GetNeighbors (std::vector<Ipv4Address> & neighbors) const;
+  /// Remove all entries
+  void Clear ();
+  /// Print all entries
+  void Print (std::ostream & os) const;
+
+private:
+  /// Return entry of neighbor, inserting an empty one if it is unknown
+  Entry & FindOrInsert (Ipv4Address neighbor);
+
+  /// Entries by neighbor address
+  FlatMap<uint32_t, Entry> m_entries;
+};
+
+}
+}
+#endif /* CPDA_KEY_MAP_H */
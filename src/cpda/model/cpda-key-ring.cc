@@ -0,0 +1,161 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "cpda-key-ring.h"
+#include "ns3/assert.h"
+#include <algorithm>
+
+namespace ns3
+{
+namespace cpda
+{
+
+KeyRing::KeyRing (uint16_t poolSize)
+  : m_poolSecret (0)
+{
+  SetPoolSize (poolSize);
+}
+
+void
+KeyRing::SetPoolSize (uint16_t poolSize)
+{
+  m_poolSize = poolSize;
+  // key IDs start from 1, bit 0 is never set
+  m_bits.assign ((uint32_t (poolSize) >> 6) + 1, 0);
+  m_keys.clear ();
+}
+
+void
+KeyRing::Clear ()
+{
+  std::fill (m_bits.begin (), m_bits.end (), 0);
+  m_keys.clear ();
+}
+
+bool
+KeyRing::Insert (uint16_t key)
+{
+  if (key == 0 || key > m_poolSize || Contains (key))
+    {
+      return false;
+    }
+  m_bits[key >> 6] |= uint64_t (1) << (key & 63);
+  m_keys.insert (std::lower_bound (m_keys.begin (), m_keys.end (), key), key);
+  return true;
+}
+
+void
+KeyRing::Generate (Ptr<UniformRandomVariable> rng, uint16_t ringSize)
+{
+  NS_ASSERT (ringSize <= m_poolSize);
+  Clear ();
+  m_keys.reserve (ringSize);
+  // draw without replacement; duplicates are simply redrawn
+  while (m_keys.size () < ringSize)
+    {
+      uint16_t key = rng->GetInteger (1, m_poolSize);
+      if (!Contains (key))
+        {
+          m_bits[key >> 6] |= uint64_t (1) << (key & 63);
+          m_keys.push_back (key);
+        }
+    }
+  std::sort (m_keys.begin (), m_keys.end ());
+}
+
+void
+KeyRing::Generate (uint32_t seed, uint16_t ringSize)
+{
+  NS_ASSERT (ringSize <= m_poolSize);
+  Clear ();
+  m_keys.reserve (ringSize);
+  // 32 bit LCG (Numerical Recipes constants); it only has to be identical on
+  // every node, not cryptographically strong
+  uint32_t state = seed;
+  while (m_keys.size () < ringSize)
+    {
+      state = 1664525 * state + 1013904223;
+      uint16_t key = 1 + uint16_t (((state >> 16) * uint32_t (m_poolSize)) >> 16);
+      if (!Contains (key))
+        {
+          m_bits[key >> 6] |= uint64_t (1) << (key & 63);
+          m_keys.push_back (key);
+        }
+    }
+  std::sort (m_keys.begin (), m_keys.end ());
+}
+
+uint32_t
+KeyRing::Intersect (const std::vector<uint16_t> & keys, std::vector<uint16_t> & shared) const
+{
+  uint32_t found = 0;
+  for (std::vector<uint16_t>::const_iterator i = keys.begin (); i != keys.end (); ++i)
+    {
+      if (Contains (*i))
+        {
+          shared.push_back (*i);
+          ++found;
+        }
+    }
+  return found;
+}
+
+uint32_t
+KeyRing::Intersect (const KeyRing & other, std::vector<uint16_t> & shared) const
+{
+  uint32_t found = 0;
+  uint32_t words = std::min (m_bits.size (), other.m_bits.size ());
+  for (uint32_t w = 0; w < words; ++w)
+    {
+      uint64_t common = m_bits[w] & other.m_bits[w];
+      for (uint16_t bit = 0; common != 0; ++bit, common >>= 1)
+        {
+          if (common & 1)
+            {
+              shared.push_back ((w << 6) + bit);
+              ++found;
+            }
+        }
+    }
+  return found;
+}
+
+uint16_t
+KeyRing::FindFirstShared (const std::vector<uint16_t> & keys) const
+{
+  for (std::vector<uint16_t>::const_iterator i = keys.begin (); i != keys.end (); ++i)
+    {
+      if (Contains (*i))
+        {
+          return *i;
+        }
+    }
+  return 0;
+}
+
+uint32_t
+KeyRing::GetKeyValue (uint16_t key) const
+{
+  if (!Contains (key))
+    {
+      return 0;
+    }
+  // stands for the key values loaded on the node before deployment
+  uint32_t value = uint32_t (Mix64 (m_poolSecret + uint64_t (key) * 0x9e3779b97f4a7c15ULL));
+  return (value == 0) ? 1 : value;
+}
+
+}
+}
@@ -0,0 +1,127 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CPDA_KEY_RING_H
+#define CPDA_KEY_RING_H
+
+#include "ns3/ptr.h"
+#include "ns3/random-variable-stream.h"
+#include <vector>
+#include <stdint.h>
+
+namespace ns3
+{
+namespace cpda
+{
+/**
+ * \ingroup cpda
+ *
+ * \brief CPDA key ring drawn from a fixed size key pool.
+ *
+ * Keys are identified by 1 ... poolSize, 0 means "no key". The ring keeps
+ * both a sorted key list (used for serialization) and a bitset over the whole
+ * pool, so membership tests are O(1) and the intersection of two rings costs
+ * one AND per 64 keys of the pool. The value of a key is derived from its ID
+ * and a secret of the whole pool, and is only handed out for keys of the ring.
+ */
+class KeyRing
+{
+public:
+  /// c-tor
+  KeyRing (uint16_t poolSize = 0);
+  /// Resize the key pool. Removes all keys from the ring.
+  void SetPoolSize (uint16_t poolSize);
+  /// Return key pool size
+  uint16_t GetPoolSize () const { return m_poolSize; }
+  /// Remove all keys from the ring
+  void Clear ();
+  /**
+   * Add key to the ring
+   * \param key key ID in [1, poolSize]
+   * \return false if the key is out of range or already in the ring
+   */
+  bool Insert (uint16_t key);
+  /// Check that key belongs to the ring
+  bool Contains (uint16_t key) const
+  {
+    return (key != 0 && key <= m_poolSize && (m_bits[key >> 6] & (uint64_t (1) << (key & 63))) != 0);
+  }
+  /// Return number of keys in the ring
+  uint32_t GetSize () const { return m_keys.size (); }
+  /// Return all keys of the ring in ascending order
+  const std::vector<uint16_t> & GetKeys () const { return m_keys; }
+  /**
+   * Fill the ring with ringSize distinct keys drawn uniformly from the pool
+   * \param rng random variable used to draw keys
+   * \param ringSize number of keys, must not exceed the pool size
+   */
+  void Generate (Ptr<UniformRandomVariable> rng, uint16_t ringSize);
+  /**
+   * Fill the ring with ringSize distinct keys drawn from a generator seeded
+   * with seed. The same seed, pool size and ring size always give the same
+   * ring, so a ring can be announced by its seed alone.
+   * \param seed generator seed
+   * \param ringSize number of keys, must not exceed the pool size
+   */
+  void Generate (uint32_t seed, uint16_t ringSize);
+  /**
+   * Find all keys of the ring that also appear in keys. Costs O(keys.size ()).
+   * \param keys key IDs announced by a neighbor, in any order
+   * \param shared shared keys are appended here
+   * \return number of shared keys found
+   */
+  uint32_t Intersect (const std::vector<uint16_t> & keys, std::vector<uint16_t> & shared) const;
+  /**
+   * Find all keys shared with another ring built over the same pool.
+   * Costs O(poolSize / 64).
+   * \param other the other ring
+   * \param shared shared keys are appended here in ascending order
+   * \return number of shared keys found
+   */
+  uint32_t Intersect (const KeyRing & other, std::vector<uint16_t> & shared) const;
+  /// Return the first key of keys that belongs to the ring, 0 if there is none
+  uint16_t FindFirstShared (const std::vector<uint16_t> & keys) const;
+  /// Set the secret every key value of the pool is derived from
+  void SetPoolSecret (uint64_t secret) { m_poolSecret = secret; }
+  /**
+   * Secret value of a pool key. Only nodes whose ring holds the key know it.
+   * \param key key ID
+   * \return the key value, never 0, or 0 if the ring doesn't hold key
+   */
+  uint32_t GetKeyValue (uint16_t key) const;
+
+private:
+  /// Number of keys in the pool
+  uint16_t m_poolSize;
+  /// One bit per pool key, bit k is set iff key k is in the ring
+  std::vector<uint64_t> m_bits;
+  /// Keys of the ring in ascending order
+  std::vector<uint16_t> m_keys;
+  /// Secret the key values are derived from, the same for the whole pool
+  uint64_t m_poolSecret;
+};
+
+/// splitmix64 finalizer: spreads every bit of z over the whole result
+static inline uint64_t
+Mix64 (uint64_t z)
+{
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+}
+}
+#endif /* CPDA_KEY_RING_H */
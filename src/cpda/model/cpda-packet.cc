@@ -0,0 +1,1033 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "cpda-packet.h"
+#include "cpda-key-ring.h"
+#include "ns3/address-utils.h"
+#include "ns3/packet.h"
+#include <algorithm>
+
+namespace ns3 {
+namespace cpda {
+
+NS_OBJECT_ENSURE_REGISTERED (TypeHeader);
+
+TypeHeader::TypeHeader (MessageType t)
+  : m_type (t),
+    m_valid (true)
+{
+}
+
+TypeId
+TypeHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::cpda::TypeHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Cpda")
+    .AddConstructor<TypeHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+TypeHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+TypeHeader::GetSerializedSize () const
+{
+  return 1;
+}
+
+void
+TypeHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteU8 ((uint8_t) m_type);
+}
+
+uint32_t
+TypeHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  uint8_t type = i.ReadU8 ();
+  m_valid = true;
+  switch (type)
+    {
+    case CPDATYPE_KEY:
+    case CPDATYPE_QUERY:
+    case CPDATYPE_JOIN:
+    case CPDATYPE_PATH_KEY_REQ:
+    case CPDATYPE_PATH_KEY:
+    case CPDATYPE_ROSTER:
+    case CPDATYPE_SHARE:
+    case CPDATYPE_SHARE_RELAY:
+    case CPDATYPE_ASSEMBLED:
+    case CPDATYPE_RESULT:
+      {
+        m_type = (MessageType) type;
+        break;
+      }
+    default:
+      m_valid = false;
+    }
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+TypeHeader::Print (std::ostream &os) const
+{
+  switch (m_type)
+    {
+    case CPDATYPE_KEY:
+      {
+        os << "CPDA_KEY";
+        break;
+      }
+    case CPDATYPE_QUERY:
+      {
+        os << "CPDA_QUERY";
+        break;
+      }
+    case CPDATYPE_JOIN:
+      {
+        os << "CPDA_JOIN";
+        break;
+      }
+    case CPDATYPE_PATH_KEY_REQ:
+      {
+        os << "CPDA_PATH_KEY_REQ";
+        break;
+      }
+    case CPDATYPE_PATH_KEY:
+      {
+        os << "CPDA_PATH_KEY";
+        break;
+      }
+    case CPDATYPE_ROSTER:
+      {
+        os << "CPDA_ROSTER";
+        break;
+      }
+    case CPDATYPE_SHARE:
+      {
+        os << "CPDA_SHARE";
+        break;
+      }
+    case CPDATYPE_SHARE_RELAY:
+      {
+        os << "CPDA_SHARE_RELAY";
+        break;
+      }
+    case CPDATYPE_ASSEMBLED:
+      {
+        os << "CPDA_ASSEMBLED";
+        break;
+      }
+    case CPDATYPE_RESULT:
+      {
+        os << "CPDA_RESULT";
+        break;
+      }
+    default:
+      os << "UNKNOWN_TYPE";
+    }
+}
+
+bool
+TypeHeader::operator== (TypeHeader const & o) const
+{
+  return (m_type == o.m_type && m_valid == o.m_valid);
+}
+
+std::ostream &
+operator<< (std::ostream & os, TypeHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// KEY
+//-----------------------------------------------------------------------------
+KeyHeader::KeyHeader (Ipv4Address origin)
+  : m_origin (origin),
+    m_keyEncoding (KEY_ENCODING_PLAIN),
+    m_keyPoolSize (0),
+    m_keySeed (0),
+    m_hasHeard (false),
+    m_valid (true)
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (KeyHeader);
+
+/// Encoding byte flag of a KeyHeader carrying a heard list
+static const uint8_t KEY_FLAG_HEARD = 0x80;
+
+TypeId
+KeyHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::cpda::KeyHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Cpda")
+    .AddConstructor<KeyHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+KeyHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+/// Number of bytes needed to write value as a 7 bit varint
+static uint32_t
+GetVarintSize (uint16_t value)
+{
+  uint32_t size = 1;
+  while (value >= 0x80)
+    {
+      value >>= 7;
+      size++;
+    }
+  return size;
+}
+
+uint32_t
+KeyHeader::GetSerializedSize () const
+{
+  // origin, key encoding and key count
+  uint32_t size = 7;
+  switch (m_keyEncoding)
+    {
+    case KEY_ENCODING_PLAIN:
+      {
+        size += 2 * m_key.size ();
+        break;
+      }
+    case KEY_ENCODING_DELTA:
+      {
+        uint16_t previous = 0;
+        for (std::vector<uint16_t>::const_iterator k = m_key.begin (); k != m_key.end (); ++k)
+          {
+            size += GetVarintSize (*k - previous);
+            previous = *k;
+          }
+        break;
+      }
+    case KEY_ENCODING_SEED:
+      {
+        size += 6;
+        break;
+      }
+    }
+  if (m_hasHeard)
+    {
+      size += 2 + 4 * m_heard.size ();
+    }
+  return size;
+}
+
+void
+KeyHeader::Serialize (Buffer::Iterator i) const
+{
+  WriteTo (i, m_origin);
+  i.WriteU8 ((uint8_t) m_keyEncoding | (m_hasHeard ? KEY_FLAG_HEARD : 0));
+  i.WriteHtonU16 (m_key.size ());
+  switch (m_keyEncoding)
+    {
+    case KEY_ENCODING_PLAIN:
+      {
+        for (std::vector<uint16_t>::const_iterator k = m_key.begin (); k != m_key.end (); ++k)
+          {
+            i.WriteHtonU16 (*k);
+          }
+        break;
+      }
+    case KEY_ENCODING_DELTA:
+      {
+        uint16_t previous = 0;
+        for (std::vector<uint16_t>::const_iterator k = m_key.begin (); k != m_key.end (); ++k)
+          {
+            NS_ASSERT (*k >= previous);
+            uint16_t delta = *k - previous;
+            while (delta >= 0x80)
+              {
+                i.WriteU8 ((delta & 0x7f) | 0x80);
+                delta >>= 7;
+              }
+            i.WriteU8 (delta);
+            previous = *k;
+          }
+        break;
+      }
+    case KEY_ENCODING_SEED:
+      {
+        i.WriteHtonU16 (m_keyPoolSize);
+        i.WriteHtonU32 (m_keySeed);
+        break;
+      }
+    }
+  if (m_hasHeard)
+    {
+      i.WriteHtonU16 (m_heard.size ());
+      for (std::vector<Ipv4Address>::const_iterator h = m_heard.begin (); h != m_heard.end (); ++h)
+        {
+          WriteTo (i, *h);
+        }
+    }
+}
+
+uint32_t
+KeyHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+
+  m_key.clear ();
+  m_heard.clear ();
+  m_valid = true;
+  if (i.GetRemainingSize () < 7)
+    {
+      return Invalidate (i, start);
+    }
+  ReadFrom (i, m_origin);
+  uint8_t encoding = i.ReadU8 ();
+  m_keyEncoding = (KeyEncoding) (encoding & ~KEY_FLAG_HEARD);
+  m_hasHeard = (encoding & KEY_FLAG_HEARD) != 0;
+  uint16_t count = i.ReadNtohU16 ();
+  switch (m_keyEncoding)
+    {
+    case KEY_ENCODING_PLAIN:
+      {
+        if (count > i.GetRemainingSize () / 2)
+          {
+            return Invalidate (i, start);
+          }
+        m_key.reserve (count);
+        for (uint16_t k = 0; k < count; k++)
+          {
+            m_key.push_back (i.ReadNtohU16 ());
+          }
+        break;
+      }
+    case KEY_ENCODING_DELTA:
+      {
+        // every delta takes at least one byte
+        if (count > i.GetRemainingSize ())
+          {
+            return Invalidate (i, start);
+          }
+        m_key.reserve (count);
+        uint16_t previous = 0;
+        for (uint16_t k = 0; k < count; k++)
+          {
+            // a 16 bit delta takes at most 3 bytes
+            uint32_t delta = 0;
+            uint8_t byte = 0x80;
+            uint8_t shift = 0;
+            while (byte & 0x80)
+              {
+                if (shift > 14 || i.GetRemainingSize () == 0)
+                  {
+                    return Invalidate (i, start);
+                  }
+                byte = i.ReadU8 ();
+                delta |= uint32_t (byte & 0x7f) << shift;
+                shift += 7;
+              }
+            if (delta > 0xffffU - previous)
+              {
+                return Invalidate (i, start);
+              }
+            previous += delta;
+            m_key.push_back (previous);
+          }
+        break;
+      }
+    case KEY_ENCODING_SEED:
+      {
+        if (i.GetRemainingSize () < 6)
+          {
+            return Invalidate (i, start);
+          }
+        m_keyPoolSize = i.ReadNtohU16 ();
+        m_keySeed = i.ReadNtohU32 ();
+        // the sender drew its ring from a pool at least as large
+        if (m_keyPoolSize == 0 || m_keyPoolSize < count)
+          {
+            return Invalidate (i, start);
+          }
+        // regenerate the sender's ring from its seed
+        KeyRing ring (m_keyPoolSize);
+        ring.Generate (m_keySeed, count);
+        m_key = ring.GetKeys ();
+        break;
+      }
+    default:
+      {
+        return Invalidate (i, start);
+      }
+    }
+  if (m_hasHeard)
+    {
+      if (i.GetRemainingSize () < 2)
+        {
+          return Invalidate (i, start);
+        }
+      uint16_t heard = i.ReadNtohU16 ();
+      if (heard > i.GetRemainingSize () / 4)
+        {
+          return Invalidate (i, start);
+        }
+      m_heard.resize (heard);
+      for (uint16_t h = 0; h < heard; h++)
+        {
+          ReadFrom (i, m_heard[h]);
+        }
+    }
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+uint32_t
+KeyHeader::Invalidate (Buffer::Iterator i, Buffer::Iterator start)
+{
+  m_valid = false;
+  m_key.clear ();
+  m_heard.clear ();
+  return i.GetDistanceFrom (start);
+}
+
+void
+KeyHeader::SetKey (std::vector<uint16_t> const & key)
+{
+  m_key = key;
+  if (m_keyEncoding == KEY_ENCODING_DELTA)
+    {
+      std::sort (m_key.begin (), m_key.end ());
+    }
+}
+
+void
+KeyHeader::SetKeyEncoding (KeyEncoding encoding)
+{
+  m_keyEncoding = encoding;
+  if (m_keyEncoding == KEY_ENCODING_DELTA)
+    {
+      std::sort (m_key.begin (), m_key.end ());
+    }
+}
+
+void
+KeyHeader::SetKeySeed (uint32_t seed, uint16_t poolSize)
+{
+  m_keyEncoding = KEY_ENCODING_SEED;
+  m_keySeed = seed;
+  m_keyPoolSize = poolSize;
+}
+
+void
+KeyHeader::SetHeard (std::vector<Ipv4Address> const & heard)
+{
+  m_hasHeard = true;
+  m_heard = heard;
+}
+
+void
+KeyHeader::Print (std::ostream &os) const
+{
+  os << "origin: ipv4 " << m_origin << " keys " << m_key.size ()
+     << " key encoding " << (uint16_t) m_keyEncoding;
+  if (m_hasHeard)
+    {
+      os << " heard " << m_heard.size ();
+    }
+}
+
+bool
+KeyHeader::operator== (KeyHeader const & o) const
+{
+  return (m_valid == o.m_valid && m_origin == o.m_origin
+          && m_keyEncoding == o.m_keyEncoding && m_key == o.m_key
+          && m_hasHeard == o.m_hasHeard && m_heard == o.m_heard);
+}
+
+std::ostream &
+operator<< (std::ostream & os, KeyHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// QUERY
+//-----------------------------------------------------------------------------
+QueryHeader::QueryHeader (Ipv4Address origin, uint32_t round)
+  : m_origin (origin),
+    m_round (round)
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (QueryHeader);
+
+TypeId
+QueryHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::cpda::QueryHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Cpda")
+    .AddConstructor<QueryHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+QueryHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+QueryHeader::GetSerializedSize () const
+{
+  return 8;
+}
+
+void
+QueryHeader::Serialize (Buffer::Iterator i) const
+{
+  WriteTo (i, m_origin);
+  i.WriteHtonU32 (m_round);
+}
+
+uint32_t
+QueryHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+
+  ReadFrom (i, m_origin);
+  m_round = i.ReadNtohU32 ();
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+QueryHeader::Print (std::ostream &os) const
+{
+  os << "origin: ipv4 " << m_origin << " round " << m_round;
+}
+
+bool
+QueryHeader::operator== (QueryHeader const & o) const
+{
+  return (m_origin == o.m_origin && m_round == o.m_round);
+}
+
+std::ostream &
+operator<< (std::ostream & os, QueryHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// JOIN
+//-----------------------------------------------------------------------------
+JoinHeader::JoinHeader (Ipv4Address leader, Ipv4Address origin, uint32_t round)
+  : m_flags (0),
+    m_leader (leader),
+    m_origin (origin),
+    m_round (round)
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (JoinHeader);
+
+TypeId
+JoinHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::cpda::JoinHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Cpda")
+    .AddConstructor<JoinHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+JoinHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+JoinHeader::GetSerializedSize () const
+{
+  return 13;
+}
+
+void
+JoinHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteU8 (m_flags);
+  WriteTo (i, m_leader);
+  WriteTo (i, m_origin);
+  i.WriteHtonU32 (m_round);
+}
+
+uint32_t
+JoinHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+
+  m_flags = i.ReadU8 ();
+  ReadFrom (i, m_leader);
+  ReadFrom (i, m_origin);
+  m_round = i.ReadNtohU32 ();
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+JoinHeader::Print (std::ostream &os) const
+{
+  os << "leader: ipv4 " << m_leader << " origin ipv4 " << m_origin << " round " << m_round
+     << " cluster leader flag " << GetClusterLeader ();
+}
+
+void
+JoinHeader::SetClusterLeader (bool f)
+{
+  if (f)
+    {
+      m_flags |= (1 << 5);
+    }
+  else
+    {
+      m_flags &= ~(1 << 5);
+    }
+}
+
+bool
+JoinHeader::GetClusterLeader () const
+{
+  return (m_flags & (1 << 5));
+}
+
+bool
+JoinHeader::operator== (JoinHeader const & o) const
+{
+  return (m_flags == o.m_flags && m_leader == o.m_leader && m_origin == o.m_origin
+          && m_round == o.m_round);
+}
+
+std::ostream &
+operator<< (std::ostream & os, JoinHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// PATH KEY
+//-----------------------------------------------------------------------------
+PathKeyHeader::PathKeyHeader (Ipv4Address origin, Ipv4Address target,
+                              Ipv4Address proxy, uint32_t pathKey,
+                              uint16_t keyId, uint32_t pathKeyValue)
+  : m_origin (origin),
+    m_target (target),
+    m_proxy (proxy),
+    m_pathKey (pathKey),
+    m_keyId (keyId),
+    m_pathKeyValue (pathKeyValue)
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (PathKeyHeader);
+
+TypeId
+PathKeyHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::cpda::PathKeyHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Cpda")
+    .AddConstructor<PathKeyHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+PathKeyHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+PathKeyHeader::GetSerializedSize () const
+{
+  return 22;
+}
+
+void
+PathKeyHeader::Serialize (Buffer::Iterator i) const
+{
+  WriteTo (i, m_origin);
+  WriteTo (i, m_target);
+  WriteTo (i, m_proxy);
+  i.WriteHtonU32 (m_pathKey);
+  i.WriteHtonU16 (m_keyId);
+  i.WriteHtonU32 (m_pathKeyValue);
+}
+
+uint32_t
+PathKeyHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+
+  ReadFrom (i, m_origin);
+  ReadFrom (i, m_target);
+  ReadFrom (i, m_proxy);
+  m_pathKey = i.ReadNtohU32 ();
+  m_keyId = i.ReadNtohU16 ();
+  m_pathKeyValue = i.ReadNtohU32 ();
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+PathKeyHeader::Print (std::ostream &os) const
+{
+  os << "origin: ipv4 " << m_origin << " target ipv4 " << m_target
+     << " proxy ipv4 " << m_proxy << " path key " << m_pathKey
+     << " key ID " << m_keyId;
+}
+
+bool
+PathKeyHeader::operator== (PathKeyHeader const & o) const
+{
+  return (m_origin == o.m_origin && m_target == o.m_target
+          && m_proxy == o.m_proxy && m_pathKey == o.m_pathKey
+          && m_keyId == o.m_keyId && m_pathKeyValue == o.m_pathKeyValue);
+}
+
+std::ostream &
+operator<< (std::ostream & os, PathKeyHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// ROSTER
+//-----------------------------------------------------------------------------
+RosterHeader::RosterHeader (uint32_t round, Ipv4Address leader)
+  : m_round (round),
+    m_leader (leader)
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (RosterHeader);
+
+TypeId
+RosterHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::cpda::RosterHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Cpda")
+    .AddConstructor<RosterHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+RosterHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+RosterHeader::GetSerializedSize () const
+{
+  return 10 + 4 * m_members.size ();
+}
+
+void
+RosterHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteHtonU32 (m_round);
+  WriteTo (i, m_leader);
+  i.WriteHtonU16 (m_members.size ());
+  for (std::vector<Ipv4Address>::const_iterator j = m_members.begin (); j != m_members.end (); ++j)
+    {
+      WriteTo (i, *j);
+    }
+}
+
+uint32_t
+RosterHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+
+  m_round = i.ReadNtohU32 ();
+  ReadFrom (i, m_leader);
+  uint16_t count = i.ReadNtohU16 ();
+  m_members.resize (count);
+  for (uint16_t k = 0; k < count; ++k)
+    {
+      ReadFrom (i, m_members[k]);
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+RosterHeader::Print (std::ostream &os) const
+{
+  os << "round " << m_round << " leader ipv4 " << m_leader << " members " << m_members.size ();
+}
+
+bool
+RosterHeader::operator== (RosterHeader const & o) const
+{
+  return (m_round == o.m_round && m_leader == o.m_leader && m_members == o.m_members);
+}
+
+std::ostream &
+operator<< (std::ostream & os, RosterHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// SHARE
+//-----------------------------------------------------------------------------
+ShareHeader::ShareHeader (uint32_t round, uint8_t batchSize)
+  : m_round (round),
+    m_batchSize (batchSize)
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (ShareHeader);
+
+TypeId
+ShareHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::cpda::ShareHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Cpda")
+    .AddConstructor<ShareHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+ShareHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+ShareHeader::GetSerializedSize () const
+{
+  return 7 + m_shares.size () * GetShareSize (m_batchSize);
+}
+
+void
+ShareHeader::AddShare (Share const & share)
+{
+  NS_ASSERT (share.m_values.size () == m_batchSize);
+  m_shares.push_back (share);
+}
+
+void
+ShareHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteHtonU32 (m_round);
+  i.WriteU8 (m_batchSize);
+  i.WriteHtonU16 (m_shares.size ());
+  for (std::vector<Share>::const_iterator j = m_shares.begin (); j != m_shares.end (); ++j)
+    {
+      WriteTo (i, j->m_origin);
+      WriteTo (i, j->m_dst);
+      i.WriteHtonU32 (j->m_keyId);
+      for (uint8_t b = 0; b < m_batchSize; ++b)
+        {
+          i.WriteHtonU32 (j->m_values[b]);
+        }
+    }
+}
+
+uint32_t
+ShareHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+
+  m_round = i.ReadNtohU32 ();
+  m_batchSize = i.ReadU8 ();
+  uint16_t count = i.ReadNtohU16 ();
+  m_shares.resize (count);
+  for (uint16_t k = 0; k < count; ++k)
+    {
+      Share & share = m_shares[k];
+      ReadFrom (i, share.m_origin);
+      ReadFrom (i, share.m_dst);
+      share.m_keyId = i.ReadNtohU32 ();
+      share.m_values.resize (m_batchSize);
+      for (uint8_t b = 0; b < m_batchSize; ++b)
+        {
+          share.m_values[b] = i.ReadNtohU32 ();
+        }
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+ShareHeader::Print (std::ostream &os) const
+{
+  os << "round " << m_round << " batch size " << (uint32_t) m_batchSize << " shares " << m_shares.size ();
+}
+
+bool
+ShareHeader::operator== (ShareHeader const & o) const
+{
+  return (m_round == o.m_round && m_batchSize == o.m_batchSize && m_shares == o.m_shares);
+}
+
+std::ostream &
+operator<< (std::ostream & os, ShareHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// SUM
+//-----------------------------------------------------------------------------
+SumHeader::SumHeader (Ipv4Address dst, uint32_t round)
+  : m_dst (dst),
+    m_round (round),
+    m_contributors (0),
+    m_messages (0)
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (SumHeader);
+
+TypeId
+SumHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::cpda::SumHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Cpda")
+    .AddConstructor<SumHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+SumHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+SumHeader::GetSerializedSize () const
+{
+  return 15 + 4 * m_values.size ();
+}
+
+void
+SumHeader::SetValues (std::vector<uint32_t> const & values)
+{
+  NS_ASSERT (values.size () <= 255);
+  m_values = values;
+}
+
+void
+SumHeader::Serialize (Buffer::Iterator i) const
+{
+  WriteTo (i, m_dst);
+  i.WriteHtonU32 (m_round);
+  i.WriteHtonU16 (m_contributors);
+  i.WriteHtonU32 (m_messages);
+  i.WriteU8 (m_values.size ());
+  for (std::vector<uint32_t>::const_iterator j = m_values.begin (); j != m_values.end (); ++j)
+    {
+      i.WriteHtonU32 (*j);
+    }
+}
+
+uint32_t
+SumHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+
+  ReadFrom (i, m_dst);
+  m_round = i.ReadNtohU32 ();
+  m_contributors = i.ReadNtohU16 ();
+  m_messages = i.ReadNtohU32 ();
+  uint8_t count = i.ReadU8 ();
+  m_values.resize (count);
+  for (uint8_t b = 0; b < count; ++b)
+    {
+      m_values[b] = i.ReadNtohU32 ();
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+SumHeader::Print (std::ostream &os) const
+{
+  os << "destination: ipv4 " << m_dst << " round " << m_round << " contributors " << m_contributors
+     << " messages " << m_messages << " values " << m_values.size ();
+}
+
+bool
+SumHeader::operator== (SumHeader const & o) const
+{
+  return (m_dst == o.m_dst && m_round == o.m_round && m_contributors == o.m_contributors
+          && m_messages == o.m_messages && m_values == o.m_values);
+}
+
+std::ostream &
+operator<< (std::ostream & os, SumHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+}
+}
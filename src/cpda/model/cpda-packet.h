@@ -0,0 +1,443 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CPDA_PACKET_H
+#define CPDA_PACKET_H
+
+#include <iostream>
+#include <vector>
+#include "ns3/header.h"
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+namespace cpda {
+
+/// CPDA message types, the first byte of every CPDA packet
+enum MessageType
+{
+  CPDATYPE_KEY = 1,          //!< key ring announcement
+  CPDATYPE_QUERY = 2,        //!< aggregation query, builds the TAG tree
+  CPDATYPE_JOIN = 3,         //!< answer to a query
+  CPDATYPE_PATH_KEY_REQ = 4, //!< path key request
+  CPDATYPE_PATH_KEY = 5,     //!< path key from a proxy
+  CPDATYPE_ROSTER = 6,       //!< final cluster membership
+  CPDATYPE_SHARE = 7,        //!< shares of a member, to the leader
+  CPDATYPE_SHARE_RELAY = 8,  //!< all shares of a cluster, from the leader
+  CPDATYPE_ASSEMBLED = 9,    //!< assembled share sum of a member
+  CPDATYPE_RESULT = 10,      //!< subtree sum, to the TAG tree parent
+};
+
+/**
+ * \ingroup cpda
+ * \brief CPDA types
+ */
+class TypeHeader : public Header
+{
+public:
+  /// c-tor
+  TypeHeader (MessageType t = CPDATYPE_KEY);
+
+  // Header serialization/deserialization
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  /// Return type
+  MessageType Get () const { return m_type; }
+  /// Check that type if valid
+  bool IsValid () const { return m_valid; }
+  bool operator== (TypeHeader const & o) const;
+private:
+  MessageType m_type;
+  bool m_valid;
+};
+
+std::ostream & operator<< (std::ostream & os, TypeHeader const & h);
+
+/**
+ * \ingroup cpda
+ * \brief How the key ring is carried in a CPDA_KEY message
+ */
+enum KeyEncoding
+{
+  KEY_ENCODING_PLAIN = 0, //!< key count followed by 16 bit key IDs
+  KEY_ENCODING_DELTA = 1, //!< key count followed by varint gaps between ascending key IDs
+  KEY_ENCODING_SEED = 2,  //!< key count, pool size and the seed the ring was drawn from
+};
+
+/**
+ * \ingroup cpda
+ * \brief Key ring announcement, broadcast by every node.
+ *
+ * \verbatim
+   Origin (4 bytes) | Flags and encoding (1 byte) | Key count (2 bytes) | ring, depending on the encoding
+   [ | Heard count (2 bytes) | Heard (4 bytes each) ]
+   \endverbatim
+ * PLAIN sends every key ID, DELTA sends the gaps between the sorted key IDs as
+ * 7 bit varints (about one byte per key for 200 keys out of 10000) and SEED only
+ * sends the pool size and seed, from which the receiver regenerates the ring
+ * with KeyRing::Generate.
+ *
+ * Repeated announcements also list the neighbors whose key rings the origin
+ * has heard, flagged by the high bit of the encoding byte, so that a neighbor
+ * missing from the list knows its own announcement was lost.
+ */
+class KeyHeader : public Header
+{
+public:
+  /// c-tor
+  KeyHeader (Ipv4Address origin = Ipv4Address ());
+
+  // Header serialization/deserialization
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  // Fields
+  void SetOrigin (Ipv4Address a) { m_origin = a; }
+  Ipv4Address GetOrigin () const { return m_origin; }
+  void SetKey (std::vector<uint16_t> const & key);
+  std::vector<uint16_t> const & GetKey () const { return m_key; }
+  void SetKeyEncoding (KeyEncoding encoding);
+  KeyEncoding GetKeyEncoding () const { return m_keyEncoding; }
+  /// Send only the seed; key must hold the ring generated from this seed and pool size
+  void SetKeySeed (uint32_t seed, uint16_t poolSize);
+  uint32_t GetKeySeed () const { return m_keySeed; }
+  uint16_t GetKeyPoolSize () const { return m_keyPoolSize; }
+  /// Attach the sorted list of neighbors whose key rings we heard
+  void SetHeard (std::vector<Ipv4Address> const & heard);
+  std::vector<Ipv4Address> const & GetHeard () const { return m_heard; }
+  /// True if the announcement carries a heard list, possibly empty
+  bool HasHeard () const { return m_hasHeard; }
+  /// Check that the deserialized key ring was well formed
+  bool IsValid () const { return m_valid; }
+
+  bool operator== (KeyHeader const & o) const;
+private:
+  /**
+   * Drop a malformed key ring and the rest of the header.
+   * \param i Where the deserialization stopped
+   * \param start Start of the header
+   * \returns The number of bytes read
+   */
+  uint32_t Invalidate (Buffer::Iterator i, Buffer::Iterator start);
+
+  Ipv4Address m_origin;        ///< Node owning the key ring
+  std::vector<uint16_t> m_key; ///< Key IDs of the ring
+  KeyEncoding m_keyEncoding;   ///< Key ring wire encoding
+  uint16_t m_keyPoolSize;      ///< Key pool size, SEED encoding only
+  uint32_t m_keySeed;          ///< Seed of the key ring, SEED encoding only
+  bool m_hasHeard;             ///< Heard list present
+  std::vector<Ipv4Address> m_heard; ///< Neighbors whose key rings the origin heard
+  bool m_valid;                ///< Key ring well formed
+};
+
+std::ostream & operator<< (std::ostream & os, KeyHeader const &);
+
+/**
+ * \ingroup cpda
+ * \brief Aggregation query. Started by the root and forwarded by every
+ * cluster leader, it builds the TAG tree and starts cluster formation.
+ *
+ * \verbatim
+   Origin (4 bytes) | Round (4 bytes)
+   \endverbatim
+ */
+class QueryHeader : public Header
+{
+public:
+  /// c-tor
+  QueryHeader (Ipv4Address origin = Ipv4Address (), uint32_t round = 0);
+
+  // Header serialization/deserialization
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  // Fields
+  void SetOrigin (Ipv4Address a) { m_origin = a; }
+  Ipv4Address GetOrigin () const { return m_origin; }
+  void SetRound (uint32_t round) { m_round = round; }
+  uint32_t GetRound () const { return m_round; }
+
+  bool operator== (QueryHeader const & o) const;
+private:
+  Ipv4Address m_origin; ///< Leader that sent or forwarded the query
+  uint32_t m_round;     ///< Aggregation round
+};
+
+std::ostream & operator<< (std::ostream & os, QueryHeader const &);
+
+/**
+ * \ingroup cpda
+ * \brief Answer to a query. Broadcast, so that the other members of the
+ * cluster can snoop on it.
+ *
+ * \verbatim
+   Flags (1 byte) | Leader (4 bytes) | Origin (4 bytes) | Round (4 bytes)
+   \endverbatim
+ */
+class JoinHeader : public Header
+{
+public:
+  /// c-tor
+  JoinHeader (Ipv4Address leader = Ipv4Address (), Ipv4Address origin = Ipv4Address (), uint32_t round = 0);
+
+  // Header serialization/deserialization
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  // Fields
+  void SetLeader (Ipv4Address a) { m_leader = a; }
+  Ipv4Address GetLeader () const { return m_leader; }
+  void SetOrigin (Ipv4Address a) { m_origin = a; }
+  Ipv4Address GetOrigin () const { return m_origin; }
+  void SetRound (uint32_t round) { m_round = round; }
+  uint32_t GetRound () const { return m_round; }
+
+  /// Set when the sender leads a cluster of its own and joins the leader as its TAG tree child
+  void SetClusterLeader (bool f);
+  bool GetClusterLeader () const;
+
+  bool operator== (JoinHeader const & o) const;
+private:
+  uint8_t m_flags;       ///< L - cluster leader flag
+  Ipv4Address m_leader;  ///< Leader whose query is answered
+  Ipv4Address m_origin;  ///< Joining node
+  uint32_t m_round;      ///< Aggregation round
+};
+
+std::ostream & operator<< (std::ostream & os, JoinHeader const &);
+
+/**
+ * \ingroup cpda
+ * \brief Path key establishment between two neighbors that share no key.
+ *
+ * The origin broadcasts a CPDATYPE_PATH_KEY_REQ naming the target. A common
+ * neighbor (proxy) sharing keys with both ends answers each of them with a
+ * unicast CPDATYPE_PATH_KEY carrying a fresh path key: its ID in the clear and
+ * its value encrypted under a pool key the proxy shares with that end.
+ * \verbatim
+   Origin (4 bytes) | Target (4 bytes) | Proxy (4 bytes) | Path key (4 bytes)
+   Key ID (2 bytes) | Encrypted path key value (4 bytes)
+   \endverbatim
+ */
+class PathKeyHeader : public Header
+{
+public:
+  /// c-tor
+  PathKeyHeader (Ipv4Address origin = Ipv4Address (), Ipv4Address target = Ipv4Address (),
+                 Ipv4Address proxy = Ipv4Address (), uint32_t pathKey = 0,
+                 uint16_t keyId = 0, uint32_t pathKeyValue = 0);
+
+  // Header serialization/deserialization
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  // Fields
+  void SetOrigin (Ipv4Address a) { m_origin = a; }
+  Ipv4Address GetOrigin () const { return m_origin; }
+  void SetTarget (Ipv4Address a) { m_target = a; }
+  Ipv4Address GetTarget () const { return m_target; }
+  void SetProxy (Ipv4Address a) { m_proxy = a; }
+  Ipv4Address GetProxy () const { return m_proxy; }
+  void SetPathKey (uint32_t key) { m_pathKey = key; }
+  uint32_t GetPathKey () const { return m_pathKey; }
+  void SetKeyId (uint16_t id) { m_keyId = id; }
+  uint16_t GetKeyId () const { return m_keyId; }
+  void SetPathKeyValue (uint32_t value) { m_pathKeyValue = value; }
+  uint32_t GetPathKeyValue () const { return m_pathKeyValue; }
+
+  bool operator== (PathKeyHeader const & o) const;
+private:
+  Ipv4Address   m_origin;           ///< Node that requested the path key
+  Ipv4Address   m_target;           ///< Neighbor the origin shares no key with
+  Ipv4Address   m_proxy;            ///< Node that generated the path key
+  uint32_t      m_pathKey;          ///< Path key ID, 0 in requests
+  uint16_t      m_keyId;            ///< Pool key shared by proxy and receiver
+  uint32_t      m_pathKeyValue;     ///< Path key value, encrypted under m_keyId
+};
+
+std::ostream & operator<< (std::ostream & os, PathKeyHeader const &);
+
+/**
+ * \ingroup cpda
+ * \brief Cluster membership announced by the leader once the join timeout
+ * expired. Every member derives its share evaluation point from its position
+ * in the (sorted) member list, so all members must use this list.
+ *
+ * \verbatim
+   Round (4 bytes) | Leader (4 bytes) | Member count (2 bytes) | Members (4 bytes each)
+   \endverbatim
+ */
+class RosterHeader : public Header
+{
+public:
+  /// c-tor
+  RosterHeader (uint32_t round = 0, Ipv4Address leader = Ipv4Address ());
+
+  // Header serialization/deserialization
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  // Fields
+  void SetRound (uint32_t round) { m_round = round; }
+  uint32_t GetRound () const { return m_round; }
+  void SetLeader (Ipv4Address a) { m_leader = a; }
+  Ipv4Address GetLeader () const { return m_leader; }
+  void SetMembers (std::vector<Ipv4Address> const & members) { m_members = members; }
+  std::vector<Ipv4Address> const & GetMembers () const { return m_members; }
+
+  bool operator== (RosterHeader const & o) const;
+private:
+  uint32_t      m_round;            ///< Aggregation round
+  Ipv4Address   m_leader;           ///< Cluster leader
+  std::vector<Ipv4Address> m_members; ///< All cluster members including the leader, sorted
+};
+
+std::ostream & operator<< (std::ostream & os, RosterHeader const &);
+
+/// One encrypted batch of shares from origin to dst
+struct Share
+{
+  Ipv4Address m_origin;           ///< Member that generated the shares
+  Ipv4Address m_dst;              ///< Member the shares are meant for
+  uint32_t m_keyId;               ///< Link key the shares are encrypted with, 0 for none
+  std::vector<uint32_t> m_values; ///< One share per aggregated value of the batch
+
+  bool operator== (Share const & o) const
+  {
+    return m_origin == o.m_origin && m_dst == o.m_dst && m_keyId == o.m_keyId && m_values == o.m_values;
+  }
+};
+
+/**
+ * \ingroup cpda
+ * \brief Encrypted shares. A member sends all of its shares in a single
+ * CPDATYPE_SHARE to the leader, which is everyone's neighbor, and the leader
+ * relays all of them in a single CPDATYPE_SHARE_RELAY broadcast.
+ *
+ * \verbatim
+   Round (4 bytes) | Batch size (1 byte) | Share count (2 bytes) |
+   Shares: Origin (4 bytes) | Dst (4 bytes) | Key ID (4 bytes) | Values (4 bytes * batch size)
+   \endverbatim
+ */
+class ShareHeader : public Header
+{
+public:
+  /// c-tor
+  ShareHeader (uint32_t round = 0, uint8_t batchSize = 0);
+
+  // Header serialization/deserialization
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  // Fields
+  void SetRound (uint32_t round) { m_round = round; }
+  uint32_t GetRound () const { return m_round; }
+  uint8_t GetBatchSize () const { return m_batchSize; }
+  /// Serialized size of one share of batchSize values
+  static uint32_t GetShareSize (uint8_t batchSize) { return 12 + 4 * batchSize; }
+  /// Append a share, share.m_values must hold GetBatchSize () values
+  void AddShare (Share const & share);
+  std::vector<Share> const & GetShares () const { return m_shares; }
+
+  bool operator== (ShareHeader const & o) const;
+private:
+  uint32_t      m_round;            ///< Aggregation round
+  uint8_t       m_batchSize;        ///< Number of values aggregated per round
+  std::vector<Share> m_shares;      ///< Shares
+};
+
+std::ostream & operator<< (std::ostream & os, ShareHeader const &);
+
+/**
+ * \ingroup cpda
+ * \brief Partial sums. CPDATYPE_ASSEMBLED carries the assembled share sum of
+ * a member to its leader, CPDATYPE_RESULT carries the sum of a whole TAG
+ * subtree from a leader to its parent.
+ *
+ * \verbatim
+   Dst (4 bytes) | Round (4 bytes) | Contributors (2 bytes) | Messages (4 bytes) |
+   Batch size (1 byte) | Values (4 bytes * batch size)
+   \endverbatim
+ */
+class SumHeader : public Header
+{
+public:
+  /// c-tor
+  SumHeader (Ipv4Address dst = Ipv4Address (), uint32_t round = 0);
+
+  // Header serialization/deserialization
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  // Fields
+  void SetDst (Ipv4Address a) { m_dst = a; }
+  Ipv4Address GetDst () const { return m_dst; }
+  void SetRound (uint32_t round) { m_round = round; }
+  uint32_t GetRound () const { return m_round; }
+  /// Number of nodes whose readings are included in the values
+  void SetContributors (uint16_t n) { m_contributors = n; }
+  uint16_t GetContributors () const { return m_contributors; }
+  /// Number of CPDA messages sent for this round by the nodes covered
+  void SetMessages (uint32_t n) { m_messages = n; }
+  uint32_t GetMessages () const { return m_messages; }
+  void SetValues (std::vector<uint32_t> const & values);
+  std::vector<uint32_t> const & GetValues () const { return m_values; }
+
+  bool operator== (SumHeader const & o) const;
+private:
+  Ipv4Address   m_dst;              ///< Leader or TAG tree parent
+  uint32_t      m_round;            ///< Aggregation round
+  uint16_t      m_contributors;     ///< Nodes included in the sums
+  uint32_t      m_messages;         ///< Messages sent by the nodes covered
+  std::vector<uint32_t> m_values;   ///< One sum per aggregated value of the batch
+};
+
+std::ostream & operator<< (std::ostream & os, SumHeader const &);
+
+}
+}
+#endif /* CPDA_PACKET_H */
@@ -0,0 +1,144 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "cpda-share-math.h"
+#include "ns3/assert.h"
+
+namespace ns3
+{
+namespace cpda
+{
+
+/*
+ * Products are folded once, (x & p) + (x >> 31) < 2^32, and summed in 64 bit;
+ * a sum of up to 2^31 folded products can't overflow, so a single full
+ * reduction per result is enough.
+ */
+static inline uint64_t
+Fold (uint64_t x)
+{
+  return (x & ShareMath::PRIME) + (x >> 31);
+}
+
+ShareMath::ShareMath ()
+  : m_members (0),
+    m_batch (0)
+{
+}
+
+uint32_t
+ShareMath::Inv (uint32_t a)
+{
+  NS_ASSERT (a % PRIME != 0);
+  // Fermat: a^(p-2) = a^-1 mod p
+  uint32_t result = 1;
+  for (uint32_t e = PRIME - 2; e != 0; e >>= 1)
+    {
+      if (e & 1)
+        {
+          result = Mul (result, a);
+        }
+      a = Mul (a, a);
+    }
+  return result;
+}
+
+void
+ShareMath::SetSize (uint32_t members, uint32_t batch)
+{
+  NS_ASSERT (members >= 1 && batch >= 1);
+  m_batch = batch;
+  if (members == m_members)
+    {
+      return;
+    }
+  m_members = members;
+  m_powers.resize (members * members);
+  m_weights.resize (members);
+  for (uint32_t j = 0; j < members; ++j)
+    {
+      uint32_t x = j + 1;
+      uint32_t power = 1;
+      for (uint32_t k = 0; k < members; ++k)
+        {
+          m_powers[j * members + k] = power;
+          power = Mul (power, x);
+        }
+    }
+  // L_j(0) = prod_(k != j) x_k / (x_k - x_j)
+  for (uint32_t j = 0; j < members; ++j)
+    {
+      uint32_t num = 1;
+      uint32_t den = 1;
+      for (uint32_t k = 0; k < members; ++k)
+        {
+          if (k != j)
+            {
+              num = Mul (num, k + 1);
+              den = Mul (den, Sub (k + 1, j + 1));
+            }
+        }
+      m_weights[j] = Mul (num, Inv (den));
+    }
+}
+
+void
+ShareMath::Evaluate (uint32_t const * coefficients, uint32_t * shares) const
+{
+  for (uint32_t j = 0; j < m_members; ++j)
+    {
+      EvaluateAt (coefficients, j, shares + j * m_batch);
+    }
+}
+
+void
+ShareMath::EvaluateAt (uint32_t const * coefficients, uint32_t member, uint32_t * shares) const
+{
+  NS_ASSERT (member < m_members);
+  uint32_t const * powers = &m_powers[member * m_members];
+  for (uint32_t b = 0; b < m_batch; ++b)
+    {
+      uint32_t const * c = coefficients + b * m_members;
+      uint64_t acc = 0;
+      for (uint32_t k = 0; k < m_members; ++k)
+        {
+          acc += Fold (uint64_t (powers[k]) * c[k]);
+        }
+      shares[b] = Reduce (acc);
+    }
+}
+
+void
+ShareMath::Solve (uint32_t const * assembled, uint32_t * sums) const
+{
+  // sum_j L_j(0) F_j, per batch element; walk the rows in memory order
+  for (uint32_t b = 0; b < m_batch; ++b)
+    {
+      sums[b] = 0;
+    }
+  for (uint32_t j = 0; j < m_members; ++j)
+    {
+      uint64_t w = m_weights[j];
+      uint32_t const * row = assembled + j * m_batch;
+      for (uint32_t b = 0; b < m_batch; ++b)
+        {
+          // sums[b] < p and the folded product < 2^32 stay below 2^33
+          sums[b] = Reduce (sums[b] + Fold (w * row[b]));
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CPDA_SHARE_MATH_H
+#define CPDA_SHARE_MATH_H
+
+#include <vector>
+#include <stdint.h>
+
+namespace ns3
+{
+namespace cpda
+{
+/**
+ * \ingroup cpda
+ *
+ * \brief CPDA share arithmetic over GF(p), p = 2^31 - 1.
+ *
+ * A cluster of m members uses the evaluation points x_j = j + 1. SetSize ()
+ * precomputes the m x m table of powers x_j^k and the Lagrange weights of
+ * the points at 0; after that Evaluate () and Solve () only stream over
+ * contiguous arrays, without allocating and without data dependent
+ * branches, so the inner loops vectorize.
+ *
+ * Layouts, for a batch of B values:
+ *  - coefficients: B rows of m values, row b holds the coefficients of x^0 ... x^(m-1)
+ *    of the polynomial hiding value b
+ *  - shares and assembled sums: m rows of B values, row j holds the values at x_j
+ */
+class ShareMath
+{
+public:
+  /// Field modulus, a Mersenne prime so reduction is a shift and an add
+  static const uint32_t PRIME = 2147483647U;
+
+  /// c-tor
+  ShareMath ();
+  /**
+   * Prepare tables for a cluster. Tables are only rebuilt when the cluster size changes.
+   * \param members cluster size m, at least 1
+   * \param batch values per round B, at least 1
+   */
+  void SetSize (uint32_t members, uint32_t batch);
+  /// Return cluster size
+  uint32_t GetMembers () const { return m_members; }
+  /// Return batch size
+  uint32_t GetBatch () const { return m_batch; }
+  /**
+   * Evaluate the B polynomials at every member's point
+   * \param coefficients B x m coefficients, each < PRIME
+   * \param shares m x B results
+   */
+  void Evaluate (uint32_t const * coefficients, uint32_t * shares) const;
+  /**
+   * Evaluate the B polynomials at the point of a single member
+   * \param coefficients B x m coefficients, each < PRIME
+   * \param member member index j
+   * \param shares B results
+   */
+  void EvaluateAt (uint32_t const * coefficients, uint32_t member, uint32_t * shares) const;
+  /**
+   * Solve the Vandermonde system V c = F for the constant terms, i.e. recover
+   * the sum of the hidden values from the assembled share sums
+   * \param assembled m x B assembled sums, each < PRIME
+   * \param sums B constant terms
+   */
+  void Solve (uint32_t const * assembled, uint32_t * sums) const;
+
+  /// Reduce a product of two field elements
+  static uint32_t Reduce (uint64_t x)
+  {
+    // x = hi * 2^31 + lo = hi + lo (mod 2^31 - 1); twice is enough for x < 2^62
+    x = (x & PRIME) + (x >> 31);
+    x = (x & PRIME) + (x >> 31);
+    return (x >= PRIME) ? uint32_t (x - PRIME) : uint32_t (x);
+  }
+  /// a + b mod p
+  static uint32_t Add (uint32_t a, uint32_t b)
+  {
+    uint32_t r = a + b;
+    return (r >= PRIME) ? r - PRIME : r;
+  }
+  /// a - b mod p
+  static uint32_t Sub (uint32_t a, uint32_t b)
+  {
+    return (a >= b) ? a - b : a + PRIME - b;
+  }
+  /// a * b mod p
+  static uint32_t Mul (uint32_t a, uint32_t b)
+  {
+    return Reduce (uint64_t (a) * b);
+  }
+  /// a^-1 mod p, a != 0
+  static uint32_t Inv (uint32_t a);
+
+private:
+  uint32_t m_members;              ///< Cluster size m
+  uint32_t m_batch;                ///< Batch size B
+  std::vector<uint32_t> m_powers;  ///< m x m, m_powers[j * m + k] = x_j^k
+  std::vector<uint32_t> m_weights; ///< m Lagrange weights L_j(0)
+};
+
+}
+}
+#endif /* CPDA_SHARE_MATH_H */
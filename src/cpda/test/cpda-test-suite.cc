@@ -0,0 +1,545 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/cpda-packet.h"
+#include "ns3/cpda-key-ring.h"
+#include "ns3/cpda-key-map.h"
+#include "ns3/cpda-share-math.h"
+#include "ns3/cpda-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+
+namespace ns3
+{
+namespace cpda
+{
+
+//-----------------------------------------------------------------------------
+/// Unit test for the CPDA type header
+struct TypeHeaderTest : public TestCase
+{
+  TypeHeaderTest () : TestCase ("CPDA TypeHeader") {}
+  virtual void DoRun ()
+  {
+    TypeHeader h;
+    NS_TEST_EXPECT_MSG_EQ (h.IsValid (), true, "Default header is valid");
+    NS_TEST_EXPECT_MSG_EQ (h.Get (), CPDATYPE_KEY, "Default header is CPDA_KEY");
+
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddHeader (TypeHeader (CPDATYPE_RESULT));
+    TypeHeader h2;
+    uint32_t bytes = p->RemoveHeader (h2);
+    NS_TEST_EXPECT_MSG_EQ (bytes, 1, "Type header is 1 byte long");
+    NS_TEST_EXPECT_MSG_EQ (h2.Get (), CPDATYPE_RESULT, "Round trip serialization works");
+
+    uint8_t bad = 0;
+    p = Create<Packet> (&bad, 1);
+    p->RemoveHeader (h2);
+    NS_TEST_EXPECT_MSG_EQ (h2.IsValid (), false, "Unknown type");
+  }
+};
+//-----------------------------------------------------------------------------
+/// Unit test for CPDA key header
+struct KeyHeaderTest : public TestCase
+{
+  KeyHeaderTest () : TestCase ("CPDA KEY") {}
+  void RoundTrip (KeyHeader const & h, uint32_t size, std::string encoding)
+  {
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddHeader (h);
+    KeyHeader h2;
+    uint32_t bytes = p->RemoveHeader (h2);
+    NS_TEST_EXPECT_MSG_EQ (bytes, size, encoding << " CPDA_KEY size");
+    NS_TEST_EXPECT_MSG_EQ (h, h2, encoding << " round trip serialization works");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetKey ().size (), h.GetKey ().size (), encoding << " key count");
+  }
+  virtual void DoRun ()
+  {
+    KeyHeader h (/*origin*/ Ipv4Address ("1.2.3.4"));
+    NS_TEST_EXPECT_MSG_EQ (h.GetKeyEncoding (), KEY_ENCODING_PLAIN, "Default encoding");
+    NS_TEST_EXPECT_MSG_EQ (h.GetSerializedSize (), 7, "Empty key ring");
+
+    KeyRing ring (10000);
+    ring.Generate (/*seed*/ 12345, /*ringSize*/ 200);
+    NS_TEST_EXPECT_MSG_EQ (ring.GetSize (), 200, "trivial");
+    h.SetKey (ring.GetKeys ());
+    RoundTrip (h, 7 + 2 * 200, "Plain");
+
+    h.SetKeyEncoding (KEY_ENCODING_DELTA);
+    NS_TEST_EXPECT_MSG_LT (h.GetSerializedSize (), 7 + 2 * 200, "Delta encoding is smaller");
+    RoundTrip (h, h.GetSerializedSize (), "Delta");
+
+    std::vector<uint16_t> wide;
+    wide.push_back (65535);
+    wide.push_back (1);
+    wide.push_back (200);
+    h.SetKey (wide);
+    NS_TEST_EXPECT_MSG_EQ (h.GetKey ().front (), 1, "Delta encoding sorts keys");
+    RoundTrip (h, 7 + 1 + 2 + 3, "Delta");
+
+    h.SetKey (ring.GetKeys ());
+    h.SetKeySeed (12345, 10000);
+    NS_TEST_EXPECT_MSG_EQ (h.GetKeyEncoding (), KEY_ENCODING_SEED, "trivial");
+    RoundTrip (h, 7 + 6, "Seed");
+
+    NS_TEST_EXPECT_MSG_EQ (h.HasHeard (), false, "No heard list by default");
+    h.SetHeard (std::vector<Ipv4Address> ());
+    NS_TEST_EXPECT_MSG_EQ (h.HasHeard (), true, "Empty heard list");
+    RoundTrip (h, 7 + 6 + 2, "Seed, heard nobody");
+    std::vector<Ipv4Address> heard;
+    heard.push_back (Ipv4Address ("1.1.1.1"));
+    heard.push_back (Ipv4Address ("2.2.2.2"));
+    h.SetHeard (heard);
+    RoundTrip (h, 7 + 6 + 2 + 2 * 4, "Seed, heard two");
+    h.SetKeyEncoding (KEY_ENCODING_DELTA);
+    h.SetKey (wide);
+    RoundTrip (h, 7 + 1 + 2 + 3 + 2 + 2 * 4, "Delta, heard two");
+
+    // origin, encoding, count 1 and a delta of more than 3 bytes
+    uint8_t tooLong[] = { 1, 2, 3, 4, KEY_ENCODING_DELTA, 0, 1, 0xff, 0xff, 0xff, 0x01 };
+    Ptr<Packet> bad = Create<Packet> (tooLong, sizeof (tooLong));
+    KeyHeader h2;
+    bad->RemoveHeader (h2);
+    NS_TEST_EXPECT_MSG_EQ (h2.IsValid (), false, "Delta longer than 16 bits");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetKey ().size (), 0, "Malformed ring dropped");
+    // count 3, but the packet ends in the second delta
+    uint8_t tooShort[] = { 1, 2, 3, 4, KEY_ENCODING_DELTA, 0, 3, 0x05, 0x85 };
+    bad = Create<Packet> (tooShort, sizeof (tooShort));
+    bad->RemoveHeader (h2);
+    NS_TEST_EXPECT_MSG_EQ (h2.IsValid (), false, "Ring past the end of the packet");
+    // count 3 plain keys, but only one in the packet
+    uint8_t plainShort[] = { 1, 2, 3, 4, KEY_ENCODING_PLAIN, 0, 3, 0, 1 };
+    bad = Create<Packet> (plainShort, sizeof (plainShort));
+    bad->RemoveHeader (h2);
+    NS_TEST_EXPECT_MSG_EQ (h2.IsValid (), false, "Plain ring past the end of the packet");
+    uint8_t unknown[] = { 1, 2, 3, 4, 7, 0, 0 };
+    bad = Create<Packet> (unknown, sizeof (unknown));
+    bad->RemoveHeader (h2);
+    NS_TEST_EXPECT_MSG_EQ (h2.IsValid (), false, "Unknown encoding");
+    // empty plain ring, heard flag (0x80) and 5 heard neighbors, but only one in the packet
+    uint8_t heardShort[] = { 1, 2, 3, 4, 0x80 | KEY_ENCODING_PLAIN, 0, 0, 0, 5, 1, 1, 1, 1 };
+    bad = Create<Packet> (heardShort, sizeof (heardShort));
+    bad->RemoveHeader (h2);
+    NS_TEST_EXPECT_MSG_EQ (h2.IsValid (), false, "Heard list past the end of the packet");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetHeard ().size (), 0, "Malformed heard list dropped");
+    // seeds with an empty pool, and with a pool smaller than the ring
+    uint8_t emptyPool[] = { 1, 2, 3, 4, KEY_ENCODING_SEED, 0, 1, 0, 0, 0, 0, 0, 1 };
+    bad = Create<Packet> (emptyPool, sizeof (emptyPool));
+    bad->RemoveHeader (h2);
+    NS_TEST_EXPECT_MSG_EQ (h2.IsValid (), false, "Seed of an empty pool");
+    uint8_t smallPool[] = { 1, 2, 3, 4, KEY_ENCODING_SEED, 0, 200, 0, 100, 0, 0, 0, 1 };
+    bad = Create<Packet> (smallPool, sizeof (smallPool));
+    bad->RemoveHeader (h2);
+    NS_TEST_EXPECT_MSG_EQ (h2.IsValid (), false, "Seed of a pool smaller than the ring");
+  }
+};
+//-----------------------------------------------------------------------------
+/// Unit test for CPDA join
+struct JoinHeaderTest : public TestCase
+{
+  JoinHeaderTest () : TestCase ("CPDA JOIN") {}
+  virtual void DoRun ()
+  {
+    JoinHeader h (/*leader*/ Ipv4Address ("1.2.3.4"), /*origin*/ Ipv4Address ("4.3.2.1"), /*round*/ 2);
+    NS_TEST_EXPECT_MSG_EQ (h.GetClusterLeader (), false, "trivial");
+    h.SetClusterLeader (true);
+    NS_TEST_EXPECT_MSG_EQ (h.GetClusterLeader (), true, "trivial");
+
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddHeader (h);
+    JoinHeader h2;
+    uint32_t bytes = p->RemoveHeader (h2);
+    NS_TEST_EXPECT_MSG_EQ (bytes, 13, "CPDA_JOIN is 13 bytes long");
+    NS_TEST_EXPECT_MSG_EQ (h, h2, "Round trip serialization works");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetClusterLeader (), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetLeader (), Ipv4Address ("1.2.3.4"), "trivial");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetRound (), 2, "trivial");
+  }
+};
+//-----------------------------------------------------------------------------
+/// Unit test for CPDA path key request/reply
+struct PathKeyHeaderTest : public TestCase
+{
+  PathKeyHeaderTest () : TestCase ("CPDA PATH KEY") {}
+  virtual void DoRun ()
+  {
+    PathKeyHeader h (/*origin*/ Ipv4Address ("1.2.3.4"), /*target*/ Ipv4Address ("1.2.3.5"),
+                         /*proxy*/ Ipv4Address ("1.2.3.6"), /*pathKey*/ 0xdeadbeef,
+                         /*keyId*/ 42, /*pathKeyValue*/ 0x01020304);
+    NS_TEST_EXPECT_MSG_EQ (h.GetPathKey (), 0xdeadbeef, "trivial");
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddHeader (h);
+    PathKeyHeader h2;
+    uint32_t bytes = p->RemoveHeader (h2);
+    NS_TEST_EXPECT_MSG_EQ (bytes, 22, "CPDA_PATH_KEY is 22 bytes long");
+    NS_TEST_EXPECT_MSG_EQ (h, h2, "Round trip serialization works");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetProxy (), Ipv4Address ("1.2.3.6"), "trivial");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetKeyId (), 42, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetPathKeyValue (), 0x01020304, "trivial");
+  }
+};
+//-----------------------------------------------------------------------------
+/// Unit test for CPDA aggregation headers
+struct AggregationHeaderTest : public TestCase
+{
+  AggregationHeaderTest () : TestCase ("CPDA AGGREGATION") {}
+  virtual void DoRun ()
+  {
+    RosterHeader roster (/*round*/ 7, /*leader*/ Ipv4Address ("10.0.0.1"));
+    std::vector<Ipv4Address> members;
+    members.push_back (Ipv4Address ("10.0.0.1"));
+    members.push_back (Ipv4Address ("10.0.0.2"));
+    members.push_back (Ipv4Address ("10.0.0.3"));
+    roster.SetMembers (members);
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddHeader (roster);
+    RosterHeader roster2;
+    NS_TEST_EXPECT_MSG_EQ (p->RemoveHeader (roster2), 10 + 3 * 4, "CPDA_ROSTER size");
+    NS_TEST_EXPECT_MSG_EQ (roster, roster2, "Round trip serialization works");
+
+    ShareHeader shares (/*round*/ 7, /*batchSize*/ 2);
+    Share share;
+    share.m_origin = Ipv4Address ("10.0.0.2");
+    share.m_dst = Ipv4Address ("10.0.0.3");
+    share.m_keyId = 42;
+    share.m_values.push_back (2147483646);
+    share.m_values.push_back (1);
+    shares.AddShare (share);
+    share.m_dst = Ipv4Address ("10.0.0.1");
+    shares.AddShare (share);
+    p = Create<Packet> ();
+    p->AddHeader (shares);
+    ShareHeader shares2;
+    NS_TEST_EXPECT_MSG_EQ (p->RemoveHeader (shares2), 7 + 2 * (12 + 2 * 4), "CPDA_SHARE size");
+    NS_TEST_EXPECT_MSG_EQ (ShareHeader::GetShareSize (2), 12 + 2 * 4, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (shares, shares2, "Round trip serialization works");
+    NS_TEST_EXPECT_MSG_EQ (shares2.GetShares ()[0].m_values[0], 2147483646, "trivial");
+
+    SumHeader sum (/*dst*/ Ipv4Address ("10.0.0.1"), /*round*/ 7);
+    sum.SetContributors (3);
+    sum.SetMessages (12);
+    sum.SetValues (share.m_values);
+    p = Create<Packet> ();
+    p->AddHeader (sum);
+    SumHeader sum2;
+    NS_TEST_EXPECT_MSG_EQ (p->RemoveHeader (sum2), 15 + 2 * 4, "CPDA_RESULT size");
+    NS_TEST_EXPECT_MSG_EQ (sum, sum2, "Round trip serialization works");
+  }
+};
+//-----------------------------------------------------------------------------
+/// Unit test for CPDA key ring
+struct KeyRingTest : public TestCase
+{
+  KeyRingTest () : TestCase ("KeyRing") {}
+  virtual void DoRun ()
+  {
+    KeyRing ring (100);
+    NS_TEST_EXPECT_MSG_EQ (ring.GetPoolSize (), 100, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (ring.Insert (0), false, "Key 0 is reserved");
+    NS_TEST_EXPECT_MSG_EQ (ring.Insert (101), false, "Key out of pool");
+    NS_TEST_EXPECT_MSG_EQ (ring.Insert (64), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (ring.Insert (3), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (ring.Insert (100), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (ring.Insert (3), false, "Duplicate key");
+    NS_TEST_EXPECT_MSG_EQ (ring.GetSize (), 3, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (ring.GetKeys ()[0], 3, "Keys are sorted");
+    NS_TEST_EXPECT_MSG_EQ (ring.GetKeys ()[2], 100, "Keys are sorted");
+    NS_TEST_EXPECT_MSG_EQ (ring.Contains (64), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (ring.Contains (63), false, "trivial");
+
+    KeyRing other (100);
+    other.Insert (100);
+    other.Insert (7);
+    other.Insert (64);
+    std::vector<uint16_t> shared;
+    NS_TEST_EXPECT_MSG_EQ (ring.Intersect (other, shared), 2, "Two shared keys");
+    NS_TEST_EXPECT_MSG_EQ (shared[0], 64, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (shared[1], 100, "trivial");
+    shared.clear ();
+    NS_TEST_EXPECT_MSG_EQ (ring.Intersect (other.GetKeys (), shared), 2, "Two shared keys");
+    NS_TEST_EXPECT_MSG_EQ (ring.FindFirstShared (other.GetKeys ()), 64, "trivial");
+
+    ring.SetPoolSecret (1);
+    other.SetPoolSecret (1);
+    NS_TEST_EXPECT_MSG_EQ (ring.GetKeyValue (64), other.GetKeyValue (64), "Both holders know the key value");
+    NS_TEST_EXPECT_MSG_NE (ring.GetKeyValue (64), 0, "trivial");
+    NS_TEST_EXPECT_MSG_NE (ring.GetKeyValue (64), ring.GetKeyValue (100), "trivial");
+    NS_TEST_EXPECT_MSG_EQ (ring.GetKeyValue (7), 0, "Value of a key the ring doesn't hold is unknown");
+
+    Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+    KeyRing full (200);
+    full.Generate (rng, 200);
+    NS_TEST_EXPECT_MSG_EQ (full.GetSize (), 200, "Keys are drawn without replacement");
+    shared.clear ();
+    NS_TEST_EXPECT_MSG_EQ (full.Intersect (ring, shared), 3, "Full ring shares every key");
+    full.Clear ();
+    NS_TEST_EXPECT_MSG_EQ (full.GetSize (), 0, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (full.Contains (64), false, "trivial");
+  }
+};
+//-----------------------------------------------------------------------------
+/// Unit test for CPDA key map
+struct KeyMapTest : public TestCase
+{
+  KeyMapTest () : TestCase ("KeyMap") {}
+  virtual void DoRun ()
+  {
+    KeyMap map;
+    Ipv4Address a ("10.0.0.1");
+    Ipv4Address b ("10.0.0.2");
+    NS_TEST_EXPECT_MSG_EQ (map.HasKey (a), false, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (map.GetKey (a), 0, "Unknown neighbor has no key");
+
+    std::vector<uint16_t> keys;
+    keys.push_back (5);
+    keys.push_back (9);
+    map.AddKeys (a, keys);
+    map.AddKey (a, 7);
+    map.AddKey (a, 9);
+    NS_TEST_ASSERT_MSG_NE (map.Lookup (a), 0, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (map.Lookup (a)->m_keys.size (), 3, "Keys are merged without duplicates");
+    NS_TEST_EXPECT_MSG_EQ (map.Lookup (a)->m_keys[1], 7, "Keys are sorted");
+    NS_TEST_EXPECT_MSG_EQ (map.GetKey (a), 5, "First shared key");
+    NS_TEST_EXPECT_MSG_EQ (map.HasSharedKey (a), true, "trivial");
+
+    map.SetPathKey (b, /*proxy*/ a, /*pathKey*/ 1234, /*pathKeyValue*/ 5678);
+    NS_TEST_EXPECT_MSG_EQ (map.HasKey (b), true, "Path key secures the link");
+    NS_TEST_EXPECT_MSG_EQ (map.HasSharedKey (b), false, "but is not a shared key");
+    NS_TEST_EXPECT_MSG_EQ (map.GetKey (b), 1234, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (map.GetSize (), 2, "trivial");
+
+    // enough neighbors to grow the table several times
+    for (uint32_t i = 0; i < 1000; ++i)
+      {
+        map.AddKey (Ipv4Address (0x0a010000 + i), i % 100 + 1);
+      }
+    NS_TEST_EXPECT_MSG_EQ (map.GetSize (), 1002, "trivial");
+    for (uint32_t i = 0; i < 1000; i += 2)
+      {
+        NS_TEST_EXPECT_MSG_EQ (map.DeleteKey (Ipv4Address (0x0a010000 + i)), true, "trivial");
+      }
+    NS_TEST_EXPECT_MSG_EQ (map.DeleteKey (Ipv4Address (0x0a010000)), false, "Already deleted");
+    NS_TEST_EXPECT_MSG_EQ (map.GetSize (), 502, "trivial");
+    bool found = true;
+    for (uint32_t i = 1; i < 1000; i += 2)
+      {
+        found = found && (map.GetKey (Ipv4Address (0x0a010000 + i)) == i % 100 + 1);
+      }
+    NS_TEST_EXPECT_MSG_EQ (found, true, "Entries survive growth and deletion");
+    NS_TEST_EXPECT_MSG_EQ (map.GetKey (b), 1234, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (map.Lookup (b)->m_pathKeyValue, 5678, "Path key value survives growth");
+    std::vector<Ipv4Address> neighbors;
+    map.GetNeighbors (neighbors);
+    NS_TEST_EXPECT_MSG_EQ (neighbors.size (), 502, "trivial");
+
+    map.Clear ();
+    NS_TEST_EXPECT_MSG_EQ (map.GetSize (), 0, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (map.HasKey (a), false, "trivial");
+  }
+};
+//-----------------------------------------------------------------------------
+/// Unit test for CPDA share arithmetic
+struct ShareMathTest : public TestCase
+{
+  ShareMathTest () : TestCase ("ShareMath") {}
+  virtual void DoRun ()
+  {
+    uint32_t const p = ShareMath::PRIME;
+    NS_TEST_EXPECT_MSG_EQ (ShareMath::Mul (p - 1, p - 1), 1, "(-1)^2 = 1");
+    NS_TEST_EXPECT_MSG_EQ (ShareMath::Add (p - 1, 2), 1, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (ShareMath::Sub (1, 2), p - 1, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (ShareMath::Mul (12345, ShareMath::Inv (12345)), 1, "trivial");
+
+    // every member of a cluster hides B values; the sums of their shares
+    // must give back the sums of the values
+    uint32_t const sizes[] = { 1, 2, 5, 20 };
+    uint32_t const batch = 3;
+    ShareMath math;
+    for (uint32_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); ++s)
+      {
+        uint32_t members = sizes[s];
+        math.SetSize (members, batch);
+        std::vector<uint32_t> assembled (members * batch, 0);
+        std::vector<uint32_t> truth (batch, 0);
+        std::vector<uint32_t> coefficients (batch * members);
+        std::vector<uint32_t> shares (members * batch);
+        uint32_t seed = 7;
+        for (uint32_t i = 0; i < members; ++i)
+          {
+            for (uint32_t c = 0; c < coefficients.size (); ++c)
+              {
+                seed = seed * 1103515245 + 12345;
+                coefficients[c] = seed % p;
+              }
+            for (uint32_t b = 0; b < batch; ++b)
+              {
+                coefficients[b * members] = 10 * i + b;
+                truth[b] += 10 * i + b;
+              }
+            math.Evaluate (&coefficients[0], &shares[0]);
+            // compare with plain Horner evaluation of the last member's share
+            uint32_t x = members;
+            uint32_t horner = 0;
+            for (uint32_t k = members; k-- > 0;)
+              {
+                horner = (uint64_t (horner) * x + coefficients[k]) % p;
+              }
+            NS_TEST_EXPECT_MSG_EQ (shares[(members - 1) * batch], horner, "Evaluate agrees with Horner");
+            for (uint32_t c = 0; c < assembled.size (); ++c)
+              {
+                assembled[c] = ShareMath::Add (assembled[c], shares[c]);
+              }
+          }
+        std::vector<uint32_t> sums (batch);
+        math.Solve (&assembled[0], &sums[0]);
+        for (uint32_t b = 0; b < batch; ++b)
+          {
+            NS_TEST_EXPECT_MSG_EQ (sums[b], truth[b], "Solve recovers the cluster sum");
+          }
+      }
+  }
+};
+//-----------------------------------------------------------------------------
+/**
+ * Behavioural test of an aggregation round: the root leads a cluster of
+ * the nodes it hears, one of which leads a second cluster of the nodes
+ * only it hears. The sums reaching the root must be the sums of all the
+ * readings, contributed by every node.
+ */
+struct AggregationRoundTest : public TestCase
+{
+  AggregationRoundTest () : TestCase ("CPDA aggregation round over two clusters"),
+                            m_readers (0), m_results (0), m_contributors (0) {}
+  void Reading (uint32_t round, std::vector<uint32_t> const & readings)
+  {
+    m_readers++;
+    m_truth.resize (readings.size (), 0);
+    for (uint32_t b = 0; b < readings.size (); ++b)
+      {
+        m_truth[b] = ShareMath::Add (m_truth[b], readings[b]);
+      }
+  }
+  void Result (uint32_t round, std::vector<uint32_t> const & sums, uint16_t contributors,
+               uint32_t messages, Time latency)
+  {
+    m_results++;
+    m_sums = sums;
+    m_contributors = contributors;
+  }
+  virtual void DoRun ()
+  {
+    RngSeedManager::SetSeed (1);
+    RngSeedManager::SetRun (1);
+    const uint32_t members = 4;
+
+    // node 0 is the root, 1 the leader of the second cluster, then the
+    // members of the root cluster and those of the second cluster
+    NodeContainer nodes;
+    nodes.Create (2 + 2 * members);
+    Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+    NetDeviceContainer devices;
+    for (uint32_t i = 0; i < nodes.GetN (); ++i)
+      {
+        Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+        device->SetAddress (Mac48Address::Allocate ());
+        device->SetChannel (channel);
+        nodes.Get (i)->AddDevice (device);
+        devices.Add (device);
+      }
+    // only the leader hears both the root and the second cluster
+    for (uint32_t i = 0; i < nodes.GetN (); ++i)
+      {
+        for (uint32_t j = 2 + members; j < nodes.GetN (); ++j)
+          {
+            if (i != 1 && (i < 2 + members))
+              {
+                Ptr<SimpleNetDevice> a = DynamicCast<SimpleNetDevice> (devices.Get (i));
+                Ptr<SimpleNetDevice> b = DynamicCast<SimpleNetDevice> (devices.Get (j));
+                channel->BlackList (a, b);
+                channel->BlackList (b, a);
+              }
+          }
+      }
+    InternetStackHelper stack;
+    stack.Install (nodes);
+    Ipv4AddressHelper address;
+    address.SetBase ("10.0.0.0", "255.0.0.0");
+    address.Assign (devices);
+
+    CpdaHelper cpda;
+    cpda.SetAttribute ("KeyPoolSize", UintegerValue (1000));
+    ApplicationContainer apps;
+    for (uint32_t i = 0; i < nodes.GetN (); ++i)
+      {
+        cpda.SetAttribute ("Root", BooleanValue (i == 0));
+        cpda.SetAttribute ("LeaderProbability", DoubleValue (i == 1 ? 1 : 0));
+        apps.Add (cpda.Install (nodes.Get (i)));
+      }
+    for (uint32_t i = 0; i < apps.GetN (); ++i)
+      {
+        apps.Get (i)->TraceConnectWithoutContext ("Reading", MakeCallback (&AggregationRoundTest::Reading, this));
+        apps.Get (i)->TraceConnectWithoutContext ("Result", MakeCallback (&AggregationRoundTest::Result, this));
+      }
+
+    Simulator::Stop (Seconds (10));
+    Simulator::Run ();
+    Simulator::Destroy ();
+
+    NS_TEST_EXPECT_MSG_EQ (m_readers, nodes.GetN (), "Every node contributes a reading");
+    NS_TEST_ASSERT_MSG_EQ (m_results, 1, "The root reports one result");
+    NS_TEST_EXPECT_MSG_EQ (m_contributors, nodes.GetN (), "Every node is counted");
+    NS_TEST_ASSERT_MSG_EQ (m_sums.size (), m_truth.size (), "One sum per slot");
+    for (uint32_t b = 0; b < m_sums.size (); ++b)
+      {
+        NS_TEST_EXPECT_MSG_EQ (m_sums[b], m_truth[b], "Sum of slot " << b);
+      }
+  }
+  uint32_t m_readers;               ///< Nodes which traced their readings
+  uint32_t m_results;               ///< Results reported by the root
+  uint16_t m_contributors;          ///< Contributors of the result
+  std::vector<uint32_t> m_truth;    ///< Sums of the traced readings
+  std::vector<uint32_t> m_sums;     ///< Sums of the result
+};
+//-----------------------------------------------------------------------------
+class CpdaTestSuite : public TestSuite
+{
+public:
+  CpdaTestSuite () : TestSuite ("cpda", UNIT)
+  {
+    AddTestCase (new TypeHeaderTest, TestCase::QUICK);
+    AddTestCase (new KeyHeaderTest, TestCase::QUICK);
+    AddTestCase (new JoinHeaderTest, TestCase::QUICK);
+    AddTestCase (new PathKeyHeaderTest, TestCase::QUICK);
+    AddTestCase (new AggregationHeaderTest, TestCase::QUICK);
+    AddTestCase (new KeyRingTest, TestCase::QUICK);
+    AddTestCase (new KeyMapTest, TestCase::QUICK);
+    AddTestCase (new ShareMathTest, TestCase::QUICK);
+    AddTestCase (new AggregationRoundTest, TestCase::QUICK);
+  }
+} g_cpdaTestSuite;
+
+}
+}
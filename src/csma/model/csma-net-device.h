@@ -163,10 +163,11 @@ public:
    * arrived at the device.
    *
    * \see CsmaChannel
-   * \param p a reference to the received packet
+   * \param p a reference to the received packet, shared with the other
+   *        devices of the channel
    * \param sender the CsmaNetDevice that transmitted the packet in the first place
    */
-  void Receive (Ptr<Packet> p, Ptr<CsmaNetDevice> sender);
+  void Receive (Ptr<const Packet> p, Ptr<CsmaNetDevice> sender);
 
   /**
    * Is the send side of the network device enabled?
@@ -383,8 +383,13 @@ void
 Ipv4Header::Serialize (Buffer::Iterator start) const
 {
   NS_LOG_FUNCTION (this << &start);
-  Buffer::Iterator i = start;
+  SerializeFixed (start);
+}
 
+template <typename W>
+void
+Ipv4Header::SerializeFields (W &i, Buffer::Iterator start) const
+{
   uint8_t verIhl = (4 << 4) | (5);
   i.WriteU8 (verIhl);
   i.WriteU8 (m_tos);
@@ -411,20 +416,26 @@ Ipv4Header::Serialize (Buffer::Iterator start) const
 
   if (m_calcChecksum) 
     {
-      i = start;
-      uint16_t checksum = i.CalculateIpChecksum (20);
+      Buffer::Iterator j = start;
+      uint16_t checksum = j.CalculateIpChecksum (20);
       NS_LOG_LOGIC ("checksum=" <<checksum);
-      i = start;
-      i.Next (10);
-      i.WriteU16 (checksum);
+      j = start;
+      j.Next (10);
+      j.WriteU16 (checksum);
     }
 }
+
 uint32_t
 Ipv4Header::Deserialize (Buffer::Iterator start)
 {
   NS_LOG_FUNCTION (this << &start);
-  Buffer::Iterator i = start;
+  return DeserializeFixed (start);
+}
 
+template <typename R>
+uint32_t
+Ipv4Header::DeserializeFields (R &i, Buffer::Iterator start)
+{
   uint8_t verIhl = i.ReadU8 ();
   uint8_t ihl = verIhl & 0x0f; 
   uint16_t headerSize = ihl * 4;
@@ -449,8 +460,7 @@ Ipv4Header::Deserialize (Buffer::Iterator start)
     {
       m_flags |= MORE_FRAGMENTS;
     }
-  i.Prev ();
-  m_fragmentOffset = i.ReadU8 () & 0x1f;
+  m_fragmentOffset = flags & 0x1f;
   m_fragmentOffset <<= 8;
   m_fragmentOffset |= i.ReadU8 ();
   m_fragmentOffset <<= 3;
@@ -464,8 +474,8 @@ Ipv4Header::Deserialize (Buffer::Iterator start)
 
   if (m_calcChecksum) 
     {
-      i = start;
-      uint16_t checksum = i.CalculateIpChecksum (headerSize);
+      Buffer::Iterator j = start;
+      uint16_t checksum = j.CalculateIpChecksum (headerSize);
       NS_LOG_LOGIC ("checksum=" <<checksum);
 
       m_goodChecksum = (checksum == 0);
@@ -21,7 +21,7 @@
 #ifndef IPV4_HEADER_H
 #define IPV4_HEADER_H
 
-#include "ns3/header.h"
+#include "ns3/fixed-size-header.h"
 #include "ns3/ipv4-address.h"
 
 namespace ns3 {
@@ -29,8 +29,12 @@ namespace ns3 {
  * \ingroup ipv4
  *
  * \brief Packet header for IPv4
+ *
+ * The header is serialized as a FixedSizeHeader of 20 bytes.  The
+ * options of a deserialized header are skipped, and counted by
+ * GetSerializedSize.
  */
-class Ipv4Header : public Header 
+class Ipv4Header : public FixedSizeHeader<Ipv4Header, 20>
 {
 public:
   /**
@@ -236,6 +240,25 @@ public:
   virtual void Serialize (Buffer::Iterator start) const;
   virtual uint32_t Deserialize (Buffer::Iterator start);
 private:
+  friend class FixedSizeHeader<Ipv4Header, 20>;
+
+  /**
+   * Write the fields of the header.
+   * \param [in,out] i The writer of the fields.
+   * \param [in] start An iterator which points to where the header
+   *        should be written, for the checksum.
+   */
+  template <typename W>
+  void SerializeFields (W &i, Buffer::Iterator start) const;
+  /**
+   * Read the fields of the header.
+   * \param [in,out] i The reader of the fields.
+   * \param [in] start An iterator which points to where the header
+   *        should be read from, for the checksum.
+   * \returns The size of the header, or 0 if it is not an IPv4 header.
+   */
+  template <typename R>
+  uint32_t DeserializeFields (R &i, Buffer::Iterator start);
 
   /// flags related to IP fragmentation
   enum FlagsE {
@@ -174,17 +174,16 @@ UdpHeader::Print (std::ostream &os) const
   ;
 }
 
-uint32_t 
-UdpHeader::GetSerializedSize (void) const
+void
+UdpHeader::Serialize (Buffer::Iterator start) const
 {
-  return 8;
+  SerializeFixed (start);
 }
 
+template <typename W>
 void
-UdpHeader::Serialize (Buffer::Iterator start) const
+UdpHeader::SerializeFields (W &i, Buffer::Iterator start) const
 {
-  Buffer::Iterator i = start;
-
   i.WriteHtonU16 (m_sourcePort);
   i.WriteHtonU16 (m_destinationPort);
   if (m_payloadSize == 0)
@@ -203,12 +202,12 @@ UdpHeader::Serialize (Buffer::Iterator start) const
       if (m_calcChecksum)
         {
           uint16_t headerChecksum = CalculateHeaderChecksum (start.GetSize ());
-          i = start;
-          uint16_t checksum = i.CalculateIpChecksum (start.GetSize (), headerChecksum);
+          Buffer::Iterator j = start;
+          uint16_t checksum = j.CalculateIpChecksum (start.GetSize (), headerChecksum);
 
-          i = start;
-          i.Next (6);
-          i.WriteU16 (checksum);
+          j = start;
+          j.Next (6);
+          j.WriteU16 (checksum);
         }
     }
   else
@@ -216,10 +215,17 @@ UdpHeader::Serialize (Buffer::Iterator start) const
       i.WriteU16 (m_checksum);
     }
 }
+
 uint32_t
 UdpHeader::Deserialize (Buffer::Iterator start)
 {
-  Buffer::Iterator i = start;
+  return DeserializeFixed (start);
+}
+
+template <typename R>
+uint32_t
+UdpHeader::DeserializeFields (R &i, Buffer::Iterator start)
+{
   m_sourcePort = i.ReadNtohU16 ();
   m_destinationPort = i.ReadNtohU16 ();
   m_payloadSize = i.ReadNtohU16 () - GetSerializedSize ();
@@ -228,8 +234,8 @@ UdpHeader::Deserialize (Buffer::Iterator start)
   if (m_calcChecksum)
     {
       uint16_t headerChecksum = CalculateHeaderChecksum (start.GetSize ());
-      i = start;
-      uint16_t checksum = i.CalculateIpChecksum (start.GetSize (), headerChecksum);
+      Buffer::Iterator j = start;
+      uint16_t checksum = j.CalculateIpChecksum (start.GetSize (), headerChecksum);
 
       m_goodChecksum = (checksum == 0);
     }
@@ -23,7 +23,7 @@
 
 #include <stdint.h>
 #include <string>
-#include "ns3/header.h"
+#include "ns3/fixed-size-header.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv6-address.h"
 
@@ -34,9 +34,9 @@ namespace ns3 {
  *
  * This class has fields corresponding to those in a network UDP header
  * (port numbers, payload size, checksum) as well as methods for serialization
- * to and deserialization from a byte buffer.
+ * to and deserialization from a byte buffer, as a FixedSizeHeader.
  */
-class UdpHeader : public Header 
+class UdpHeader : public FixedSizeHeader<UdpHeader, 8>
 {
 public:
 
@@ -121,7 +121,6 @@ public:
   static TypeId GetTypeId (void);
   virtual TypeId GetInstanceTypeId (void) const;
   virtual void Print (std::ostream &os) const;
-  virtual uint32_t GetSerializedSize (void) const;
   virtual void Serialize (Buffer::Iterator start) const;
   virtual uint32_t Deserialize (Buffer::Iterator start);
 
@@ -167,6 +166,25 @@ public:
   uint16_t GetChecksum ();
 
 private:
+  friend class FixedSizeHeader<UdpHeader, 8>;
+
+  /**
+   * Write the fields of the header.
+   * \param [in,out] i The writer of the fields.
+   * \param [in] start An iterator which points to where the header
+   *        should be written, for the length and the checksum.
+   */
+  template <typename W>
+  void SerializeFields (W &i, Buffer::Iterator start) const;
+  /**
+   * Read the fields of the header.
+   * \param [in,out] i The reader of the fields.
+   * \param [in] start An iterator which points to where the header
+   *        should be read from, for the checksum.
+   * \returns The size of the header.
+   */
+  template <typename R>
+  uint32_t DeserializeFields (R &i, Buffer::Iterator start);
   /**
    * \brief Calculate the header checksum
    * \param size packet size
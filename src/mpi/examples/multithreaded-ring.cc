@@ -0,0 +1,203 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <sys/time.h>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-helper.h"
+
+/**
+ * \file
+ * \ingroup mpi
+ * Run a ring of nodes with ns3::MultithreadedSimulatorImpl.
+ *
+ * The nodes of a ring, linked by point to point channels, are split in
+ * contiguous blocks, one for each thread. Tokens travel around the ring:
+ * each node receiving a token spends some work to mix it, folds it into a
+ * hash of the tokens it saw, and passes it to one of its neighbours, after
+ * the link delay plus a jitter derived from the token. The channels give
+ * the lookahead; the tokens are plain values, so that no reference
+ * counted state crosses the threads.
+ *
+ * The program runs the ring twice with MultithreadedSimulatorImpl, checks
+ * that both runs give the same hashes, and once with DefaultSimulatorImpl
+ * to check the number of tokens received and compare the wall clock times.
+ *
+ * \verbatim
+   ./waf --run="multithreaded-ring --threads=4 --nodes=64 --work=1000"
+   \endverbatim
+ */
+
+using namespace ns3;
+
+namespace {
+
+/// Nodes of the ring and the tokens they pass
+class Ring
+{
+public:
+  Ring (uint32_t nodes, Time delay, uint32_t work)
+    : m_hash (nodes, 0),
+      m_received (nodes, 0),
+      m_delay (delay),
+      m_work (work)
+  {
+  }
+  /// Handle a token at a node
+  void Receive (uint32_t node, uint64_t token)
+  {
+    token += node;
+    for (uint32_t i = 0; i < m_work; i++)
+      {
+        token = token * 6364136223846793005ULL + 1442695040888963407ULL;
+      }
+    m_hash[node] = (m_hash[node] ^ token ^ Simulator::Now ().GetTimeStep ()) * 1099511628211ULL;
+    m_received[node]++;
+    uint32_t next = (token >> 33) & 1 ? (node + 1) % m_hash.size () : (node + m_hash.size () - 1) % m_hash.size ();
+    Simulator::ScheduleWithContext (next, m_delay + NanoSeconds ((token >> 40) % 1000),
+                                    &Ring::Receive, this, next, token);
+  }
+  /// Combine the hashes of the nodes
+  uint64_t GetDigest (void) const
+  {
+    uint64_t digest = 14695981039346656037ULL;
+    for (uint32_t i = 0; i < m_hash.size (); i++)
+      {
+        digest = (digest ^ m_hash[i]) * 1099511628211ULL;
+      }
+    return digest;
+  }
+  /// Count the tokens received by all the nodes
+  uint64_t GetReceived (void) const
+  {
+    uint64_t received = 0;
+    for (uint32_t i = 0; i < m_received.size (); i++)
+      {
+        received += m_received[i];
+      }
+    return received;
+  }
+
+private:
+  std::vector<uint64_t> m_hash;
+  std::vector<uint64_t> m_received;
+  Time m_delay;
+  uint32_t m_work;
+};
+
+/// Outcome of a run
+struct Result
+{
+  uint64_t digest;
+  uint64_t received;
+  uint64_t events;
+  double wall;
+};
+
+double
+GetWallClock (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+Result
+RunRing (std::string impl, uint32_t threads, uint32_t nodes, uint32_t tokens,
+         Time delay, uint32_t work, Time stop)
+{
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue (impl));
+
+  NodeContainer ring;
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      ring.Add (CreateObject<Node> (uint64_t (i) * threads / nodes));
+    }
+  PointToPointHelper p2p;
+  p2p.SetChannelAttribute ("Delay", TimeValue (delay));
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      p2p.Install (ring.Get (i), ring.Get ((i + 1) % nodes));
+    }
+
+  Ring model (nodes, delay, work);
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      for (uint32_t j = 0; j < tokens; j++)
+        {
+          Simulator::ScheduleWithContext (i, NanoSeconds (j), &Ring::Receive, &model, i, (uint64_t (i) << 32) + j);
+        }
+    }
+  Simulator::Stop (stop);
+
+  Result result;
+  double start = GetWallClock ();
+  Simulator::Run ();
+  result.wall = GetWallClock () - start;
+  result.events = Simulator::GetEventCount ();
+  result.digest = model.GetDigest ();
+  result.received = model.GetReceived ();
+  Simulator::Destroy ();
+  return result;
+}
+
+} // namespace
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t threads = 4;
+  uint32_t nodes = 64;
+  uint32_t tokens = 4;
+  uint32_t work = 1000;
+  Time delay = MilliSeconds (1);
+  Time stop = Seconds (10);
+
+  CommandLine cmd;
+  cmd.AddValue ("threads", "Number of threads", threads);
+  cmd.AddValue ("nodes", "Number of nodes in the ring", nodes);
+  cmd.AddValue ("tokens", "Number of tokens started by each node", tokens);
+  cmd.AddValue ("work", "Iterations of work for each token received", work);
+  cmd.AddValue ("delay", "Delay of the links", delay);
+  cmd.AddValue ("stop", "Simulation time", stop);
+  cmd.Parse (argc, argv);
+
+  if (threads == 0 || nodes < 3 || threads > nodes)
+    {
+      std::cerr << "there must be at least one thread, three nodes, and no more threads than nodes" << std::endl;
+      return 1;
+    }
+
+  Result first = RunRing ("ns3::MultithreadedSimulatorImpl", threads, nodes, tokens, delay, work, stop);
+  Result second = RunRing ("ns3::MultithreadedSimulatorImpl", threads, nodes, tokens, delay, work, stop);
+  Result sequential = RunRing ("ns3::DefaultSimulatorImpl", 1, nodes, tokens, delay, work, stop);
+
+  bool deterministic = first.digest == second.digest && first.events == second.events;
+  // the path of a token does not depend on the order of simultaneous
+  // events, so that all the runs receive the same tokens
+  bool complete = first.received == sequential.received;
+  std::cout << std::fixed << std::setprecision (3)
+            << "threads " << threads << ": " << first.events << " events "
+            << first.wall << " s, again " << second.wall << " s" << std::endl
+            << "sequential: " << sequential.events << " events " << sequential.wall << " s" << std::endl
+            << "runs " << (deterministic ? "match" : "DIFFER")
+            << ", tokens received " << (complete ? "match" : "DIFFER") << std::endl;
+  return deterministic && complete ? 0 : 1;
+}
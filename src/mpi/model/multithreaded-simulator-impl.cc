@@ -0,0 +1,705 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/channel.h"
+#include "ns3/channel-list.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/nstime.h"
+#include "ns3/system-thread.h"
+#include "ns3/ptr.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <limits>
+#include <sched.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+namespace {
+
+/** Partition run by the calling thread plus one, 0 outside of Run. */
+__thread uint32_t g_currentPartition = 0;
+
+/** Time of the events which never happen. */
+const uint64_t NEVER = std::numeric_limits<uint64_t>::max ();
+
+/** Partition of no node. */
+const uint32_t NO_PARTITION = std::numeric_limits<uint32_t>::max ();
+
+} // anonymous namespace
+
+MultithreadedSimulatorImpl::Barrier::Barrier (uint32_t n)
+  : m_n (n),
+    m_waiting (0),
+    m_phase (0)
+{
+}
+
+void
+MultithreadedSimulatorImpl::Barrier::Wait (void)
+{
+  uint32_t phase = __atomic_load_n (&m_phase, __ATOMIC_ACQUIRE);
+  if (__atomic_add_fetch (&m_waiting, 1, __ATOMIC_ACQ_REL) == m_n)
+    {
+      __atomic_store_n (&m_waiting, 0, __ATOMIC_RELAXED);
+      __atomic_store_n (&m_phase, phase + 1, __ATOMIC_RELEASE);
+      return;
+    }
+  // windows are short when the lookahead is small, so spin for a while
+  // before giving the processor away
+  for (uint32_t spin = 0; __atomic_load_n (&m_phase, __ATOMIC_ACQUIRE) == phase; spin++)
+    {
+      if (spin >= 1000)
+        {
+          sched_yield ();
+        }
+    }
+}
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Mpi")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_barrier (0),
+    m_lookAhead (NEVER),
+    m_stopTs (NEVER),
+    m_endTs (0),
+    m_stop (false),
+    m_running (false)
+{
+  NS_LOG_FUNCTION (this);
+  // partition 0 holds all the events until Run knows the partitions
+  struct Partition partition;
+  partition.m_id = 0;
+  // uids are allocated from 4.
+  // uid 0 is "invalid" events
+  // uid 1 is "now" events
+  // uid 2 is "destroy" events
+  partition.m_uid = 4;
+  // before ::Run is entered, the m_currentUid will be zero
+  partition.m_currentUid = 0;
+  partition.m_currentTs = 0;
+  partition.m_currentContext = Simulator::NO_CONTEXT;
+  partition.m_eventCount = 0;
+  partition.m_unscheduledEvents = 0;
+  partition.m_outbox.resize (1);
+  partition.m_next = NEVER;
+  partition.m_stopTs = NEVER;
+  partition.m_stop = false;
+  m_partitions.push_back (partition);
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+  delete m_barrier;
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<struct Partition>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      while (!i->m_events->IsEmpty ())
+        {
+          Scheduler::Event next = i->m_events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      i->m_events = 0;
+    }
+  delete m_barrier;
+  m_barrier = 0;
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  NS_ASSERT_MSG (!m_running, "Cannot change the scheduler while the simulation runs");
+  m_schedulerFactory = schedulerFactory;
+  for (std::vector<struct Partition>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      if (i->m_events != 0)
+        {
+          while (!i->m_events->IsEmpty ())
+            {
+              scheduler->Insert (i->m_events->RemoveNext ());
+            }
+        }
+      i->m_events = scheduler;
+    }
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetCurrentPartition (void) const
+{
+  if (g_currentPartition != 0)
+    {
+      return g_currentPartition - 1;
+    }
+  if (m_running)
+    {
+      NS_FATAL_ERROR ("Only the simulation threads can use the simulator while it runs");
+    }
+  return 0;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartition (uint32_t context) const
+{
+  if (context == Simulator::NO_CONTEXT || m_nodePartitions.empty ())
+    {
+      return 0;
+    }
+  if (context >= m_nodePartitions.size ())
+    {
+      NS_FATAL_ERROR ("Context " << context << " is not the id of a node known at Simulator::Run");
+    }
+  return m_nodePartitions[context];
+}
+
+void
+MultithreadedSimulatorImpl::CreatePartitions (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t n = 1;
+  m_nodePartitions.resize (NodeList::GetNNodes ());
+  for (uint32_t i = 0; i < NodeList::GetNNodes (); i++)
+    {
+      uint32_t systemId = NodeList::GetNode (i)->GetSystemId ();
+      m_nodePartitions[i] = systemId;
+      n = std::max (n, systemId + 1);
+    }
+  if (m_partitions.size () > 1 && m_partitions.size () != n)
+    {
+      NS_FATAL_ERROR ("The number of partitions changed from " << m_partitions.size () << " to " << n);
+    }
+
+  // the lookahead is the smallest delay of the channels between partitions;
+  // only the point to point channels copy the packets they pass between
+  // partitions, so that the others (shared media) are rejected
+  TypeId pointToPoint;
+  bool havePointToPoint = TypeId::LookupByNameFailSafe ("ns3::PointToPointChannel", &pointToPoint);
+  m_lookAhead = NEVER;
+  for (uint32_t i = 0; i < ChannelList::GetNChannels (); i++)
+    {
+      Ptr<Channel> channel = ChannelList::GetChannel (i);
+      bool remote = false;
+      uint32_t first = NO_PARTITION;
+      for (uint32_t j = 0; j < channel->GetNDevices (); j++)
+        {
+          Ptr<NetDevice> device = channel->GetDevice (j);
+          if (device == 0 || device->GetNode () == 0)
+            {
+              continue;
+            }
+          uint32_t partition = m_nodePartitions[device->GetNode ()->GetId ()];
+          if (first == NO_PARTITION)
+            {
+              first = partition;
+            }
+          remote = remote || partition != first;
+        }
+      if (!remote)
+        {
+          continue;
+        }
+      TypeId tid = channel->GetInstanceTypeId ();
+      if (!havePointToPoint || (tid != pointToPoint && !tid.IsChildOf (pointToPoint)))
+        {
+          NS_FATAL_ERROR ("Channel " << tid.GetName ()
+                          << " connects partitions, but only point to point channels can");
+        }
+      // let the channel find its ends before the threads share it
+      channel->Initialize ();
+      TimeValue delay;
+      channel->GetAttribute ("Delay", delay);
+      NS_LOG_LOGIC ("channel " << channel->GetId () << " between partitions, delay " << delay.Get ());
+      m_lookAhead = std::min (m_lookAhead, uint64_t (delay.Get ().GetTimeStep ()));
+    }
+  if (n > 1 && m_lookAhead == 0)
+    {
+      NS_FATAL_ERROR ("A channel of zero delay connects partitions");
+    }
+  NS_LOG_DEBUG ("partitions " << n << " lookahead " << m_lookAhead);
+
+  if (m_barrier == 0)
+    {
+      m_barrier = new Barrier (n);
+    }
+  if (m_partitions.size () == n)
+    {
+      return;
+    }
+  // hand the events scheduled so far over to their partition, with their uid
+  std::vector<Scheduler::Event> events;
+  struct Partition &first = m_partitions[0];
+  while (!first.m_events->IsEmpty ())
+    {
+      events.push_back (first.m_events->RemoveNext ());
+    }
+  first.m_unscheduledEvents = 0;
+  first.m_outbox.resize (n);
+  m_partitions.reserve (n);
+  for (uint32_t i = 1; i < n; i++)
+    {
+      struct Partition partition = m_partitions[0];
+      partition.m_id = i;
+      partition.m_eventCount = 0;
+      partition.m_events = m_schedulerFactory.Create<Scheduler> ();
+      m_partitions.push_back (partition);
+    }
+  for (std::vector<Scheduler::Event>::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      struct Partition &partition = m_partitions[GetPartition (i->key.m_context)];
+      partition.m_events->Insert (*i);
+      partition.m_unscheduledEvents++;
+    }
+}
+
+EventId
+MultithreadedSimulatorImpl::Insert (struct Partition &partition, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = partition.m_uid;
+  partition.m_uid++;
+  partition.m_unscheduledEvents++;
+  partition.m_events->Insert (ev);
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (struct Partition &partition)
+{
+  Scheduler::Event next = partition.m_events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= partition.m_currentTs);
+  partition.m_unscheduledEvents--;
+
+  NS_LOG_LOGIC ("handle " << next.key.m_ts << " in partition " << partition.m_id);
+  partition.m_currentTs = next.key.m_ts;
+  partition.m_currentContext = next.key.m_context;
+  partition.m_currentUid = next.key.m_uid;
+  partition.m_eventCount++;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::RunPartition (uint32_t p)
+{
+  NS_LOG_FUNCTION (this << p);
+  g_currentPartition = p + 1;
+  struct Partition &partition = m_partitions[p];
+  uint32_t n = m_partitions.size ();
+  uint64_t stopTs = m_stopTs;
+  bool stop = false;
+
+  for (;;)
+    {
+      // every thread computes the same window from the published times
+      partition.m_next = partition.m_events->IsEmpty () ? NEVER : partition.m_events->PeekNext ().key.m_ts;
+      m_barrier->Wait ();
+      uint64_t lbts = NEVER;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          lbts = std::min (lbts, m_partitions[i].m_next);
+        }
+      if (stop || lbts == NEVER || lbts >= stopTs)
+        {
+          break;
+        }
+      uint64_t end = (lbts > NEVER - m_lookAhead) ? NEVER : lbts + m_lookAhead;
+      end = std::min (end, stopTs);
+
+      // the events this partition sends to the others are at least one
+      // lookahead later than its own time, hence not earlier than end
+      while (!partition.m_events->IsEmpty () && !partition.m_stop
+             && partition.m_events->PeekNext ().key.m_ts < std::min (end, partition.m_stopTs))
+        {
+          ProcessOneEvent (partition);
+        }
+      m_barrier->Wait ();
+
+      // mailboxes are read in partition order, for determinism
+      for (uint32_t i = 0; i < n; i++)
+        {
+          std::vector<Message> &inbox = m_partitions[i].m_outbox[p];
+          for (std::vector<Message>::const_iterator j = inbox.begin (); j != inbox.end (); ++j)
+            {
+              Insert (partition, j->m_ts, j->m_context, j->m_impl);
+            }
+          inbox.clear ();
+          stop = stop || m_partitions[i].m_stop;
+          stopTs = std::min (stopTs, m_partitions[i].m_stopTs);
+        }
+    }
+
+  if (p == 0)
+    {
+      m_stop = stop;
+      m_endTs = 0;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          m_endTs = std::max (m_endTs, m_partitions[i].m_currentTs);
+        }
+      if (!stop && stopTs != NEVER && stopTs >= m_endTs)
+        {
+          m_endTs = stopTs;
+        }
+    }
+  g_currentPartition = 0;
+}
+
+void
+MultithreadedSimulatorImpl::RunThread (std::pair<MultithreadedSimulatorImpl *, uint32_t> context)
+{
+  context.first->RunPartition (context.second);
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  CreatePartitions ();
+  m_stop = false;
+  for (std::vector<struct Partition>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      i->m_stop = false;
+      i->m_stopTs = NEVER;
+    }
+
+  m_running = true;
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 1; i < m_partitions.size (); i++)
+    {
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (&MultithreadedSimulatorImpl::RunThread,
+                                                                  std::make_pair (this, i))));
+      threads.back ()->Start ();
+    }
+  RunPartition (0);
+  for (uint32_t i = 0; i < threads.size (); i++)
+    {
+      threads[i]->Join ();
+    }
+  m_running = false;
+
+  // all the partitions resume at the time the simulation stopped
+  for (std::vector<struct Partition>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      if (i->m_currentTs < m_endTs)
+        {
+          i->m_currentTs = m_endTs;
+          i->m_currentUid = 0;
+        }
+      i->m_currentContext = Simulator::NO_CONTEXT;
+      // If the simulator stopped naturally by lack of events, make a
+      // consistency test to check that we didn't lose any events along the way.
+      NS_ASSERT (!i->m_events->IsEmpty () || i->m_unscheduledEvents == 0);
+    }
+  if (m_stopTs <= m_endTs)
+    {
+      m_stopTs = NEVER;
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_stop)
+    {
+      return true;
+    }
+  for (std::vector<struct Partition>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      if (!i->m_events->IsEmpty ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_running)
+    {
+      m_partitions[GetCurrentPartition ()].m_stop = true;
+    }
+  else
+    {
+      m_stop = true;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  struct Partition &partition = m_partitions[GetCurrentPartition ()];
+  uint64_t ts = partition.m_currentTs + delay.GetTimeStep ();
+  if (m_running)
+    {
+      partition.m_stopTs = std::min (partition.m_stopTs, ts);
+    }
+  else
+    {
+      m_stopTs = std::min (m_stopTs, ts);
+    }
+}
+
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep () << event);
+  struct Partition &partition = m_partitions[GetCurrentPartition ()];
+  Time tAbsolute = delay + TimeStep (partition.m_currentTs);
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (partition.m_currentTs));
+  return Insert (partition, tAbsolute.GetTimeStep (), partition.m_currentContext, event);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << delay.GetTimeStep () << event);
+  uint32_t current = GetCurrentPartition ();
+  uint32_t target = GetPartition (context);
+  struct Partition &partition = m_partitions[current];
+  uint64_t ts = partition.m_currentTs + delay.GetTimeStep ();
+  if (target == current || !m_running)
+    {
+      Insert (m_partitions[target], ts, context, event);
+      return;
+    }
+  if (uint64_t (delay.GetTimeStep ()) < m_lookAhead)
+    {
+      NS_FATAL_ERROR ("Event for node " << context << " in partition " << target
+                      << " scheduled " << delay << " ahead, less than the lookahead "
+                      << TimeStep (m_lookAhead));
+    }
+  Message message;
+  message.m_ts = ts;
+  message.m_context = context;
+  message.m_impl = event;
+  partition.m_outbox[target].push_back (message);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << event);
+  struct Partition &partition = m_partitions[GetCurrentPartition ()];
+  return Insert (partition, partition.m_currentTs, partition.m_currentContext, event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << event);
+  EventId id (Ptr<EventImpl> (event, false), m_partitions[GetCurrentPartition ()].m_currentTs, 0xffffffff, 2);
+  CriticalSection cs (m_destroyEventsMutex);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  return TimeStep (m_partitions[GetCurrentPartition ()].m_currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - m_partitions[GetPartition (id.GetContext ())].m_currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_destroyEventsMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  uint32_t p = GetPartition (id.GetContext ());
+  NS_ASSERT_MSG (!m_running || p == GetCurrentPartition (),
+                 "Cannot remove an event of another partition");
+  struct Partition &partition = m_partitions[p];
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  partition.m_events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  partition.m_unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0
+          || id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (const_cast<SystemMutex &> (m_destroyEventsMutex));
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  const struct Partition &partition = m_partitions[GetPartition (id.GetContext ())];
+  if (id.PeekEventImpl () == 0
+      || id.GetTs () < partition.m_currentTs
+      || (id.GetTs () == partition.m_currentTs
+          && id.GetUid () <= partition.m_currentUid)
+      || id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return m_running ? GetCurrentPartition () : 0;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return m_partitions[GetCurrentPartition ()].m_currentContext;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetEventCount (void) const
+{
+  if (m_running)
+    {
+      return m_partitions[GetCurrentPartition ()].m_eventCount;
+    }
+  uint64_t count = 0;
+  for (std::vector<struct Partition>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      count += i->m_eventCount;
+    }
+  return count;
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookAhead (void) const
+{
+  return TimeStep (m_lookAhead == NEVER ? 0x7fffffffffffffffLL : m_lookAhead);
+}
+
+} // namespace ns3
@@ -0,0 +1,223 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MULTITHREADED_SIMULATOR_IMPL_H
+#define NS3_MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/object-factory.h"
+#include "ns3/ptr.h"
+#include "ns3/system-mutex.h"
+
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ * \ingroup mpi
+ *
+ * \brief Conservative parallel simulator implementation using threads
+ *
+ * The nodes are partitioned by their system id, as for
+ * DistributedSimulatorImpl, but the partitions run in threads of a
+ * single process: the thread calling Simulator::Run runs partition 0 and
+ * starts one thread for each other partition. Each partition owns the
+ * events of its nodes (the events whose context is the id of one of its
+ * nodes) in its own scheduler; the events without context belong to
+ * partition 0.
+ *
+ * The partitions advance in time windows. The lookahead is the smallest
+ * Delay attribute of the channels which connect nodes of different
+ * partitions. These must be PointToPointChannels, which hand the
+ * receiving partition a serialized copy of each packet; shared media,
+ * such as CsmaChannel, are rejected when Run starts. All the
+ * partitions run their events earlier than the smallest pending event
+ * time plus the lookahead, then meet at a barrier. An event scheduled by
+ * one partition for a node of another one is written to a mailbox that
+ * only the sending thread writes and only the receiving thread reads,
+ * after the barrier, so that no lock is taken. The receiving partition
+ * takes its mailboxes in partition order, which makes a simulation
+ * deterministic for a given partitioning.
+ *
+ * Stop() and Stop(Time) stop the calling partition at once and the
+ * other partitions at the end of the current time window. The events of
+ * a partition must only touch the state of its own nodes; in
+ * particular, ns-3 reference counts and packet buffers are not thread
+ * safe, so the events which cross partitions must not share them with
+ * the sending partition. The packet and chunk uid counters are shared
+ * by all the partitions, so that the uids stay unique but are not
+ * deterministic.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  MultithreadedSimulatorImpl ();
+  /** Destructor. */
+  ~MultithreadedSimulatorImpl ();
+
+  // Inherited
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &delay);
+  virtual EventId Schedule (Time const &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+  virtual uint64_t GetEventCount (void) const;
+
+  /**
+   * \returns The lookahead of the last call to Run.
+   */
+  Time GetLookAhead (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /** An event sent to another partition. */
+  struct Message
+  {
+    uint64_t m_ts;         /**< Event time. */
+    uint32_t m_context;    /**< Event context. */
+    EventImpl *m_impl;     /**< The event. */
+  };
+
+  /** A partition and the state of the thread running it. */
+  struct Partition
+  {
+    Ptr<Scheduler> m_events;    /**< The events of the partition. */
+    uint32_t m_id;              /**< Partition index. */
+    uint32_t m_uid;             /**< Next event unique id. */
+    uint32_t m_currentUid;      /**< Unique id of the current event. */
+    uint64_t m_currentTs;       /**< Timestamp of the current event. */
+    uint32_t m_currentContext;  /**< Execution context of the current event. */
+    uint64_t m_eventCount;      /**< Number of events executed. */
+    int m_unscheduledEvents;    /**< Events inserted but not yet run, for validation. */
+    /** Events sent to each partition during the current window. */
+    std::vector<std::vector<Message> > m_outbox;
+    uint64_t m_next;            /**< Next event time, published at the barrier. */
+    uint64_t m_stopTs;          /**< Stop time requested by the partition. */
+    bool m_stop;                /**< Whether the partition called Stop(). */
+    /** Pad the partitions to their own cache lines. */
+    char m_pad[64];
+  };
+
+  /** A thread barrier which spins, then yields. */
+  class Barrier
+  {
+  public:
+    /**
+     * Constructor.
+     * \param [in] n The number of threads to wait for.
+     */
+    Barrier (uint32_t n);
+    /** Wait until all the threads reached the barrier. */
+    void Wait (void);
+
+  private:
+    uint32_t m_n;         /**< Number of threads. */
+    uint32_t m_waiting;   /**< Number of threads waiting. */
+    uint32_t m_phase;     /**< Incremented when the threads are released. */
+  };
+
+  /**
+   * \returns The partition of the calling thread while the simulation
+   *          runs, partition 0 otherwise.
+   */
+  uint32_t GetCurrentPartition (void) const;
+  /**
+   * Get the partition which owns a context.
+   * \param [in] context The context.
+   * \returns The partition index.
+   */
+  uint32_t GetPartition (uint32_t context) const;
+  /**
+   * Insert an event in a partition.
+   * \param [in] partition The partition.
+   * \param [in] ts The event time.
+   * \param [in] context The event context.
+   * \param [in] event The event.
+   * \returns The id of the event.
+   */
+  EventId Insert (Partition &partition, uint64_t ts, uint32_t context, EventImpl *event);
+  /** Create the partitions and compute the lookahead. */
+  void CreatePartitions (void);
+  /**
+   * Run the next event of a partition.
+   * \param [in] partition The partition.
+   */
+  void ProcessOneEvent (Partition &partition);
+  /**
+   * Run a partition until the end of the simulation.
+   * \param [in] partition The partition index.
+   */
+  void RunPartition (uint32_t partition);
+  /**
+   * Thread entry point.
+   * \param [in] context The simulator and the partition index.
+   */
+  static void RunThread (std::pair<MultithreadedSimulatorImpl *, uint32_t> context);
+
+  /** Container type for the events to run at Simulator::Destroy() */
+  typedef std::list<EventId> DestroyEvents;
+  /** The container of events to run at Destroy. */
+  DestroyEvents m_destroyEvents;
+  /** Mutex to control access to m_destroyEvents. */
+  SystemMutex m_destroyEventsMutex;
+  /** The partitions. */
+  std::vector<struct Partition> m_partitions;
+  /** Partition of each node. */
+  std::vector<uint32_t> m_nodePartitions;
+  /** Factory of the schedulers of the partitions. */
+  ObjectFactory m_schedulerFactory;
+  /** The barrier of the time windows. */
+  Barrier *m_barrier;
+  /** The lookahead, in time steps. */
+  uint64_t m_lookAhead;
+  /** Stop time set before Run. */
+  uint64_t m_stopTs;
+  /** Simulation time at the end of Run. */
+  uint64_t m_endTs;
+  /** Whether Stop was called. */
+  bool m_stop;
+  /** Whether the partitions run. */
+  bool m_running;
+};
+
+} // namespace ns3
+
+#endif /* NS3_MULTITHREADED_SIMULATOR_IMPL_H */
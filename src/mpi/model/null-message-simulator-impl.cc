@@ -82,6 +82,7 @@ NullMessageSimulatorImpl::NullMessageSimulatorImpl ()
   // before ::Run is entered, the m_currentUid will be zero
   m_currentUid = 0;
   m_currentTs = 0;
+  m_eventCount = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
   m_events = 0;
@@ -240,6 +241,7 @@ NullMessageSimulatorImpl::ProcessOneEvent (void)
   m_currentTs = next.key.m_ts;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
+  m_eventCount++;
   next.impl->Invoke ();
   next.impl->Unref ();
 }
@@ -575,6 +577,12 @@ NullMessageSimulatorImpl::GetContext (void) const
   return m_currentContext;
 }
 
+uint64_t
+NullMessageSimulatorImpl::GetEventCount (void) const
+{
+  return m_eventCount;
+}
+
 Time NullMessageSimulatorImpl::CalculateGuaranteeTime (uint32_t nodeSysId)
 {
   Ptr<RemoteChannelBundle> bundle = RemoteChannelBundleManager::Find (nodeSysId);
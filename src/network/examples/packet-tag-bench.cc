@@ -0,0 +1,244 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <string>
+
+#include "ns3/core-module.h"
+#include "ns3/tag.h"
+#include "ns3/packet.h"
+
+/**
+ * \file
+ * \ingroup packet
+ * Microbenchmarks of the packet tags.
+ *
+ * Extends main-packet-tag.cc to time the packet tag operations of a
+ * packet which already carries \c --tags tags, as the packets of the
+ * wifi and AODV models do:
+ *
+ *   - \c add+remove adds a tag and removes it;
+ *   - \c peek-hit and \c peek-miss look for a tag which is, or is not, on
+ *     the packet;
+ *   - \c replace rewrites one of the tags;
+ *   - \c hop copies the packet, then peeks at two tags, replaces one and
+ *     adds and removes another, as a packet forwarded by a node.
+ *
+ * The program replaces the global operator new and delete to count the
+ * heap allocations of each operation.
+ *
+ * \verbatim
+   ./waf --run="packet-tag-bench --tags=3 --iterations=2000000"
+   \endverbatim
+ */
+
+namespace {
+
+/// Number of calls to the global operator new
+uint64_t g_news = 0;
+
+} // namespace
+
+void *
+operator new (std::size_t size)
+{
+  g_news++;
+  void *p = std::malloc (size == 0 ? 1 : size);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+void
+operator delete (void *p) throw ()
+{
+  std::free (p);
+}
+
+using namespace ns3;
+
+namespace {
+
+/// A tag type per value of N, carrying one byte like MyTag of main-packet-tag.cc
+template <int N>
+class BenchTag : public Tag
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId (GetName ().c_str ())
+      .SetParent<Tag> ()
+      .AddConstructor<BenchTag<N> > ()
+    ;
+    return tid;
+  }
+  virtual TypeId GetInstanceTypeId (void) const
+  {
+    return GetTypeId ();
+  }
+  virtual uint32_t GetSerializedSize (void) const
+  {
+    return 1;
+  }
+  virtual void Serialize (TagBuffer i) const
+  {
+    i.WriteU8 (m_value);
+  }
+  virtual void Deserialize (TagBuffer i)
+  {
+    m_value = i.ReadU8 ();
+  }
+  virtual void Print (std::ostream &os) const
+  {
+    os << "v=" << (uint32_t)m_value;
+  }
+  BenchTag (uint8_t value = 0)
+    : m_value (value)
+  {
+  }
+  uint8_t GetValue (void) const
+  {
+    return m_value;
+  }
+
+private:
+  static std::string GetName (void)
+  {
+    std::ostringstream oss;
+    oss << "ns3::BenchTag" << N;
+    return oss.str ();
+  }
+  uint8_t m_value;
+};
+
+/// Add the tags N to n - 1 to the packet
+template <int N>
+void
+AddTags (Ptr<Packet> p, uint32_t n)
+{
+  if (uint32_t (N) < n)
+    {
+      p->AddPacketTag (BenchTag<N> (N));
+      AddTags<N + 1> (p, n);
+    }
+}
+
+/// End of the recursion: BenchTag<8> and BenchTag<9> are never added
+template <>
+void
+AddTags<8> (Ptr<Packet> p, uint32_t n)
+{
+}
+
+/// Print one measurement
+void
+Report (std::string name, clock_t start, uint64_t news, uint64_t iterations, uint64_t sum)
+{
+  double ns = double (clock () - start) / CLOCKS_PER_SEC * 1e9 / iterations;
+  std::cout << std::left << std::setw (12) << name << std::right
+            << std::fixed << std::setprecision (1) << std::setw (10) << ns << " ns/op"
+            << std::setprecision (2) << std::setw (8) << double (g_news - news) / iterations << " allocs/op"
+            << "  (" << sum << ")" << std::endl;
+}
+
+} // namespace
+
+int main (int argc, char *argv[])
+{
+  uint32_t tags = 3;
+  uint64_t iterations = 1000000;
+
+  CommandLine cmd;
+  cmd.AddValue ("tags", "Number of tags already on the packet, up to 7", tags);
+  cmd.AddValue ("iterations", "Number of operations timed", iterations);
+  cmd.Parse (argc, argv);
+  tags = std::min<uint32_t> (tags, 7);
+
+  Ptr<Packet> p = Create<Packet> (100);
+  AddTags<0> (p, tags);
+  // a tag added and removed by the loops, and one which is never added
+  BenchTag<8> extra (8);
+  BenchTag<9> missing;
+  uint64_t sum = 0;
+
+  std::cout << "packet tags: " << tags << std::endl;
+
+  clock_t start = clock ();
+  uint64_t news = g_news;
+  for (uint64_t i = 0; i < iterations; i++)
+    {
+      p->AddPacketTag (extra);
+      sum += p->RemovePacketTag (extra);
+    }
+  Report ("add+remove", start, news, iterations, sum);
+
+  // peek at the oldest and the newest tags
+  BenchTag<0> first;
+  p->AddPacketTag (extra);
+  sum = 0;
+  start = clock ();
+  news = g_news;
+  for (uint64_t i = 0; i < iterations; i++)
+    {
+      sum += p->PeekPacketTag (first) ? 1 : 0;
+      sum += p->PeekPacketTag (extra) ? 1 : 0;
+    }
+  Report ("peek-hit", start, news, 2 * iterations, sum);
+
+  sum = 0;
+  start = clock ();
+  news = g_news;
+  for (uint64_t i = 0; i < iterations; i++)
+    {
+      sum += p->PeekPacketTag (missing) ? 1 : 0;
+    }
+  Report ("peek-miss", start, news, iterations, sum);
+
+  sum = 0;
+  start = clock ();
+  news = g_news;
+  for (uint64_t i = 0; i < iterations; i++)
+    {
+      BenchTag<8> value (i & 0xff);
+      sum += p->ReplacePacketTag (value);
+    }
+  Report ("replace", start, news, iterations, sum);
+  p->RemovePacketTag (extra);
+
+  sum = 0;
+  start = clock ();
+  news = g_news;
+  for (uint64_t i = 0; i < iterations; i++)
+    {
+      Ptr<Packet> copy = p->Copy ();
+      sum += copy->PeekPacketTag (missing) ? 1 : 0;
+      sum += copy->PeekPacketTag (first) ? first.GetValue () + 1 : 0;
+      copy->AddPacketTag (extra);
+      BenchTag<8> value (i & 0xff);
+      copy->ReplacePacketTag (value);
+      sum += copy->RemovePacketTag (extra);
+    }
+  Report ("hop", start, news, iterations, sum);
+
+  return 0;
+}
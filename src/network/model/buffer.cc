@@ -21,6 +21,8 @@
 #include "ns3/assert.h"
 #include "ns3/log.h"
 
+#include <algorithm>
+
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
                 ", zero end="<<m_zeroAreaEnd<<", count="<<m_data->m_count<<", size="<<m_data->m_size<<   \
@@ -50,48 +52,22 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
-uint32_t Buffer::g_recommendedStart = 0;
+__thread uint32_t Buffer::g_recommendedStart = 0;
 #ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
- */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
+namespace {
+
+/** Free lists of the buffer data of the calling thread. */
+__thread SizeClassPool::Lists g_freeLists;
+
+} // anonymous namespace
+
 struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
 
 Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
 {
   NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
-    {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
-        {
-          Buffer::Deallocate (*i);
-        }
-      delete g_freeList;
-      g_freeList = DESTROYED;
-    }
+  // the buffers destroyed after this point go back to the heap
+  SizeClassPool::Release (g_freeLists, true);
 }
 
 void
@@ -99,49 +75,39 @@ Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
-    {
-      Buffer::Deallocate (data);
-    }
-  else
-    {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
-    }
+  SizeClassPool::Free (g_freeLists, data, sizeof (struct Buffer::Data) - 1 + data->m_size);
 }
 
 Buffer::Data *
 Buffer::Create (uint32_t dataSize)
 {
   NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
-    {
-      g_freeList = new Buffer::FreeList ();
-    }
-  else if (IS_INITIALIZED (g_freeList))
-    {
-      while (!g_freeList->empty ()) 
-        {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
-        }
-    }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
-  NS_ASSERT (data->m_count == 1);
+  // the whole block of the size class is usable
+  uint32_t size = SizeClassPool::GetBlockSize (sizeof (struct Buffer::Data) - 1 + std::max<uint32_t> (dataSize, 1));
+  struct Buffer::Data *data = static_cast<struct Buffer::Data *> (SizeClassPool::Allocate (g_freeLists, size));
+  data->m_size = size - (sizeof (struct Buffer::Data) - 1);
+  data->m_count = 1;
   return data;
 }
+
+SizeClassPool::Stats
+Buffer::GetFreeListStats (void)
+{
+  return g_freeLists.m_stats;
+}
+
+void
+Buffer::ResetFreeListStats (void)
+{
+  SizeClassPool::ResetStats (g_freeLists);
+}
+
+void
+Buffer::ReleaseFreeLists (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  SizeClassPool::Release (g_freeLists, false);
+}
 #else /* BUFFER_FREE_LIST */
 void
 Buffer::Recycle (struct Buffer::Data *data)
@@ -157,6 +123,23 @@ Buffer::Create (uint32_t size)
   NS_LOG_FUNCTION (size);
   return Allocate (size);
 }
+
+SizeClassPool::Stats
+Buffer::GetFreeListStats (void)
+{
+  SizeClassPool::Stats stats = { 0, 0, 0, 0, 0, 0, 0 };
+  return stats;
+}
+
+void
+Buffer::ResetFreeListStats (void)
+{
+}
+
+void
+Buffer::ReleaseFreeLists (void)
+{
+}
 #endif /* BUFFER_FREE_LIST */
 
 struct Buffer::Data *
@@ -244,7 +227,8 @@ void
 Buffer::Initialize (uint32_t zeroSize)
 {
   NS_LOG_FUNCTION (this << zeroSize);
-  m_data = Buffer::Create (0);
+  // leave room for as many header bytes as the buffers needed so far
+  m_data = Buffer::Create (g_recommendedStart);
   m_start = std::min (m_data->m_size, g_recommendedStart);
   m_maxZeroAreaStart = m_start;
   m_zeroAreaStart = m_start;
@@ -24,6 +24,7 @@
 #include <vector>
 #include <ostream>
 #include "ns3/assert.h"
+#include "ns3/size-class-pool.h"
 
 #define BUFFER_FREE_LIST 1
 
@@ -381,6 +382,18 @@ public:
      */
     uint32_t GetRemainingSize (void) const;
 
+    /**
+     * \param [in] size The number of bytes.
+     * \returns A pointer to the \pname{size} bytes which follow the
+     *          iterator, or 0 if they extend past the end of the buffer
+     *          or into its virtual zero area.
+     *
+     * The iterator does not move.  This checks the bounds of a span of
+     * bytes once, so that a FixedSizeHeader can then write or read them
+     * without the checks of the other methods.
+     */
+    inline uint8_t *PeekContiguous (uint32_t size);
+
 private:
     friend class Buffer;
     /**
@@ -641,6 +654,26 @@ private:
    */
   Buffer (uint32_t dataSize, bool initialize);
   ~Buffer ();
+
+  /**
+   * \name Buffer data free lists
+   *
+   * The data of the buffers is allocated from free lists of size classes,
+   * one set of lists per thread; see SizeClassPool.
+   */
+  /**@{*/
+  /**
+   * \returns The counters of the free lists of the calling thread.
+   */
+  static SizeClassPool::Stats GetFreeListStats (void);
+  /** Reset the counters of the free lists of the calling thread. */
+  static void ResetFreeListStats (void);
+  /**
+   * Return the memory kept by the free lists of the calling thread to the
+   * heap, for instance before the thread exits.
+   */
+  static void ReleaseFreeLists (void);
+  /**@}*/
 private:
   /**
    * This data structure is variable-sized through its last member whose size
@@ -764,9 +797,9 @@ private:
   /**
    * location in a newly-allocated buffer where you should start
    * writing data. i.e., m_start should be initialized to this 
-   * value.
+   * value. Each thread learns its own value.
    */
-  static uint32_t g_recommendedStart;
+  static __thread uint32_t g_recommendedStart;
 
   /**
    * offset to the start of the virtual zero area from the start
@@ -790,15 +823,11 @@ private:
   uint32_t m_end;
 
 #ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
   /// Local static destructor structure
   struct LocalStaticDestructor 
   {
     ~LocalStaticDestructor ();
   };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
   static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
 #endif
 };
@@ -864,6 +893,24 @@ Buffer::Iterator::Prev (uint32_t delta)
   NS_ASSERT (m_current >= delta);
   m_current -= delta;
 }
+uint8_t *
+Buffer::Iterator::PeekContiguous (uint32_t size)
+{
+  if (m_current + size > m_dataEnd)
+    {
+      return 0;
+    }
+  if (m_current + size <= m_zeroStart || m_zeroStart == m_zeroEnd)
+    {
+      return &m_data[m_current];
+    }
+  if (m_current >= m_zeroEnd)
+    {
+      return &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+    }
+  return 0;
+}
+
 void
 Buffer::Iterator::WriteU8 (uint8_t data)
 {
@@ -18,12 +18,12 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "byte-tag-list.h"
+#include "ns3/size-class-pool.h"
 #include "ns3/log.h"
-#include <vector>
+#include <algorithm>
 #include <cstring>
 
 #define USE_FREE_LIST 1
-#define FREE_LIST_SIZE 1000
 #define OFFSET_MAX (2147483647)
 
 namespace ns3 {
@@ -45,30 +45,27 @@ struct ByteTagListData {
 };
 
 #ifdef USE_FREE_LIST
+namespace {
+
+/** Free lists of the byte tag data of the calling thread. */
+__thread SizeClassPool::Lists g_freeLists;
+
 /**
  * \ingroup packet
  *
- * \brief Container class for struct ByteTagListData
+ * \brief Return the free lists to the heap at exit.
  *
- * Internal use only.
+ * The lists destroyed after this point free their data to the heap.
  */
-static class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
+struct ByteTagListDataFreeList
 {
-public:
-  ~ByteTagListDataFreeList ();
-} g_freeList; //!< Container for struct ByteTagListData
-static uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
+  ~ByteTagListDataFreeList ()
+  {
+    SizeClassPool::Release (g_freeLists, true);
+  }
+} g_freeList; //!< Releases the free lists at exit.
 
-ByteTagListDataFreeList::~ByteTagListDataFreeList ()
-{
-  NS_LOG_FUNCTION (this);
-  for (ByteTagListDataFreeList::iterator i = begin ();
-       i != end (); i++)
-    {
-      uint8_t *buffer = (uint8_t *)(*i);
-      delete [] buffer;
-    }
-}
+} // anonymous namespace
 #endif /* USE_FREE_LIST */
 
 ByteTagList::Iterator::Item::Item (TagBuffer buf_)
@@ -344,24 +341,12 @@ struct ByteTagListData *
 ByteTagList::Allocate (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
-  while (!g_freeList.empty ())
-    {
-      struct ByteTagListData *data = g_freeList.back ();
-      g_freeList.pop_back ();
-      NS_ASSERT (data != 0);
-      if (data->size >= size)
-        {
-          data->count = 1;
-          data->dirty = 0;
-          return data;
-        }
-      uint8_t *buffer = (uint8_t *)data;
-      delete [] buffer;
-    }
-  uint8_t *buffer = new uint8_t [std::max (size, g_maxSize) + sizeof (struct ByteTagListData) - 4];
-  struct ByteTagListData *data = (struct ByteTagListData *)buffer;
+  // the data takes the whole block of its size class, so that the list
+  // can grow in place
+  uint32_t block = SizeClassPool::GetBlockSize (size + sizeof (struct ByteTagListData) - 4);
+  struct ByteTagListData *data = static_cast<struct ByteTagListData *> (SizeClassPool::Allocate (g_freeLists, block));
   data->count = 1;
-  data->size = size;
+  data->size = block - (sizeof (struct ByteTagListData) - 4);
   data->dirty = 0;
   return data;
 }
@@ -374,20 +359,10 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
     {
       return;
     }
-  g_maxSize = std::max (g_maxSize, data->size);
   data->count--;
   if (data->count == 0)
     {
-      if (g_freeList.size () > FREE_LIST_SIZE ||
-          data->size < g_maxSize)
-        {
-          uint8_t *buffer = (uint8_t *)data;
-          delete [] buffer;
-        }
-      else
-        {
-          g_freeList.push_back (data);
-        }
+      SizeClassPool::Free (g_freeLists, data, data->size + sizeof (struct ByteTagListData) - 4);
     }
 }
 
@@ -0,0 +1,279 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FIXED_SIZE_HEADER_H
+#define FIXED_SIZE_HEADER_H
+
+#include "header.h"
+#include "buffer.h"
+#include <stdint.h>
+#include <cstring>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ * \brief Writes the fields of a FixedSizeHeader into contiguous bytes.
+ *
+ * The methods have the names and byte orders of those of
+ * Buffer::Iterator, so that a header writes its fields with the same
+ * code into either, but they check neither bounds nor the virtual zero
+ * area: FixedSizeHeader::SerializeFixed checked the whole span once.
+ */
+class FixedSizeWriter
+{
+public:
+  /**
+   * \param [in] start The first of the bytes to write.
+   */
+  explicit FixedSizeWriter (uint8_t *start)
+    : m_current (start)
+  {
+  }
+  /**
+   * \param [in] delta The number of bytes to skip.
+   */
+  void Next (uint32_t delta)
+  {
+    m_current += delta;
+  }
+  /**
+   * \param [in] data The byte to write.
+   */
+  void WriteU8 (uint8_t data)
+  {
+    *m_current++ = data;
+  }
+  /**
+   * \param [in] data The byte to write.
+   * \param [in] len The number of times to write it.
+   */
+  void WriteU8 (uint8_t data, uint32_t len)
+  {
+    std::memset (m_current, data, len);
+    m_current += len;
+  }
+  /**
+   * \param [in] data The value to write, least significant byte first
+   *        as Buffer::Iterator::WriteU16 does.
+   */
+  void WriteU16 (uint16_t data)
+  {
+    m_current[0] = data & 0xff;
+    m_current[1] = (data >> 8) & 0xff;
+    m_current += 2;
+  }
+  /**
+   * \param [in] data The value to write in network order.
+   */
+  void WriteHtonU16 (uint16_t data)
+  {
+    m_current[0] = (data >> 8) & 0xff;
+    m_current[1] = data & 0xff;
+    m_current += 2;
+  }
+  /**
+   * \param [in] data The value to write in network order.
+   */
+  void WriteHtonU32 (uint32_t data)
+  {
+    m_current[0] = (data >> 24) & 0xff;
+    m_current[1] = (data >> 16) & 0xff;
+    m_current[2] = (data >> 8) & 0xff;
+    m_current[3] = data & 0xff;
+    m_current += 4;
+  }
+  /**
+   * \param [in] buffer The bytes to write.
+   * \param [in] size The number of bytes.
+   */
+  void Write (uint8_t const *buffer, uint32_t size)
+  {
+    std::memcpy (m_current, buffer, size);
+    m_current += size;
+  }
+
+private:
+  uint8_t *m_current;  //!< The next byte to write.
+};
+
+/**
+ * \ingroup packet
+ * \brief Reads the fields of a FixedSizeHeader from contiguous bytes.
+ *
+ * The reading counterpart of FixedSizeWriter.
+ */
+class FixedSizeReader
+{
+public:
+  /**
+   * \param [in] start The first of the bytes to read.
+   */
+  explicit FixedSizeReader (uint8_t const *start)
+    : m_current (start)
+  {
+  }
+  /**
+   * \param [in] delta The number of bytes to skip.
+   */
+  void Next (uint32_t delta)
+  {
+    m_current += delta;
+  }
+  /**
+   * \returns The byte read.
+   */
+  uint8_t ReadU8 (void)
+  {
+    return *m_current++;
+  }
+  /**
+   * \returns The value read, least significant byte first as
+   *          Buffer::Iterator::ReadU16 does.
+   */
+  uint16_t ReadU16 (void)
+  {
+    uint16_t data = m_current[0] | (m_current[1] << 8);
+    m_current += 2;
+    return data;
+  }
+  /**
+   * \returns The value read in network order.
+   */
+  uint16_t ReadNtohU16 (void)
+  {
+    uint16_t data = (m_current[0] << 8) | m_current[1];
+    m_current += 2;
+    return data;
+  }
+  /**
+   * \returns The value read in network order.
+   */
+  uint32_t ReadNtohU32 (void)
+  {
+    uint32_t data = (static_cast<uint32_t> (m_current[0]) << 24)
+      | (static_cast<uint32_t> (m_current[1]) << 16)
+      | (static_cast<uint32_t> (m_current[2]) << 8)
+      | m_current[3];
+    m_current += 4;
+    return data;
+  }
+  /**
+   * \param [out] buffer The bytes read.
+   * \param [in] size The number of bytes.
+   */
+  void Read (uint8_t *buffer, uint32_t size)
+  {
+    std::memcpy (buffer, m_current, size);
+    m_current += size;
+  }
+
+private:
+  uint8_t const *m_current;  //!< The next byte to read.
+};
+
+/**
+ * \ingroup packet
+ * \brief A Header whose serialized size is known at compile time.
+ *
+ * \tparam T The header class, deriving from FixedSizeHeader<T, SIZE>.
+ * \tparam SIZE The serialized size of T.
+ *
+ * T declares its fields once, in two member templates which
+ * SerializeFixed and DeserializeFixed instantiate:
+ *
+ * \code
+ *   template <typename W>
+ *   void SerializeFields (W &i, Buffer::Iterator start) const;
+ *   template <typename R>
+ *   uint32_t DeserializeFields (R &i, Buffer::Iterator start);
+ * \endcode
+ *
+ * The first writes the fields with \c i, the second reads them and
+ * returns the number of bytes deserialized.  \c start points to the
+ * header in the buffer, for the fields which depend on the rest of the
+ * packet, like lengths and checksums.  The Serialize and Deserialize
+ * methods of T call SerializeFixed and DeserializeFixed, so that the
+ * member templates are only instantiated in the file which defines
+ * them.
+ *
+ * When the SIZE bytes of the header are stored contiguously, which is
+ * the case of the bytes added by Packet::AddHeader, \c i is a
+ * FixedSizeWriter or a FixedSizeReader: the bounds are checked once,
+ * and the fields are plain stores and loads the compiler can merge.
+ * Otherwise, when the header extends into the virtual zero area of the
+ * buffer or past its end, \c i is a copy of \c start, whose methods
+ * check each byte as usual.
+ */
+template <typename T, uint32_t SIZE>
+class FixedSizeHeader : public Header
+{
+public:
+  /** The serialized size of T. */
+  static const uint32_t SERIALIZED_SIZE = SIZE;
+
+  virtual uint32_t GetSerializedSize (void) const
+  {
+    return SIZE;
+  }
+
+protected:
+  /**
+   * Write the fields of T.
+   * \param [in] start An iterator which points to where the header
+   *        should be written.
+   */
+  void SerializeFixed (Buffer::Iterator start) const
+  {
+    const T *header = static_cast<const T *> (this);
+    uint8_t *data = start.PeekContiguous (SIZE);
+    if (data != 0)
+      {
+        FixedSizeWriter i (data);
+        header->SerializeFields (i, start);
+      }
+    else
+      {
+        Buffer::Iterator i = start;
+        header->SerializeFields (i, start);
+      }
+  }
+  /**
+   * Read the fields of T.
+   * \param [in] start An iterator which points to where the header
+   *        should be read from.
+   * \returns The number of bytes read.
+   */
+  uint32_t DeserializeFixed (Buffer::Iterator start)
+  {
+    T *header = static_cast<T *> (this);
+    uint8_t *data = start.PeekContiguous (SIZE);
+    if (data != 0)
+      {
+        FixedSizeReader i (data);
+        return header->DeserializeFields (i, start);
+      }
+    Buffer::Iterator i = start;
+    return header->DeserializeFields (i, start);
+  }
+};
+
+template <typename T, uint32_t SIZE>
+const uint32_t FixedSizeHeader<T, SIZE>::SERIALIZED_SIZE;
+
+} // namespace ns3
+
+#endif /* FIXED_SIZE_HEADER_H */
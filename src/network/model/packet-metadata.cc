@@ -19,6 +19,7 @@
  */
 #include <utility>
 #include <list>
+#include <algorithm>
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
@@ -34,18 +35,41 @@ NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
 bool PacketMetadata::m_metadataSkipped = false;
-uint32_t PacketMetadata::m_maxSize = 0;
+uint64_t PacketMetadata::m_sampleThreshold = static_cast<uint64_t> (1) << 32;
 uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+struct PacketMetadata::LocalStaticDestructor PacketMetadata::g_localStaticDestructor;
 
-PacketMetadata::DataFreeList::~DataFreeList ()
+namespace {
+
+/** Free lists of the metadata storage of the calling thread. */
+__thread SizeClassPool::Lists g_freeLists;
+
+} // anonymous namespace
+
+PacketMetadata::LocalStaticDestructor::~LocalStaticDestructor ()
 {
   NS_LOG_FUNCTION (this);
-  for (iterator i = begin (); i != end (); i++)
-    {
-      PacketMetadata::Deallocate (*i);
-    }
-  PacketMetadata::m_enable = false;
+  // the metadata destroyed after this point goes back to the heap
+  SizeClassPool::Release (g_freeLists, true);
+}
+
+SizeClassPool::Stats
+PacketMetadata::GetFreeListStats (void)
+{
+  return g_freeLists.m_stats;
+}
+
+void
+PacketMetadata::ResetFreeListStats (void)
+{
+  SizeClassPool::ResetStats (g_freeLists);
+}
+
+void
+PacketMetadata::ReleaseFreeLists (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  SizeClassPool::Release (g_freeLists, false);
 }
 
 void 
@@ -70,6 +94,26 @@ PacketMetadata::EnableChecking (void)
   m_enableChecking = true;
 }
 
+void
+PacketMetadata::EnableSampling (double fraction)
+{
+  NS_LOG_FUNCTION (fraction);
+  NS_ASSERT_MSG (fraction >= 0 && fraction <= 1, "Invalid sampled fraction " << fraction);
+  Enable ();
+  m_sampleThreshold = static_cast<uint64_t> (fraction * (static_cast<uint64_t> (1) << 32));
+}
+
+void
+PacketMetadata::Record (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_data == 0)
+    {
+      m_data = PacketMetadata::Create (10);
+      memset (m_data->m_data, 0xff, 4);
+    }
+}
+
 void
 PacketMetadata::ReserveCopy (uint32_t size)
 {
@@ -133,6 +177,10 @@ bool
 PacketMetadata::IsStateOk (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_data == 0)
+    {
+      return m_head == 0xffff && m_tail == 0xffff && m_used == 0;
+    }
   bool ok = m_used <= m_data->m_size;
   ok &= IsPointerOk (m_head);
   ok &= IsPointerOk (m_tail);
@@ -571,73 +619,23 @@ struct PacketMetadata::Data *
 PacketMetadata::Create (uint32_t size)
 {
   NS_LOG_FUNCTION (size);
-  NS_LOG_LOGIC ("create size="<<size<<", max="<<m_maxSize);
-  if (size > m_maxSize)
-    {
-      m_maxSize = size;
-    }
-  while (!m_freeList.empty ()) 
-    {
-      struct PacketMetadata::Data *data = m_freeList.back ();
-      m_freeList.pop_back ();
-      if (data->m_size >= size) 
-        {
-          NS_LOG_LOGIC ("create found size="<<data->m_size);
-          data->m_count = 1;
-          return data;
-        }
-      PacketMetadata::Deallocate (data);
-      NS_LOG_LOGIC ("create dealloc size="<<data->m_size);
-    }
-  NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
-  return PacketMetadata::Allocate (m_maxSize);
+  // the whole block of the size class is usable
+  uint32_t header = sizeof (struct Data) - PACKET_METADATA_DATA_M_DATA_SIZE;
+  uint32_t block = SizeClassPool::GetBlockSize (header + std::max<uint32_t> (size, PACKET_METADATA_DATA_M_DATA_SIZE));
+  struct PacketMetadata::Data *data = static_cast<struct PacketMetadata::Data *> (SizeClassPool::Allocate (g_freeLists, block));
+  data->m_size = block - header;
+  data->m_count = 1;
+  data->m_dirtyEnd = 0;
+  NS_LOG_LOGIC ("create size="<<size<<", allocated="<<data->m_size);
+  return data;
 }
 
 void
 PacketMetadata::Recycle (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  if (!m_enable)
-    {
-      PacketMetadata::Deallocate (data);
-      return;
-    } 
-  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
   NS_ASSERT (data->m_count == 0);
-  if (m_freeList.size () > 1000 ||
-      data->m_size < m_maxSize) 
-    {
-      PacketMetadata::Deallocate (data);
-    } 
-  else 
-    {
-      m_freeList.push_back (data);
-    }
-}
-
-struct PacketMetadata::Data *
-PacketMetadata::Allocate (uint32_t n)
-{
-  NS_LOG_FUNCTION (n);
-  uint32_t size = sizeof (struct Data);
-  if (n <= PACKET_METADATA_DATA_M_DATA_SIZE)
-    {
-      n = PACKET_METADATA_DATA_M_DATA_SIZE;
-    }
-  size += n - PACKET_METADATA_DATA_M_DATA_SIZE;
-  uint8_t *buf = new uint8_t [size];
-  struct PacketMetadata::Data *data = (struct PacketMetadata::Data *)buf;
-  data->m_size = n;
-  data->m_count = 1;
-  data->m_dirtyEnd = 0;
-  return data;
-}
-void 
-PacketMetadata::Deallocate (struct PacketMetadata::Data *data)
-{
-  NS_LOG_FUNCTION (data);
-  uint8_t *buf = (uint8_t *)data;
-  delete [] buf;
+  SizeClassPool::Free (g_freeLists, data, sizeof (struct Data) - PACKET_METADATA_DATA_M_DATA_SIZE + data->m_size);
 }
 
 
@@ -652,7 +650,7 @@ PacketMetadata::CreateFragment (uint32_t start, uint32_t end) const
 }
 
 void 
-PacketMetadata::AddHeader (const Header &header, uint32_t size)
+PacketMetadata::DoAddHeader (const Header &header, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &header << size);
   NS_ASSERT (IsStateOk ());
@@ -664,33 +662,21 @@ void
 PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
 {
   NS_LOG_FUNCTION (this << uid << size);
-  if (!m_enable)
-    {
-      m_metadataSkipped = true;
-      return;
-    }
-
   struct PacketMetadata::SmallItem item;
   item.next = m_head;
   item.prev = 0xffff;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = __atomic_fetch_add (&m_chunkUid, 1, __ATOMIC_RELAXED);
   uint16_t written = AddSmall (&item);
   UpdateHead (written);
 }
 void 
-PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
+PacketMetadata::DoRemoveHeader (const Header &header, uint32_t size)
 {
   uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &header << size);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
-    {
-      m_metadataSkipped = true;
-      return;
-    }
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_head, &item, &extraItem);
@@ -729,38 +715,33 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
   NS_ASSERT (IsStateOk ());
 }
 void 
-PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
+PacketMetadata::DoAddTrailer (const Trailer &trailer, uint32_t size)
 {
   uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &trailer << size);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable)
-    {
-      m_metadataSkipped = true;
-      return;
-    }
+  DoAddTrailer (uid, size);
+  NS_ASSERT (IsStateOk ());
+}
+void
+PacketMetadata::DoAddTrailer (uint32_t uid, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << uid << size);
   struct PacketMetadata::SmallItem item;
   item.next = 0xffff;
   item.prev = m_tail;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = __atomic_fetch_add (&m_chunkUid, 1, __ATOMIC_RELAXED);
   uint16_t written = AddSmall (&item);
   UpdateTail (written);
-  NS_ASSERT (IsStateOk ());
 }
 void 
-PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
+PacketMetadata::DoRemoveTrailer (const Trailer &trailer, uint32_t size)
 {
   uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &trailer << size);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
-    {
-      m_metadataSkipped = true;
-      return;
-    }
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_tail, &item, &extraItem);
@@ -799,13 +780,18 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
   NS_ASSERT (IsStateOk ());
 }
 void
-PacketMetadata::AddAtEnd (PacketMetadata const&o)
+PacketMetadata::DoAddAtEnd (PacketMetadata const&o, uint32_t size)
 {
-  NS_LOG_FUNCTION (this << &o);
+  NS_LOG_FUNCTION (this << &o << size);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (o.m_data == 0)
     {
-      m_metadataSkipped = true;
+      // the packet appended was not sampled: its bytes are payload
+      if (size > 0)
+        {
+          DoAddTrailer (0, size);
+        }
+      NS_ASSERT (IsStateOk ());
       return;
     }
   if (m_tail == 0xffff)
@@ -876,26 +862,11 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
     }
   NS_ASSERT (IsStateOk ());
 }
-void
-PacketMetadata::AddPaddingAtEnd (uint32_t end)
-{
-  NS_LOG_FUNCTION (this << end);
-  if (!m_enable)
-    {
-      m_metadataSkipped = true;
-      return;
-    }
-}
 void 
-PacketMetadata::RemoveAtStart (uint32_t start)
+PacketMetadata::DoRemoveAtStart (uint32_t start)
 {
   NS_LOG_FUNCTION (this << start);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
-    {
-      m_metadataSkipped = true;
-      return;
-    }
   NS_ASSERT (m_data != 0);
   uint32_t leftToRemove = start;
   uint16_t current = m_head;
@@ -923,6 +894,7 @@ PacketMetadata::RemoveAtStart (uint32_t start)
         {
           // fragment the list item.
           PacketMetadata fragment (m_packetUid, 0);
+          fragment.Record ();
           extraItem.fragmentStart += leftToRemove;
           leftToRemove = 0;
           uint16_t written = fragment.AddBig (0xffff, fragment.m_tail,
@@ -950,15 +922,10 @@ PacketMetadata::RemoveAtStart (uint32_t start)
   NS_ASSERT (IsStateOk ());
 }
 void 
-PacketMetadata::RemoveAtEnd (uint32_t end)
+PacketMetadata::DoRemoveAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
-    {
-      m_metadataSkipped = true;
-      return;
-    }
   NS_ASSERT (m_data != 0);
 
   uint32_t leftToRemove = end;
@@ -987,6 +954,7 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
         {
           // fragment the list item.
           PacketMetadata fragment (m_packetUid, 0);
+          fragment.Record ();
           NS_ASSERT (extraItem.fragmentEnd > leftToRemove);
           extraItem.fragmentEnd -= leftToRemove;
           leftToRemove = 0;
@@ -1330,6 +1298,7 @@ PacketMetadata::Deserialize (const uint8_t* buffer, uint32_t size)
                     ", size="<<item.size<<", chunkUid="<<item.chunkUid<<
                     ", fragmentStart="<<extraItem.fragmentStart<<", fragmentEnd="<<
                     extraItem.fragmentEnd<< ", packetUid="<<extraItem.packetUid);
+      Record ();
       uint32_t tmp = AddBig (0xffff, m_tail, &item, &extraItem);
       UpdateTail (tmp);
     }
@@ -26,6 +26,7 @@
 #include "ns3/callback.h"
 #include "ns3/assert.h"
 #include "ns3/type-id.h"
+#include "ns3/size-class-pool.h"
 #include "buffer.h"
 
 namespace ns3 {
@@ -74,6 +75,11 @@ class Trailer;
  * integers, and some others as variable-size 32-bit integers.
  * The variable-size 32 bit integers are stored using the uleb128
  * encoding.
+ *
+ * Only the packets created while the metadata is enabled, or a sample
+ * of them (see EnableSampling), record their items.  The others have
+ * no storage at all, and the methods which record an operation return
+ * after an inline test of the storage pointer.
  */
 class PacketMetadata 
 {
@@ -159,6 +165,39 @@ private:
    * \brief Enable the packet metadata checking
    */
   static void EnableChecking (void);
+  /**
+   * \brief Enable the packet metadata of a sample of the packets
+   *
+   * Record the metadata of a fraction of the packets created from now
+   * on.  The packets are sampled from their uid, without drawing random
+   * numbers, so that a simulation creates and samples the same packets
+   * whatever the fraction.  The fragments and copies of a packet record
+   * metadata if the packet does, and the packets appended to it are
+   * recorded as payload if they do not.
+   *
+   * \param [in] fraction The fraction of the packets sampled, in [0, 1].
+   */
+  static void EnableSampling (double fraction);
+
+  /**
+   * \name Metadata free lists
+   *
+   * The metadata storage is allocated from free lists of size classes,
+   * one set of lists per thread; see SizeClassPool.
+   */
+  /**@{*/
+  /**
+   * \returns The counters of the free lists of the calling thread.
+   */
+  static SizeClassPool::Stats GetFreeListStats (void);
+  /** Reset the counters of the free lists of the calling thread. */
+  static void ResetFreeListStats (void);
+  /**
+   * Return the memory kept by the free lists of the calling thread to the
+   * heap, for instance before the thread exits.
+   */
+  static void ReleaseFreeLists (void);
+  /**@}*/
 
   /**
    * \brief Constructor
@@ -179,31 +218,38 @@ private:
   inline PacketMetadata &operator = (PacketMetadata const& o);
   inline ~PacketMetadata ();
 
+  /**
+   * \returns true if this metadata records the operations on the packet,
+   *          false if the metadata is disabled or the packet was not
+   *          sampled.
+   */
+  inline bool IsRecording (void) const;
+
   /**
    * \brief Add an header
    * \param header header to add
    * \param size header serialized size
    */
-  void AddHeader (Header const &header, uint32_t size);
+  inline void AddHeader (Header const &header, uint32_t size);
   /**
    * \brief Remove an header
    * \param header header to remove
    * \param size header serialized size
    */
-  void RemoveHeader (Header const &header, uint32_t size);
+  inline void RemoveHeader (Header const &header, uint32_t size);
 
   /**
    * Add a trailer
    * \param trailer trailer to add
    * \param size trailer serialized size
    */
-  void AddTrailer (Trailer const &trailer, uint32_t size);
+  inline void AddTrailer (Trailer const &trailer, uint32_t size);
   /**
    * Remove a trailer
    * \param trailer trailer to remove
    * \param size trailer serialized size
    */
-  void RemoveTrailer (Trailer const &trailer, uint32_t size);
+  inline void RemoveTrailer (Trailer const &trailer, uint32_t size);
 
   /**
    * \brief Creates a fragment.
@@ -218,25 +264,27 @@ private:
   PacketMetadata CreateFragment (uint32_t start, uint32_t end) const;
 
   /**
-   * \brief Add a metadata at the metadata start
+   * \brief Add a metadata at the metadata end
    * \param o the metadata to add
+   * \param size the size of the packet of \p o, recorded as payload if
+   *        \p o does not record its items
    */
-  void AddAtEnd (PacketMetadata const&o);
+  inline void AddAtEnd (PacketMetadata const&o, uint32_t size);
   /**
    * \brief Add some padding at the end
    * \param end size of padding
    */
-  void AddPaddingAtEnd (uint32_t end);
+  inline void AddPaddingAtEnd (uint32_t end);
   /**
    * \brief Remove a chunk of metadata at the metadata start
    * \param start the size of metadata to remove
    */
-  void RemoveAtStart (uint32_t start);
+  inline void RemoveAtStart (uint32_t start);
   /**
    * \brief Remove a chunk of metadata at the metadata end
    * \param end the size of metadata to remove
    */
-  void RemoveAtEnd (uint32_t end);
+  inline void RemoveAtEnd (uint32_t end);
 
   /**
    * \brief Get the packet Uid
@@ -491,16 +539,12 @@ private:
     uint64_t packetUid;
   };
 
-  /**
-   * \brief Class to hold all the metadata
-   */
-  class DataFreeList : public std::vector<struct Data *>
+  /// Local static destructor structure
+  struct LocalStaticDestructor
   {
-public:
-    ~DataFreeList ();
+    ~LocalStaticDestructor ();
   };
 
-  friend DataFreeList::~DataFreeList ();
   friend class ItemIterator;
 
   PacketMetadata ();
@@ -615,6 +659,67 @@ public:
    * \param size header serialized size
    */
   void DoAddHeader (uint32_t uid, uint32_t size);
+  /**
+   * \brief Add a trailer
+   * \param uid trailer's uid to add
+   * \param size trailer serialized size
+   */
+  void DoAddTrailer (uint32_t uid, uint32_t size);
+  /**
+   * \name Recording of the operations
+   *
+   * The implementations of the public methods of the same names, called
+   * when IsRecording.
+   */
+  /**@{*/
+  /**
+   * \param header header to add
+   * \param size header serialized size
+   */
+  void DoAddHeader (Header const &header, uint32_t size);
+  /**
+   * \param header header to remove
+   * \param size header serialized size
+   */
+  void DoRemoveHeader (Header const &header, uint32_t size);
+  /**
+   * \param trailer trailer to add
+   * \param size trailer serialized size
+   */
+  void DoAddTrailer (Trailer const &trailer, uint32_t size);
+  /**
+   * \param trailer trailer to remove
+   * \param size trailer serialized size
+   */
+  void DoRemoveTrailer (Trailer const &trailer, uint32_t size);
+  /**
+   * \param o the metadata to add
+   * \param size the size of the packet of \p o
+   */
+  void DoAddAtEnd (PacketMetadata const&o, uint32_t size);
+  /**
+   * \param start the size of metadata to remove
+   */
+  void DoRemoveAtStart (uint32_t start);
+  /**
+   * \param end the size of metadata to remove
+   */
+  void DoRemoveAtEnd (uint32_t end);
+  /**@}*/
+  /**
+   * \brief Start recording, if not yet, with an empty list
+   */
+  void Record (void);
+  /**
+   * \brief Stop recording and release the storage
+   */
+  inline void Unrecord (void);
+  /**
+   * \brief Check if the metadata of a new packet is recorded
+   * \param uid the packet uid
+   * \returns true if the metadata is enabled and the packet is sampled
+   */
+  static inline bool IsSampled (uint64_t uid);
   /**
    * \brief Check if the metadata state is ok
    * \returns true if the internal state is ok
@@ -644,19 +749,8 @@ public:
    * \returns a pointer to the created buffer storage
    */
   static struct PacketMetadata::Data *Create (uint32_t size);
-  /**
-   * \brief Allocate a buffer data storage
-   * \param n the storage size to create
-   * \returns a pointer to the allocated buffer storage
-   */
-  static struct PacketMetadata::Data *Allocate (uint32_t n);
-  /**
-   * \brief Deallocate the buffer memory
-   * \param data the buffer data storage
-   */
-  static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList; //!< the metadata data storage
+  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
 
@@ -667,10 +761,15 @@ public:
    */
   static bool m_metadataSkipped;
 
-  static uint32_t m_maxSize; //!< maximum metadata size
-  static uint16_t m_chunkUid; //!< Chunk Uid
+  /**
+   * The packets whose hashed uid is below this threshold are sampled,
+   * out of 2^32; all of them by default.
+   */
+  static uint64_t m_sampleThreshold;
 
-  struct Data *m_data; //!< Metadata storage
+  static uint16_t m_chunkUid; //!< Chunk Uid, incremented atomically
+
+  struct Data *m_data; //!< Metadata storage, 0 if not recording
   /*
      head -(next)-> tail
        ^             |
@@ -686,17 +785,32 @@ public:
 
 namespace ns3 {
 
+bool
+PacketMetadata::IsSampled (uint64_t uid)
+{
+  // Fibonacci hashing spreads consecutive uids over the 32 bits
+  return m_enable
+         && ((uid * 0x9e3779b97f4a7c15ULL) >> 32) < m_sampleThreshold;
+}
+
 PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
-  : m_data (PacketMetadata::Create (10)),
+  : m_data (0),
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
     m_packetUid (uid)
 {
-  memset (m_data->m_data, 0xff, 4);
-  if (size > 0)
+  if (IsSampled (uid))
+    {
+      Record ();
+      if (size > 0)
+        {
+          DoAddHeader (0, size);
+        }
+    }
+  else if (!m_enable && size > 0)
     {
-      DoAddHeader (0, size);
+      m_metadataSkipped = true;
     }
 }
 PacketMetadata::PacketMetadata (PacketMetadata const &o)
@@ -706,9 +820,11 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
     m_used (o.m_used),
     m_packetUid (o.m_packetUid)
 {
-  NS_ASSERT (m_data != 0);
-  NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  if (m_data != 0)
+    {
+      NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
+      m_data->m_count++;
+    }
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -716,15 +832,12 @@ PacketMetadata::operator = (PacketMetadata const& o)
   if (m_data != o.m_data) 
     {
       // not self assignment
-      NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      Unrecord ();
+      m_data = o.m_data;
+      if (m_data != 0)
         {
-          PacketMetadata::Recycle (m_data);
+          m_data->m_count++;
         }
-      m_data = o.m_data;
-      NS_ASSERT (m_data != 0);
-      m_data->m_count++;
     }
   m_head = o.m_head;
   m_tail = o.m_tail;
@@ -734,11 +847,91 @@ PacketMetadata::operator = (PacketMetadata const& o)
 }
 PacketMetadata::~PacketMetadata ()
 {
-  NS_ASSERT (m_data != 0);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  Unrecord ();
+}
+
+bool
+PacketMetadata::IsRecording (void) const
+{
+  return m_data != 0;
+}
+
+void
+PacketMetadata::Unrecord (void)
+{
+  if (m_data != 0)
+    {
+      m_data->m_count--;
+      if (m_data->m_count == 0) 
+        {
+          PacketMetadata::Recycle (m_data);
+        }
+      m_data = 0;
+    }
+  m_head = 0xffff;
+  m_tail = 0xffff;
+  m_used = 0;
+}
+
+void
+PacketMetadata::AddHeader (Header const &header, uint32_t size)
+{
+  if (m_data != 0)
+    {
+      DoAddHeader (header, size);
+    }
+}
+void
+PacketMetadata::RemoveHeader (Header const &header, uint32_t size)
+{
+  if (m_data != 0)
+    {
+      DoRemoveHeader (header, size);
+    }
+}
+void
+PacketMetadata::AddTrailer (Trailer const &trailer, uint32_t size)
+{
+  if (m_data != 0)
+    {
+      DoAddTrailer (trailer, size);
+    }
+}
+void
+PacketMetadata::RemoveTrailer (Trailer const &trailer, uint32_t size)
+{
+  if (m_data != 0)
+    {
+      DoRemoveTrailer (trailer, size);
+    }
+}
+void
+PacketMetadata::AddAtEnd (PacketMetadata const&o, uint32_t size)
+{
+  if (m_data != 0)
+    {
+      DoAddAtEnd (o, size);
+    }
+}
+void
+PacketMetadata::AddPaddingAtEnd (uint32_t end)
+{
+  // the padding is not recorded
+}
+void
+PacketMetadata::RemoveAtStart (uint32_t start)
+{
+  if (m_data != 0)
+    {
+      DoRemoveAtStart (start);
+    }
+}
+void
+PacketMetadata::RemoveAtEnd (uint32_t end)
+{
+  if (m_data != 0)
     {
-      PacketMetadata::Recycle (m_data);
+      DoRemoveAtEnd (end);
     }
 }
 
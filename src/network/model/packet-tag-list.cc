@@ -20,269 +20,200 @@
 
 /**
 \file   packet-tag-list.cc
-\brief  Implements a linked list of Packet tags, including copy-on-write semantics.
+\brief  Implements a small vector of Packet tags, including copy-on-write semantics.
 */
 
 #include "packet-tag-list.h"
+#include "ns3/size-class-pool.h"
 #include "tag-buffer.h"
 #include "tag.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+
 #include <cstring>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
-bool
-PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
-{
-  TypeId tid = tag.GetInstanceTypeId ();
-  NS_LOG_FUNCTION (this << tid);
-  NS_LOG_INFO     ("looking for " << tid);
+namespace {
 
-  // trivial case when list is empty
-  if (m_next == 0)
-    {
-      return false;
-    }
+/** Free lists of the overflow blocks of the calling thread. */
+__thread SizeClassPool::Lists g_freeLists;
 
-  bool found = false;
+/**
+ * Return the overflow blocks to the heap at exit, so that the lists
+ * destroyed after this point free their blocks to the heap.
+ */
+struct LocalStaticDestructor
+{
+  ~LocalStaticDestructor ()
+  {
+    SizeClassPool::Release (g_freeLists, true);
+  }
+} g_localStaticDestructor; //!< Releases the free lists at exit.
 
-  struct TagData ** prevNext = &m_next; // previous node's next pointer
-  struct TagData  * cur      =  m_next; // cursor to current node
-  struct TagData  * it = 0;             // utility
+/**
+ * \param [in] tid A tag type.
+ * \returns The bit of \pname{tid} in PacketTagList::m_mask.
+ */
+uint64_t
+GetMaskBit (TypeId tid)
+{
+  return static_cast<uint64_t> (1) << (tid.GetUid () & 63);
+}
 
-  // Search from the head of the list until we find tid or a merge
-  while (cur != 0)
-    {
-      if (cur->count > 1)
-        {
-          // found merge
-          NS_LOG_INFO ("found initial merge before tid");
-          break;
-        }
-      else if (cur->tid == tid)
-        {
-          NS_LOG_INFO ("found tid before initial merge, calling writer");
-          found = (this->*Writer)(tag, true, cur, prevNext);
-          break;
-        }
-      else
-        {
-          // no merge or tid found yet, move on
-          prevNext = &cur->next;
-          cur      =  cur->next;
-        }
-    }  // while !found && !cow
+} // anonymous namespace
 
-  // did we find it or run out of tags?
-  if (cur == 0 || found)
+uint32_t
+PacketTagList::Find (TypeId tid) const
+{
+  if ((m_mask & GetMaskBit (tid)) == 0)
     {
-      NS_LOG_INFO ("returning after header with found: " << found);
-      return found;
+      return m_size;
     }
-
-  // From here on out, we have to copy the list
-  // until we find tid, then link past it
-
-  // Before we do all that work, let's make sure tid really exists
-  for (it = cur; it != 0; it = it->next)
+  const struct TagData *tags = Begin ();
+  for (uint32_t i = 0; i < m_size; i++)
     {
-      if (it->tid == tid)
+      if (tags[i].tid == tid)
         {
-          break;
+          return i;
         }
     }
-  if (it == 0)
+  return m_size;
+}
+
+struct PacketTagList::TagData *
+PacketTagList::GetWritableTags (void)
+{
+  if (m_overflow == 0)
     {
-      // got to end of list without finding tid
-      NS_LOG_INFO ("tid not found after first merge");
-      return found;
+      return m_tags;
     }
-
-  // At this point cur is a merge, but untested for tid
-  NS_ASSERT (cur != 0);
-  NS_ASSERT (cur->count > 1);
-
-  /*
-     Walk the remainder of the list, copying, until we find tid
-     As we put a copy of the cur node onto our list,
-     we move the merge point down the list.
-
-     Starting position                  End position
-       T1 is a merge                     T1.count decremented
-                                         T2 is a merge
-                                         T1' is a copy of T1
-
-          other                             other
-               \                                 \
-      Prev  ->  T1  ->  T2  -> ...                T1  ->  T2  -> ...
-           /   /                                         /|
-      pNext cur                         Prev  ->  T1' --/ |
-                                                     /    |
-                                                pNext   cur
-
-     When we reach tid, we link past it, decrement count, and we're done.
-  */
-
-  // Should normally check for null cur pointer,
-  // but since we know tid exists, we'll skip this test
-  while ( /* cur && */ cur->tid != tid)
+  if (m_overflow->count > 1)
     {
-      NS_ASSERT (cur != 0);
-      NS_ASSERT (cur->count > 1);
-      cur->count--;                       // unmerge cur
-      struct TagData * copy = new struct TagData ();
-      copy->tid = cur->tid;
-      copy->count = 1;
-      memcpy (copy->data, cur->data, TagData::MAX_SIZE);
-      copy->next = cur->next;             // merge into tail
-      copy->next->count++;                // mark new merge
-      *prevNext = copy;                   // point prior list at copy
-      prevNext = &copy->next;             // advance
-      cur      =  copy->next;
+      NS_LOG_INFO ("copying the shared overflow block");
+      Reallocate (m_overflow->capacity);
     }
-  // Sanity check:
-  NS_ASSERT (cur != 0);                 // cur should be non-zero
-  NS_ASSERT (cur->tid == tid);          // cur->tid should be tid
-  NS_ASSERT (cur->count > 1);           // cur should be a merge
-
-  // link around tid, removing it from our list
-  found = (this->*Writer)(tag, false, cur, prevNext);
-  return found;
+  return m_overflow->tags;
+}
 
+void
+PacketTagList::Reallocate (uint32_t capacity)
+{
+  NS_LOG_FUNCTION (this << capacity);
+  const uint32_t header = sizeof (struct Overflow) - sizeof (struct TagData);
+  uint32_t size = SizeClassPool::GetBlockSize (header + capacity * sizeof (struct TagData));
+  struct Overflow *overflow = static_cast<struct Overflow *> (SizeClassPool::Allocate (g_freeLists, size));
+  overflow->count = 1;
+  overflow->capacity = (size - header) / sizeof (struct TagData);
+  NS_ASSERT (overflow->capacity >= capacity);
+  std::memcpy (static_cast<void *> (overflow->tags), Begin (), m_size * sizeof (struct TagData));
+  if (m_overflow != 0)
+    {
+      Release (m_overflow);
+    }
+  m_overflow = overflow;
 }
 
-bool
-PacketTagList::Remove (Tag & tag)
+void
+PacketTagList::Release (struct Overflow *overflow)
 {
-  return COWTraverse (tag, &PacketTagList::RemoveWriter);
+  overflow->count--;
+  if (overflow->count == 0)
+    {
+      const uint32_t header = sizeof (struct Overflow) - sizeof (struct TagData);
+      uint32_t size = SizeClassPool::GetBlockSize (header + overflow->capacity * sizeof (struct TagData));
+      SizeClassPool::Free (g_freeLists, overflow, size);
+    }
 }
 
-// COWWriter implementing Remove
 bool
-PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
-                             struct PacketTagList::TagData  * cur,
-                             struct PacketTagList::TagData ** prevNext)
+PacketTagList::Remove (Tag & tag)
 {
-  NS_LOG_FUNCTION_NOARGS ();
-
-  // found tid
-  bool found = true;
-  tag.Deserialize (TagBuffer (cur->data,
-                              cur->data + TagData::MAX_SIZE));
-  *prevNext = cur->next;            // link around cur
-
-  if (preMerge)
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  uint32_t i = Find (tid);
+  if (i == m_size)
     {
-      // found tid before first merge, so delete cur
-      delete cur;
+      return false;
     }
-  else
+  struct TagData *tags = GetWritableTags ();
+  tag.Deserialize (TagBuffer (tags[i].data, tags[i].data + TagData::MAX_SIZE));
+  std::memmove (static_cast<void *> (tags + i), tags + i + 1, (m_size - i - 1) * sizeof (struct TagData));
+  m_size--;
+  m_mask = 0;
+  for (uint32_t j = 0; j < m_size; j++)
     {
-      // cur is always a merge at this point
-      // unmerge cur, since we linked around it already
-      cur->count--;
-      if (cur->next != 0)
-        {
-          // there's a next, so make it a merge
-          cur->next->count++;
-        }
+      m_mask |= GetMaskBit (tags[j].tid);
     }
-  return found;
+  return true;
 }
 
 bool
 PacketTagList::Replace (Tag & tag)
 {
-  bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
-  if (!found)
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  uint32_t i = Find (tid);
+  if (i == m_size)
     {
       Add (tag);
+      return false;
     }
-  return found;
+  struct TagData *tags = GetWritableTags ();
+  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
+  tag.Serialize (TagBuffer (tags[i].data, tags[i].data + tag.GetSerializedSize ()));
+  return true;
 }
 
-// COWWriter implementing Replace
-bool
-PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
-                              struct PacketTagList::TagData  * cur,
-                              struct PacketTagList::TagData ** prevNext)
+void 
+PacketTagList::Add (const Tag &tag) const
 {
-  NS_LOG_FUNCTION_NOARGS ();
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  // ensure this id was not yet added
+  NS_ASSERT_MSG (Find (tid) == m_size, "Error: cannot add the same kind of tag twice.");
+  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
 
-  // found tid
-  bool found = true;
-  if (preMerge)
+  // adding a tag does not change the other packets sharing the tags
+  PacketTagList *self = const_cast<PacketTagList *> (this);
+  struct TagData *tags;
+  if (m_overflow == 0 && m_size < INLINE_TAGS)
     {
-      // found tid before first merge, so just rewrite
-      tag.Serialize (TagBuffer (cur->data,
-                                cur->data + tag.GetSerializedSize ()));
+      tags = self->m_tags;
     }
-  else
+  else if (m_overflow == 0 || m_overflow->count > 1 || m_size == m_overflow->capacity)
     {
-      // cur is always a merge at this point
-      // need to copy, replace, and link past cur
-      cur->count--;                     // unmerge cur
-      struct TagData * copy = new struct TagData ();
-      copy->tid = tag.GetInstanceTypeId ();
-      copy->count = 1;
-      tag.Serialize (TagBuffer (copy->data,
-                                copy->data + tag.GetSerializedSize ()));
-      copy->next = cur->next;           // merge into tail
-      if (copy->next != 0)
-        {
-          copy->next->count++;          // mark new merge
-        }
-      *prevNext = copy;                 // point prior list at copy
+      self->Reallocate (2 * m_size);
+      tags = m_overflow->tags;
     }
-  return found;
-}
-
-void 
-PacketTagList::Add (const Tag &tag) const
-{
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
-  // ensure this id was not yet added
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  else
     {
-      NS_ASSERT_MSG (cur->tid != tag.GetInstanceTypeId (), "Error: cannot add the same kind of tag twice.");
+      tags = m_overflow->tags;
     }
-  struct TagData * head = new struct TagData ();
-  head->count = 1;
-  head->next = 0;
-  head->tid = tag.GetInstanceTypeId ();
-  head->next = m_next;
-  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
-  tag.Serialize (TagBuffer (head->data, head->data + tag.GetSerializedSize ()));
-
-  const_cast<PacketTagList *> (this)->m_next = head;
+  struct TagData *cur = &tags[m_size];
+  cur->tid = tid;
+  tag.Serialize (TagBuffer (cur->data, cur->data + tag.GetSerializedSize ()));
+  self->m_size++;
+  self->m_mask |= GetMaskBit (tid);
 }
 
 bool
 PacketTagList::Peek (Tag &tag) const
 {
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  NS_LOG_FUNCTION (this << tid);
+  uint32_t i = Find (tid);
+  if (i == m_size)
     {
-      if (cur->tid == tid) 
-        {
-          /* found tag */
-          tag.Deserialize (TagBuffer (cur->data, cur->data + TagData::MAX_SIZE));
-          return true;
-        }
+      /* no tag found */
+      return false;
     }
-  /* no tag found */
-  return false;
-}
-
-const struct PacketTagList::TagData *
-PacketTagList::Head (void) const
-{
-  return m_next;
+  /* found tag */
+  uint8_t *data = const_cast<uint8_t *> (Begin ()[i].data);
+  tag.Deserialize (TagBuffer (data, data + TagData::MAX_SIZE));
+  return true;
 }
 
 } /* namespace ns3 */
-
@@ -22,10 +22,11 @@
 
 /**
 \file   packet-tag-list.h
-\brief  Defines a linked list of Packet tags, including copy-on-write semantics.
+\brief  Defines a small vector of Packet tags, including copy-on-write semantics.
 */
 
 #include <stdint.h>
+#include <cstring>
 #include <ostream>
 #include "ns3/type-id.h"
 
@@ -43,96 +44,36 @@ class Tag;
  *
  * \internal
  *
- * The implementation of this class is a bit tricky.  Refer to this
- * diagram in the discussion that follows.
+ * Packets rarely carry more than a few tags, and most of them are peeked
+ * at, added and removed at every hop.  The list is therefore a small
+ * vector of serialized tags (TagData):
  *
- * \dot
- *    digraph {
- *        rankdir = "LR";
- *        clusterrank = local;
- *        node [ shape = record, fontname="FreeSans", fontsize="10" ];
- *        oth  [ label="<l> Other branch | <n> next | <c> ..." ];
- *        PTL1 [ label="<l> PacketTagList A | <n> m_next" , shape=Mrecord];
- *        PTL2 [ label="<l> PacketTagList B | <n> m_next" , shape=Mrecord];
- *        oth:n  -> T7:l ;
- *        PTL2:n -> T6:l ;
- *        PTL1:n -> T5:l ;
- *        T1   [ label="<l> T1  | <n> next | <c> count = 1" ];
- *        T2   [ label="<l> T2  | <n> next | <c> count = 1" ];
- *        T3   [ label="<l> T3  | <n> next | <c> count = 2" ];
- *        T4   [ label="<l> T4  | <n> next | <c> count = 1" ];
- *        T5   [ label="<l> T5  | <n> next | <c> count = 2" ];
- *        T6   [ label="<l> T6  | <n> next | <c> count = 1" ];
- *        T7   [ label="<l> T7  | <n> next | <c> count = 1" ];
- *        NULL [ label="0", shape = ellipse ];
- *        subgraph cluster_list {
- *          penwidth = 0;
- *          T6:n -> T5:l ;
- *          T5:n -> T4:l ;
- *          T4:n -> T3:l ;
- *          T7:n -> T3:l ;
- *          T3:n -> T2:l ;
- *          T2:n -> T1:l ;
- *          T1:n -> NULL ;
- *        };
- *      }
- * \enddot
+ *   - Up to #INLINE_TAGS tags are stored in the PacketTagList itself, so
+ *     that adding a tag allocates nothing, and copying a list copies a few
+ *     contiguous TagData.
  *
- *   - Tags are stored in serialized form in a tree of TagData
- *     structures. (<tt>T1-T7</tt> in the diagram)
+ *   - Beyond #INLINE_TAGS, all the tags move to an overflow block taken
+ *     from per-thread free lists (see SizeClassPool).  The block is
+ *     reference counted: copies of the list share it, and #Add, #Remove
+ *     and #Replace copy it first if it is shared (copy-on-write).
  *
- *   - Each TagData points (\c next pointers in the diagram)
- *     toward the root of the tree, which is a null pointer.
+ *   - #m_mask has the bit <tt>uid % 64</tt> set for the TypeId uid of
+ *     each tag, so that looking for a tag which is not in the list, the
+ *     common case, costs one test whatever the number of tags; a tag
+ *     which is in the list is found by comparing the few contiguous uids.
  *
- *   - \c count is the number of incoming pointers to this
- *     TagData.  Branch points, where branches merge or join, have
- *     <tt>count \> 1</tt> (\c T3, \c T5); successive links along
- *     a branch have <tt>count = 1</tt> (\c T1, \c T2, \c T4, \c T6, \c T7).
- *
- *   - Each PacketTagList points to a specific TagData,
- *     which is the most recent Tag added to the packet. (<tt>T5-T7</tt>)
- *
- *   - Conceptually, therefore, each Packet has a PacketTagList which
- *     points to a singly-linked list of TagData.
- *
- * \par <b> Copy-on-write </b> is implemented as follows:
- *
- *   - #Add prepends the new tag to the list (growing that branch of the tree,
- *     as \c T6). This is a constant time operation, and does not affect
- *     any other #PacketTagList's, hence this is a \c const function.
- *
- *   - Copy constructor (PacketTagList(const PacketTagList & o))
- *     and assignment (#operator=(const PacketTagList & o))
- *     simply join the tree at the same place as the original
- *     PacketTagList \c o, incrementing the \c count.
- *     For assignment, the old branch is deleted, up to
- *     the first branch point, which has its \c count decremented.
- *     (PacketTagList \c B started as a copy of PacketTagList \c A,
- *     before \c T6 was added to \c B).
- *
- *   - #Remove and #Replace are a little tricky, depending on where the
- *     target tag is found relative to the first branch point:
- *     - \e Target before <em> the first branch point: </em> \n
- *       The target is just dealt with in place (linked around and deleted,
- *       in the case of #Remove; rewritten in the case of #Replace).
- *     - \e Target at or after <em> the first branch point: </em> \n
- *       The portion of the list between the first branch and the target is
- *       shared. This portion is copied before the #Remove or #Replace is
- *       performed.
+ *   - Tags are kept in the order they were added; #Remove shifts the
+ *     following tags down.
  *
  * \par <b> Memory Management: </b>
  * \n
  * Packet tags must serialize to a finite maximum size, see TagData
- *
- * This documentation entitles the original author to a free beer.
  */
 class PacketTagList 
 {
 public:
   /**
-   * Tree node for sharing serialized tags.
-   *
-   * See PacketTagList for a discussion of the data structure.
+   * Serialized tag.
    *
    * See TagData::TagData_e for a discussion of the size limit on
    * tag serialization.
@@ -146,15 +87,9 @@ public:
      * in this constant.
      *
      * \internal
-     * Ideally, TagData would be 32 bytes in size, so they require
-     * no padding on 64-bit architectures.  (The architecture
-     * affects the size because of the \c #next pointer.)
-     * This would leave 18 bytes for \c #data.  However,
-     * ns3:Ipv6PacketInfoTag needs 19 bytes!  The current
-     * implementation allows 20 bytes, which gives TagData
-     * a size of 30 bytes on 32-byte machines (which gets
-     * padded with 2 bytes), and 34 bytes on 64-bit machines, which
-     * gets padded to 40 bytes.
+     * ns3:Ipv6PacketInfoTag needs 19 bytes.  With 21 bytes of data and
+     * the 2 bytes TypeId, a TagData takes 24 bytes, so that the inline
+     * tags of a PacketTagList fill whole cache lines.
      */
     enum TagData_e
     {
@@ -162,9 +97,7 @@ public:
   };
 
     uint8_t data[MAX_SIZE];   /**< Serialization buffer */
-    struct TagData * next;   /**< Pointer to next in list */
     TypeId tid;               /**< Type of the tag serialized into #data */
-    uint32_t count;           /**< Number of incoming links */
   };  /* struct TagData */
 
   /**
@@ -176,8 +109,8 @@ public:
    *
    * \param [in] o The PacketTagList to copy.
    *
-   * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * This copies the inline tags of \pname{o}, or shares its
+   * overflow block.
    */
   inline PacketTagList (PacketTagList const &o);
   /**
@@ -187,18 +120,19 @@ public:
    * \returns the copied object
    *
    * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * copying the inline tags of \pname{o}, or sharing its
+   * overflow block.
    */
   inline PacketTagList &operator = (PacketTagList const &o);
   /**
    * Destructor
    *
-   * #RemoveAll's the tags up to the first merge.
+   * Releases the overflow block, if any.
    */
   inline ~PacketTagList ();
 
   /**
-   * Add a tag to the head of this branch.
+   * Add a tag at the end of the list.
    *
    * \param [in] tag The tag to add
    */
@@ -230,67 +164,58 @@ public:
    */
   bool Peek (Tag &tag) const;
   /**
-   * Remove all tags from this list (up to the first merge).
+   * Remove all tags from this list.
    */
   inline void RemoveAll (void);
   /**
-   * \returns pointer to head of tag list
+   * \returns pointer to the first tag of the list
+   */
+  inline const struct PacketTagList::TagData *Begin (void) const;
+  /**
+   * \returns pointer past the last tag of the list
    */
-  const struct PacketTagList::TagData *Head (void) const;
+  inline const struct PacketTagList::TagData *End (void) const;
 
 private:
+  /** Number of tags stored in the list itself. */
+  static const uint32_t INLINE_TAGS = 4;
+
   /**
-   * Typedef of method function pointer for copy-on-write operations
-   *
-   * \param [in] tag The tag type to operate on.
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *             false otherwise.
-   * \param [in] cur Pointer to the tag.
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True if operation successful, false otherwise
+   * Tags of a list beyond INLINE_TAGS, shared by the copies of the list.
    */
-  typedef bool (PacketTagList::*COWWriter)
-    (Tag       & tag, bool         preMerge,
-    struct TagData * cur, struct TagData ** prevNext);
+  struct Overflow
+  {
+    uint32_t count;      /**< Number of lists sharing the block */
+    uint32_t capacity;   /**< Number of tags the block can hold */
+    TagData tags[1];     /**< The tags, extending to capacity */
+  };
+
   /**
-   * Traverse the list implementing copy-on-write, using \pname{Writer}.
-   *
-   * \param [in] tag The tag type to operate on.
-   * \param [in] Writer The copy-on-write function to use.
-   * \returns True if \pname{tag} found, false otherwise.
+   * \param [in] tid The tag type to find.
+   * \returns The index of the tag, or #m_size if not found.
    */
-  bool COWTraverse   (Tag & tag, PacketTagList::COWWriter Writer);
+  uint32_t Find (TypeId tid) const;
   /**
-   * Copy-on-write implementing Remove.
+   * \returns The tags of the list, ready to be modified.
    *
-   * \param [in] tag The target tag type to remove.
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *             false otherwise.
-   * \param [in] cur Pointer to the tag.
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True, since tag will definitely be removed.
+   * This unshares the overflow block, if any.
    */
-  bool RemoveWriter  (Tag       & tag, bool         preMerge,
-                      struct TagData * cur, struct TagData ** prevNext);
+  struct TagData *GetWritableTags (void);
   /**
-   * Copy-on-write implementing Replace
-   *
-   * \param [in] tag The target tag type to replace
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *          false otherwise.
-   * \param [in] cur Pointer to the tag
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True, since tag value will definitely be replaced.
+   * Move the tags to a new overflow block.
+   * \param [in] capacity The minimum capacity of the block.
    */
-  bool ReplaceWriter (Tag & tag, bool preMerge, struct TagData * cur, struct TagData ** prevNext);
-
+  void Reallocate (uint32_t capacity);
   /**
-   * Pointer to first \ref TagData on the list
+   * Release an overflow block.
+   * \param [in] overflow The block.
    */
-  struct TagData *m_next;
+  static void Release (struct Overflow *overflow);
+
+  uint64_t m_mask;                      //!< Bit of the TypeId uid of each tag
+  uint32_t m_size;                      //!< Number of tags
+  struct Overflow *m_overflow;          //!< The tags if more than INLINE_TAGS, else 0
+  struct TagData m_tags[INLINE_TAGS];   //!< The tags if m_overflow is 0
 };
 
 } // namespace ns3
@@ -302,33 +227,44 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_mask (0),
+    m_size (0),
+    m_overflow (0)
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
-  : m_next (o.m_next)
+  : m_mask (o.m_mask),
+    m_size (o.m_size),
+    m_overflow (o.m_overflow)
 {
-  if (m_next != 0)
+  if (m_overflow != 0)
     {
-      m_next->count++;
+      m_overflow->count++;
+      return;
     }
+  // a TagData is plain data: its TypeId is a uid
+  std::memcpy (static_cast<void *> (m_tags), o.m_tags, m_size * sizeof (struct TagData));
 }
 
 PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o)
     {
       return *this;
     }
   RemoveAll ();
-  m_next = o.m_next;
-  if (m_next != 0) 
+  m_mask = o.m_mask;
+  m_size = o.m_size;
+  m_overflow = o.m_overflow;
+  if (m_overflow != 0)
     {
-      m_next->count++;
+      m_overflow->count++;
+      return *this;
     }
+  std::memcpy (static_cast<void *> (m_tags), o.m_tags, m_size * sizeof (struct TagData));
   return *this;
 }
 
@@ -340,25 +276,25 @@ PacketTagList::~PacketTagList ()
 void
 PacketTagList::RemoveAll (void)
 {
-  struct TagData *prev = 0;
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
-    {
-      cur->count--;
-      if (cur->count > 0) 
-        {
-          break;
-        }
-      if (prev != 0) 
-        {
-	  delete prev;
-        }
-      prev = cur;
-    }
-  if (prev != 0) 
+  if (m_overflow != 0)
     {
-      delete prev;
+      Release (m_overflow);
+      m_overflow = 0;
     }
-  m_next = 0;
+  m_size = 0;
+  m_mask = 0;
+}
+
+const struct PacketTagList::TagData *
+PacketTagList::Begin (void) const
+{
+  return m_overflow != 0 ? m_overflow->tags : m_tags;
+}
+
+const struct PacketTagList::TagData *
+PacketTagList::End (void) const
+{
+  return Begin () + m_size;
 }
 
 } // namespace ns3
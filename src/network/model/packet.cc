@@ -81,22 +81,24 @@ ByteTagIterator::ByteTagIterator (ByteTagList::Iterator i)
 }
 
 
-PacketTagIterator::PacketTagIterator (const struct PacketTagList::TagData *head)
-  : m_current (head)
+PacketTagIterator::PacketTagIterator (const struct PacketTagList::TagData *begin,
+                                      const struct PacketTagList::TagData *end)
+  : m_begin (begin),
+    m_current (end)
 {
 }
 bool
 PacketTagIterator::HasNext (void) const
 {
-  return m_current != 0;
+  return m_current != m_begin;
 }
 PacketTagIterator::Item
 PacketTagIterator::Next (void)
 {
   NS_ASSERT (HasNext ());
-  const struct PacketTagList::TagData *prev = m_current;
-  m_current = m_current->next;
-  return PacketTagIterator::Item (prev);
+  // most recently added tags first
+  m_current--;
+  return PacketTagIterator::Item (m_current);
 }
 
 PacketTagIterator::Item::Item (const struct PacketTagList::TagData *data)
@@ -137,10 +139,10 @@ Packet::Packet ()
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32
+                | __atomic_fetch_add (&m_globalUid, 1, __ATOMIC_RELAXED), 0),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 
 Packet::Packet (const Packet &o)
@@ -179,10 +181,10 @@ Packet::Packet (uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32
+                | __atomic_fetch_add (&m_globalUid, 1, __ATOMIC_RELAXED), size),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
   : m_buffer (0, false),
@@ -205,10 +207,10 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32
+                | __atomic_fetch_add (&m_globalUid, 1, __ATOMIC_RELAXED), size),
     m_nixVector (0)
 {
-  m_globalUid++;
   m_buffer.AddAtStart (size);
   Buffer::Iterator i = m_buffer.Begin ();
   i.Write (buffer, size);
@@ -319,7 +321,7 @@ Packet::AddAtEnd (Ptr<const Packet> packet)
   copy.Adjust (GetSize ());
   m_byteTagList.Add (copy);
   m_buffer.AddAtEnd (packet->m_buffer);
-  m_metadata.AddAtEnd (packet->m_metadata);
+  m_metadata.AddAtEnd (packet->m_metadata, packet->m_buffer.GetSize ());
 }
 void
 Packet::AddPaddingAtEnd (uint32_t size)
@@ -538,6 +540,19 @@ Packet::EnablePrinting (void)
   PacketMetadata::Enable ();
 }
 
+void
+Packet::EnableSampledPrinting (double fraction)
+{
+  NS_LOG_FUNCTION (fraction);
+  PacketMetadata::EnableSampling (fraction);
+}
+
+bool
+Packet::HasMetadata (void) const
+{
+  return m_metadata.IsRecording ();
+}
+
 void
 Packet::EnableChecking (void)
 {
@@ -881,7 +896,7 @@ Packet::PrintPacketTags (std::ostream &os) const
 PacketTagIterator 
 Packet::GetPacketTagIterator (void) const
 {
-  return PacketTagIterator (m_packetTagList.Head ());
+  return PacketTagIterator (m_packetTagList.Begin (), m_packetTagList.End ());
 }
 
 std::ostream& operator<< (std::ostream& os, const Packet &packet)
@@ -169,10 +169,13 @@ private:
   friend class Packet;
   /**
    * Constructor
-   * \param head head of the items
+   * \param begin first of the items
+   * \param end past the last of the items
    */
-  PacketTagIterator (const struct PacketTagList::TagData *head);
-  const struct PacketTagList::TagData *m_current;  //!< actual position over the set of tags in a packet
+  PacketTagIterator (const struct PacketTagList::TagData *begin,
+                     const struct PacketTagList::TagData *end);
+  const struct PacketTagList::TagData *m_begin;    //!< first of the tags in a packet
+  const struct PacketTagList::TagData *m_current;  //!< past the next tag, which is the most recently added one
 };
 
 /**
@@ -195,7 +198,9 @@ private:
  * output from Packet::Print. If you wish to only enable
  * checking of metadata, and do not need any printing capability, you can
  * call Packet::EnableChecking: its runtime cost is lower than
- * Packet::EnablePrinting.
+ * Packet::EnablePrinting. Packet::EnableSampledPrinting records the
+ * metadata of a sample of the packets only, and the others pay almost
+ * nothing for it.
  *
  * - The set of tags contain simulation-specific information which cannot
  * be stored in the packet byte buffer because the protocol headers or trailers
@@ -490,6 +495,25 @@ public:
    * simulation setup and before any packet is created.
    */
   static void EnablePrinting (void);
+  /**
+   * \brief Enable printing the metadata of a sample of the packets.
+   *
+   * Like EnablePrinting, but only a fraction of the packets created
+   * afterwards keep their metadata; Print describes the headers and
+   * trailers of these only, see HasMetadata.  The sample depends on the
+   * packet uids only, so it doesn't change the random numbers drawn by
+   * the simulation.
+   *
+   * \param [in] fraction The fraction of the packets sampled, in [0, 1].
+   */
+  static void EnableSampledPrinting (double fraction);
+  /**
+   * \returns true if the packet keeps its metadata, so that Print
+   *          describes its headers and trailers.
+   *
+   * \sa EnablePrinting EnableSampledPrinting
+   */
+  bool HasMetadata (void) const;
   /**
    * \brief Enable packets metadata checking.
    *
@@ -727,7 +751,7 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
-  static uint32_t m_globalUid; //!< Global counter of packets Uid
+  static uint32_t m_globalUid; //!< Global counter of packets Uid, incremented atomically
 };
 
 /**
@@ -361,6 +361,76 @@ BufferTest::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
 //-----------------------------------------------------------------------------
+// The buffer data is recycled by size class, so that the blocks of both
+// small and large packets are reused.
+class BufferFreeListTest : public TestCase
+{
+public:
+  BufferFreeListTest ();
+private:
+  void Exchange (void);
+  virtual void DoRun (void);
+};
+
+BufferFreeListTest::BufferFreeListTest ()
+  : TestCase ("Buffer free lists")
+{
+}
+
+void
+BufferFreeListTest::Exchange (void)
+{
+  // a full frame and its acknowledgement
+  Buffer frame;
+  frame.AddAtStart (1500);
+  Buffer ack;
+  ack.AddAtStart (40);
+}
+
+void
+BufferFreeListTest::DoRun (void)
+{
+  // size classes keep both sizes
+  SizeClassPool::Lists lists = SizeClassPool::Lists ();
+  uint32_t smallSize = SizeClassPool::GetBlockSize (60);
+  uint32_t largeSize = SizeClassPool::GetBlockSize (1600);
+  NS_TEST_ASSERT_MSG_EQ ((smallSize >= 60 && smallSize < 128), true, "Bad small size class");
+  NS_TEST_ASSERT_MSG_EQ ((largeSize >= 1600 && largeSize < 4096), true, "Bad large size class");
+  void *large = SizeClassPool::Allocate (lists, largeSize);
+  void *small = SizeClassPool::Allocate (lists, smallSize);
+  SizeClassPool::Free (lists, large, largeSize);
+  SizeClassPool::Free (lists, small, smallSize);
+  NS_TEST_ASSERT_MSG_EQ (lists.m_stats.m_bytesRetained, smallSize + largeSize, "Freed blocks not retained");
+  NS_TEST_ASSERT_MSG_EQ (SizeClassPool::Allocate (lists, smallSize), small, "Small block not reused");
+  NS_TEST_ASSERT_MSG_EQ (SizeClassPool::Allocate (lists, largeSize), large, "Large block not reused");
+  NS_TEST_ASSERT_MSG_EQ (lists.m_stats.m_hits, 2, "Wrong hit count");
+  NS_TEST_ASSERT_MSG_EQ (lists.m_stats.m_bytesRetained, 0, "Allocated blocks still retained");
+  NS_TEST_ASSERT_MSG_EQ (lists.m_stats.m_maxBytesRetained, smallSize + largeSize, "Wrong high-water mark");
+  SizeClassPool::Free (lists, large, largeSize);
+  SizeClassPool::Free (lists, small, smallSize);
+  SizeClassPool::Release (lists, true);
+  NS_TEST_ASSERT_MSG_EQ (lists.m_stats.m_bytesRetained, 0, "Released lists retain memory");
+  void *huge = SizeClassPool::Allocate (lists, SizeClassPool::GetBlockSize (100000));
+  SizeClassPool::Free (lists, huge, SizeClassPool::GetBlockSize (100000));
+  NS_TEST_ASSERT_MSG_EQ (lists.m_stats.m_heapFrees, 3, "Blocks retained after release");
+
+  // once warm, the buffers of a steady exchange come from the free lists
+  Exchange ();
+  Exchange ();
+  Buffer::ResetFreeListStats ();
+  Exchange ();
+  SizeClassPool::Stats stats = Buffer::GetFreeListStats ();
+  NS_TEST_ASSERT_MSG_EQ ((stats.m_allocations > 0), true, "No buffer data allocated");
+  NS_TEST_ASSERT_MSG_EQ (stats.m_hits, stats.m_allocations, "Buffer data not reused");
+  NS_TEST_ASSERT_MSG_EQ (stats.m_frees, stats.m_allocations, "Buffer data not freed");
+  NS_TEST_ASSERT_MSG_EQ (stats.m_heapFrees, 0, "Buffer data returned to the heap");
+
+  Buffer::ReleaseFreeLists ();
+  stats = Buffer::GetFreeListStats ();
+  NS_TEST_ASSERT_MSG_EQ (stats.m_bytesRetained, 0, "Released free lists retain memory");
+  NS_TEST_ASSERT_MSG_EQ ((stats.m_maxBytesRetained >= 1540), true, "High-water mark lost");
+}
+//-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
 {
 public:
@@ -371,6 +441,7 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferFreeListTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite;
@@ -252,7 +252,7 @@ HistoryTrailer<N>::Deserialize (Buffer::Iterator start)
 
 class PacketMetadataTest : public TestCase {
 public:
-  PacketMetadataTest ();
+  PacketMetadataTest (std::string name = "Packet metadata");
   virtual ~PacketMetadataTest ();
   void CheckHistory (Ptr<Packet> p, const char *file, int line, uint32_t n, ...);
   virtual void DoRun (void);
@@ -260,8 +260,8 @@ private:
   Ptr<Packet> DoAddHeader (Ptr<Packet> p);
 };
 
-PacketMetadataTest::PacketMetadataTest ()
-  : TestCase ("Packet metadata")
+PacketMetadataTest::PacketMetadataTest (std::string name)
+  : TestCase (name)
 {
 }
 
@@ -823,6 +823,59 @@ PacketMetadataTest::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (msg, std::string ("hello world"), "Could not find original data in received packet");
 }
 //-----------------------------------------------------------------------------
+class PacketMetadataSamplingTest : public PacketMetadataTest {
+public:
+  PacketMetadataSamplingTest ();
+  virtual void DoRun (void);
+};
+
+PacketMetadataSamplingTest::PacketMetadataSamplingTest ()
+  : PacketMetadataTest ("Packet metadata sampling")
+{
+}
+
+void
+PacketMetadataSamplingTest::DoRun (void)
+{
+  PacketMetadata::EnableSampling (0.5);
+
+  uint32_t sampled = 0;
+  Ptr<Packet> in;
+  Ptr<Packet> out;
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (10);
+      if (p->HasMetadata ())
+        {
+          sampled++;
+          in = p;
+        }
+      else
+        {
+          out = p;
+        }
+    }
+  NS_TEST_EXPECT_MSG_GT (sampled, 400, "Too few packets sampled");
+  NS_TEST_EXPECT_MSG_LT (sampled, 600, "Too many packets sampled");
+
+  ADD_HEADER (in, 1);
+  CHECK_HISTORY (in, 2, 1, 10);
+  ADD_HEADER (out, 1);
+  NS_TEST_EXPECT_MSG_EQ (out->ToString (), "", "Metadata of a packet not sampled");
+  NS_TEST_EXPECT_MSG_EQ (in->Copy ()->HasMetadata (), true, "Copy of a sampled packet");
+  NS_TEST_EXPECT_MSG_EQ (out->CreateFragment (0, 5)->HasMetadata (), false, "Fragment of a packet not sampled");
+
+  // the bytes of a packet not sampled are payload in a sampled packet
+  in->AddAtEnd (out);
+  CHECK_HISTORY (in, 3, 1, 10, 11);
+  in->RemoveAtEnd (11);
+  CHECK_HISTORY (in, 2, 1, 10);
+  out->AddAtEnd (in);
+  NS_TEST_EXPECT_MSG_EQ (out->HasMetadata (), false, "Packet not sampled got metadata");
+
+  PacketMetadata::EnableSampling (1);
+}
+//-----------------------------------------------------------------------------
 class PacketMetadataTestSuite : public TestSuite
 {
 public:
@@ -833,6 +886,7 @@ PacketMetadataTestSuite::PacketMetadataTestSuite ()
   : TestSuite ("packet-metadata", UNIT)
 {
   AddTestCase (new PacketMetadataTest, TestCase::QUICK);
+  AddTestCase (new PacketMetadataSamplingTest, TestCase::QUICK);
 }
 
 PacketMetadataTestSuite g_packetMetadataTest;
@@ -785,6 +785,34 @@ PacketTagListTest::DoRun (void)
 #   undef RemoveCheck
   }  // Removal
 
+  { // Growth
+    std::cout << GetName () << "check growth of a short list" << std::endl;
+    PacketTagList ptl;
+    ptl.Add (t1);
+    ptl.Add (t2);
+    ptl.Add (t3);
+    PacketTagList shr = ptl;  // short list, copied
+    ptl.Add (t4);
+    ptl.Add (t5);
+    ptl.Add (t6);
+    ptl.Add (t7);
+    CheckRefList (ptl, "grown list");
+    const char * msg = "copy of the short list";
+    CheckRef (shr, t3, msg, false);
+    CheckRef (shr, t4, msg, true);
+    CheckRef (shr, t7, msg, true);
+    ptl.Remove (t7);
+    ptl.Remove (t6);
+    ptl.Remove (t5);
+    ptl.Remove (t4);
+    ptl.Add (t7);
+    CheckRef (ptl, t4, "shrunk list", true);
+    CheckRef (ptl, t7, "shrunk list", false);
+    ptl.RemoveAll ();
+    CheckRef (ptl, t1, "empty list", true);
+    CheckRefList (ref, "growth orig");
+  }
+
   { // Replace
 
     std::cout << GetName () << "check replacing each tag" << std::endl;
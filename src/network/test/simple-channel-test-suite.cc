@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/flow-id-tag.h"
+#include "ns3/error-model.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+
+#include <vector>
+
+using namespace ns3;
+
+// The receivers of a broadcast share the packet of the channel until they
+// forward it up, and then each one gets a packet of its own.
+class SimpleChannelSharedDeliveryTest : public TestCase
+{
+public:
+  SimpleChannelSharedDeliveryTest ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Receive callback of the devices.
+   * \param [in] device The receiving device.
+   * \param [in] packet The packet.
+   * \param [in] protocol The protocol number.
+   * \param [in] from The source address.
+   * \returns true.
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  std::vector<Ptr<const Packet> > m_packets;  //!< Packets received, in order.
+  std::vector<uint32_t> m_tags;               //!< Tag seen by each receiver.
+};
+
+SimpleChannelSharedDeliveryTest::SimpleChannelSharedDeliveryTest ()
+  : TestCase ("Check that the receivers of a broadcast get packets of their own")
+{
+}
+
+bool
+SimpleChannelSharedDeliveryTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  FlowIdTag tag;
+  m_tags.push_back (packet->PeekPacketTag (tag) ? tag.GetFlowId () : 0);
+  // a receiver which tags its packet must not tag the others
+  packet->AddPacketTag (FlowIdTag (device->GetNode ()->GetId () + 1));
+  m_packets.push_back (packet);
+  return true;
+}
+
+void
+SimpleChannelSharedDeliveryTest::DoRun (void)
+{
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  std::vector<Ptr<SimpleNetDevice> > devices;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Ptr<Node> node = CreateObject<Node> ();
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      node->AddDevice (device);
+      device->SetChannel (channel);
+      device->SetReceiveCallback (MakeCallback (&SimpleChannelSharedDeliveryTest::Receive, this));
+      devices.push_back (device);
+    }
+  Ptr<ReceiveListErrorModel> em = CreateObject<ReceiveListErrorModel> ();
+  std::list<uint32_t> uids;
+  Ptr<Packet> packet = Create<Packet> (100);
+  uids.push_back (packet->GetUid ());
+  em->SetList (uids);
+  devices[3]->SetReceiveErrorModel (em);
+
+  Mac48Address broadcast = Mac48Address::GetBroadcast ();
+  Mac48Address source = Mac48Address::ConvertFrom (devices[0]->GetAddress ());
+  channel->Send (packet, 1, broadcast, source, devices[0]);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_packets.size (), 2, "Wrong number of receptions");
+  NS_TEST_EXPECT_MSG_NE (m_packets[0], m_packets[1], "The receivers share a packet");
+  NS_TEST_EXPECT_MSG_NE (m_packets[0], packet, "The receiver got the sent packet");
+  NS_TEST_EXPECT_MSG_EQ (m_packets[1]->GetSize (), 100, "Wrong packet size");
+  NS_TEST_EXPECT_MSG_EQ (m_tags[0], 0, "Unexpected tag");
+  NS_TEST_EXPECT_MSG_EQ (m_tags[1], 0, "Tag of another receiver");
+  FlowIdTag tag;
+  NS_TEST_EXPECT_MSG_EQ (packet->PeekPacketTag (tag), false, "Tag of a receiver on the sent packet");
+
+  // a unicast is not forwarded up by the other devices
+  m_packets.clear ();
+  Mac48Address destination = Mac48Address::ConvertFrom (devices[1]->GetAddress ());
+  channel->Send (Create<Packet> (10), 1, destination, source, devices[0]);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_packets.size (), 1, "Wrong number of receptions");
+
+  m_packets.clear ();
+  Simulator::Destroy ();
+}
+
+
+class SimpleChannelTestSuite : public TestSuite
+{
+public:
+  SimpleChannelTestSuite ();
+};
+
+SimpleChannelTestSuite::SimpleChannelTestSuite ()
+  : TestSuite ("simple-channel", UNIT)
+{
+  AddTestCase (new SimpleChannelSharedDeliveryTest, TestCase::QUICK);
+}
+
+static SimpleChannelTestSuite g_simpleChannelTestSuite;
@@ -230,16 +230,21 @@ SimpleNetDevice::SimpleNetDevice ()
 }
 
 void
-SimpleNetDevice::Receive (Ptr<Packet> packet, uint16_t protocol,
+SimpleNetDevice::Receive (Ptr<const Packet> packet, uint16_t protocol,
                           Mac48Address to, Mac48Address from)
 {
   NS_LOG_FUNCTION (this << packet << protocol << to << from);
   NetDevice::PacketType packetType;
+  Ptr<Packet> copy;
 
-  if (m_receiveErrorModel && m_receiveErrorModel->IsCorrupt (packet) )
+  if (m_receiveErrorModel)
     {
-      m_phyRxDropTrace (packet);
-      return;
+      copy = packet->Copy ();
+      if (m_receiveErrorModel->IsCorrupt (copy))
+        {
+          m_phyRxDropTrace (copy);
+          return;
+        }
     }
 
   if (to == m_address)
@@ -259,14 +264,23 @@ SimpleNetDevice::Receive (Ptr<Packet> packet, uint16_t protocol,
       packetType = NetDevice::PACKET_OTHERHOST;
     }
 
+  if (packetType == NetDevice::PACKET_OTHERHOST && m_promiscCallback.IsNull ())
+    {
+      return;
+    }
+  if (copy == 0)
+    {
+      copy = packet->Copy ();
+    }
+
   if (packetType != NetDevice::PACKET_OTHERHOST)
     {
-      m_rxCallback (this, packet, protocol, from);
+      m_rxCallback (this, copy, protocol, from);
     }
 
   if (!m_promiscCallback.IsNull ())
     {
-      m_promiscCallback (this, packet, protocol, from, to, packetType);
+      m_promiscCallback (this, copy, protocol, from, to, packetType);
     }
 }
 
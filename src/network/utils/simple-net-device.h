@@ -65,14 +65,16 @@ public:
   /**
    * Receive a packet from a connected SimpleChannel.  The 
    * SimpleNetDevice receives packets from its connected channel
-   * and then forwards them by calling its rx callback method
+   * and then forwards them by calling its rx callback method.
+   * The packet is shared with the other receivers: the device copies it
+   * before it runs the receive error model or forwards it.
    *
    * \param packet Packet received on the channel
    * \param protocol protocol number
    * \param to address packet should be sent to
    * \param from address packet was sent from
    */
-  void Receive (Ptr<Packet> packet, uint16_t protocol, Mac48Address to, Mac48Address from);
+  void Receive (Ptr<const Packet> packet, uint16_t protocol, Mac48Address to, Mac48Address from);
   
   /**
    * Attach a channel to this net device.  This will be the 
@@ -20,7 +20,11 @@
 #include "point-to-point-net-device.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/packet.h"
+#include "ns3/node.h"
 #include "ns3/simulator.h"
+#include "ns3/global-value.h"
+#include "ns3/string.h"
+#include "ns3/mpi-interface.h"
 #include "ns3/log.h"
 
 namespace ns3 {
@@ -96,8 +100,27 @@ PointToPointChannel::TransmitStart (
   NS_ASSERT (m_link[1].m_state != INITIALIZING);
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
+  if (m_link[wire].m_dstNode == Simulator::NO_CONTEXT)
+    {
+      ResolveLinks ();
+    }
+
+  if (m_link[wire].m_remote)
+    {
+      // the other partition receives its own copy of the packet, as from
+      // a PointToPointRemoteChannel, and a plain pointer to the device
+      uint32_t size = p->GetSerializedSize ();
+      uint8_t *buffer = new uint8_t [size];
+      p->Serialize (buffer, size);
+      Ptr<Packet> copy = Create<Packet> (buffer, size, true);
+      delete [] buffer;
+      Simulator::ScheduleWithContext (m_link[wire].m_dstNode,
+                                      txTime + m_delay, &PointToPointNetDevice::Receive,
+                                      PeekPointer (m_link[wire].m_dst), copy);
+      return true;
+    }
 
-  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
+  Simulator::ScheduleWithContext (m_link[wire].m_dstNode,
                                   txTime + m_delay, &PointToPointNetDevice::Receive,
                                   m_link[wire].m_dst, p);
 
@@ -106,6 +129,40 @@ PointToPointChannel::TransmitStart (
   return true;
 }
 
+void
+PointToPointChannel::DoInitialize (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_nDevices == N_DEVICES)
+    {
+      ResolveLinks ();
+    }
+  Channel::DoInitialize ();
+}
+
+void
+PointToPointChannel::ResolveLinks (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_nDevices == N_DEVICES);
+  // system ids only separate threads or processes in a parallel run; a
+  // sequential run keeps the plain delivery and its trace
+  bool parallel = MpiInterface::IsEnabled ();
+  StringValue impl;
+  if (!parallel && GlobalValue::GetValueByNameFailSafe ("SimulatorImplementationType", impl))
+    {
+      parallel = impl.Get () == "ns3::MultithreadedSimulatorImpl";
+    }
+  for (int i = 0; i < N_DEVICES; i++)
+    {
+      Ptr<Node> src = m_link[i].m_src->GetNode ();
+      Ptr<Node> dst = m_link[i].m_dst->GetNode ();
+      NS_ASSERT_MSG (src != 0 && dst != 0, "The devices of the channel are not on nodes");
+      m_link[i].m_dstNode = dst->GetId ();
+      m_link[i].m_remote = parallel && src->GetSystemId () != dst->GetSystemId ();
+    }
+}
+
 uint32_t 
 PointToPointChannel::GetNDevices (void) const
 {
@@ -25,6 +25,7 @@
 #include "ns3/nstime.h"
 #include "ns3/data-rate.h"
 #include "ns3/traced-callback.h"
+#include "ns3/simulator.h"
 
 namespace ns3 {
 
@@ -44,6 +45,15 @@ class Packet;
  * [0] wire to transmit on.  The second device gets the [1] wire.  There is a
  * state (IDLE, TRANSMITTING) associated with each wire.
  *
+ * When the simulation runs with MultithreadedSimulatorImpl or with MPI, a
+ * wire between nodes of different system ids, such as the partitions of
+ * MultithreadedSimulatorImpl, delivers a serialized copy of each packet
+ * to a plain pointer to the receiving device, and does not fire the
+ * TxRxPointToPoint trace, so that the two ends share no reference
+ * counted state. A sequential run delivers every packet as usual. The
+ * ends of the wires are resolved when the channel is initialized, or
+ * else at the first transmission.
+ *
  * \see Attach
  * \see TransmitStart
  */
@@ -146,6 +156,14 @@ protected:
      Time duration, Time lastBitTime);
                     
 private:
+  virtual void DoInitialize (void);
+
+  /**
+   * \brief Record the node of the destination of each wire, and whether
+   * the two ends have different system ids in a parallel run.
+   */
+  void ResolveLinks (void);
+
   /** Each point to point link has exactly two net devices. */
   static const int N_DEVICES = 2;
 
@@ -194,11 +212,14 @@ public:
     /** \brief Create the link, it will be in INITIALIZING state
      *
      */
-    Link() : m_state (INITIALIZING), m_src (0), m_dst (0) {}
-
-    WireState                  m_state; //!< State of the link
-    Ptr<PointToPointNetDevice> m_src;   //!< First NetDevice
-    Ptr<PointToPointNetDevice> m_dst;   //!< Second NetDevice
+    Link() : m_state (INITIALIZING), m_src (0), m_dst (0),
+             m_dstNode (Simulator::NO_CONTEXT), m_remote (false) {}
+
+    WireState                  m_state;   //!< State of the link
+    Ptr<PointToPointNetDevice> m_src;     //!< First NetDevice
+    Ptr<PointToPointNetDevice> m_dst;     //!< Second NetDevice
+    uint32_t                   m_dstNode; //!< Node id of m_dst, NO_CONTEXT until resolved
+    bool                       m_remote;  //!< The nodes of m_src and m_dst run in different threads or processes
   };
 
   Link    m_link[N_DEVICES]; //!< Link model
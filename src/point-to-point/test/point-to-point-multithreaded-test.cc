@@ -0,0 +1,220 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/packet.h"
+#include "ns3/point-to-point-helper.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \brief Test class for PointToPointChannel with MultithreadedSimulatorImpl
+ *
+ * Packets travel around a ring of point to point links whose nodes are
+ * split between four partitions. Each node checks the payload of the
+ * packets it receives, rewrites it, and sends it on until its hop count
+ * runs out. The ring runs with DefaultSimulatorImpl, all its nodes in
+ * one system id, and with MultithreadedSimulatorImpl, where the links
+ * between partitions pass serialized copies of the packets; both runs
+ * must receive the same packets at the same times.
+ */
+class PointToPointMultithreadedTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointMultithreadedTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /// What the nodes of a ring received
+  struct Result
+  {
+    std::vector<uint64_t> digest;   //!< Hash of the packets received by each node
+    std::vector<uint32_t> received; //!< Number of packets received by each node
+    std::vector<uint32_t> corrupt;  //!< Number of packets with a wrong payload
+  };
+
+  /**
+   * \brief Run the ring with a simulator implementation
+   * \param impl The SimulatorImplementationType
+   * \param partitions The number of system ids of the nodes
+   * \returns What the nodes received
+   */
+  Result RunRing (std::string impl, uint32_t partitions);
+
+  /**
+   * \brief Send a packet on the next link of the ring
+   * \param node The sending node
+   * \param hops The hops left
+   * \param size The payload size
+   */
+  void Send (uint32_t node, uint8_t hops, uint32_t size);
+
+  /**
+   * \brief Handle a packet received from the previous node of the ring
+   * \param device The receiving device
+   * \param packet The packet
+   * \param protocol The protocol number
+   * \param from The sender address
+   * \returns true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  static const uint32_t NODES = 12; //!< Nodes of the ring
+
+  std::vector<Ptr<NetDevice> > m_next; //!< Device of each node to the next one
+  Result m_result;                     //!< Outcome of the current run
+};
+
+PointToPointMultithreadedTest::PointToPointMultithreadedTest ()
+  : TestCase ("Point to point traffic between the partitions of MultithreadedSimulatorImpl")
+{
+}
+
+void
+PointToPointMultithreadedTest::Send (uint32_t node, uint8_t hops, uint32_t size)
+{
+  // the payload is the hop count followed by bytes derived from the
+  // sender, which the receiver checks
+  std::vector<uint8_t> payload (size);
+  payload[0] = hops;
+  for (uint32_t i = 1; i < size; i++)
+    {
+      payload[i] = static_cast<uint8_t> (node * 31 + hops * 7 + i);
+    }
+  Ptr<NetDevice> device = m_next[node];
+  device->Send (Create<Packet> (&payload[0], size), device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointMultithreadedTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                         uint16_t protocol, const Address &from)
+{
+  uint32_t node = device->GetNode ()->GetId ();
+  uint32_t previous = (node + NODES - 1) % NODES;
+  uint32_t size = packet->GetSize ();
+  std::vector<uint8_t> payload (size);
+  packet->CopyData (&payload[0], size);
+  uint8_t hops = payload[0];
+  for (uint32_t i = 1; i < size; i++)
+    {
+      if (payload[i] != static_cast<uint8_t> (previous * 31 + hops * 7 + i))
+        {
+          m_result.corrupt[node]++;
+          break;
+        }
+    }
+  uint64_t &digest = m_result.digest[node];
+  digest = (digest ^ Simulator::Now ().GetTimeStep ()) * 1099511628211ULL;
+  digest = (digest ^ (size << 8 | hops)) * 1099511628211ULL;
+  m_result.received[node]++;
+  if (hops > 0)
+    {
+      Send (node, hops - 1, size);
+    }
+  return true;
+}
+
+PointToPointMultithreadedTest::Result
+PointToPointMultithreadedTest::RunRing (std::string impl, uint32_t partitions)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (impl));
+
+  NodeContainer ring;
+  for (uint32_t i = 0; i < NODES; i++)
+    {
+      ring.Add (CreateObject<Node> (i * partitions / NODES));
+    }
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("2ms"));
+  m_next.clear ();
+  for (uint32_t i = 0; i < NODES; i++)
+    {
+      NetDeviceContainer devices = p2p.Install (ring.Get (i), ring.Get ((i + 1) % NODES));
+      m_next.push_back (devices.Get (0));
+      devices.Get (1)->SetReceiveCallback (MakeCallback (&PointToPointMultithreadedTest::Receive, this));
+    }
+
+  m_result.digest.assign (NODES, 14695981039346656037ULL);
+  m_result.received.assign (NODES, 0);
+  m_result.corrupt.assign (NODES, 0);
+  for (uint32_t i = 0; i < NODES; i++)
+    {
+      // every packet goes three times around the ring and one hop more
+      for (uint32_t j = 0; j < 4; j++)
+        {
+          Simulator::ScheduleWithContext (i, MicroSeconds (100 * j + i), &PointToPointMultithreadedTest::Send,
+                                          this, i, 3 * NODES, 64 + 300 * j + i);
+        }
+    }
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  m_next.clear ();
+  return m_result;
+}
+
+void
+PointToPointMultithreadedTest::DoRun (void)
+{
+  Result sequential = RunRing ("ns3::DefaultSimulatorImpl", 1);
+  Result parallel = RunRing ("ns3::MultithreadedSimulatorImpl", 4);
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+
+  for (uint32_t i = 0; i < NODES; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (sequential.received[i], 4 * (3 * NODES + 1), "node " << i << " lost packets");
+      NS_TEST_ASSERT_MSG_EQ (sequential.corrupt[i], 0, "node " << i << " received corrupt packets");
+      NS_TEST_ASSERT_MSG_EQ (parallel.corrupt[i], 0, "node " << i << " received corrupt packets in parallel");
+      NS_TEST_ASSERT_MSG_EQ (parallel.received[i], sequential.received[i], "node " << i << " received other packets");
+      NS_TEST_ASSERT_MSG_EQ (parallel.digest[i], sequential.digest[i], "node " << i << " received other packets");
+    }
+}
+
+/**
+ * \brief TestSuite for PointToPointChannel with MultithreadedSimulatorImpl
+ */
+class PointToPointMultithreadedTestSuite : public TestSuite
+{
+public:
+  /**
+   * \brief Constructor
+   */
+  PointToPointMultithreadedTestSuite ();
+};
+
+PointToPointMultithreadedTestSuite::PointToPointMultithreadedTestSuite ()
+  : TestSuite ("devices-point-to-point-multithreaded", UNIT)
+{
+  AddTestCase (new PointToPointMultithreadedTest, TestCase::QUICK);
+}
+
+static PointToPointMultithreadedTestSuite g_pointToPointMultithreadedTestSuite; //!< The testsuite
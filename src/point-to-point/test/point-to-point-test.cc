@@ -100,6 +100,127 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test class for PointToPointChannel between system ids
+ *
+ * It sends one packet between nodes of different system ids with
+ * DefaultSimulatorImpl, which must deliver it as usual and fire the
+ * TxRxPointToPoint trace.
+ */
+class PointToPointSystemIdTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointSystemIdTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send one packet to the device specified
+   *
+   * \param device NetDevice to send to
+   */
+  void SendOnePacket (Ptr<PointToPointNetDevice> device);
+
+  /**
+   * \brief Count the packets which leave on the channel
+   * \param packet The packet
+   * \param txDevice The sending device
+   * \param rxDevice The receiving device
+   * \param duration The transmission time
+   * \param lastBitTime The arrival time of the last bit
+   */
+  void TxRx (Ptr<const Packet> packet, Ptr<NetDevice> txDevice, Ptr<NetDevice> rxDevice,
+             Time duration, Time lastBitTime);
+
+  /**
+   * \brief Count the packets received
+   * \param device The receiving device
+   * \param packet The packet
+   * \param protocol The protocol number
+   * \param from The sender address
+   * \returns true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  uint32_t m_txrx;     //!< Packets seen by the channel trace
+  uint32_t m_received; //!< Packets received
+};
+
+PointToPointSystemIdTest::PointToPointSystemIdTest ()
+  : TestCase ("PointToPoint between system ids in a sequential run"),
+    m_txrx (0),
+    m_received (0)
+{
+}
+
+void
+PointToPointSystemIdTest::SendOnePacket (Ptr<PointToPointNetDevice> device)
+{
+  Ptr<Packet> p = Create<Packet> ();
+  device->Send (p, device->GetBroadcast (), 0x800);
+}
+
+void
+PointToPointSystemIdTest::TxRx (Ptr<const Packet> packet, Ptr<NetDevice> txDevice, Ptr<NetDevice> rxDevice,
+                                Time duration, Time lastBitTime)
+{
+  m_txrx++;
+}
+
+bool
+PointToPointSystemIdTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                                   uint16_t protocol, const Address &from)
+{
+  m_received++;
+  return true;
+}
+
+void
+PointToPointSystemIdTest::DoRun (void)
+{
+  Ptr<Node> a = CreateObject<Node> (0);
+  Ptr<Node> b = CreateObject<Node> (1);
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue> ());
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+
+  Ptr<NetDeviceQueueInterface> ifaceA = CreateObject<NetDeviceQueueInterface> ();
+  devA->AggregateObject (ifaceA);
+  ifaceA->CreateTxQueues ();
+  Ptr<NetDeviceQueueInterface> ifaceB = CreateObject<NetDeviceQueueInterface> ();
+  devB->AggregateObject (ifaceB);
+  ifaceB->CreateTxQueues ();
+
+  channel->TraceConnectWithoutContext ("TxRxPointToPoint", MakeCallback (&PointToPointSystemIdTest::TxRx, this));
+  devB->SetReceiveCallback (MakeCallback (&PointToPointSystemIdTest::Receive, this));
+
+  Simulator::Schedule (Seconds (1.0), &PointToPointSystemIdTest::SendOnePacket, this, devA);
+
+  Simulator::Run ();
+
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_received, 1, "the packet was not delivered");
+  NS_TEST_ASSERT_MSG_EQ (m_txrx, 1, "the channel did not trace the packet");
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -116,6 +237,7 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointSystemIdTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
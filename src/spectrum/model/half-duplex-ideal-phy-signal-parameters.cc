@@ -36,7 +36,7 @@ HalfDuplexIdealPhySignalParameters::HalfDuplexIdealPhySignalParameters (const Ha
   : SpectrumSignalParameters (p)
 {
   NS_LOG_FUNCTION (this << &p);
-  data = p.data->Copy ();
+  data = p.data;
 }
 
 Ptr<SpectrumSignalParameters>
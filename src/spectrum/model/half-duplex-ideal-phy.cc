@@ -300,7 +300,7 @@ HalfDuplexIdealPhy::StartTx (Ptr<Packet> p)
         txParams->txPhy = GetObject<SpectrumPhy> ();
         txParams->txAntenna = m_antenna;
         txParams->psd = m_txPsd;
-        txParams->data = m_txPacket;
+        txParams->data = m_txPacket->Copy ();
 
         NS_LOG_LOGIC (this << " tx power: " << 10 * std::log10 (Integral (*(txParams->psd))) + 30 << " dBm");
         m_channel->StartTx (txParams);
@@ -371,7 +371,7 @@ HalfDuplexIdealPhy::StartRx (Ptr<SpectrumSignalParameters> spectrumParams)
         case IDLE:
           // preamble detection and synchronization is supposed to be always successful.
 
-          Ptr<Packet> p = rxParams->data;
+          Ptr<const Packet> p = rxParams->data;
           m_phyRxStartTrace (p);
           m_rxPacket = p;
           m_rxPsd = rxParams->psd;
@@ -433,7 +433,7 @@ HalfDuplexIdealPhy::EndRx ()
       if (!m_phyMacRxEndOkCallback.IsNull ())
         {
           NS_LOG_LOGIC (this << " calling m_phyMacRxEndOkCallback");
-          m_phyMacRxEndOkCallback (m_rxPacket);
+          m_phyMacRxEndOkCallback (m_rxPacket->Copy ());
         }
       else
         {
@@ -220,7 +220,7 @@ private:
   Ptr<SpectrumValue> m_txPsd;       //!< Tx power spectral density
   Ptr<const SpectrumValue> m_rxPsd; //!< Rx power spectral density
   Ptr<Packet> m_txPacket; //!< Tx packet
-  Ptr<Packet> m_rxPacket; //!< Rx packet
+  Ptr<const Packet> m_rxPacket; //!< Rx packet, shared with the other receivers
 
   DataRate m_rate;  //!< Datarate
   State m_state;    //!< PHY state
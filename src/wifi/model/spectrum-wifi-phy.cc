@@ -407,7 +407,7 @@ SpectrumWifiPhy::StartRx (Ptr<SpectrumSignalParameters> rxParams)
     }
 
   NS_LOG_INFO ("Received Wi-Fi signal");
-  Ptr<Packet> packet = wifiRxParams->packet->Copy ();
+  Ptr<const Packet> packet = wifiRxParams->packet;
   WifiPhyTag tag;
   bool found = packet->PeekPacketTag (tag);
   if (!found)
@@ -571,7 +571,7 @@ SpectrumWifiPhy::StartRx (Ptr<SpectrumSignalParameters> rxParams)
 }
 
 void
-SpectrumWifiPhy::StartReceivePacket (Ptr<Packet> packet,
+SpectrumWifiPhy::StartReceivePacket (Ptr<const Packet> packet,
                                      WifiTxVector txVector,
                                      enum WifiPreamble preamble,
                                      enum mpduType mpdutype,
@@ -761,7 +761,7 @@ SpectrumWifiPhy::UnregisterListener (WifiPhyListener *listener)
 }
 
 void
-SpectrumWifiPhy::EndReceive (Ptr<Packet> packet, enum WifiPreamble preamble, enum mpduType mpdutype, Ptr<InterferenceHelper::Event> event)
+SpectrumWifiPhy::EndReceive (Ptr<const Packet> packet, enum WifiPreamble preamble, enum mpduType mpdutype, Ptr<InterferenceHelper::Event> event)
 {
   NS_LOG_FUNCTION (this << packet << event);
   NS_ASSERT (IsStateRx ());
@@ -89,7 +89,7 @@ public:
    * \param mpdutype the type of the MPDU as defined in WifiPhy::mpduType.
    * \param event the corresponding event of the first time the packet arrives
    */
-  void StartReceivePacket (Ptr<Packet> packet,
+  void StartReceivePacket (Ptr<const Packet> packet,
                            WifiTxVector txVector,
                            WifiPreamble preamble,
                            enum mpduType mpdutype,
@@ -188,7 +188,7 @@ private:
    * \param mpdutype the type of the MPDU as defined in WifiPhy::mpduType.
    * \param event the corresponding event of the first time the packet arrives
    */
-  void EndReceive (Ptr<Packet> packet, enum WifiPreamble preamble, enum mpduType mpdutype, Ptr<InterferenceHelper::Event> event);
+  void EndReceive (Ptr<const Packet> packet, enum WifiPreamble preamble, enum mpduType mpdutype, Ptr<InterferenceHelper::Event> event);
 
   /**
    * Check if Phy state should move to CCA busy state based on current
@@ -156,19 +156,21 @@ public:
   /**
    * Switch from RX after the reception was successful.
    *
-   * \param packet the successfully received packet
+   * \param packet the successfully received packet, copied for the
+   *        receive callback
    * \param snr the SNR of the received packet
    * \param txVector TXVECTOR of the packet
    * \param preamble the preamble of the received packet
    */
-  void SwitchFromRxEndOk (Ptr<Packet> packet, double snr, WifiTxVector txVector, enum WifiPreamble preamble);
+  void SwitchFromRxEndOk (Ptr<const Packet> packet, double snr, WifiTxVector txVector, enum WifiPreamble preamble);
   /**
    * Switch from RX after the reception failed.
    *
-   * \param packet the packet that we failed to received
+   * \param packet the packet that we failed to received, copied for the
+   *        receive error callback
    * \param snr the SNR of the received packet
    */
-  void SwitchFromRxEndError (Ptr<Packet> packet, double snr);
+  void SwitchFromRxEndError (Ptr<const Packet> packet, double snr);
   /**
    * Switch to CCA busy.
    *
@@ -127,12 +127,12 @@ private:
    * bit of the packet has arrived.
    *
    * \param i index of the corresponding YansWifiPhy in the PHY list
-   * \param packet the packet being sent
+   * \param packet the packet being sent, shared by all the receivers
    * \param atts a vector containing the received power in dBm and the packet type
    * \param txVector the TXVECTOR of the packet
    * \param preamble the type of preamble being used to send the packet
    */
-  void Receive (uint32_t i, Ptr<Packet> packet, struct Parameters parameters) const;
+  void Receive (uint32_t i, Ptr<const Packet> packet, struct Parameters parameters) const;
 
   PhyList m_phyList;                   //!< List of YansWifiPhys connected to this YansWifiChannel
   Ptr<PropagationLossModel> m_loss;    //!< Propagation loss model
@@ -257,7 +257,7 @@ YansWifiPhy::SetReceiveErrorCallback (RxErrorCallback callback)
 }
 
 void
-YansWifiPhy::StartReceivePreambleAndHeader (Ptr<Packet> packet,
+YansWifiPhy::StartReceivePreambleAndHeader (Ptr<const Packet> packet,
                                             double rxPowerDbm,
                                             WifiTxVector txVector,
                                             enum WifiPreamble preamble,
@@ -415,7 +415,7 @@ maybeCcaBusy:
 }
 
 void
-YansWifiPhy::StartReceivePacket (Ptr<Packet> packet,
+YansWifiPhy::StartReceivePacket (Ptr<const Packet> packet,
                                  WifiTxVector txVector,
                                  enum WifiPreamble preamble,
                                  enum mpduType mpdutype,
@@ -525,7 +525,7 @@ YansWifiPhy::UnregisterListener (WifiPhyListener *listener)
 }
 
 void
-YansWifiPhy::EndReceive (Ptr<Packet> packet, enum WifiPreamble preamble, enum mpduType mpdutype, Ptr<InterferenceHelper::Event> event)
+YansWifiPhy::EndReceive (Ptr<const Packet> packet, enum WifiPreamble preamble, enum mpduType mpdutype, Ptr<InterferenceHelper::Event> event)
 {
   NS_LOG_FUNCTION (this << packet << event);
   NS_ASSERT (IsStateRx ());